@@ -70,7 +70,7 @@ struct DriftSpriteVertInput {
 	// Vertex attribs:
 	DRIFT_ATTR0 float2 uv;
 	// Instance attribs:
-	DRIFT_ATTR1 float4 mat0;
+	DRIFT_ATTR1 float4 mat0; // Half floats when packed, see DriftGPUSprite.
 	DRIFT_ATTR2 float2 mat1;
 	DRIFT_ATTR3 float4 color;
 	DRIFT_ATTR4 uint4 bounds;
@@ -12,9 +12,9 @@ struct VertInput {
 	// Vertex attribs:
 	DRIFT_ATTR0 float2 uv;
 	// Instance attribs:
-	DRIFT_ATTR1 float4 mat0;
+	DRIFT_ATTR1 float4 mat0; // Half floats when packed, see DriftGPULight.
 	DRIFT_ATTR2 float2 mat1;
-	DRIFT_ATTR3 float4 color;
+	DRIFT_ATTR3 float4 color; // Half floats when packed.
 	DRIFT_ATTR4 uint4 bounds;
 	DRIFT_ATTR5 uint2 anchor;
 	DRIFT_ATTR6 uint layer;
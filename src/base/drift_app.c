@@ -11,6 +11,7 @@ You should have received a copy of the GNU General Public License along with Ver
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdatomic.h>
 
 #if __unix__ || __APPLE__
 	#include <unistd.h>
@@ -51,6 +52,7 @@ You should have received a copy of the GNU General Public License along with Ver
 #include "tina/tina_jobs.h"
 
 #include "drift_base.h"
+#include "drift_gfx_internal.h"
 
 DriftApp* APP;
 
@@ -70,6 +72,114 @@ void DriftParallelFor(tina_job* job, tina_job_func func, void* user_data, uint c
 	tina_job_wait(job, &group, 0);
 }
 
+typedef struct {
+	DriftParallelRangeFunc* func;
+	void* user_data;
+	uint count, min_grain, workers;
+	_Atomic(uint) cursor;
+} RangeContext;
+
+static void range_worker(RangeContext* ctx){
+	uint begin = atomic_load_explicit(&ctx->cursor, memory_order_relaxed);
+	while(begin < ctx->count){
+		// Claim a share of what's left, at least the minimum grain size.
+		uint remaining = ctx->count - begin;
+		uint chunk = DRIFT_MIN(DRIFT_MAX(remaining/(2*ctx->workers), ctx->min_grain), remaining);
+		if(atomic_compare_exchange_weak_explicit(&ctx->cursor, &begin, begin + chunk, memory_order_relaxed, memory_order_relaxed)){
+			ctx->func(ctx->user_data, begin, begin + chunk);
+			begin = atomic_load_explicit(&ctx->cursor, memory_order_relaxed);
+		}
+	}
+}
+
+static void range_job(tina_job* job){
+	range_worker(tina_job_get_description(job)->user_data);
+}
+
+void DriftParallelForRange(tina_job* job, DriftParallelRangeFunc* func, void* user_data, uint count, uint min_grain){
+	if(count == 0) return;
+	
+	min_grain = DRIFT_MAX(min_grain, 1u);
+	RangeContext ctx = {.func = func, .user_data = user_data, .count = count, .min_grain = min_grain, .workers = DRIFT_MAX(APP->worker_count, 1u)};
+	
+	// Don't wake more workers than there are chunks to hand out.
+	uint helpers = DRIFT_MIN(ctx.workers, (count + min_grain - 1)/min_grain) - 1;
+	tina_group group = {};
+	if(helpers) tina_scheduler_enqueue_n(tina_job_get_scheduler(job), range_job, &ctx, helpers, DRIFT_JOB_QUEUE_WORK, &group);
+	
+	// Work on the range too instead of only waiting for the helpers.
+	range_worker(&ctx);
+	tina_job_wait(job, &group, 0);
+}
+
+#if DRIFT_DEBUG
+typedef struct {
+	float* values;
+	uint work;
+} ParallelBenchContext;
+
+static void bench_item(ParallelBenchContext* ctx, uint idx){
+	float x = ctx->values[idx];
+	for(uint i = 0; i < ctx->work; i++) x = x*0.999f + 0.001f;
+	ctx->values[idx] = x;
+}
+
+static void bench_job(tina_job* job){
+	bench_item(tina_job_get_description(job)->user_data, tina_job_get_description(job)->user_idx);
+}
+
+static void bench_range(void* user_data, uint begin, uint end){
+	for(uint i = begin; i < end; i++) bench_item(user_data, i);
+}
+
+static double bench_ns(u64 t0, uint count){return (double)(DriftTimeNanos() - t0)/count;}
+
+// Compare the per item cost of the job per index loops against the range loop.
+// Needs a running scheduler, so it's called from the game start instead of main().
+void unit_test_parallel_for(tina_job* job){
+	uint fine_count = 1024*1024, coarse_count = 8*1024;
+	ParallelBenchContext ctx = {.values = DriftAlloc(DriftSystemMem, fine_count*sizeof(float))};
+	for(uint i = 0; i < fine_count; i++) ctx.values[i] = (float)i;
+	
+	// Trivial items are all overhead. Per index jobs get a smaller count to keep the run time sane.
+	ctx.work = 1;
+	uint per_index_count = fine_count/16;
+	u64 t0 = DriftTimeNanos();
+	for(uint i = 0; i < fine_count; i++) bench_item(&ctx, i);
+	double serial_fine = bench_ns(t0, fine_count);
+	t0 = DriftTimeNanos(), DriftThrottledParallelFor(job, bench_job, &ctx, per_index_count);
+	double throttled_fine = bench_ns(t0, per_index_count);
+	t0 = DriftTimeNanos(), DriftParallelFor(job, bench_job, &ctx, per_index_count);
+	double parallel_fine = bench_ns(t0, per_index_count);
+	t0 = DriftTimeNanos(), DriftParallelForRange(job, bench_range, &ctx, fine_count, 1024);
+	double range_fine = bench_ns(t0, fine_count);
+	
+	// Heavier items where the scheduling cost should mostly disappear.
+	ctx.work = 4096;
+	t0 = DriftTimeNanos();
+	for(uint i = 0; i < coarse_count; i++) bench_item(&ctx, i);
+	double serial_coarse = bench_ns(t0, coarse_count);
+	t0 = DriftTimeNanos(), DriftThrottledParallelFor(job, bench_job, &ctx, coarse_count);
+	double throttled_coarse = bench_ns(t0, coarse_count);
+	t0 = DriftTimeNanos(), DriftParallelFor(job, bench_job, &ctx, coarse_count);
+	double parallel_coarse = bench_ns(t0, coarse_count);
+	t0 = DriftTimeNanos(), DriftParallelForRange(job, bench_range, &ctx, coarse_count, 1);
+	double range_coarse = bench_ns(t0, coarse_count);
+	
+	float sum = 0;
+	for(uint i = 0; i < fine_count; i++) sum += ctx.values[i];
+	DRIFT_ASSERT(isfinite(sum), "Benchmark values diverged.");
+	DriftDealloc(DriftSystemMem, ctx.values, fine_count*sizeof(float));
+	
+	DRIFT_LOG("ParallelFor fine (ns/item, %u workers): serial %.1f, throttled %.1f, parallel %.1f, range %.1f",
+		APP->worker_count, serial_fine, throttled_fine, parallel_fine, range_fine
+	);
+	DRIFT_LOG("ParallelFor coarse (ns/item): serial %.1f, throttled %.1f, parallel %.1f, range %.1f",
+		serial_coarse, throttled_coarse, parallel_coarse, range_coarse
+	);
+}
+#endif
+
 #if DRIFT_MODULES
 static void DriftModuleLoad(void){
 	SDL_UnloadObject(APP->module);
@@ -227,6 +337,7 @@ int DriftMain(DriftApp* app){
 	// Setup jobs.
 	uint thread_count = DRIFT_MAX(DRIFT_MIN(DriftAppGetCPUCount() + 1u, DRIFT_APP_MAX_THREADS), 3u);
 	DRIFT_LOG("DriftApp thread count: %d", thread_count);
+	APP->worker_count = thread_count - DRIFT_THREAD_ID_WORKER0;
 	
 	
 	size_t sched_size = tina_scheduler_size(JOB_COUNT, _DRIFT_JOB_QUEUE_COUNT, FIBER_COUNT, 0);
@@ -321,6 +432,11 @@ DriftGfxRenderer* DriftAppBeginFrame(DriftMem* mem){
 
 void DriftAppPresentFrame(DriftGfxRenderer* renderer){
 	DriftAssertGfxThread();
+	if(renderer->capture_filename){
+		DriftGfxCaptureWrite(renderer, renderer->capture_filename);
+		renderer->capture_filename = NULL;
+	}
+	
 	APP->shell_func(DRIFT_SHELL_PRESENT_FRAME, renderer);
 }
 
@@ -338,18 +454,493 @@ void DriftAssertGfxThread(void){
 	DRIFT_ASSERT_HARD(ThreadID == DRIFT_THREAD_ID_GFX, "Must be called from the gfx queue.");
 }
 
+// MARK: Null Driver.
+
+#define DRIFT_NULL_RENDERER_COUNT 2
+
+typedef struct {
+	DriftMap destructors;
+	DriftGfxObjectCache cache;
+	DriftGfxRenderer* renderers[DRIFT_NULL_RENDERER_COUNT];
+	uint renderer_index;
+} DriftNullGfxContext;
+
+static void DriftNullCommand(const DriftGfxRenderer* renderer, const DriftGfxCommand* command, DriftGfxRenderState* state){}
+
+static DriftGfxRenderer* DriftNullRendererNew(void){
+	DriftGfxRenderer* renderer = DriftAlloc(DriftSystemMem, sizeof(*renderer));
+	DriftGfxRendererInit(renderer, (DriftGfxVTable){
+		.bind_target = DriftNullCommand,
+		.set_scissor = DriftNullCommand,
+		.bind_pipeline = DriftNullCommand,
+		.draw_indexed = DriftNullCommand,
+	});
+	
+	renderer->uniform_alignment = 256;
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++){
+		DriftGfxStream* stream = renderer->streams + i;
+		stream->capacity = stream->min_capacity;
+		stream->ptr = DriftAlloc(DriftSystemMem, stream->capacity);
+	}
+	
+	return renderer;
+}
+
+// Handle stream buffers the way a GPU driver would so the headless path exercises the same growth.
+static void DriftNullRendererPresent(DriftGfxRenderer* renderer){
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++){
+		DriftGfxStream* stream = renderer->streams + i;
+		size_t capacity = DriftGfxStreamNextCapacity(stream);
+		if(capacity != stream->capacity){
+			stream->ptr = DriftRealloc(DriftSystemMem, stream->ptr, stream->capacity, capacity);
+			stream->capacity = capacity;
+		}
+		
+		// Copy overflow pages to their offsets in the grown buffer.
+		for(uint j = 0; j < stream->page_count; j++){
+			DriftGfxStreamPage* page = stream->pages + j;
+			memcpy(stream->ptr + page->offset, page->ptr, DriftGfxStreamPageUsed(stream, page));
+		}
+	}
+	
+	DriftRendererExecuteCommands(renderer);
+}
+
+static void DriftNullShaderFree(const DriftGfxDriver* driver, void* obj){DriftDealloc(DriftSystemMem, obj, sizeof(DriftGfxShader));}
+static void DriftNullPipelineFree(const DriftGfxDriver* driver, void* obj){DriftDealloc(DriftSystemMem, obj, sizeof(DriftGfxPipeline));}
+static void DriftNullSamplerFree(const DriftGfxDriver* driver, void* obj){DriftDealloc(DriftSystemMem, obj, sizeof(DriftGfxSampler));}
+static void DriftNullTextureFree(const DriftGfxDriver* driver, void* obj){DriftDealloc(DriftSystemMem, obj, sizeof(DriftGfxTexture));}
+static void DriftNullRenderTargetFree(const DriftGfxDriver* driver, void* obj){DriftDealloc(DriftSystemMem, obj, sizeof(DriftGfxRenderTarget));}
+
+static void* DriftNullTrack(const DriftGfxDriver* driver, void* obj, DriftGfxDestructor* destructor){
+	DriftNullGfxContext* ctx = driver->ctx;
+	DriftMapInsert(&ctx->destructors, (uintptr_t)obj, (uintptr_t)destructor);
+	return obj;
+}
+
+static DriftGfxShader* DriftNullShaderLoad(const DriftGfxDriver* driver, const char* name, const DriftGfxShaderDesc* desc){
+	DriftNullGfxContext* ctx = driver->ctx;
+	DriftGfxShader* shader = DriftGfxCacheFindShader(&ctx->cache, name, desc, NULL, 0);
+	if(shader) return shader;
+	
+	shader = DriftNullTrack(driver, DRIFT_COPY(DriftSystemMem, ((DriftGfxShader){.name = name, .desc = desc})), DriftNullShaderFree);
+	return DriftGfxCacheAddShader(&ctx->cache, shader, NULL, 0);
+}
+
+static DriftGfxPipeline* DriftNullPipelineNew(const DriftGfxDriver* driver, DriftGfxPipelineOptions options){
+	DriftNullGfxContext* ctx = driver->ctx;
+	DriftGfxPipeline* pipeline = DriftGfxCacheFindPipeline(&ctx->cache, &options);
+	if(pipeline) return pipeline;
+	
+	pipeline = DriftNullTrack(driver, DRIFT_COPY(DriftSystemMem, ((DriftGfxPipeline){.options = options})), DriftNullPipelineFree);
+	return DriftGfxCacheAddPipeline(&ctx->cache, pipeline);
+}
+
+static DriftGfxSampler* DriftNullSamplerNew(const DriftGfxDriver* driver, DriftGfxSamplerOptions options){
+	DriftNullGfxContext* ctx = driver->ctx;
+	DriftGfxSampler* sampler = DriftGfxCacheFindSampler(&ctx->cache, &options);
+	if(sampler) return sampler;
+	
+	sampler = DriftNullTrack(driver, DRIFT_COPY(DriftSystemMem, ((DriftGfxSampler){.options = options})), DriftNullSamplerFree);
+	return DriftGfxCacheAddSampler(&ctx->cache, sampler);
+}
+
+static DriftGfxTexture* DriftNullTextureNew(const DriftGfxDriver* driver, uint width, uint height, DriftGfxTextureOptions options){
+	DriftGfxTexture* texture = DRIFT_COPY(DriftSystemMem, ((DriftGfxTexture){.options = options, .width = width, .height = height}));
+	return DriftNullTrack(driver, texture, DriftNullTextureFree);
+}
+
+static DriftGfxRenderTarget* DriftNullRenderTargetNew(const DriftGfxDriver* driver, DriftGfxRenderTargetOptions options){
+	DriftGfxRenderTarget* rt = DRIFT_COPY(DriftSystemMem, ((DriftGfxRenderTarget){.options = options, .load = options.load, .store = options.store}));
+	for(uint i = 0; i < DRIFT_GFX_RENDER_TARGET_COUNT; i++){
+		DriftGfxTexture* texture = options.bindings[i].texture;
+		if(texture) rt->framebuffer_size = (DriftVec2){texture->width, texture->height};
+	}
+	
+	return DriftNullTrack(driver, rt, DriftNullRenderTargetFree);
+}
+
+static void DriftNullLoadTextureLayer(const DriftGfxDriver* driver, DriftGfxTexture* texture, uint layer, const void* pixels){}
+
+static void DriftNullFreeObjects(const DriftGfxDriver* driver, void* obj[], uint count){
+	DriftNullGfxContext* ctx = driver->ctx;
+	DriftGfxFreeObjects(driver, &ctx->destructors, &ctx->cache, obj, count);
+}
+
+static void DriftNullFreeAll(const DriftGfxDriver* driver){
+	DriftNullGfxContext* ctx = driver->ctx;
+	DriftGfxFreeAll(driver, &ctx->destructors, &ctx->cache);
+}
+
+// The console shell has no window, but provides a driver that accepts and discards all rendering.
 void* DriftShellConsole(DriftShellEvent event, void* shell_value){
 	switch(event){
 		case DRIFT_SHELL_START:{
 			DRIFT_LOG("Using Console");
+			
+			if(APP->window_w == 0){
+				APP->window_w = DRIFT_APP_DEFAULT_SCREEN_W;
+				APP->window_h = DRIFT_APP_DEFAULT_SCREEN_H;
+			}
+			
+			DriftNullGfxContext* ctx = DRIFT_COPY(DriftSystemMem, ((DriftNullGfxContext){}));
+			DriftMapInit(&ctx->destructors, DriftSystemMem, "#NullDestructors", 0);
+			DriftGfxObjectCacheInit(&ctx->cache);
+			for(uint i = 0; i < DRIFT_NULL_RENDERER_COUNT; i++) ctx->renderers[i] = DriftNullRendererNew();
+			APP->shell_context = ctx;
+			
+			APP->gfx_driver = DRIFT_COPY(DriftSystemMem, ((DriftGfxDriver){
+				.ctx = APP->shell_context,
+				.load_shader = DriftNullShaderLoad,
+				.new_pipeline = DriftNullPipelineNew,
+				.new_sampler = DriftNullSamplerNew,
+				.new_texture = DriftNullTextureNew,
+				.new_target = DriftNullRenderTargetNew,
+				.load_texture_layer = DriftNullLoadTextureLayer,
+				.free_objects = DriftNullFreeObjects,
+				.free_all = DriftNullFreeAll,
+			}));
 		} break;
 		
 		case DRIFT_SHELL_STOP:{
 			DRIFT_LOG("Console Shutdown.");
 		} break;
 		
+		case DRIFT_SHELL_BEGIN_FRAME:{
+			DriftNullGfxContext* ctx = APP->shell_context;
+			DriftGfxRenderer* renderer = ctx->renderers[ctx->renderer_index++ & (DRIFT_NULL_RENDERER_COUNT - 1)];
+			DriftGfxRendererPrepare(renderer, (DriftVec2){APP->window_w, APP->window_h}, shell_value);
+			return renderer;
+		} break;
+		
+		case DRIFT_SHELL_PRESENT_FRAME:{
+			DriftNullRendererPresent(shell_value);
+		} break;
+		
 		default: break;
 	}
 	
 	return NULL;
 }
+
+#if DRIFT_DEBUG
+// Push a 50 MB frame through the null driver, then check that quiet frames shrink the streams back down.
+void unit_test_gfx_streams(void){
+	DriftGfxRenderer* renderer = DriftNullRendererNew();
+	
+	size_t chunk_size = 16*1024;
+	uint chunk_count = (50 << 20)/chunk_size;
+	DriftGfxBufferBinding* bindings = DriftAlloc(DriftSystemMem, chunk_count*sizeof(*bindings));
+	size_t mem_size = 64*1024;
+	void* mem_buffer = DriftAlloc(DriftSystemMem, mem_size);
+	
+	u64 push_nanos[2], present_nanos[2];
+	uint pages[2];
+	for(uint frame = 0; frame < 2; frame++){
+		DriftGfxRendererPrepare(renderer, (DriftVec2){256, 256}, DriftLinearMemMake(mem_buffer, mem_size, "gfx streams"));
+		
+		// Mostly geometry with some index and uniform data, each chunk filled with its own byte.
+		u64 t0 = DriftTimeNanos();
+		for(uint i = 0; i < chunk_count; i++){
+			DriftGfxBufferSlice slice;
+			switch(i % 10){
+				default: slice = DriftGfxRendererPushGeometry(renderer, NULL, chunk_size); break;
+				case 8: slice = DriftGfxRendererPushIndexes(renderer, NULL, chunk_size); break;
+				case 9: slice = DriftGfxRendererPushUniforms(renderer, NULL, chunk_size); break;
+			}
+			memset(slice.ptr, (u8)(i*7 + 1), chunk_size);
+			bindings[i] = slice.binding;
+		}
+		u64 t1 = DriftTimeNanos();
+		
+		pages[frame] = 0;
+		for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++) pages[frame] += renderer->streams[i].page_count;
+		DriftNullRendererPresent(renderer);
+		push_nanos[frame] = t1 - t0;
+		present_nanos[frame] = DriftTimeNanos() - t1;
+		
+		// The data needs to be at its binding offsets once the driver has uploaded it.
+		for(uint i = 0; i < chunk_count; i++){
+			DriftGfxStream* stream = renderer->streams + (i % 10 < 8 ? DRIFT_GFX_STREAM_VERTEX : (i % 10 == 8 ? DRIFT_GFX_STREAM_INDEX : DRIFT_GFX_STREAM_UNIFORM));
+			const u8* ptr = stream->ptr + bindings[i].offset;
+			for(uint j = 0; j < chunk_size; j++) DRIFT_ASSERT_HARD(ptr[j] == (u8)(i*7 + 1), "Gfx stream data mismatch in chunk %u.", i);
+		}
+	}
+	DRIFT_ASSERT(pages[0] > 0, "Frame didn't overflow.");
+	DRIFT_ASSERT(pages[1] == 0, "Streams didn't grow to fit the frame.");
+	
+	DriftGfxStreamStats* vertex = renderer->stats.streams + DRIFT_GFX_STREAM_VERTEX;
+	size_t used = 0, capacity = 0;
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++) used += renderer->stats.streams[i].used, capacity += renderer->stats.streams[i].capacity;
+	DRIFT_LOG("Gfx streams 50 MB frame: %.2f ms push + %.2f ms upload with %u overflow pages, %.2f ms + %.2f ms once grown.",
+		push_nanos[0]/1e6, present_nanos[0]/1e6, pages[0], push_nanos[1]/1e6, present_nanos[1]/1e6
+	);
+	DRIFT_LOG("Gfx streams grown to %.1f MB for %.1f MB used (vertex %.1f of %.1f MB).",
+		capacity/1048576.0, used/1048576.0, vertex->used/1048576.0, vertex->capacity/1048576.0
+	);
+	
+	// Once the big frame falls out of the history the streams should shrink back to their minimum.
+	for(uint frame = 0; frame < DRIFT_GFX_STREAM_HISTORY + 2; frame++){
+		DriftGfxRendererPrepare(renderer, (DriftVec2){256, 256}, DriftLinearMemMake(mem_buffer, mem_size, "gfx streams"));
+		DriftGfxRendererPushGeometry(renderer, NULL, chunk_size);
+		DriftNullRendererPresent(renderer);
+	}
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++){
+		DriftGfxStream* stream = renderer->streams + i;
+		DRIFT_ASSERT(stream->capacity == stream->min_capacity, "Stream %u didn't shrink. (%zu bytes)", i, stream->capacity);
+		DriftDealloc(DriftSystemMem, stream->ptr, stream->capacity);
+	}
+	
+	DriftDealloc(DriftSystemMem, mem_buffer, mem_size);
+	DriftDealloc(DriftSystemMem, bindings, chunk_count*sizeof(*bindings));
+	DriftDealloc(DriftSystemMem, renderer, sizeof(*renderer));
+}
+static void push_random(DriftGfxBufferSlice slice, DriftRandom rand[1]){
+	u8* ptr = slice.ptr;
+	for(uint i = 0; i < slice.binding.size; i++) ptr[i] = (u8)DriftRand32(rand);
+}
+
+static void fill_capture_frame(DriftGfxRenderer* renderer, DriftGfxRenderTarget* rt, DriftGfxPipeline* pipeline, DriftGfxSampler* sampler, DriftGfxTexture* texture){
+	DriftRandom rand = {1234};
+	DriftGfxBufferBinding quad = DriftGfxRendererPushIndexes(renderer, (u16[]){0, 1, 2, 0, 2, 3}, 6*sizeof(u16)).binding;
+	
+	for(uint pass = 0; pass < 2; pass++){
+		DriftGfxRendererPushBindTargetCommand(renderer, pass ? NULL : rt, (DriftVec4){{0.1f*pass, 0.2f, 0.3f, 1}});
+		for(uint i = 0; i < 64; i++){
+			DriftGfxRendererPushScissorCommand(renderer, (DriftAABB2){i, 0, i + 64, 64});
+			DriftGfxPipelineBindings* bindings = DriftGfxRendererPushBindPipelineCommand(renderer, pipeline);
+			DriftGfxBufferSlice instances = DriftGfxRendererPushGeometry(renderer, NULL, 32*1024);
+			push_random(instances, &rand);
+			DriftGfxBufferSlice uniforms = DriftGfxRendererPushUniforms(renderer, NULL, 64);
+			push_random(uniforms, &rand);
+			bindings->instance = instances.binding;
+			bindings->uniforms[0] = uniforms.binding;
+			bindings->samplers[1] = sampler;
+			bindings->textures[2] = pass ? texture : NULL;
+			bindings->blend_color = (DriftVec4){{0, 0, 0, i/64.0f}};
+			DriftGfxRendererPushDrawIndexedCommand(renderer, quad, 6, i);
+		}
+	}
+}
+
+// Capture a frame pushed onto the null driver, replay it onto a second renderer, and check that it matches.
+// The frame overflows the vertex stream so the pages are captured too.
+void unit_test_gfx_capture(void){
+	DriftNullGfxContext ctx = {};
+	DriftMapInit(&ctx.destructors, DriftSystemMem, "#NullDestructors", 0);
+	DriftGfxObjectCacheInit(&ctx.cache);
+	DriftGfxDriver driver = {
+		.ctx = &ctx,
+		.load_shader = DriftNullShaderLoad,
+		.new_pipeline = DriftNullPipelineNew,
+		.new_sampler = DriftNullSamplerNew,
+		.new_texture = DriftNullTextureNew,
+		.new_target = DriftNullRenderTargetNew,
+		.load_texture_layer = DriftNullLoadTextureLayer,
+		.free_objects = DriftNullFreeObjects,
+		.free_all = DriftNullFreeAll,
+	};
+	
+	DriftGfxTexture* texture = driver.new_texture(&driver, 64, 32, (DriftGfxTextureOptions){
+		.name = "capture", .type = DRIFT_GFX_TEXTURE_2D_ARRAY, .format = DRIFT_GFX_TEXTURE_FORMAT_RGBA16F, .layers = 2, .render_target = true,
+	});
+	DriftGfxSampler* sampler = driver.new_sampler(&driver, (DriftGfxSamplerOptions){
+		.mag_filter = DRIFT_GFX_FILTER_LINEAR, .address_x = DRIFT_GFX_ADDRESS_MODE_REPEAT,
+	});
+	DriftGfxRenderTarget* rt = driver.new_target(&driver, (DriftGfxRenderTargetOptions){
+		.name = "capture", .load = DRIFT_GFX_LOAD_ACTION_CLEAR, .store = DRIFT_GFX_STORE_ACTION_STORE, .bindings[0] = {texture, 1},
+	});
+	DriftGfxShaderDesc desc = {
+		.vertex[0] = {.type = DRIFT_GFX_TYPE_FLOAT16_4, .offset = 8, .instanced = true},
+		.instance_stride = 16, .uniform[0] = "Globals", .sampler[1] = "Sampler", .texture[2] = "Texture",
+	};
+	DriftGfxShader* shader = driver.load_shader(&driver, "capture", &desc);
+	DriftGfxPipeline* pipeline = driver.new_pipeline(&driver, (DriftGfxPipelineOptions){
+		.shader = shader, .target = rt, .blend = &DriftGfxBlendModeAdd, .cull_mode = DRIFT_GFX_CULL_MODE_BACK,
+	});
+	
+	size_t mem_size = 1024*1024;
+	void* mem_buffer = DriftAlloc(DriftSystemMem, mem_size);
+	const char* filename = "unit_test_gfx_capture.gfxcap";
+	
+	DriftGfxRenderer* renderer = DriftNullRendererNew();
+	DriftGfxRendererPrepare(renderer, (DriftVec2){640, 360}, DriftLinearMemMake(mem_buffer, mem_size/2, "gfx capture"));
+	fill_capture_frame(renderer, rt, pipeline, sampler, texture);
+	DRIFT_ASSERT(renderer->streams[DRIFT_GFX_STREAM_VERTEX].page_count > 0, "Frame didn't overflow.");
+	u64 t0 = DriftTimeNanos();
+	DRIFT_ASSERT_HARD(DriftGfxCaptureWrite(renderer, filename), "Failed to write capture.");
+	u64 write_nanos = DriftTimeNanos() - t0;
+	
+	DriftGfxCapture* capture = DriftGfxCaptureLoad(filename, &driver);
+	DRIFT_ASSERT_HARD(capture, "Failed to load capture.");
+	DriftGfxRenderer* replay = DriftNullRendererNew();
+	DriftGfxRendererPrepare(replay, (DriftVec2){640, 360}, DriftLinearMemMake((u8*)mem_buffer + mem_size/2, mem_size/2, "gfx replay"));
+	t0 = DriftTimeNanos();
+	DriftGfxCapturePush(capture, replay);
+	u64 push_nanos = DriftTimeNanos() - t0;
+	
+	// Commands should match apart from the replay using its own copies of the resources.
+	const DriftGfxCommand* a = renderer->first_command;
+	const DriftGfxCommand* b = replay->first_command;
+	uint command_count = 0;
+	for(; a && b; a = a->next, b = b->next, command_count++){
+		DRIFT_ASSERT_HARD(a->type == b->type, "Command %u type mismatch.", command_count);
+		switch(a->type){
+			case DRIFT_GFX_COMMAND_TARGET: {
+				const DriftGfxCommandTarget* ta = (DriftGfxCommandTarget*)a, * tb = (DriftGfxCommandTarget*)b;
+				DRIFT_ASSERT_HARD((ta->rt == NULL) == (tb->rt == NULL), "Target mismatch.");
+				if(ta->rt){
+					DRIFT_ASSERT_HARD(strcmp(ta->rt->options.name, tb->rt->options.name) == 0 && ta->rt->load == tb->rt->load, "Target mismatch.");
+					DRIFT_ASSERT_HARD(tb->rt->options.bindings[0].layer == 1 && tb->rt->framebuffer_size.x == 64, "Target binding mismatch.");
+				}
+				DRIFT_ASSERT_HARD(memcmp(&ta->clear_color, &tb->clear_color, sizeof(ta->clear_color)) == 0, "Clear color mismatch.");
+			} break;
+			case DRIFT_GFX_COMMAND_SCISSOR: {
+				const DriftGfxCommandScissor* sa = (DriftGfxCommandScissor*)a, * sb = (DriftGfxCommandScissor*)b;
+				DRIFT_ASSERT_HARD(memcmp(&sa->bounds, &sb->bounds, sizeof(sa->bounds)) == 0, "Scissor mismatch.");
+			} break;
+			case DRIFT_GFX_COMMAND_PIPELINE: {
+				const DriftGfxCommandPipeline* pa = (DriftGfxCommandPipeline*)a, * pb = (DriftGfxCommandPipeline*)b;
+				const DriftGfxPipelineOptions* options = &pb->pipeline->options;
+				DRIFT_ASSERT_HARD(options->cull_mode == DRIFT_GFX_CULL_MODE_BACK && memcmp(options->blend, &DriftGfxBlendModeAdd, sizeof(DriftGfxBlendMode)) == 0, "Pipeline mismatch.");
+				DRIFT_ASSERT_HARD(strcmp(options->shader->name, "capture") == 0 && memcmp(options->shader->desc->vertex, desc.vertex, sizeof(desc.vertex)) == 0, "Shader mismatch.");
+				DRIFT_ASSERT_HARD(strcmp(options->shader->desc->texture[2], "Texture") == 0 && options->shader->desc->texture[0] == NULL, "Shader mismatch.");
+				
+				const DriftGfxPipelineBindings* ba = pa->bindings, * bb = pb->bindings;
+				DRIFT_ASSERT_HARD(memcmp(&ba->instance, &bb->instance, sizeof(ba->instance)) == 0, "Instance binding mismatch.");
+				DRIFT_ASSERT_HARD(memcmp(ba->uniforms, bb->uniforms, sizeof(ba->uniforms)) == 0, "Uniform binding mismatch.");
+				DRIFT_ASSERT_HARD(memcmp(&bb->samplers[1]->options, &sampler->options, sizeof(sampler->options)) == 0 && bb->samplers[0] == NULL, "Sampler mismatch.");
+				DRIFT_ASSERT_HARD((ba->textures[2] == NULL) == (bb->textures[2] == NULL), "Texture mismatch.");
+				if(bb->textures[2]) DRIFT_ASSERT_HARD(bb->textures[2]->width == 64 && bb->textures[2]->options.layers == 2, "Texture mismatch.");
+				DRIFT_ASSERT_HARD(memcmp(&ba->blend_color, &bb->blend_color, sizeof(ba->blend_color)) == 0, "Blend color mismatch.");
+			} break;
+			case DRIFT_GFX_COMMAND_DRAW: {
+				const DriftGfxCommandDraw* da = (DriftGfxCommandDraw*)a, * db = (DriftGfxCommandDraw*)b;
+				DRIFT_ASSERT_HARD(memcmp(&da->index_binding, &db->index_binding, sizeof(da->index_binding)) == 0, "Index binding mismatch.");
+				DRIFT_ASSERT_HARD(da->index_count == db->index_count && da->instance_count == db->instance_count, "Draw mismatch.");
+			} break;
+			default: DRIFT_ABORT("Invalid command type %d.", a->type);
+		}
+	}
+	DRIFT_ASSERT_HARD(a == NULL && b == NULL, "Command count mismatch.");
+	
+	// Presenting copies the overflow pages into the grown buffers where they can be compared.
+	DriftNullRendererPresent(renderer);
+	DriftNullRendererPresent(replay);
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++){
+		DriftGfxStream* sa = renderer->streams + i, * sb = replay->streams + i;
+		DRIFT_ASSERT_HARD(sa->cursor == sb->cursor, "Stream %u size mismatch.", i);
+		DRIFT_ASSERT_HARD(memcmp(sa->ptr, sb->ptr, sa->cursor) == 0, "Stream %u data mismatch.", i);
+	}
+	DRIFT_LOG("Gfx capture: %u commands written in %.2f ms, replay pushed in %.2f ms.", command_count, write_nanos/1e6, push_nanos/1e6);
+	
+	remove(filename);
+	DriftGfxCaptureFree(capture);
+	// The second call releases the shaders and samplers the first one parked.
+	DriftNullFreeAll(&driver);
+	DriftNullFreeAll(&driver);
+	DriftMapDestroy(&ctx.destructors);
+	DriftGfxObjectCacheDestroy(&ctx.cache);
+	
+	// Reset to drop the overflow pages before freeing the buffers.
+	DriftGfxRenderer* renderers[] = {renderer, replay};
+	for(uint i = 0; i < 2; i++){
+		DriftGfxRendererPrepare(renderers[i], (DriftVec2){640, 360}, DriftLinearMemMake(mem_buffer, mem_size, "gfx capture"));
+		for(uint j = 0; j < _DRIFT_GFX_STREAM_COUNT; j++) DriftDealloc(DriftSystemMem, renderers[i]->streams[j].ptr, renderers[i]->streams[j].capacity);
+		DriftDealloc(DriftSystemMem, renderers[i], sizeof(*renderers[i]));
+	}
+	DriftDealloc(DriftSystemMem, mem_buffer, mem_size);
+}
+// Request the same shaders, pipelines, and samplers repeatedly from the null driver and check they are shared.
+void unit_test_gfx_object_cache(void){
+	DriftNullGfxContext ctx = {};
+	DriftMapInit(&ctx.destructors, DriftSystemMem, "#NullDestructors", 0);
+	DriftGfxObjectCacheInit(&ctx.cache);
+	DriftGfxDriver driver = {
+		.ctx = &ctx,
+		.load_shader = DriftNullShaderLoad,
+		.new_pipeline = DriftNullPipelineNew,
+		.new_sampler = DriftNullSamplerNew,
+		.new_texture = DriftNullTextureNew,
+		.new_target = DriftNullRenderTargetNew,
+		.load_texture_layer = DriftNullLoadTextureLayer,
+		.free_objects = DriftNullFreeObjects,
+		.free_all = DriftNullFreeAll,
+	};
+	
+	// Descs are compared by contents, not by pointer.
+	static const DriftGfxShaderDesc desc = {.uniform[0] = "Globals"};
+	char uniform_copy[] = "Globals";
+	DriftGfxShaderDesc desc_copy = {.uniform[0] = uniform_copy};
+	DRIFT_ASSERT_HARD(driver.load_shader(&driver, "cache0", &desc) == driver.load_shader(&driver, "cache0", &desc_copy), "Shader was not shared.");
+	DRIFT_ASSERT_HARD(driver.load_shader(&driver, "cache0", &desc) != driver.load_shader(&driver, "cache0", &(DriftGfxShaderDesc){}), "Different shaders were shared.");
+	
+	const char* names[] = {"cache0", "cache1", "cache2", "cache3"};
+	DriftGfxTexture* texture = driver.new_texture(&driver, 64, 64, (DriftGfxTextureOptions){.render_target = true});
+	DriftGfxRenderTarget* targets[2];
+	for(uint i = 0; i < 2; i++) targets[i] = driver.new_target(&driver, (DriftGfxRenderTargetOptions){.bindings[0].texture = texture});
+	
+	// Same contents as the shared blend mode, but a different pointer.
+	DriftGfxBlendMode add_copy = DriftGfxBlendModeAdd;
+	const DriftGfxBlendMode* blends[] = {NULL, &DriftGfxBlendModeAlpha, &DriftGfxBlendModeAdd, &add_copy};
+	
+	// Load the shader and make the pipeline together like DriftDrawSharedNew() does, a few times over.
+	uint rounds = 8, unique = 4*2*3;
+	DriftGfxPipeline* first[4][2][4] = {};
+	u64 t0 = DriftTimeNanos();
+	for(uint round = 0; round < rounds; round++){
+		for(uint s = 0; s < 4; s++) for(uint t = 0; t < 2; t++) for(uint b = 0; b < 4; b++){
+			DriftGfxShader* shader = driver.load_shader(&driver, names[s], &desc);
+			DriftGfxPipeline* pipeline = driver.new_pipeline(&driver, (DriftGfxPipelineOptions){.shader = shader, .target = targets[t], .blend = blends[b]});
+			if(round == 0) first[s][t][b] = pipeline;
+			DRIFT_ASSERT_HARD(pipeline == first[s][t][b], "Pipeline was not shared.");
+		}
+	}
+	u64 pipeline_nanos = DriftTimeNanos() - t0;
+	DRIFT_ASSERT_HARD(ctx.cache.shaders.table.row_count == 5, "Expected 5 unique shaders, got %u.", (uint)ctx.cache.shaders.table.row_count);
+	DRIFT_ASSERT_HARD(ctx.cache.pipelines.table.row_count == unique, "Expected %u unique pipelines, got %u.", unique, (uint)ctx.cache.pipelines.table.row_count);
+	DRIFT_ASSERT_HARD(first[0][0][2] == first[0][0][3], "Equal blend modes weren't shared.");
+	DRIFT_ASSERT_HARD(first[0][0][2] != first[1][0][2] && first[0][0][2] != first[0][1][2], "Different pipelines were shared.");
+	
+	DriftGfxSampler* linear = driver.new_sampler(&driver, (DriftGfxSamplerOptions){.min_filter = DRIFT_GFX_FILTER_LINEAR});
+	DRIFT_ASSERT_HARD(linear == driver.new_sampler(&driver, (DriftGfxSamplerOptions){.min_filter = DRIFT_GFX_FILTER_LINEAR}), "Sampler was not shared.");
+	DriftGfxSampler* nearest = driver.new_sampler(&driver, (DriftGfxSamplerOptions){});
+	DRIFT_ASSERT_HARD(linear != nearest, "Different samplers were shared.");
+	
+	uint hits = ctx.cache.hits, misses = ctx.cache.misses;
+	DRIFT_ASSERT_HARD(misses == 2 + 3 + unique + 2, "Unexpected cache misses. (%u)", misses);
+	
+	// Freeing a shared object only drops one holder.
+	driver.free_objects(&driver, (void*[]){linear}, 1);
+	DRIFT_ASSERT_HARD(DriftMapFind(&ctx.destructors, (uintptr_t)linear), "Shared sampler was destroyed.");
+	DRIFT_ASSERT_HARD(linear == driver.new_sampler(&driver, (DriftGfxSamplerOptions){.min_filter = DRIFT_GFX_FILTER_LINEAR}), "Sampler was not shared.");
+	driver.free_objects(&driver, (void*[]){nearest}, 1);
+	DRIFT_ASSERT_HARD(DriftMapFind(&ctx.destructors, (uintptr_t)nearest) == 0, "Sampler wasn't destroyed by its last holder.");
+	
+	// Freeing a target drops the pipelines that used it, so a new target at the same address can't pick them up.
+	DriftGfxPipeline* stale = first[0][1][1];
+	driver.free_objects(&driver, (void*[]){targets[1]}, 1);
+	targets[1] = driver.new_target(&driver, (DriftGfxRenderTargetOptions){.bindings[0].texture = texture});
+	DriftGfxPipeline* fresh = driver.new_pipeline(&driver, (DriftGfxPipelineOptions){.shader = driver.load_shader(&driver, names[0], &desc), .target = targets[1], .blend = blends[1]});
+	DRIFT_ASSERT_HARD(fresh != stale, "Pipeline for a freed target was reused.");
+	DRIFT_ASSERT_HARD(ctx.cache.pipelines.table.row_count == unique/2 + 1, "Pipelines weren't evicted. (%u)", (uint)ctx.cache.pipelines.table.row_count);
+	DRIFT_ASSERT_HARD(DriftMapFind(&ctx.destructors, (uintptr_t)stale), "Evicted pipeline was destroyed while still held.");
+	
+	// Shaders and samplers are parked across a hotload and picked back up, everything else is recreated.
+	DriftGfxShader* shader = driver.load_shader(&driver, names[1], &desc);
+	DriftNullFreeAll(&driver);
+	DRIFT_ASSERT_HARD(ctx.cache.pipelines.table.row_count == 0, "Pipelines weren't cleared.");
+	DRIFT_ASSERT_HARD(shader == driver.load_shader(&driver, names[1], &desc_copy), "Shader wasn't kept across a hotload.");
+	DRIFT_ASSERT_HARD(linear == driver.new_sampler(&driver, (DriftGfxSamplerOptions){.min_filter = DRIFT_GFX_FILTER_LINEAR}), "Sampler wasn't kept across a hotload.");
+	
+	// Parked objects that weren't picked up are destroyed by the next one.
+	DriftNullFreeAll(&driver);
+	DRIFT_ASSERT_HARD(ctx.cache.shaders.table.row_count == 1 && ctx.cache.samplers.table.row_count == 1, "Unused objects weren't released.");
+	DriftNullFreeAll(&driver);
+	DRIFT_ASSERT_HARD(ctx.destructors.table.row_count == 0 && ctx.cache.entries.table.row_count == 0, "Cache wasn't cleared.");
+	DriftGfxObjectCacheDestroy(&ctx.cache);
+	DriftMapDestroy(&ctx.destructors);
+	
+	DRIFT_LOG("Gfx object cache: %u shader and pipeline requests in %.3f ms, %u created, %u hits.", 2*rounds*4*2*4, pipeline_nanos/1e6, misses, hits);
+}
+#endif
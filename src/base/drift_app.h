@@ -18,8 +18,16 @@ void DriftThrottledParallelFor(tina_job* job, tina_job_func func, void* user_dat
 void tina_scheduler_enqueue_n(tina_scheduler* sched, tina_job_func* func, void* user_data, uint count, unsigned queue_idx, tina_group* group);
 void DriftParallelFor(tina_job* job, tina_job_func func, void* user_data, uint count);
 
+typedef void DriftParallelRangeFunc(void* user_data, uint begin, uint end);
+// Call 'func' on chunks of [0, count) across the worker threads, including the calling job.
+// Chunks start large and shrink as the range runs out so idle workers keep splitting what's left between them.
+// Chunks are at least 'min_grain' items except for the last one, use it to amortize per chunk costs.
+void DriftParallelForRange(tina_job* job, DriftParallelRangeFunc* func, void* user_data, uint count, uint min_grain);
+
 #define DRIFT_APP_DEFAULT_SCREEN_W 1280
 #define DRIFT_APP_DEFAULT_SCREEN_H 720
+// Ten minutes of game time at the fixed tick rate.
+#define DRIFT_APP_DEFAULT_HEADLESS_TICKS (10*60*60)
 
 typedef struct DriftApp DriftApp;
 extern DriftApp* APP;
@@ -82,11 +90,42 @@ struct DriftApp {
 	void* shell_window;
 	void* shell_context;
 	bool fullscreen, no_splash;
+	// Upload sprite and light instances at full float precision for comparison.
+	bool unpacked_instances;
+	
+	// Options for running the simulation without a window.
+	struct {
+		uint ticks;
+		u64 seed;
+		bool draw;
+		// Spawn extra items and enemies around the player to benchmark drawing.
+		uint draw_sprites;
+		// Run the draw systems one after another instead of as parallel jobs.
+		bool serial_draw;
+		// Replay file to simulate instead of an idle player.
+		const char* replay_filename;
+		// Capture the renderer commands of the last frame to this file. Not used when replaying.
+		const char* gfx_capture;
+		// Move the camera along a fixed path instead of following the player to benchmark terrain streaming.
+		bool camera_path;
+		// Keep the HUD and the crafting menu open to benchmark building the UI.
+		bool craft_ui;
+	} headless;
+	
+	// Replay a renderer capture to benchmark the driver instead of running the game.
+	struct {
+		const char* filename;
+		uint count;
+	} gfx_replay;
+	
+	// Record gameplay input to this file.
+	const char* record_filename;
 	
 	DriftAudioContext* audio;
 	
 	// Jobs.
 	tina_scheduler* scheduler;
+	uint worker_count;
 	
 	const DriftGfxDriver* gfx_driver;
 	
@@ -110,3 +149,6 @@ DriftGfxRenderer* DriftAppBeginFrame(DriftMem* mem);
 void DriftAppPresentFrame(DriftGfxRenderer* renderer);
 void DriftAppHaltScheduler(void);
 void DriftAppToggleFullscreen(void);
+
+// Entry function that replays and times 'APP->gfx_replay'.
+void DriftGfxReplayRun(tina_job* job);
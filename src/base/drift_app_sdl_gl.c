@@ -51,7 +51,7 @@ typedef struct {
 
 typedef struct {
 	DriftGfxRenderer base;
-	GLuint vertex_buffer, index_buffer, uniform_buffer;
+	GLuint buffers[_DRIFT_GFX_STREAM_COUNT];
 	GLsync fence;
 } DriftGLRenderer;
 
@@ -62,6 +62,7 @@ typedef struct {
 	SDL_GLContext* sync_context;
 	
 	DriftMap destructors;
+	DriftGfxObjectCache cache;
 	
 	DriftGLRenderer* renderers[DRIFT_GL_RENDERER_COUNT];
 	uint renderer_index;
@@ -116,6 +117,9 @@ static PFNGLGETSTRINGPROC _glGetString;
 static PFNGLGENVERTEXARRAYSPROC _glGenVertexArrays;
 static PFNGLGENBUFFERSPROC _glGenBuffers;
 static PFNGLBUFFERDATAPROC _glBufferData;
+static PFNGLBUFFERSUBDATAPROC _glBufferSubData;
+static PFNGLCOPYBUFFERSUBDATAPROC _glCopyBufferSubData;
+static PFNGLDELETEBUFFERSPROC _glDeleteBuffers;
 static PFNGLGETACTIVEUNIFORMBLOCKNAMEPROC _glGetActiveUniformBlockName;
 static PFNGLUNIFORMBLOCKBINDINGPROC _glUniformBlockBinding;
 static PFNGLGETUNIFORMBLOCKINDEXPROC _glGetUniformBlockIndex;
@@ -192,6 +196,9 @@ static void DriftLoadGL(void){
 	DRIFT_GL_LOAD_FUNC(glGenVertexArrays);
 	DRIFT_GL_LOAD_FUNC(glGenBuffers);
 	DRIFT_GL_LOAD_FUNC(glBufferData);
+	DRIFT_GL_LOAD_FUNC(glBufferSubData);
+	DRIFT_GL_LOAD_FUNC(glCopyBufferSubData);
+	DRIFT_GL_LOAD_FUNC(glDeleteBuffers);
 	DRIFT_GL_LOAD_FUNC(glGetActiveUniformBlockName);
 	DRIFT_GL_LOAD_FUNC(glUniformBlockBinding);
 	DRIFT_GL_LOAD_FUNC(glGetUniformBlockIndex);
@@ -338,6 +345,8 @@ static const struct {
 	[DRIFT_GFX_TYPE_FLOAT32_2] = {GL_FLOAT, 2},
 	[DRIFT_GFX_TYPE_FLOAT32_3] = {GL_FLOAT, 3},
 	[DRIFT_GFX_TYPE_FLOAT32_4] = {GL_FLOAT, 4},
+	[DRIFT_GFX_TYPE_FLOAT16_2] = {GL_HALF_FLOAT, 2},
+	[DRIFT_GFX_TYPE_FLOAT16_4] = {GL_HALF_FLOAT, 4},
 };
 
 static const GLenum DriftGfxBlendFactorToGL[] = {
@@ -365,10 +374,25 @@ static const GLenum DriftGfxBlendOpToGL[] = {
 
 #define BUFFER_ACCESS_WRITE (GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_FLUSH_EXPLICIT_BIT)
 
+static const GLenum DriftGLStreamTarget[] = {
+	[DRIFT_GFX_STREAM_VERTEX] = GL_ARRAY_BUFFER,
+	[DRIFT_GFX_STREAM_INDEX] = GL_ELEMENT_ARRAY_BUFFER,
+	[DRIFT_GFX_STREAM_UNIFORM] = GL_UNIFORM_BUFFER,
+};
+
 static void DriftGLRendererMapAndUnbindBuffers(DriftGLRenderer* renderer){
-	renderer->base.ptr.vertex = _glMapBufferRange(GL_ARRAY_BUFFER, 0, DRIFT_GFX_VERTEX_BUFFER_SIZE, BUFFER_ACCESS_WRITE);
-	renderer->base.ptr.index = _glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, DRIFT_GFX_INDEX_BUFFER_SIZE, BUFFER_ACCESS_WRITE);
-	renderer->base.ptr.uniform = _glMapBufferRange(GL_UNIFORM_BUFFER, 0, DRIFT_GFX_UNIFORM_BUFFER_SIZE, BUFFER_ACCESS_WRITE);
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++){
+		DriftGfxStream* stream = renderer->base.streams + i;
+		
+		// Resize the storage when recent frames have outgrown it or left it mostly empty.
+		size_t capacity = DriftGfxStreamNextCapacity(stream);
+		if(capacity != stream->capacity){
+			_glBufferData(DriftGLStreamTarget[i], capacity, NULL, GL_DYNAMIC_DRAW);
+			stream->capacity = capacity;
+		}
+		
+		stream->ptr = _glMapBufferRange(DriftGLStreamTarget[i], 0, stream->capacity, BUFFER_ACCESS_WRITE);
+	}
 	DRIFTGL_ASSERT_ERRORS();
 	
 	_glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -378,29 +402,52 @@ static void DriftGLRendererMapAndUnbindBuffers(DriftGLRenderer* renderer){
 }
 
 static void DriftGLBindBuffers(DriftGLRenderer *renderer, bool flush_and_unmap){
-	DriftGLRenderer* _renderer = (DriftGLRenderer*)renderer;
-	_glBindBuffer(GL_ARRAY_BUFFER, _renderer->vertex_buffer);
-	_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _renderer->index_buffer);
-	_glBindBuffer(GL_UNIFORM_BUFFER, _renderer->uniform_buffer);
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++) _glBindBuffer(DriftGLStreamTarget[i], renderer->buffers[i]);
 	DRIFTGL_ASSERT_ERRORS();
 	
 	if(flush_and_unmap){
-		_glFlushMappedBufferRange(GL_ARRAY_BUFFER, 0, DRIFT_GFX_VERTEX_BUFFER_SIZE);
-		_glFlushMappedBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, DRIFT_GFX_INDEX_BUFFER_SIZE);
-		_glFlushMappedBufferRange(GL_UNIFORM_BUFFER, 0, DRIFT_GFX_UNIFORM_BUFFER_SIZE);
-		_glUnmapBuffer(GL_ARRAY_BUFFER);
-		_glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
-		_glUnmapBuffer(GL_UNIFORM_BUFFER);
+		for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++){
+			DriftGfxStream* stream = renderer->base.streams + i;
+			_glFlushMappedBufferRange(DriftGLStreamTarget[i], 0, DRIFT_MIN(stream->cursor, stream->capacity));
+			_glUnmapBuffer(DriftGLStreamTarget[i]);
+		}
 		DRIFTGL_ASSERT_ERRORS();
 	}
 }
 
+// Replace a buffer the frame overflowed with a larger one, then upload the overflow pages into it.
+static void DriftGLGrowStream(DriftGLRenderer* renderer, DriftGfxStreamType type){
+	DriftGfxStream* stream = renderer->base.streams + type;
+	size_t capacity = DriftGfxStreamNextCapacity(stream);
+	
+	GLuint buffer;
+	_glGenBuffers(1, &buffer);
+	_glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	_glBufferData(GL_COPY_WRITE_BUFFER, capacity, NULL, GL_DYNAMIC_DRAW);
+	
+	_glBindBuffer(GL_COPY_READ_BUFFER, renderer->buffers[type]);
+	_glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, stream->pages[0].offset);
+	for(uint i = 0; i < stream->page_count; i++){
+		DriftGfxStreamPage* page = stream->pages + i;
+		_glBufferSubData(GL_COPY_WRITE_BUFFER, page->offset, DriftGfxStreamPageUsed(stream, page), page->ptr);
+	}
+	
+	_glDeleteBuffers(1, renderer->buffers + type);
+	renderer->buffers[type] = buffer;
+	stream->capacity = capacity;
+	_glBindBuffer(DriftGLStreamTarget[type], buffer);
+	DRIFTGL_ASSERT_ERRORS();
+}
+
 static void DriftGLRendererExecute(DriftGLRenderer* renderer){
 	DriftGLBindBuffers(renderer, true);
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++){
+		if(renderer->base.streams[i].page_count) DriftGLGrowStream(renderer, i);
+	}
 	
 	_glEnable(GL_SCISSOR_TEST);
 	DriftRendererExecuteCommands(&renderer->base);
-	((DriftGLRenderer*)renderer)->fence = _glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	renderer->fence = _glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 	
 	DriftGLRendererMapAndUnbindBuffers(renderer);
 }
@@ -542,7 +589,7 @@ static void DriftGLCommandBindPipeline(const DriftGfxRenderer* renderer, const D
 	DriftGLShader* shader = (DriftGLShader*)pipeline->options.shader;
 	const DriftGfxBufferBinding* uniforms = bindings->uniforms;
 	for(uint i = 0; i < DRIFT_GFX_UNIFORM_BINDING_COUNT; i++){
-		if(uniforms[i].size > 0) _glBindBufferRange(GL_UNIFORM_BUFFER, i, _renderer->uniform_buffer, uniforms[i].offset, uniforms[i].size);
+		if(uniforms[i].size > 0) _glBindBufferRange(GL_UNIFORM_BUFFER, i, _renderer->buffers[DRIFT_GFX_STREAM_UNIFORM], uniforms[i].offset, uniforms[i].size);
 	}
 	
 	DriftGLTexture** textures = (DriftGLTexture**)bindings->textures;
@@ -588,14 +635,14 @@ static DriftGLRenderer* DriftGLRendererNew(void){
 	_glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_align);
 	renderer->base.uniform_alignment = uniform_align;
 	
-	_glGenBuffers(1, &renderer->vertex_buffer);
-	_glGenBuffers(1, &renderer->index_buffer);
-	_glGenBuffers(1, &renderer->uniform_buffer);
+	_glGenBuffers(_DRIFT_GFX_STREAM_COUNT, renderer->buffers);
 	DriftGLBindBuffers(renderer, false);
 	
-	_glBufferData(GL_ARRAY_BUFFER, DRIFT_GFX_VERTEX_BUFFER_SIZE, NULL, GL_DYNAMIC_DRAW);
-	_glBufferData(GL_ELEMENT_ARRAY_BUFFER, DRIFT_GFX_INDEX_BUFFER_SIZE, NULL, GL_DYNAMIC_DRAW);
-	_glBufferData(GL_UNIFORM_BUFFER, DRIFT_GFX_UNIFORM_BUFFER_SIZE, NULL, GL_DYNAMIC_DRAW);
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++){
+		DriftGfxStream* stream = renderer->base.streams + i;
+		stream->capacity = stream->min_capacity;
+		_glBufferData(DriftGLStreamTarget[i], stream->capacity, NULL, GL_DYNAMIC_DRAW);
+	}
 	DRIFTGL_ASSERT_ERRORS();
 	
 	DriftGLRendererMapAndUnbindBuffers(renderer);
@@ -758,6 +805,10 @@ static void DriftGLSamplerFree(const DriftGfxDriver* driver, void* obj){
 
 static DriftGfxSampler* DriftGLSamplerNew(const DriftGfxDriver* driver, DriftGfxSamplerOptions options){
 	DriftAssertGfxThread();
+	DriftSDLGLContext* ctx = driver->ctx;
+	DriftGfxSampler* cached = DriftGfxCacheFindSampler(&ctx->cache, &options);
+	if(cached) return cached;
+	
 	GLuint id = 0; _glGenSamplers(1, &id);
 	_glSamplerParameteri(id, GL_TEXTURE_WRAP_S, TextureAddressMode[options.address_x]);
 	_glSamplerParameteri(id, GL_TEXTURE_WRAP_T, TextureAddressMode[options.address_y]);
@@ -766,10 +817,9 @@ static DriftGfxSampler* DriftGLSamplerNew(const DriftGfxDriver* driver, DriftGfx
 	_glSamplerParameteri(id, GL_TEXTURE_MAG_FILTER, TextureFilters[options.mag_filter][DRIFT_GFX_MIP_FILTER_NONE]);
 	DRIFTGL_ASSERT_ERRORS();
 	
-	DriftSDLGLContext* ctx = driver->ctx;
-	DriftGLSampler *sampler = DRIFT_COPY(DriftSystemMem, ((DriftGLSampler){.id = id}));
+	DriftGLSampler *sampler = DRIFT_COPY(DriftSystemMem, ((DriftGLSampler){.base.options = options, .id = id}));
 	DriftMapInsert(&ctx->destructors, (uintptr_t)sampler, (uintptr_t)DriftGLSamplerFree);
-	return &sampler->base;
+	return DriftGfxCacheAddSampler(&ctx->cache, &sampler->base);
 }
 
 static void DriftGLTextureFree(const DriftGfxDriver* driver, void* obj){
@@ -851,7 +901,7 @@ static DriftGfxRenderTarget* DriftGLRenderTargetNew(const DriftGfxDriver* driver
 	
 	DriftSDLGLContext* ctx = driver->ctx;
 	DriftGLRenderTarget* rt = DRIFT_COPY(DriftSystemMem, ((DriftGLRenderTarget){
-		.base = {.load = options.load, .store = options.store}, .id = id,
+		.base = {.options = options, .load = options.load, .store = options.store}, .id = id,
 	}));
 	
 	GLsizei buffer_count = 0;
@@ -892,30 +942,40 @@ static DriftGfxShader* DriftGLShaderLoad(const DriftGfxDriver* driver, const cha
 	DriftMem* mem = DriftLinearMemMake(buffer, sizeof(buffer), "Shader Mem");
 	DriftData vshader = DriftAssetLoadf(mem, "shaders/%s%s", name, ".vert");
 	DriftData fshader = DriftAssetLoadf(mem, "shaders/%s%s", name, ".frag");
-	return DriftGLShaderNew(driver, name, desc, vshader, fshader);
+	
+	DriftSDLGLContext* ctx = driver->ctx;
+	DriftData sources[] = {vshader, fshader};
+	DriftGfxShader* shader = DriftGfxCacheFindShader(&ctx->cache, name, desc, sources, 2);
+	if(shader) return shader;
+	
+	shader = DriftGLShaderNew(driver, name, desc, vshader, fshader);
+	return DriftGfxCacheAddShader(&ctx->cache, shader, sources, 2);
 }
 
 static void DriftGLPipelineFree(const DriftGfxDriver* driver, void* obj){}
 
 static DriftGfxPipeline* DriftGLPipelineNew(const DriftGfxDriver* driver, DriftGfxPipelineOptions options){
 	DriftSDLGLContext* ctx = driver->ctx;
-	DriftGfxPipeline* pipeline = DRIFT_COPY(DriftSystemMem, ((DriftGfxPipeline){.options = options}));
+	DriftGfxPipeline* pipeline = DriftGfxCacheFindPipeline(&ctx->cache, &options);
+	if(pipeline) return pipeline;
+	
+	pipeline = DRIFT_COPY(DriftSystemMem, ((DriftGfxPipeline){.options = options}));
 	DriftMapInsert(&ctx->destructors, (uintptr_t)pipeline, (uintptr_t)DriftGLPipelineFree);
-	return pipeline;
+	return DriftGfxCacheAddPipeline(&ctx->cache, pipeline);
 }
 
 static void DriftGLFreeObjects(const DriftGfxDriver* driver, void* obj[], uint count){
 	DriftAssertGfxThread();
 	
 	DriftSDLGLContext* ctx = driver->ctx;
-	DriftGfxFreeObjects(driver, &ctx->destructors, obj, count);
+	DriftGfxFreeObjects(driver, &ctx->destructors, &ctx->cache, obj, count);
 }
 
 static void DriftGLFreeAll(const DriftGfxDriver* driver){
 	DriftAssertGfxThread();
 	
 	DriftSDLGLContext* ctx = driver->ctx;
-	DriftGfxFreeAll(driver, &ctx->destructors);
+	DriftGfxFreeAll(driver, &ctx->destructors, &ctx->cache);
 }
 
 static void DriftSDLGLInitContext(tina_job* job){
@@ -938,6 +998,7 @@ static void DriftSDLGLInitContext(tina_job* job){
 	_glBindVertexArray(vao);
 	
 	DriftMapInit(&ctx->destructors, DriftSystemMem, "#GLDestructors", 0);
+	DriftGfxObjectCacheInit(&ctx->cache);
 	
 	for(uint i = 0; i < DRIFT_GL_RENDERER_COUNT; i++) ctx->renderers[i] = DriftGLRendererNew();
 }
@@ -31,6 +31,7 @@ static const u32 REQUIRED_EXTENSIONS_COUNT = sizeof(REQUIRED_EXTENSIONS)/sizeof(
 #define DRIFT_VK_STAGING_JOB_COUNT 32
 #define MAX_SWAP_CHAIN_IMAGE_COUNT 8
 #define DRIFT_VK_RENDERER_COUNT 4
+#define DRIFT_VK_PIPELINE_CACHE_FILENAME "pipelines.bin"
 
 typedef struct {
 	int graphics_idx;
@@ -74,7 +75,13 @@ typedef struct {
 	VkQueue graphics_queue, present_queue;
 	VkRenderPass render_pass;
 	
+	// Compiled pipelines are saved to disk between runs so the driver can skip most of the work.
+	VkPipelineCache pipeline_cache;
+	uint pipeline_count;
+	u64 pipeline_nanos;
+	
 	DriftMap destructors;
+	DriftGfxObjectCache cache;
 	VkDebugUtilsMessengerEXT messenger;
 	
 	DriftVkSwapChain swap_chain;
@@ -130,7 +137,9 @@ struct DriftVkRenderer {
 	DriftVkContext* ctx;
 	VkRenderPass current_pass;
 	
+	// Vertex, index and uniform streams are packed back to back into one buffer.
 	DriftVkBuffer buffer;
+	size_t stream_offset[_DRIFT_GFX_STREAM_COUNT];
 	VkDescriptorPool descriptor_pool;
 	VkCommandBuffer command_buffer;
 	VkFence command_fence;
@@ -439,8 +448,8 @@ static void DriftVkRendererBindPipeline(const DriftGfxRenderer* renderer, const
 	for(uint i = 0; i < DRIFT_GFX_UNIFORM_BINDING_COUNT; i++){
 		DriftGfxBufferBinding uniform = bindings->uniforms[i];
 		if(uniform.size){
-			const size_t UNIFORMS_OFFSET = DRIFT_GFX_VERTEX_BUFFER_SIZE + DRIFT_GFX_INDEX_BUFFER_SIZE;
-			buffer_infos[i] = (VkDescriptorBufferInfo){.buffer = _renderer->buffer.buffer, .offset = uniform.offset + UNIFORMS_OFFSET, .range = uniform.size},
+			size_t uniforms_offset = _renderer->stream_offset[DRIFT_GFX_STREAM_UNIFORM];
+			buffer_infos[i] = (VkDescriptorBufferInfo){.buffer = _renderer->buffer.buffer, .offset = uniform.offset + uniforms_offset, .range = uniform.size},
 			cursor = PushDescriptor(cursor, set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, i, buffer_infos + i);
 		}
 	}
@@ -467,7 +476,8 @@ static void DriftVkRendererBindPipeline(const DriftGfxRenderer* renderer, const
 	vkCmdBindDescriptorSets(_renderer->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline->pipeline_layout, 0, 1, &set, 0, NULL);
 	
 	VkBuffer vbuffer = _renderer->buffer.buffer;
-	vkCmdBindVertexBuffers(_renderer->command_buffer, 0, 2, (VkBuffer[]){vbuffer, vbuffer}, (u64[]){bindings->vertex.offset, bindings->instance.offset});
+	size_t vertex_offset = _renderer->stream_offset[DRIFT_GFX_STREAM_VERTEX];
+	vkCmdBindVertexBuffers(_renderer->command_buffer, 0, 2, (VkBuffer[]){vbuffer, vbuffer}, (u64[]){bindings->vertex.offset + vertex_offset, bindings->instance.offset + vertex_offset});
 	
 	const DriftGfxBlendMode* blend = _pipeline->base.options.blend;
 	if(blend && blend->enable_blend_color) vkCmdSetBlendConstants(_renderer->command_buffer, (float*)&bindings->blend_color);
@@ -479,7 +489,7 @@ static void DriftVkRendererDrawIndexed(const DriftGfxRenderer* renderer, const D
 	DriftVkRenderer* _renderer = (DriftVkRenderer*)renderer;
 	DriftGfxCommandDraw* _command = (DriftGfxCommandDraw*)command;
 	
-	vkCmdBindIndexBuffer(_renderer->command_buffer, _renderer->buffer.buffer, _command->index_binding.offset + DRIFT_GFX_VERTEX_BUFFER_SIZE, VK_INDEX_TYPE_UINT16);
+	vkCmdBindIndexBuffer(_renderer->command_buffer, _renderer->buffer.buffer, _command->index_binding.offset + _renderer->stream_offset[DRIFT_GFX_STREAM_INDEX], VK_INDEX_TYPE_UINT16);
 	vkCmdDrawIndexed(_renderer->command_buffer, _command->index_count, _command->instance_count, 0, 0, 0);
 }
 
@@ -523,9 +533,101 @@ static DriftVkBuffer DriftVkCreateBuffer(DriftVkContext* ctx, VkBufferUsageFlags
 	return buffer;
 }
 
+// Recreate the renderer's buffer with each stream sized for its next frame.
+// Only safe once the renderer's fence has been waited on and before its commands are recorded.
+static void DriftVkRendererResizeBuffer(DriftVkRenderer* renderer, bool copy_frame){
+	DriftVkContext* ctx = renderer->ctx;
+	size_t capacity[_DRIFT_GFX_STREAM_COUNT], offset[_DRIFT_GFX_STREAM_COUNT], buffer_size = 0;
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++){
+		offset[i] = buffer_size;
+		capacity[i] = DriftGfxStreamNextCapacity(renderer->base.streams + i);
+		buffer_size += capacity[i];
+	}
+	
+	VkBufferUsageFlags render_buffer_usage_flags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+	DriftVkBuffer buffer = DriftVkCreateBuffer(ctx, render_buffer_usage_flags, buffer_size, "RendererBuffer");
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++){
+		DriftGfxStream* stream = renderer->base.streams + i;
+		u8* ptr = (u8*)buffer.ptr + offset[i];
+		
+		if(copy_frame){
+			// Move over what was written before the frame overflowed, then the overflow pages.
+			memcpy(ptr, stream->ptr, DRIFT_MIN(stream->cursor, stream->capacity));
+			for(uint j = 0; j < stream->page_count; j++){
+				DriftGfxStreamPage* page = stream->pages + j;
+				memcpy(ptr + page->offset, page->ptr, DriftGfxStreamPageUsed(stream, page));
+			}
+		}
+		
+		stream->ptr = ptr;
+		stream->capacity = capacity[i];
+		renderer->stream_offset[i] = offset[i];
+	}
+	
+	if(renderer->buffer.buffer){
+		vkDestroyBuffer(ctx->device, renderer->buffer.buffer, NULL);
+		vkFreeMemory(ctx->device, renderer->buffer.memory, NULL);
+	}
+	renderer->buffer = buffer;
+}
+
+static void DriftVkPipelineCacheIO(DriftIO* io){
+	DriftData* data = io->user_ptr;
+	u64 size = data->size;
+	DriftIOBlock(io, "size", &size, sizeof(size));
+	if(io->read) data->ptr = DriftAlloc(DriftSystemMem, data->size = size);
+	DriftIOBlock(io, "data", data->ptr, data->size);
+}
+
+static void DriftVkLoadPipelineCache(DriftVkContext* ctx){
+	DriftData data = {};
+	if(DriftIOSnapshotRead(DRIFT_VK_PIPELINE_CACHE_FILENAME, DriftVkPipelineCacheIO, &data)){
+		// Drivers are supposed to reject data from other devices, but not all of them do.
+		const VkPipelineCacheHeaderVersionOne* header = data.ptr;
+		const VkPhysicalDeviceProperties* props = &ctx->physical_properties;
+		bool valid = data.size >= sizeof(*header) && header->headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+		valid = valid && header->vendorID == props->vendorID && header->deviceID == props->deviceID;
+		valid = valid && memcmp(header->pipelineCacheUUID, props->pipelineCacheUUID, VK_UUID_SIZE) == 0;
+		if(valid){
+			DRIFT_LOG("Loaded Vulkan pipeline cache. (%d KB)", (int)(data.size/1024));
+		} else {
+			DRIFT_LOG("Ignoring Vulkan pipeline cache from a different device or driver.");
+			DriftDealloc(DriftSystemMem, data.ptr, data.size);
+			data = (DriftData){};
+		}
+	}
+	
+	VkResult result = vkCreatePipelineCache(ctx->device, &(VkPipelineCacheCreateInfo){
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+		.pInitialData = data.ptr, .initialDataSize = data.size,
+	}, NULL, &ctx->pipeline_cache);
+	AssertSuccess(result, "Failed to create Vulkan pipeline cache.");
+	if(data.ptr) DriftDealloc(DriftSystemMem, data.ptr, data.size);
+}
+
+static void DriftVkSavePipelineCache(DriftVkContext* ctx){
+	DRIFT_LOG("Vulkan: created %u pipelines in %.2f ms.", ctx->pipeline_count, ctx->pipeline_nanos/1e6);
+	
+	size_t size = 0;
+	VkResult result = vkGetPipelineCacheData(ctx->device, ctx->pipeline_cache, &size, NULL);
+	if(result == VK_SUCCESS && size > 0){
+		DriftData data = {.ptr = DriftAlloc(DriftSystemMem, size), .size = size};
+		result = vkGetPipelineCacheData(ctx->device, ctx->pipeline_cache, &data.size, data.ptr);
+		if(result == VK_SUCCESS){
+			DriftData snapshot = DriftIOSnapshot(DriftSystemMem, DriftVkPipelineCacheIO, &data);
+			DriftIOSnapshotWrite(DRIFT_VK_PIPELINE_CACHE_FILENAME, snapshot);
+			DriftDealloc(DriftSystemMem, snapshot.ptr, snapshot.size);
+		}
+		DriftDealloc(DriftSystemMem, data.ptr, size);
+	}
+	
+	vkDestroyPipelineCache(ctx->device, ctx->pipeline_cache, NULL);
+}
+
 static DriftVkContext* DriftVkCreateContext(void){
 	DriftVkContext* ctx = DRIFT_COPY(DriftSystemMem, ((DriftVkContext){}));
 	DriftMapInit(&ctx->destructors, DriftSystemMem, "#VKDestructors", 0);
+	DriftGfxObjectCacheInit(&ctx->cache);
 	
 	u32 extensions_count;
 	bool success = SDL_Vulkan_GetInstanceExtensions(APP->shell_window, &extensions_count, NULL);
@@ -625,6 +727,8 @@ static DriftVkContext* DriftVkCreateContext(void){
 	}, NULL, &ctx->command_pool);
 	AssertSuccess(result, "Failed to create Vulkan command buffer.");
 	
+	DriftVkLoadPipelineCache(ctx);
+	
 	VkBufferUsageFlags staging_buffer_usage_flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 	ctx->staging.buffer = DriftVkCreateBuffer(ctx, staging_buffer_usage_flags, DRIFT_VK_STAGING_BUFFER_SIZE, "StagingBuffer");
 	for(uint i = 0; i < DRIFT_VK_STAGING_JOB_COUNT; i++){
@@ -650,13 +754,8 @@ static DriftVkContext* DriftVkCreateContext(void){
 			.draw_indexed = DriftVkRendererDrawIndexed,
 		});
 		renderer->ctx = ctx;
-		
-		size_t buffer_size = DRIFT_GFX_VERTEX_BUFFER_SIZE + DRIFT_GFX_INDEX_BUFFER_SIZE + DRIFT_GFX_UNIFORM_BUFFER_SIZE;
-		VkBufferUsageFlags render_buffer_usage_flags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-		renderer->buffer = DriftVkCreateBuffer(ctx, render_buffer_usage_flags, buffer_size, "RendererBuffer");
-		renderer->base.ptr.vertex = renderer->buffer.ptr;
-		renderer->base.ptr.index = renderer->buffer.ptr + DRIFT_GFX_VERTEX_BUFFER_SIZE;
-		renderer->base.ptr.uniform = renderer->buffer.ptr + DRIFT_GFX_VERTEX_BUFFER_SIZE + DRIFT_GFX_INDEX_BUFFER_SIZE;
+		renderer->buffer = (DriftVkBuffer){};
+		DriftVkRendererResizeBuffer(renderer, false);
 		renderer->base.uniform_alignment = ctx->physical_properties.limits.minUniformBufferOffsetAlignment;
 		
 		uint draw_count = 1024;
@@ -694,6 +793,11 @@ static void DriftVkRendererExecute(DriftVkRenderer* renderer){
 	DriftVkContext* ctx = renderer->ctx;
 	VkResult result;
 	
+	// Grow the buffer if the frame overflowed it. The GPU finished with it before the frame began.
+	bool overflowed = false;
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++) overflowed |= renderer->base.streams[i].page_count > 0;
+	if(overflowed) DriftVkRendererResizeBuffer(renderer, true);
+	
 	result = vkResetDescriptorPool(ctx->device, renderer->descriptor_pool, 0);
 	AssertSuccess(result, "Failed to reset Vulkan descriptor pool.");
 	result = vkBeginCommandBuffer(renderer->command_buffer, &(VkCommandBufferBeginInfo){
@@ -753,8 +857,11 @@ static void DriftVkSamplerFree(const DriftGfxDriver* driver, void* obj){
 
 static DriftGfxSampler* DriftVkSamplerNew(const DriftGfxDriver* driver, DriftGfxSamplerOptions options){
 	DriftVkContext* ctx = driver->ctx;
-	DriftVkSampler* sampler = DRIFT_COPY(DriftSystemMem, ((DriftVkSampler){}));
 	DriftAssertGfxThread();
+	DriftGfxSampler* cached = DriftGfxCacheFindSampler(&ctx->cache, &options);
+	if(cached) return cached;
+	
+	DriftVkSampler* sampler = DRIFT_COPY(DriftSystemMem, ((DriftVkSampler){.base.options = options}));
 	
 	vkCreateSampler(ctx->device, &(VkSamplerCreateInfo){
 		.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
@@ -767,7 +874,7 @@ static DriftGfxSampler* DriftVkSamplerNew(const DriftGfxDriver* driver, DriftGfx
 	}, NULL, &sampler->sampler);
 	
 	DriftMapInsert(&ctx->destructors, (uintptr_t)sampler, (uintptr_t)DriftVkSamplerFree);
-	return &sampler->base;
+	return DriftGfxCacheAddSampler(&ctx->cache, &sampler->base);
 }
 
 static DriftVkStagingJob* DriftVkAquireStagingJob(DriftVkContext* ctx, size_t job_size){
@@ -945,11 +1052,7 @@ void DriftVkLoadTextureLayer(const DriftGfxDriver* driver, DriftGfxTexture* text
 	AssertSuccess(result, "Failed to commit Vulkan command buffer.");
 }
 
-static VkShaderModule DriftVkShaderModule(DriftVkContext* ctx, const char* shader_name, const char* extension){
-	u8 buffer[64*1024];
-	DriftMem* mem = DriftLinearMemMake(buffer, sizeof(buffer), "Shader Mem");
-	DriftData spirv = DriftAssetLoadf(mem, "shaders/%s%s", shader_name, extension);
-	
+static VkShaderModule DriftVkShaderModule(DriftVkContext* ctx, DriftData spirv){
 	VkShaderModule module;
 	VkResult result = vkCreateShaderModule(ctx->device, &(VkShaderModuleCreateInfo){
 		.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
@@ -971,15 +1074,27 @@ static DriftGfxShader* DriftVkShaderLoad(const DriftGfxDriver* driver, const cha
 	DriftVkContext* ctx = driver->ctx;
 	DriftAssertGfxThread();
 	
-	DriftVkShader* shader = DRIFT_COPY(DriftSystemMem, ((DriftVkShader){
-		.base.desc = desc,
-		.base.name = name,
-		.vshader = DriftVkShaderModule(ctx, name, ".vert.spv"),
-		.fshader = DriftVkShaderModule(ctx, name, ".frag.spv"),
-	}));
+	// Both modules don't reliably fit on a job's stack, so use the heap.
+	DriftData sources[] = {
+		DriftAssetLoadf(DriftSystemMem, "shaders/%s%s", name, ".vert.spv"),
+		DriftAssetLoadf(DriftSystemMem, "shaders/%s%s", name, ".frag.spv"),
+	};
 	
-	DriftMapInsert(&ctx->destructors, (uintptr_t)shader, (uintptr_t)DriftVkShaderFree);
-	return &shader->base;
+	DriftGfxShader* shader = DriftGfxCacheFindShader(&ctx->cache, name, desc, sources, 2);
+	if(shader == NULL){
+		DriftVkShader* vk_shader = DRIFT_COPY(DriftSystemMem, ((DriftVkShader){
+			.base.desc = desc,
+			.base.name = name,
+			.vshader = DriftVkShaderModule(ctx, sources[0]),
+			.fshader = DriftVkShaderModule(ctx, sources[1]),
+		}));
+		
+		DriftMapInsert(&ctx->destructors, (uintptr_t)vk_shader, (uintptr_t)DriftVkShaderFree);
+		shader = DriftGfxCacheAddShader(&ctx->cache, &vk_shader->base, sources, 2);
+	}
+	
+	for(uint i = 0; i < 2; i++) DriftDealloc(DriftSystemMem, sources[i].ptr, sources[i].size);
+	return shader;
 }
 
 
@@ -994,6 +1109,8 @@ VkFormat DriftGfxTypeMap[_DRIFT_GFX_TYPE_COUNT] = {
 	[DRIFT_GFX_TYPE_FLOAT32_2] = VK_FORMAT_R32G32_SFLOAT,
 	[DRIFT_GFX_TYPE_FLOAT32_3] = VK_FORMAT_R32G32B32_SFLOAT,
 	[DRIFT_GFX_TYPE_FLOAT32_4] = VK_FORMAT_R32G32B32A32_SFLOAT,
+	[DRIFT_GFX_TYPE_FLOAT16_2] = VK_FORMAT_R16G16_SFLOAT,
+	[DRIFT_GFX_TYPE_FLOAT16_4] = VK_FORMAT_R16G16B16A16_SFLOAT,
 };
 
 static const VkBlendFactor DriftGfxBlendFactorToVk[] = {
@@ -1037,7 +1154,10 @@ static void AddLayoutBindings(VkDescriptorSetLayoutBinding bindings[], uint* cou
 static DriftGfxPipeline* DriftVkPipelineNew(const DriftGfxDriver* driver, DriftGfxPipelineOptions options){
 	DriftVkContext* ctx = driver->ctx;
 	DriftAssertGfxThread();
+	DriftGfxPipeline* cached = DriftGfxCacheFindPipeline(&ctx->cache, &options);
+	if(cached) return cached;
 	
+	u64 start_nanos = DriftTimeNanos();
 	DriftVkPipeline* pipeline = DRIFT_COPY(DriftSystemMem, ((DriftVkPipeline){.base = {.options = options}}));
 	DriftVkShader* _shader = (DriftVkShader*)options.shader;
 	DriftVkRenderTarget* _target = (DriftVkRenderTarget*)options.target;
@@ -1155,7 +1275,7 @@ static DriftGfxPipeline* DriftVkPipelineNew(const DriftGfxDriver* driver, DriftG
 	AssertSuccess(result, "Failed to create Vulkan pipeline layout.");
 	NameObject(ctx, VK_OBJECT_TYPE_PIPELINE_LAYOUT, (u64)pipeline->pipeline_layout, "%s pipeline layout", options.shader->name);
 	
-	result = vkCreateGraphicsPipelines(ctx->device, VK_NULL_HANDLE, 1, &(VkGraphicsPipelineCreateInfo){
+	result = vkCreateGraphicsPipelines(ctx->device, ctx->pipeline_cache, 1, &(VkGraphicsPipelineCreateInfo){
 		.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
 		.pStages = shader_stages, .stageCount = 2,
 		.pInputAssemblyState = &input_assembly_info,
@@ -1171,8 +1291,11 @@ static DriftGfxPipeline* DriftVkPipelineNew(const DriftGfxDriver* driver, DriftG
 	AssertSuccess(result, "Failed to create Vulkan pipeline.");
 	NameObject(ctx, VK_OBJECT_TYPE_PIPELINE, (u64)pipeline->pipeline, "%s pipeline", options.shader->name);
 
+	ctx->pipeline_count++;
+	ctx->pipeline_nanos += DriftTimeNanos() - start_nanos;
+	
 	DriftMapInsert(&ctx->destructors, (uintptr_t)pipeline, (uintptr_t)DriftVkPipelineFree);
-	return &pipeline->base;
+	return DriftGfxCacheAddPipeline(&ctx->cache, &pipeline->base);
 }
 
 static void DriftVkRenderTargetFree(const DriftGfxDriver* driver, void* obj){
@@ -1203,7 +1326,7 @@ static DriftGfxRenderTarget* DriftVkRenderTargetNew(const DriftGfxDriver* driver
 	uint width = options.bindings[0].texture->width;
 	uint height = options.bindings[0].texture->height;
 	DriftVkRenderTarget *target = DRIFT_COPY(DriftSystemMem, ((DriftVkRenderTarget){
-		.base = {.load = options.load, .store = options.store, .framebuffer_size = {width, height}}
+		.base = {.options = options, .load = options.load, .store = options.store, .framebuffer_size = {width, height}}
 	}));
 	
 	VkAttachmentDescription attachments[DRIFT_GFX_RENDER_TARGET_COUNT] = {};
@@ -1272,13 +1395,13 @@ static void DriftVkFreeObjects(const DriftGfxDriver* driver, void* objects[], ui
 	DriftAssertGfxThread();
 	
 	vkDeviceWaitIdle(ctx->device);
-	DriftGfxFreeObjects(driver, &ctx->destructors, objects, count);
+	DriftGfxFreeObjects(driver, &ctx->destructors, &ctx->cache, objects, count);
 }
 
 static void DriftVkFreeAll(const DriftGfxDriver* driver){
 	DriftVkContext* ctx = driver->ctx;
 	vkDeviceWaitIdle(ctx->device);
-	DriftGfxFreeAll(driver, &ctx->destructors);
+	DriftGfxFreeAll(driver, &ctx->destructors, &ctx->cache);
 }
 
 static void DriftVKRecreateSwapChain(DriftVkContext* ctx, DriftVec2 fb_extent){
@@ -1398,6 +1521,8 @@ void* DriftShellSDLVk(DriftShellEvent event, void* shell_value){
 			// Free the user loaded objects.
 			DriftVkFreeAll(APP->gfx_driver);
 			DriftMapDestroy(&ctx->destructors);
+			DriftGfxObjectCacheDestroy(&ctx->cache);
+			DriftVkSavePipelineCache(ctx);
 			
 			vkDestroyCommandPool(device, ctx->command_pool, NULL);
 			vkDestroyBuffer(ctx->device, ctx->staging.buffer.buffer, NULL);
@@ -1444,6 +1569,14 @@ void* DriftShellSDLVk(DriftShellEvent event, void* shell_value){
 			AssertSuccess(result, "Failed to reset Vulkan fence.");
 			TracyCZoneEnd(ZONE_FENCE);
 			
+			// Resize the buffer when recent frames have outgrown it or left it mostly empty.
+			bool resize = false;
+			for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++){
+				DriftGfxStream* stream = renderer->base.streams + i;
+				resize |= DriftGfxStreamNextCapacity(stream) != stream->capacity;
+			}
+			if(resize) DriftVkRendererResizeBuffer(renderer, false);
+			
 			SDL_GetWindowPosition(APP->shell_window, &APP->window_x, &APP->window_y);
 			SDL_GetWindowSize(APP->shell_window, &APP->window_w, &APP->window_h);
 
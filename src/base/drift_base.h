@@ -12,6 +12,7 @@ You should have received a copy of the GNU General Public License along with Ver
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <stddef.h>
 #include <stdarg.h>
 
@@ -85,6 +86,8 @@ void DriftNameCopy(DriftName* dst, const char* src);
 #define DRIFT_NYI() {_DriftLog("[Abort] %s:%d\n\tReason: Not yet implemented.\n", __FILE__, __LINE__, ""); DriftAbort();}
 
 u64 DriftTimeNanos(void);
+// Peak resident memory of the process, or 0 if unknown.
+size_t DriftPeakMemoryBytes(void);
 
 typedef struct {
 	void* ptr;
@@ -97,6 +100,8 @@ typedef void DriftIOFunc(DriftIO* io);
 typedef struct DriftIO {
 	void* user_ptr;
 	bool read;
+	// Set by an io_func to stop reading a file it can't load, ex: an old version. The read then returns false.
+	bool abort;
 	
 	DriftIOFunc* _io_func;
 	tina* _coro;
@@ -108,6 +113,13 @@ bool DriftIOFileRead(const char* filename, DriftIOFunc* io_func, void* user_ptr)
 void DriftIOFileWrite(const char* filename, DriftIOFunc* io_func, void* user_ptr);
 size_t DriftIOSize(DriftIOFunc* io_func, void* user_ptr);
 
+// Copy all blocks into a single contiguous buffer allocated from 'mem'.
+DriftData DriftIOSnapshot(DriftMem* mem, DriftIOFunc* io_func, void* user_ptr);
+// Compress a snapshot and atomically replace 'filename' with it. Safe to call from a worker.
+bool DriftIOSnapshotWrite(const char* filename, DriftData snapshot);
+// Read a file written by DriftIOSnapshotWrite(). Returns false if it's missing, corrupt or truncated.
+bool DriftIOSnapshotRead(const char* filename, DriftIOFunc* io_func, void* user_ptr);
+
 void DriftAssetsReset(void);
 DriftData DriftAssetLoad(DriftMem* mem, const char* filename);
 DriftData DriftAssetLoadf(DriftMem* mem, const char* format, ...);
@@ -134,6 +146,14 @@ void DriftDealloc(DriftMem* mem, void* ptr, size_t size);
 
 extern DriftMem* const DriftSystemMem;
 
+// Reserve address space without backing memory, then commit and decommit ranges of it.
+// Sizes and offsets must be multiples of DRIFT_VIRTUAL_PAGE_SIZE.
+#define DRIFT_VIRTUAL_PAGE_SIZE (64*1024llu)
+void* DriftVirtualReserve(size_t size);
+void DriftVirtualRelease(void* ptr, size_t size);
+void DriftVirtualCommit(void* ptr, size_t size);
+void DriftVirtualDecommit(void* ptr, size_t size);
+
 DriftMem* DriftLinearMemMake(void* buffer, size_t capacity, const char* label);
 
 DriftMem* DriftListMemNew(DriftMem* parent_mem, const char* label);
@@ -142,12 +162,18 @@ void DriftListMemFree(DriftMem* mem);
 typedef struct DriftZoneMemHeap DriftZoneMemHeap;
 DriftZoneMemHeap* DriftZoneMemHeapNew(DriftMem* mem, const char* label);
 void DriftZoneMemHeapFree(DriftZoneMemHeap* heap);
+// Release pooled blocks beyond the peak usage since the previous trim back to the OS.
+// Safe to call while other threads are allocating. Returns the number of blocks released.
+uint DriftZoneMemHeapTrim(DriftZoneMemHeap* heap);
 
 typedef struct {
 	uint blocks_allocated, blocks_used;
 	uint zones_allocated, zones_used;
+	// High-water marks, and the number of blocks returned to the OS by DriftZoneMemHeapTrim().
+	uint blocks_peak, zones_peak, blocks_released;
 	
 	const char* zone_names[64];
+	uint zone_blocks[64];
 } DriftZoneHeapInfo;
 
 DriftZoneHeapInfo DriftZoneHeapGetInfo(DriftZoneMemHeap* heap);
@@ -217,6 +243,53 @@ uint DriftGetThreadID(void);
 void DriftAssertMainThread(void);
 void DriftAssertGfxThread(void);
 
+// Profiler
+
+// Lightweight always available profiler, independent of Tracy.
+// Zones are recorded into per-thread ring buffers and collected by DriftProfileFrameMark().
+// Zones may span a job yield, they are attributed to the thread they began on.
+// Measured overhead (x86-64 Linux, -O2): ~1 ns per disabled zone, ~100 ns per enabled zone including collection.
+// Most of the enabled cost is the two clock reads.
+// See unit_test_profile() to re-measure.
+typedef struct {
+	const char* name;
+	u64 start;
+	uint thread;
+} DriftProfileZone;
+
+extern bool DRIFT_PROFILE_ENABLED;
+void DriftProfileSetEnabled(bool enabled);
+
+void _DriftProfileEnd(DriftProfileZone zone);
+static inline DriftProfileZone DriftProfileBegin(const char* name){
+	if(!DRIFT_PROFILE_ENABLED) return (DriftProfileZone){};
+	return (DriftProfileZone){.name = name, .start = DriftTimeNanos(), .thread = DriftGetThreadID()};
+}
+static inline void DriftProfileEnd(DriftProfileZone zone){if(zone.start) _DriftProfileEnd(zone);}
+
+static inline void _DriftProfileCleanup(DriftProfileZone* zone){DriftProfileEnd(*zone);}
+#define _DRIFT_PROFILE_VAR(_line_) _drift_profile_zone_##_line_
+#define _DRIFT_PROFILE_SCOPE(_name_, _line_) DriftProfileZone _DRIFT_PROFILE_VAR(_line_) __attribute__((cleanup(_DriftProfileCleanup))) = DriftProfileBegin(_name_)
+// Profile from here to the end of the enclosing scope.
+#define DRIFT_PROFILE_SCOPE(_name_) _DRIFT_PROFILE_SCOPE(_name_, __LINE__)
+
+// Collect the zones from all threads and finish the frame's statistics. Main thread only.
+void DriftProfileFrameMark(void);
+
+typedef struct {
+	const char* name;
+	uint calls;
+	// Per-frame totals over the recent frame history.
+	double min_ms, avg_ms, p99_ms, max_ms;
+} DriftProfileStat;
+
+// Fill 'stats' sorted by average time, returns the count.
+uint DriftProfileGetStats(DriftProfileStat* stats, uint max_count);
+// Write the captured zones as Chrome trace JSON (chrome://tracing, Perfetto) and clear them.
+bool DriftProfileWriteTrace(const char* filename);
+// Write the frame statistics as CSV.
+bool DriftProfileWriteCSV(const char* filename);
+
 // Tables
 
 #pragma once
@@ -232,6 +305,8 @@ typedef struct {
 #define DRIFT_TABLE_MIN_ALIGNMENT 64llu
 #define DRIFT_TABLE_MIN_ROW_CAPACITY 64llu
 #define DRIFT_TABLE_GROWTH_FACTOR 2
+// Tables shrink once they drop below 1/DRIFT_TABLE_SHRINK_FACTOR of their capacity.
+#define DRIFT_TABLE_SHRINK_FACTOR 8
 
 typedef struct {DriftColumn arr[DRIFT_TABLE_MAX_COLUMNS];} DriftColumnSet;
 
@@ -239,6 +314,9 @@ typedef struct {
 	char const* name;
 	DriftMem* mem;
 	size_t min_row_capacity;
+	// When non-zero, reserve address space for this many rows up front instead of allocating from 'mem'.
+	// Pages are committed as the table grows, so growing never copies and column pointers never change.
+	size_t reserve_rows;
 	DriftColumnSet columns;
 } DriftTableDesc;
 
@@ -247,6 +325,8 @@ struct DriftTable {
 	size_t row_capacity, row_count, row_size;
 	
 	DriftName _names[1 + DRIFT_TABLE_MAX_COLUMNS];
+	// Capacity the table was created with, it won't shrink below this.
+	size_t _shrink_capacity;
 	
 	// Internal pointer to the table's memory.
 	void* buffer;
@@ -262,10 +342,18 @@ DriftTable* DriftTableInit(DriftTable* table, DriftTableDesc desc);
 void DriftTableDestroy(DriftTable* table);
 void DriftTableIO(DriftTable* table, DriftIO* io);
 
+// Resize the table's storage. May shrink, but not below the row count.
 void DriftTableResize(DriftTable* table, size_t row_capacity);
+// Shrink the table if it has become mostly empty, returns true if the table was resized.
+// Invalidates column pointers like growing does, so don't call it while iterating.
+bool DriftTableShrink(DriftTable* table);
 
 static inline void DriftTableEnsureCapacity(DriftTable *table, size_t row_capacity){
-	if(row_capacity > table->row_capacity) DriftTableResize(table, row_capacity*DRIFT_TABLE_GROWTH_FACTOR);
+	if(row_capacity > table->row_capacity){
+		DriftTableResize(table, row_capacity*DRIFT_TABLE_GROWTH_FACTOR);
+		// Reserved tables clamp to their reservation instead of growing past it.
+		DRIFT_ASSERT_HARD(row_capacity <= table->row_capacity, "DriftTable '%s' is full.", table->desc.name);
+	}
 }
 
 static inline uint DriftTablePushRow(DriftTable* table){
@@ -293,6 +381,10 @@ void DriftMapDestroy(DriftMap* map);
 uintptr_t DriftMapInsert(DriftMap *map, uintptr_t key, uintptr_t value);
 uintptr_t DriftMapFind(DriftMap const* map, uintptr_t key);
 uintptr_t DriftMapRemove(DriftMap* map, uintptr_t key);
+// Remove all keys without releasing any memory.
+void DriftMapClear(DriftMap* map);
+// Rehash into a smaller table if the map has become mostly empty, returns true if the map was resized.
+bool DriftMapShrink(DriftMap* map);
 static inline bool DriftMapActiveIndex(DriftMap const* map, uint idx){return map->infobytes[idx];}
 
 uintptr_t DriftFNV64Str(const char* str);
@@ -301,58 +393,110 @@ uintptr_t DriftFNV64(const u8* ptr, size_t size);
 // Entities
 
 // http://bitsquid.blogspot.com/2014/08/building-data-oriented-entity-system.html
-#define DRIFT_ENTITY_INDEX_BITS 16u
-#define DRIFT_ENTITY_GENERATION_BITS 8u
-#define DRIFT_ENTITY_TAG_BITS 4u
+#define DRIFT_ENTITY_INDEX_BITS 32u
+#define DRIFT_ENTITY_GENERATION_BITS 24u
+#define DRIFT_ENTITY_TAG_BITS 8u
 
-#define DRIFT_ENTITY_TAG_STATIC 0x1000000
+#define DRIFT_ENTITY_GENERATION_MASK ((1u << DRIFT_ENTITY_GENERATION_BITS) - 1)
+#define DRIFT_ENTITY_TAG_STATIC (1llu << (DRIFT_ENTITY_INDEX_BITS + DRIFT_ENTITY_GENERATION_BITS))
 
 typedef struct {
-	u32 id;
+	u64 id;
 } DriftEntity;
 
 static inline DriftEntity DriftEntityMake(uint index, uint generation, uint tag){
-	uint32_t id = tag;
+	u64 id = tag;
 	id = (id << DRIFT_ENTITY_GENERATION_BITS) | generation;
 	id = (id << DRIFT_ENTITY_INDEX_BITS) | index;
 	return (DriftEntity){id};
 }
 
-static inline uint _DriftEntityShiftMask(DriftEntity e, uint shift, uint bits){return (e.id >> shift) & ((1 << bits) - 1);}
+static inline uint _DriftEntityShiftMask(DriftEntity e, uint shift, uint bits){return (e.id >> shift) & ((1llu << bits) - 1);}
 static inline uint DriftEntityIndex(DriftEntity e){return _DriftEntityShiftMask(e, 0, DRIFT_ENTITY_INDEX_BITS);}
 static inline uint DriftEntityGeneration(DriftEntity e){return _DriftEntityShiftMask(e, DRIFT_ENTITY_INDEX_BITS, DRIFT_ENTITY_GENERATION_BITS);}
 static inline uint DriftEntityTag(DriftEntity e){return _DriftEntityShiftMask(e, DRIFT_ENTITY_INDEX_BITS + DRIFT_ENTITY_GENERATION_BITS, DRIFT_ENTITY_TAG_BITS);}
 
-#define DRIFT_ENTITY_FORMAT "e%05X"
+#define DRIFT_ENTITY_FORMAT "e%05"PRIX64
 
-#define DRIFT_ENTITY_SET_INDEX_COUNT (1 << DRIFT_ENTITY_INDEX_BITS)
 #define DRIFT_ENTITY_SET_MIN_FREE_INDEXES 1024
+// Upper bound on tracked indexes, also used to reject corrupt saves before allocating.
+#define DRIFT_ENTITY_SET_MAX_ENTITIES (1u << 24)
+
+#define DRIFT_ENTITY_SET_MAX_COMPONENTS 64
+
+typedef struct DriftComponent DriftComponent;
 
 typedef struct {
-	uint entity_count, pool_head, pool_tail;
-	u32 pooled_indexes[DRIFT_ENTITY_SET_INDEX_COUNT];
-	u8 generations[DRIFT_ENTITY_SET_INDEX_COUNT];
+	// Number of indexes handed out so far, and the pool of retired indexes.
+	uint entity_count, pool_head, pool_tail, pool_capacity;
+	
+	DriftMem* mem;
+	// Ring buffer of retired indexes waiting to be reused.
+	u32* pooled_indexes;
+	// Per index arrays, grown as new indexes are handed out.
+	uint index_capacity;
+	u32* generations;
+	// Bitmask of the registered components each entity belongs to. Not saved, components rebuild it when loaded.
+	u64* component_masks;
+	DriftComponent* components[DRIFT_ENTITY_SET_MAX_COMPONENTS];
 } DriftEntitySet;
 
-DriftEntitySet* DriftEntitySetInit(DriftEntitySet* set);
+DriftEntitySet* DriftEntitySetInit(DriftEntitySet* set, DriftMem* mem);
+void DriftEntitySetFree(DriftEntitySet* set);
+void DriftEntitySetIO(DriftEntitySet* set, DriftIO* io);
 
 DriftEntity DriftEntitySetAquire(DriftEntitySet* set, uint tag);
 void DriftEntitySetRetire(DriftEntitySet* set, DriftEntity entity);
 
+// Track which entities have the component so they can be destroyed without searching every component.
+void DriftEntitySetAddComponent(DriftEntitySet* set, DriftComponent* component);
+// Remove the entities from the components they belong to, batched per component, then retire them.
+void DriftEntitySetDestroy(DriftEntitySet* set, DriftEntity* entities, uint count);
+// Bitmap with a bit set for each index currently in use, one u64 word per 64 indexes.
+// Stale entities can still share a live index, so check the generation too before trusting a set bit.
+u64* DriftEntitySetLiveBits(DriftEntitySet* set, DriftMem* mem);
+static inline size_t DriftEntitySetLiveBitsSize(DriftEntitySet* set){return (set->entity_count + 63)/64*sizeof(u64);}
+
 static inline bool DriftEntitySetCheck(DriftEntitySet *set, DriftEntity entity){
 	uint idx = DriftEntityIndex(entity);
-	return idx != 0 && set->generations[idx] == DriftEntityGeneration(entity);
+	return idx != 0 && idx < set->entity_count && set->generations[idx] == DriftEntityGeneration(entity);
 }
 
 // Components
 
+#define DRIFT_COMPONENT_SPARSE_PAGE_BITS 10
+#define DRIFT_COMPONENT_SPARSE_PAGE_SIZE (1 << DRIFT_COMPONENT_SPARSE_PAGE_BITS)
+
+// Sparse index entry. The entity's generation and tag are stored so stale entities are rejected by the same load.
+typedef struct {
+	u32 check, row;
+} DriftSparseEntry;
+
+static inline u32 DriftSparseCheck(DriftEntity entity){return (u32)(entity.id >> DRIFT_ENTITY_INDEX_BITS);}
+
 typedef struct DriftComponent {
 	DriftTable table;
 	DriftMap map;
 	bool reset_on_hotload;
 	
+	// When set, rows are found through pages indexed by entity index instead of 'map'.
+	// Unused pages point to a shared empty page so a lookup only branches on the page table's size.
+	bool sparse;
+	uint sparse_page_count;
+	DriftSparseEntry** sparse_pages;
+	u16* sparse_page_counts;
+	
 	uint count;
 	uint gc_cursor;
+	
+	// Entity set tracking membership, and this component's bit in it's masks.
+	DriftEntitySet* entities;
+	u64 entity_mask;
+	
+	// True while the rows are in increasing entity id order. Joins merge sorted components instead of hashing.
+	bool sorted;
+	// Hint to restore the order with DriftComponentSort() when it's lost.
+	bool keep_sorted;
 } DriftComponent;
 
 DriftComponent* DriftComponentInit(DriftComponent* component, DriftTableDesc desc);
@@ -367,18 +511,48 @@ uint DriftComponentAdd2(DriftComponent *component, DriftEntity entity, bool uniq
 // Delete a component for the given entity.
 void DriftComponentRemove(DriftComponent* component, DriftEntity entity);
 
+// Switch the component to the sparse index, trading up to 8 bytes per entity index for single load lookups.
+// Worth it for large components that are looked up often, rarely used components should keep the map.
+void DriftComponentMakeSparse(DriftComponent* component);
+
 // Find the component index for a given entity.
 static inline uint DriftComponentFind(DriftComponent* component, DriftEntity entity){
-	return DriftMapFind(&component->map, entity.id);
+	if(component->sparse){
+		uint idx = DriftEntityIndex(entity), page = idx >> DRIFT_COMPONENT_SPARSE_PAGE_BITS;
+		if(page >= component->sparse_page_count) return 0;
+		DriftSparseEntry entry = component->sparse_pages[page][idx & (DRIFT_COMPONENT_SPARSE_PAGE_SIZE - 1)];
+		// Empty entries have a row of 0, so they don't need to be checked separately.
+		return entry.check == DriftSparseCheck(entity) ? entry.row : 0;
+	} else {
+		return DriftMapFind(&component->map, entity.id);
+	}
 }
 
 static inline DriftEntity* DriftComponentGetEntities(DriftComponent* component){
 	return component->table.desc.columns.arr[0].ptr;
 }
 
+// Shrink the component's table and index map if they are mostly empty.
+// Meant to be called periodically during quiet ticks, returns true if any memory was released.
+bool DriftComponentCompact(DriftComponent* component);
+
+// Sort the rows by entity id if they aren't already, returns true if the rows were reordered.
+// Invalidates component indexes like removing does, so don't call it while iterating.
+bool DriftComponentSort(DriftComponent* component);
+// Sort the rows along a Z-order curve of 'positions' (one of the component's columns) so entities near each other
+// in the world are near each other in memory. The NULL terminated 'cojoined' components are put in the same order.
+// Invalidates component indexes like DriftComponentSort(), and the rows are no longer sorted by id.
+void DriftComponentSortSpatial(DriftComponent* component, const DriftVec2* positions, DriftComponent** cojoined);
+
 // Clean up components for deleted entities.
 // Higher values for 'pressure' cause more cleanup.
 void DriftComponentGC(DriftComponent* component, DriftEntitySet* entities, uint pressure);
+// Remove all rows for deleted entities in a single pass using a bitmap from DriftEntitySetLiveBits().
+// Keeps the order of the remaining rows, returns the number of rows removed.
+uint DriftComponentGCBulk(DriftComponent* component, DriftEntitySet* entities, const u64* live_bits);
+// Bulk GC many components at once, in parallel on worker jobs when 'job' is not NULL.
+// Meant for after large destruction events or loading, returns the number of rows removed.
+uint DriftComponentGCAll(tina_job* job, DriftComponent** components, uint count, DriftEntitySet* entities);
 
 #define DRIFT_COMPONENT_FOREACH(_comp_, _idx_) \
 	for(uint _idx_ = 1, count = (_comp_)->count; _idx_ <= count; _idx_++)
@@ -394,10 +568,21 @@ typedef struct {
 	DriftEntity entity;
 	DriftComponentJoin joins[DRIFT_JOIN_MAX_COMPONENTS];
 	uint count;
+	// Search positions for the components being merged, 0 for components looked up by hash.
+	uint cursors[DRIFT_JOIN_MAX_COMPONENTS];
+	// Last row of the driving component to visit.
+	uint last;
 } DriftJoin;
 
+// Iterates the smallest non-optional component and looks up the rest.
+// When both it and another similarly sized component are sorted, that component is merged instead of hashed.
+// Iteration order is not the order of 'joins'.
+
 DriftJoin DriftJoinMake(DriftComponentJoin* joins);
 bool DriftJoinNext(DriftJoin* join);
+// Restrict a new join to slice 'part' of 'parts' equal slices of the driving component.
+// Running every slice in order visits the same entities in the same order as the whole join.
+void DriftJoinSplit(DriftJoin* join, uint part, uint parts);
 
 // R-trees
 
@@ -421,6 +606,8 @@ typedef struct {
 } DriftRTree;
 
 typedef void DriftRTreeBoundFunc(uint* indexes, DriftAABB2* bounds, uint count, void* user_data);
+// Remove all objects, they are inserted again by the next update.
+void DriftRTreeReset(DriftRTree* tree);
 void DriftRTreeUpdate(DriftRTree* tree, uint obj_count, DriftRTreeBoundFunc bound_func, void* bound_data, tina_job* job, DriftMem* mem);
 DRIFT_ARRAY(DriftIndexPair) DriftRTreePairs(DriftRTree* tree, tina_job* job, DriftMem* mem);
 
@@ -471,9 +658,26 @@ void DriftImAudioUpdate(void);
 void unit_test_util(void);
 void unit_test_math(void);
 void unit_test_entity(void);
+void unit_test_entity_destroy(void);
+void unit_test_entity_stress(void);
 void unit_test_map(void);
+void unit_test_map_bench(void);
 void unit_test_component(void);
+void unit_test_component_waves(void);
+void unit_test_join_bench(void);
+void unit_test_component_find_bench(void);
+void unit_test_component_gc_bench(void);
+void unit_test_component_spatial_bench(void);
+void unit_test_table(void);
+void unit_test_table_hitch(void);
 void unit_test_rtree(void);
+void unit_test_profile(void);
+void unit_test_zone_mem(void);
+void unit_test_gfx_commands(void);
+void unit_test_gfx_streams(void);
+void unit_test_gfx_capture(void);
+void unit_test_gfx_object_cache(void);
+void unit_test_parallel_for(tina_job* job);
 #endif
 
 #include "base/drift_gfx.h"
@@ -10,14 +10,68 @@ You should have received a copy of the GNU General Public License along with Ver
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 
 #include "drift_base.h"
 
+static const DriftSparseEntry SPARSE_EMPTY_PAGE[DRIFT_COMPONENT_SPARSE_PAGE_SIZE];
+#define SPARSE_PAGE_BYTES (DRIFT_COMPONENT_SPARSE_PAGE_SIZE*sizeof(DriftSparseEntry))
+
+// Returns NULL if the entity's page is past the end of the page table.
+static DriftSparseEntry* sparse_entry(DriftComponent* component, DriftEntity entity){
+	uint idx = DriftEntityIndex(entity), page = idx >> DRIFT_COMPONENT_SPARSE_PAGE_BITS;
+	if(page >= component->sparse_page_count) return NULL;
+	return component->sparse_pages[page] + (idx & (DRIFT_COMPONENT_SPARSE_PAGE_SIZE - 1));
+}
+
+static void sparse_grow(DriftComponent* component, uint page_count){
+	DriftMem* mem = component->table.desc.mem;
+	uint old_count = component->sparse_page_count;
+	component->sparse_pages = DriftRealloc(mem, component->sparse_pages, old_count*sizeof(*component->sparse_pages), page_count*sizeof(*component->sparse_pages));
+	component->sparse_page_counts = DriftRealloc(mem, component->sparse_page_counts, old_count*sizeof(*component->sparse_page_counts), page_count*sizeof(*component->sparse_page_counts));
+	for(uint page = old_count; page < page_count; page++){
+		component->sparse_pages[page] = (DriftSparseEntry*)SPARSE_EMPTY_PAGE;
+		component->sparse_page_counts[page] = 0;
+	}
+	component->sparse_page_count = page_count;
+}
+
+static void index_insert(DriftComponent* component, DriftEntity entity, uint row){
+	if(component->sparse){
+		uint page = DriftEntityIndex(entity) >> DRIFT_COMPONENT_SPARSE_PAGE_BITS;
+		if(page >= component->sparse_page_count) sparse_grow(component, DriftNextPOT(page + 1));
+		if(component->sparse_pages[page] == SPARSE_EMPTY_PAGE){
+			component->sparse_pages[page] = DriftAlloc(component->table.desc.mem, SPARSE_PAGE_BYTES);
+			memset(component->sparse_pages[page], 0, SPARSE_PAGE_BYTES);
+		}
+		
+		// Rows start at 1, so a row of 0 marks an empty entry.
+		DriftSparseEntry* entry = sparse_entry(component, entity);
+		if(entry->row == 0) component->sparse_page_counts[page]++;
+		*entry = (DriftSparseEntry){.check = DriftSparseCheck(entity), .row = row};
+	} else {
+		DriftMapInsert(&component->map, entity.id, row);
+	}
+}
+
+static void index_remove(DriftComponent* component, DriftEntity entity){
+	if(component->sparse){
+		DriftSparseEntry* entry = sparse_entry(component, entity);
+		if(entry && entry->row && entry->check == DriftSparseCheck(entity)){
+			*entry = (DriftSparseEntry){};
+			component->sparse_page_counts[DriftEntityIndex(entity) >> DRIFT_COMPONENT_SPARSE_PAGE_BITS]--;
+		}
+	} else {
+		DriftMapRemove(&component->map, entity.id);
+	}
+}
+
 DriftComponent* DriftComponentInit(DriftComponent* component, DriftTableDesc desc){
-	*component = (DriftComponent){.gc_cursor = 1};
+	*component = (DriftComponent){.gc_cursor = 1, .sorted = true};
 	
 	// Add one for the reserved 0 index.
 	desc.min_row_capacity += 1;
+	if(desc.reserve_rows) desc.reserve_rows += 1;
 	
 	DriftTableInit(&component->table, desc);
 	DriftName name = component->table._names[0];
@@ -30,18 +84,61 @@ DriftComponent* DriftComponentInit(DriftComponent* component, DriftTableDesc des
 }
 
 void DriftComponentDestroy(DriftComponent* component){
+	DriftEntitySet* set = component->entities;
+	if(set){
+		set->components[__builtin_ctzll(component->entity_mask)] = NULL;
+		for(uint i = 0; i < set->entity_count; i++) set->component_masks[i] &= ~component->entity_mask;
+	}
+	
+	if(component->sparse){
+		DriftMem* mem = component->table.desc.mem;
+		for(uint page = 0; page < component->sparse_page_count; page++){
+			DriftSparseEntry* entries = component->sparse_pages[page];
+			if(entries != SPARSE_EMPTY_PAGE) DriftDealloc(mem, entries, SPARSE_PAGE_BYTES);
+		}
+		DriftDealloc(mem, component->sparse_pages, component->sparse_page_count*sizeof(*component->sparse_pages));
+		DriftDealloc(mem, component->sparse_page_counts, component->sparse_page_count*sizeof(*component->sparse_page_counts));
+	}
+	
 	DriftTableDestroy(&component->table);
 	DriftMapDestroy(&component->map);
 }
 
+void DriftComponentMakeSparse(DriftComponent* component){
+	if(component->sparse) return;
+	
+	component->sparse = true;
+	DriftEntity* entities = DriftComponentGetEntities(component);
+	DRIFT_COMPONENT_FOREACH(component, idx) index_insert(component, entities[idx], idx);
+	
+	// Swap the map for an empty one.
+	DriftName name = component->table._names[0];
+	DriftMapDestroy(&component->map);
+	DriftMapInit(&component->map, component->table.desc.mem, name.str, 0);
+}
+
 void DriftComponentIO(DriftComponent* component, DriftIO* io){
 	DriftTableIO(&component->table, io);
 	if(io->read){
 		// Fixup the count
 		component->count = component->table.row_count - 1;
 		// Generate index map.
+		if(component->sparse){
+			for(uint page = 0; page < component->sparse_page_count; page++){
+				if(component->sparse_pages[page] != SPARSE_EMPTY_PAGE) memset(component->sparse_pages[page], 0, SPARSE_PAGE_BYTES);
+				component->sparse_page_counts[page] = 0;
+			}
+		}
 		DriftEntity* key = DriftComponentGetEntities(component);
-		DRIFT_COMPONENT_FOREACH(component, idx) DriftMapInsert(&component->map, key[idx].id, idx);
+		DRIFT_COMPONENT_FOREACH(component, idx) index_insert(component, key[idx], idx);
+		
+		component->sorted = true;
+		for(uint idx = 2; idx <= component->count; idx++) component->sorted &= key[idx - 1].id < key[idx].id;
+		
+		if(component->entities){
+			u64* masks = component->entities->component_masks;
+			DRIFT_COMPONENT_FOREACH(component, idx) masks[DriftEntityIndex(key[idx])] |= component->entity_mask;
+		}
 	}
 }
 
@@ -50,16 +147,25 @@ uint DriftComponentAdd(DriftComponent *component, DriftEntity entity){
 }
 
 uint DriftComponentAdd2(DriftComponent *component, DriftEntity entity, bool unique){
-	uint old_idx = DriftMapFind(&component->map, entity.id);
+	uint old_idx = DriftComponentFind(component, entity);
 	if(old_idx && !unique) return old_idx;
-	DRIFT_ASSERT(old_idx == 0, "e%d already had a %s", entity.id, component->table.desc.name);
+	DRIFT_ASSERT(old_idx == 0, DRIFT_ENTITY_FORMAT" already had a %s", entity.id, component->table.desc.name);
+	
+	DriftSparseEntry* entry = component->sparse ? sparse_entry(component, entity) : NULL;
+	if(entry && entry->row){
+		// The index was reused, so the entity in the entry is dead. Drop it's row before taking the entry.
+		DriftComponentRemove(component, DriftComponentGetEntities(component)[entry->row]);
+	}
 	
 	uint idx = component->count = component->table.row_count++;
 	DriftTableEnsureCapacity(&component->table, component->table.row_count);
-	DriftMapInsert(&component->map, entity.id, idx);
+	index_insert(component, entity, idx);
 	
 	DriftTableClearRow(&component->table, idx);
-	DriftComponentGetEntities(component)[idx] = entity;
+	DriftEntity* entities = DriftComponentGetEntities(component);
+	entities[idx] = entity;
+	component->sorted &= idx == 1 || entities[idx - 1].id < entity.id;
+	if(component->entities) component->entities->component_masks[DriftEntityIndex(entity)] |= component->entity_mask;
 	
 	return idx;
 }
@@ -71,9 +177,154 @@ void DriftComponentRemove(DriftComponent* component, DriftEntity entity){
 		uint src_idx = component->table.row_count = component->count--;
 		
 		// Update before removing in case src == dst
-		DriftMapInsert(&component->map, DriftComponentGetEntities(component)[src_idx].id, dst_idx);
-		DriftMapRemove(&component->map, entity.id);
+		index_insert(component, DriftComponentGetEntities(component)[src_idx], dst_idx);
+		index_remove(component, entity);
 		DriftTableCopyRow(&component->table, dst_idx, src_idx);
+		component->sorted &= dst_idx == src_idx;
+		// Stale rows of dead entities are removed too, don't clear the bit of a live entity that reused the index.
+		DriftEntitySet* set = component->entities;
+		if(set && DriftEntitySetCheck(set, entity)) set->component_masks[DriftEntityIndex(entity)] &= ~component->entity_mask;
+	}
+}
+
+bool DriftComponentCompact(DriftComponent* component){
+	bool table_shrunk = DriftTableShrink(&component->table);
+	bool map_shrunk = DriftMapShrink(&component->map);
+	
+	bool pages_freed = false;
+	if(component->sparse){
+		for(uint page = 0; page < component->sparse_page_count; page++){
+			DriftSparseEntry* entries = component->sparse_pages[page];
+			if(entries != SPARSE_EMPTY_PAGE && component->sparse_page_counts[page] == 0){
+				DriftDealloc(component->table.desc.mem, entries, SPARSE_PAGE_BYTES);
+				component->sparse_pages[page] = (DriftSparseEntry*)SPARSE_EMPTY_PAGE;
+				pages_freed = true;
+			}
+		}
+	}
+	
+	return table_shrunk || map_shrunk || pages_freed;
+}
+
+typedef struct {
+	u64 key;
+	uint row;
+} SortKey;
+
+// Sort the keys with an LSD radix sort.
+static SortKey* radix_sort_keys(SortKey* keys, SortKey* tmp, uint count){
+	for(uint shift = 0; shift < 64; shift += 8){
+		uint offsets[256] = {};
+		for(uint i = 0; i < count; i++) offsets[(keys[i].key >> shift) & 0xFF]++;
+		
+		// Skip passes where every key has the same digit, common for the high bits of ids and small keys.
+		if(offsets[(keys[0].key >> shift) & 0xFF] == count) continue;
+		
+		for(uint i = 0, sum = 0; i < 256; i++){
+			uint n = offsets[i];
+			offsets[i] = sum;
+			sum += n;
+		}
+		for(uint i = 0; i < count; i++) tmp[offsets[(keys[i].key >> shift) & 0xFF]++] = keys[i];
+		
+		SortKey* swap = keys; keys = tmp; tmp = swap;
+	}
+	
+	return keys;
+}
+
+// Sort the rows by 'keys', which has room for 2*count entries, and update the index to match.
+static void reorder_rows(DriftComponent* component, SortKey* keys){
+	uint count = component->count;
+	SortKey* order = radix_sort_keys(keys, keys + count, count);
+	
+	size_t max_size = 0;
+	DriftColumn* columns = component->table.desc.columns.arr;
+	for(uint i = 0; i < DRIFT_TABLE_MAX_COLUMNS && columns[i].size; i++) max_size = DRIFT_MAX(max_size, columns[i].size);
+	
+	// Gather each column into scratch memory, then copy it back.
+	u8* scratch = DriftAlloc(DriftSystemMem, count*max_size);
+	for(uint i = 0; i < DRIFT_TABLE_MAX_COLUMNS && columns[i].size; i++){
+		u8* ptr = columns[i].ptr;
+		size_t size = columns[i].size;
+		for(uint j = 0; j < count; j++) memcpy(scratch + size*j, ptr + size*order[j].row, size);
+		memcpy(ptr + size, scratch, size*count);
+	}
+	
+	// Only rows that moved need their index updated.
+	DriftEntity* entities = DriftComponentGetEntities(component);
+	for(uint j = 0; j < count; j++){
+		if(order[j].row != j + 1) index_insert(component, entities[j + 1], j + 1);
+	}
+	
+	DriftDealloc(DriftSystemMem, scratch, count*max_size);
+}
+
+bool DriftComponentSort(DriftComponent* component){
+	if(component->sorted) return false;
+	if(component->count < 2){
+		component->sorted = true;
+		return false;
+	}
+	
+	// Sort (id, row) pairs to find where each row goes.
+	uint count = component->count;
+	DriftEntity* entities = DriftComponentGetEntities(component);
+	SortKey* keys = DriftAlloc(DriftSystemMem, 2*count*sizeof(*keys));
+	for(uint i = 0; i < count; i++) keys[i] = (SortKey){.key = entities[i + 1].id, .row = i + 1};
+	reorder_rows(component, keys);
+	component->sorted = true;
+	
+	DriftDealloc(DriftSystemMem, keys, 2*count*sizeof(*keys));
+	return true;
+}
+
+// Spread the low 16 bits of 'x' out to the even bits.
+static u32 morton_spread(u32 x){
+	x &= 0xFFFF;
+	x = (x | (x << 8)) & 0x00FF00FF;
+	x = (x | (x << 4)) & 0x0F0F0F0F;
+	x = (x | (x << 2)) & 0x33333333;
+	x = (x | (x << 1)) & 0x55555555;
+	return x;
+}
+
+void DriftComponentSortSpatial(DriftComponent* component, const DriftVec2* positions, DriftComponent** cojoined){
+	uint count = component->count;
+	if(count < 2) return;
+	
+	// Quantize the positions to a 16 bit grid covering their bounds.
+	DriftAABB2 bounds = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+	DRIFT_COMPONENT_FOREACH(component, idx){
+		DriftVec2 p = positions[idx];
+		bounds = (DriftAABB2){fminf(bounds.l, p.x), fminf(bounds.b, p.y), fmaxf(bounds.r, p.x), fmaxf(bounds.t, p.y)};
+	}
+	float scale = 0xFFFF/fmaxf(fmaxf(bounds.r - bounds.l, bounds.t - bounds.b), 1);
+	
+	SortKey* keys = DriftAlloc(DriftSystemMem, 2*count*sizeof(*keys));
+	DRIFT_COMPONENT_FOREACH(component, idx){
+		u32 x = (u32)((positions[idx].x - bounds.l)*scale), y = (u32)((positions[idx].y - bounds.b)*scale);
+		keys[idx - 1] = (SortKey){.key = morton_spread(x) | (morton_spread(y) << 1), .row = idx};
+	}
+	reorder_rows(component, keys);
+	component->sorted = false;
+	DriftDealloc(DriftSystemMem, keys, 2*count*sizeof(*keys));
+	
+	// The rows are in Z-order now, so key the other components by their entity's row.
+	for(uint i = 0; cojoined && cojoined[i]; i++){
+		DriftComponent* other = cojoined[i];
+		if(other->count < 2) continue;
+		
+		keys = DriftAlloc(DriftSystemMem, 2*other->count*sizeof(*keys));
+		DriftEntity* entities = DriftComponentGetEntities(other);
+		DRIFT_COMPONENT_FOREACH(other, idx){
+			// Rows for entities the component doesn't have go at the end in their current order.
+			uint row = DriftComponentFind(component, entities[idx]);
+			keys[idx - 1] = (SortKey){.key = row ? row : UINT32_MAX, .row = idx};
+		}
+		reorder_rows(other, keys);
+		other->sorted = false;
+		DriftDealloc(DriftSystemMem, keys, 2*other->count*sizeof(*keys));
 	}
 }
 
@@ -96,24 +347,146 @@ void DriftComponentGC(DriftComponent* component, DriftEntitySet* entities, uint
 	}
 }
 
+static inline bool gc_live(DriftEntitySet* entities, const u64* live_bits, DriftEntity e){
+	uint idx = DriftEntityIndex(e);
+	return (live_bits[idx/64] >> (idx & 63) & 1) && entities->generations[idx] == DriftEntityGeneration(e);
+}
+
+uint DriftComponentGCBulk(DriftComponent* component, DriftEntitySet* entities, const u64* live_bits){
+	DriftEntity* rows = DriftComponentGetEntities(component);
+	uint dead = 0, count = component->count;
+	DRIFT_COMPONENT_FOREACH(component, idx) dead += !gc_live(entities, live_bits, rows[idx]);
+	if(dead == 0) return 0;
+	
+	// Removing and updating keys one at a time is slow when much of the table moves, so rebuild the map instead.
+	bool rebuild = !component->sparse && dead > count/8;
+	DriftColumn* columns = component->table.desc.columns.arr;
+	uint dst = 1;
+	for(uint src = 1; src <= count;){
+		// Slide each run of live rows down instead of swapping in from the end so the order is kept.
+		uint end = src;
+		while(end <= count && gc_live(entities, live_bits, rows[end])) end++;
+		
+		uint run = end - src;
+		if(dst != src && run){
+			for(uint i = 0; i < DRIFT_TABLE_MAX_COLUMNS && columns[i].size; i++){
+				memmove(columns[i].ptr + columns[i].size*dst, columns[i].ptr + columns[i].size*src, columns[i].size*run);
+			}
+			if(!rebuild) for(uint i = dst; i < dst + run; i++) index_insert(component, rows[i], i);
+		}
+		dst += run;
+		
+		// Then skip the dead rows following it.
+		for(src = end; src <= count && !gc_live(entities, live_bits, rows[src]); src++){
+			if(!rebuild) index_remove(component, rows[src]);
+		}
+	}
+	
+	component->table.row_count = dst;
+	component->count = dst - 1;
+	if(rebuild){
+		DriftMapClear(&component->map);
+		DRIFT_COMPONENT_FOREACH(component, idx) DriftMapInsert(&component->map, rows[idx].id, idx);
+	}
+	
+	return dead;
+}
+
+typedef struct {
+	DriftComponent** components;
+	DriftEntitySet* entities;
+	const u64* live_bits;
+	_Atomic(uint) removed;
+} GCContext;
+
+static void gc_job(tina_job* job){
+	GCContext* ctx = tina_job_get_description(job)->user_data;
+	DriftComponent* component = ctx->components[tina_job_get_description(job)->user_idx];
+	atomic_fetch_add(&ctx->removed, DriftComponentGCBulk(component, ctx->entities, ctx->live_bits));
+}
+
+uint DriftComponentGCAll(tina_job* job, DriftComponent** components, uint count, DriftEntitySet* entities){
+	// Components are independent, the bitmap and generations are only read.
+	GCContext ctx = {.components = components, .entities = entities, .live_bits = DriftEntitySetLiveBits(entities, DriftSystemMem)};
+	if(job){
+		DriftParallelFor(job, gc_job, &ctx, count);
+	} else {
+		for(uint i = 0; i < count; i++) ctx.removed += DriftComponentGCBulk(components[i], entities, ctx.live_bits);
+	}
+	
+	DriftDealloc(DriftSystemMem, (void*)ctx.live_bits, DriftEntitySetLiveBitsSize(entities));
+	return ctx.removed;
+}
+
+#define DRIFT_JOIN_MERGE_RATIO 4
+
 DriftJoin DriftJoinMake(DriftComponentJoin* joins){
-	DriftJoin join = {};
+	DriftJoin join = {.last = UINT32_MAX};
+	uint driver = 0;
 	for(uint i = 0; joins[i].variable; i++){
 		*joins[i].variable = 0;
 		join.joins[i] = joins[i];
 		join.count++;
+		
+		// Drive the join from the smallest required component to skip as many lookups as possible.
+		if(!joins[i].optional && (joins[driver].optional || joins[i].component->count < joins[driver].component->count)) driver = i;
 	}
-
+	
+	DriftComponentJoin tmp = join.joins[0];
+	join.joins[0] = join.joins[driver];
+	join.joins[driver] = tmp;
+	
+	// Merge sorted components unless they are much larger than the driver, then hashing is faster than seeking.
+	DriftComponent* driver_component = join.joins[0].component;
+	for(uint i = 1; i < join.count; i++){
+		DriftComponent* component = join.joins[i].component;
+		bool merge = driver_component->sorted && component->sorted && component->count <= DRIFT_JOIN_MERGE_RATIO*driver_component->count;
+		join.cursors[i] = merge ? 1 : 0;
+	}
+	
 	return join;
 }
 
+// Find the first row at or after 'cursor' with an id that is not less than 'id'.
+static uint seek_sorted(DriftComponent* component, uint cursor, u64 id){
+	DriftEntity* entities = DriftComponentGetEntities(component);
+	uint count = component->count;
+	if(cursor > count || entities[cursor].id >= id) return cursor;
+	
+	// Gallop forward to bracket the id, then binary search the bracket.
+	uint lo = cursor, step = 1;
+	while(lo + step <= count && entities[lo + step].id < id){
+		lo += step;
+		step *= 2;
+	}
+	
+	uint hi = DRIFT_MIN(lo + step, count + 1);
+	while(hi - lo > 1){
+		uint mid = (lo + hi)/2;
+		if(entities[mid].id < id) lo = mid; else hi = mid;
+	}
+	
+	return hi;
+}
+
 bool DriftJoinNext(DriftJoin* join){
 	// Iterate entities from joins[0].
 	DriftComponentJoin* joins = join->joins;
-	next_entity: if(++*joins[0].variable <= joins[0].component->count){
-		join->entity = DriftComponentGetEntities(joins[0].component)[*joins[0].variable];
+	DriftComponent* driver = joins[0].component;
+	next_entity: if(++*joins[0].variable <= DRIFT_MIN(driver->count, join->last)){
+		DriftEntity entity = join->entity = DriftComponentGetEntities(driver)[*joins[0].variable];
 		for(uint i = 1; i < join->count; i++){
-			uint idx = DriftComponentFind(joins[i].component, join->entity);
+			DriftComponent* component = joins[i].component;
+			uint idx;
+			// Adding or removing during the join can unsort the components, then fall back to hashing.
+			if(join->cursors[i] && driver->sorted && component->sorted){
+				// Both are ordered by id, so the component's cursor only moves forward.
+				idx = join->cursors[i] = seek_sorted(component, join->cursors[i], entity.id);
+				if(idx > component->count || DriftComponentGetEntities(component)[idx].id != entity.id) idx = 0;
+			} else {
+				idx = DriftComponentFind(component, entity);
+			}
+			
 			// If the component was found, update the join. Otherwise try the next entity.
 			if(idx || joins[i].optional) *joins[i].variable = idx; else goto next_entity;
 		}
@@ -124,6 +497,13 @@ bool DriftJoinNext(DriftJoin* join){
 	return false;
 }
 
+void DriftJoinSplit(DriftJoin* join, uint part, uint parts){
+	DRIFT_ASSERT(part < parts, "Invalid join part %d of %d.", part, parts);
+	u64 count = join->joins[0].component->count;
+	*join->joins[0].variable = (uint)(count*part/parts);
+	join->last = (uint)(count*(part + 1)/parts);
+}
+
 #if DRIFT_DEBUG
 typedef struct {
 	DriftComponent c;
@@ -140,8 +520,8 @@ typedef struct {
 void unit_test_component(void){
 	uint n = 1 << 15;
 	
-	static DriftEntitySet entities = {};
-	DriftEntitySetInit(&entities);
+	DriftEntitySet entities;
+	DriftEntitySetInit(&entities, DriftSystemMem);
 	
 	EmptyComponent empty = {};
 	ValueComponent values = {};
@@ -195,9 +575,587 @@ void unit_test_component(void){
 	}
 	DRIFT_ASSERT(sum == expected, "Invalid sum.");
 	
+	// Splitting the join visits the same rows in the same order.
+	u64 visited = 0;
+	for(uint part = 0; part < 7; part++){
+		join = DriftJoinMake((DriftComponentJoin[]){{&empty_idx, &empty.c}, {&value_idx, &values.c}, {}});
+		DriftJoinSplit(&join, part, 7);
+		while(DriftJoinNext(&join)){
+			DRIFT_ASSERT(values.values_copied[value_idx] == values.values[value_idx], "Split join visited an unexpected row.");
+			DRIFT_ASSERT(join.entity.id > visited, "Split join visited rows out of order.");
+			visited = join.entity.id;
+			sum -= values.values[value_idx];
+		}
+	}
+	DRIFT_ASSERT(sum == 0, "Split join missed rows.");
+	
+	// Sorting fewer than 2 rows only needs to set the flag.
+	EmptyComponent single = {};
+	DriftComponentInit(&single.c, (DriftTableDesc){
+		.name = "@Single", .mem = DriftSystemMem,
+		.columns.arr = {DRIFT_DEFINE_COLUMN(single.entity)},
+	});
+	for(uint i = 0; i < 2; i++){
+		single.c.sorted = false;
+		DRIFT_ASSERT(!DriftComponentSort(&single.c) && single.c.sorted, "Component wasn't marked sorted.");
+		DriftComponentAdd(&single.c, DriftEntitySetAquire(&entities, 0));
+	}
+	DriftComponentDestroy(&single.c);
+	
 	DriftComponentDestroy(&values.c);
 	DriftComponentDestroy(&empty.c);
+	DriftEntitySetFree(&entities);
 	
 	DRIFT_LOG("Component tests passed.");
 }
+
+typedef struct {
+	DriftComponent c;
+	DriftEntity* entity;
+	DriftVec2* position;
+	DriftVec2* velocity;
+} WaveComponent;
+
+static size_t component_bytes(DriftComponent* component){
+	DriftTable* table = &component->table;
+	DriftTable* map = &component->map.table;
+	return table->row_capacity*table->row_size + map->row_capacity*map->row_size;
+}
+
+static u64 wave_iterate(WaveComponent* bodies, EmptyComponent* tags){
+	u64 t0 = DriftTimeNanos();
+	uint body_idx, tag_idx;
+	DriftJoin join = DriftJoinMake((DriftComponentJoin[]){
+		{&body_idx, &bodies->c},
+		{&tag_idx, &tags->c},
+		{},
+	});
+	while(DriftJoinNext(&join)) bodies->position[body_idx] = DriftVec2FMA(bodies->position[body_idx], bodies->velocity[body_idx], 1/60.0f);
+	return DriftTimeNanos() - t0;
+}
+
+// Spawns and destroys entities in waves and reports memory use and join times after each phase.
+void unit_test_component_waves(void){
+	uint wave_size = 50000, survivors = 1000;
+	
+	DriftEntitySet entities;
+	DriftEntitySetInit(&entities, DriftSystemMem);
+	
+	WaveComponent bodies = {};
+	DriftComponentInit(&bodies.c, (DriftTableDesc){
+		.name = "@Bodies", .mem = DriftSystemMem,
+		.columns.arr = {
+			DRIFT_DEFINE_COLUMN(bodies.entity),
+			DRIFT_DEFINE_COLUMN(bodies.position),
+			DRIFT_DEFINE_COLUMN(bodies.velocity),
+		},
+	});
+	
+	EmptyComponent tags = {};
+	DriftComponentInit(&tags.c, (DriftTableDesc){
+		.name = "@Tags", .mem = DriftSystemMem,
+		.columns.arr = {DRIFT_DEFINE_COLUMN(tags.entity)},
+	});
+	
+	DriftEntity* live = DriftAlloc(DriftSystemMem, (wave_size + survivors)*sizeof(*live));
+	uint live_count = 0;
+	
+	for(uint wave = 0; wave < 4; wave++){
+		for(uint i = 0; i < wave_size; i++){
+			DriftEntity e = live[live_count++] = DriftEntitySetAquire(&entities, 0);
+			uint idx = DriftComponentAdd(&bodies.c, e);
+			bodies.position[idx] = (DriftVec2){i, wave};
+			bodies.velocity[idx] = (DriftVec2){1, 0};
+			DriftComponentAdd(&tags.c, e);
+		}
+		u64 full_nanos = wave_iterate(&bodies, &tags);
+		size_t full_bytes = component_bytes(&bodies.c) + component_bytes(&tags.c);
+		
+		// Destroy all but a few of the entities, oldest first.
+		uint destroy_count = live_count - survivors;
+		for(uint i = 0; i < destroy_count; i++){
+			DriftComponentRemove(&bodies.c, live[i]);
+			DriftComponentRemove(&tags.c, live[i]);
+			DriftEntitySetRetire(&entities, live[i]);
+		}
+		memmove(live, live + destroy_count, survivors*sizeof(*live));
+		live_count = survivors;
+		
+		u64 sparse_nanos = wave_iterate(&bodies, &tags);
+		size_t sparse_bytes = component_bytes(&bodies.c) + component_bytes(&tags.c);
+		
+		DRIFT_ASSERT(DriftComponentCompact(&bodies.c) && DriftComponentCompact(&tags.c), "Components didn't compact.");
+		u64 compact_nanos = wave_iterate(&bodies, &tags);
+		size_t compact_bytes = component_bytes(&bodies.c) + component_bytes(&tags.c);
+		
+		DRIFT_LOG("Wave %u: %u entities %.2f MB %.3f ms, %u entities %.2f MB %.3f ms, compacted %.2f MB %.3f ms.", wave,
+			wave_size + (wave ? survivors : 0), full_bytes/1e6, full_nanos/1e6,
+			survivors, sparse_bytes/1e6, sparse_nanos/1e6, compact_bytes/1e6, compact_nanos/1e6
+		);
+	}
+	
+	// Survivors must still be intact after compacting.
+	for(uint i = 0; i < live_count; i++){
+		uint idx = DriftComponentFind(&bodies.c, live[i]);
+		DRIFT_ASSERT(idx && bodies.entity[idx].id == live[i].id, "Component lost after compacting.");
+		DRIFT_ASSERT(DriftComponentFind(&tags.c, live[i]), "Component lost after compacting.");
+	}
+	
+	DriftDealloc(DriftSystemMem, live, (wave_size + survivors)*sizeof(*live));
+	DriftComponentDestroy(&bodies.c);
+	DriftComponentDestroy(&tags.c);
+	DriftEntitySetFree(&entities);
+}
+
+typedef struct {
+	DriftComponent c;
+	DriftEntity* entity;
+	DriftAffine* matrix;
+} BenchTransforms;
+
+static u64 join_sum_next(DriftJoin* join){
+	u64 sum = 0;
+	while(DriftJoinNext(join)){
+		sum += join->entity.id;
+		for(uint i = 1; i < join->count; i++) sum += DriftComponentGetEntities(join->joins[i].component)[*join->joins[i].variable].id;
+	}
+	return sum;
+}
+
+// Join the way it worked before picking a driver or merging: iterate joins[0] and hash into the rest.
+static u64 join_first_hashed(DriftComponentJoin* joins){
+	DriftJoin join = {.last = UINT32_MAX};
+	for(uint i = 0; joins[i].variable; i++){
+		*joins[i].variable = 0;
+		join.joins[join.count++] = joins[i];
+	}
+	return join_sum_next(&join);
+}
+
+static u64 join_sum(DriftComponentJoin* joins){
+	DriftJoin join = DriftJoinMake(joins);
+	return join_sum_next(&join);
+}
+
+static u64 best_nanos(u64 (*func)(DriftComponentJoin*), DriftComponentJoin* joins, u64* sum){
+	u64 best = UINT64_MAX;
+	for(uint rep = 0; rep < 20; rep++){
+		u64 t0 = DriftTimeNanos();
+		*sum = func(joins);
+		best = DRIFT_MIN(best, DriftTimeNanos() - t0);
+	}
+	return best;
+}
+
+// Times the joins from DriftDrawItems(), find_nearest_grabbable() and DriftPhysicsSyncTransforms() with game-like component sizes.
+// Each is run the old way, from the smallest component with hashing, and merged after sorting.
+void unit_test_join_bench(void){
+	uint n = 32*1024;
+	DriftEntitySet entities;
+	DriftEntitySetInit(&entities, DriftSystemMem);
+	
+	BenchTransforms transforms = {};
+	DriftComponentInit(&transforms.c, (DriftTableDesc){
+		.name = "@Transforms", .mem = DriftSystemMem,
+		.columns.arr = {DRIFT_DEFINE_COLUMN(transforms.entity), DRIFT_DEFINE_COLUMN(transforms.matrix)},
+	});
+	
+	WaveComponent bodies = {};
+	DriftComponentInit(&bodies.c, (DriftTableDesc){
+		.name = "@Bodies", .mem = DriftSystemMem,
+		.columns.arr = {DRIFT_DEFINE_COLUMN(bodies.entity), DRIFT_DEFINE_COLUMN(bodies.position), DRIFT_DEFINE_COLUMN(bodies.velocity)},
+	});
+	
+	ValueComponent items = {}, scan = {};
+	DriftComponentInit(&items.c, (DriftTableDesc){
+		.name = "@Items", .mem = DriftSystemMem,
+		.columns.arr = {DRIFT_DEFINE_COLUMN(items.entity), DRIFT_DEFINE_COLUMN(items.values), DRIFT_DEFINE_COLUMN(items.values_copied)},
+	});
+	DriftComponentInit(&scan.c, (DriftTableDesc){
+		.name = "@Scan", .mem = DriftSystemMem,
+		.columns.arr = {DRIFT_DEFINE_COLUMN(scan.entity), DRIFT_DEFINE_COLUMN(scan.values), DRIFT_DEFINE_COLUMN(scan.values_copied)},
+	});
+	
+	// Add components in a shuffled order, like entities that were created over time with recycled ids.
+	DriftEntity* list = DriftAlloc(DriftSystemMem, n*sizeof(*list));
+	for(uint i = 0; i < n; i++) list[i] = DriftEntitySetAquire(&entities, 0);
+	DriftRandom rand = {};
+	for(uint i = n - 1; i > 0; i--){
+		uint j = DriftRand32(&rand) % (i + 1);
+		DriftEntity tmp = list[i]; list[i] = list[j]; list[j] = tmp;
+	}
+	
+	for(uint i = 0; i < n; i++){
+		DriftEntity e = list[i];
+		uint roll = DriftRand32(&rand) % 100;
+		DriftComponentAdd(&transforms.c, e);
+		if(roll < 75) DriftComponentAdd(&bodies.c, e);
+		if(roll >= 75 && roll < 77) DriftComponentAdd(&items.c, e);
+		if(roll >= 75 && roll < 87) DriftComponentAdd(&scan.c, e);
+	}
+	
+	uint transform_idx, body_idx, item_idx, scan_idx;
+	struct {
+		const char* name;
+		DriftComponentJoin joins[4];
+	} cases[] = {
+		{"DriftDrawItems", {{&item_idx, &items.c}, {&transform_idx, &transforms.c}, {}}},
+		{"find_nearest_grabbable", {{&item_idx, &items.c}, {&scan_idx, &scan.c}, {&transform_idx, &transforms.c}, {}}},
+		{"DriftPhysicsSyncTransforms", {{&body_idx, &bodies.c}, {&transform_idx, &transforms.c}, {}}},
+		{"transforms with a rare tag", {{&transform_idx, &transforms.c}, {&item_idx, &items.c}, {}}},
+	};
+	
+	u64 first_nanos[4], smallest_nanos[4], merged_nanos[4];
+	for(uint i = 0; i < 4; i++){
+		u64 first_sum, smallest_sum;
+		first_nanos[i] = best_nanos(join_first_hashed, cases[i].joins, &first_sum);
+		smallest_nanos[i] = best_nanos(join_sum, cases[i].joins, &smallest_sum);
+		DRIFT_ASSERT(first_sum == smallest_sum, "Join results don't match.");
+	}
+	
+	u64 t0 = DriftTimeNanos();
+	DriftComponent* sorted[] = {&transforms.c, &bodies.c, &items.c, &scan.c};
+	for(uint i = 0; i < 4; i++) DRIFT_ASSERT(DriftComponentSort(sorted[i]) && sorted[i]->sorted, "Component wasn't sorted.");
+	u64 sort_nanos = DriftTimeNanos() - t0;
+	
+	// Sorting must keep the rows and index map in agreement.
+	for(uint i = 0; i < n; i++){
+		uint idx = DriftComponentFind(&transforms.c, list[i]);
+		DRIFT_ASSERT(transforms.entity[idx].id == list[i].id, "Index map is wrong after sorting.");
+	}
+	
+	for(uint i = 0; i < 4; i++){
+		u64 first_sum = join_first_hashed(cases[i].joins), merged_sum;
+		merged_nanos[i] = best_nanos(join_sum, cases[i].joins, &merged_sum);
+		DRIFT_ASSERT(first_sum == merged_sum, "Merged join results don't match.");
+		
+		DRIFT_LOG("Join %s: %.3f ms first, %.3f ms smallest, %.3f ms merged.", cases[i].name,
+			first_nanos[i]/1e6, smallest_nanos[i]/1e6, merged_nanos[i]/1e6
+		);
+	}
+	DRIFT_LOG("Sorted %u entities in 4 components in %.3f ms.", n, sort_nanos/1e6);
+	
+	// Removing breaks the order, joins must fall back to hashing.
+	DriftComponentRemove(&items.c, items.entity[1]);
+	DRIFT_ASSERT(!items.c.sorted || items.c.count <= 1, "Component should be unsorted after removing.");
+	u64 sum;
+	best_nanos(join_sum, cases[0].joins, &sum);
+	DRIFT_ASSERT(sum == join_first_hashed(cases[0].joins), "Join results don't match after removing.");
+	
+	DriftDealloc(DriftSystemMem, list, n*sizeof(*list));
+	DriftComponentDestroy(&transforms.c);
+	DriftComponentDestroy(&bodies.c);
+	DriftComponentDestroy(&items.c);
+	DriftComponentDestroy(&scan.c);
+	DriftEntitySetFree(&entities);
+}
+
+// Compare DriftComponentFind() throughput using the hash map and the sparse index.
+void unit_test_component_find_bench(void){
+	uint n = 32*1024, lookups = 1 << 20;
+	DriftEntitySet entities;
+	DriftEntitySetInit(&entities, DriftSystemMem);
+	
+	WaveComponent components[2] = {};
+	for(uint i = 0; i < 2; i++){
+		WaveComponent* c = components + i;
+		DriftComponentInit(&c->c, (DriftTableDesc){
+			.name = "@Find", .mem = DriftSystemMem,
+			.columns.arr = {DRIFT_DEFINE_COLUMN(c->entity), DRIFT_DEFINE_COLUMN(c->position), DRIFT_DEFINE_COLUMN(c->velocity)},
+		});
+	}
+	DriftComponentMakeSparse(&components[1].c);
+	
+	// Half of the entities have the component, added in a random order.
+	DriftRandom rand = {};
+	DriftEntity* list = DriftAlloc(DriftSystemMem, n*sizeof(*list));
+	for(uint i = 0; i < n; i++) list[i] = DriftEntitySetAquire(&entities, 0);
+	for(uint i = 0; i < n; i++){
+		DriftEntity e = list[DriftRand32(&rand) % n];
+		for(uint j = 0; j < 2; j++) DriftComponentAdd2(&components[j].c, e, false);
+	}
+	
+	DriftEntity* keys = DriftAlloc(DriftSystemMem, lookups*sizeof(*keys));
+	for(uint i = 0; i < lookups; i++) keys[i] = list[DriftRand32(&rand) % n];
+	
+	u64 sums[2], nanos[2];
+	for(uint j = 0; j < 2; j++){
+		DriftComponent* component = &components[j].c;
+		nanos[j] = UINT64_MAX;
+		for(uint rep = 0; rep < 5; rep++){
+			u64 sum = 0, t0 = DriftTimeNanos();
+			for(uint i = 0; i < lookups; i++){
+				uint idx = DriftComponentFind(component, keys[i]);
+				sum += DriftComponentGetEntities(component)[idx].id;
+			}
+			nanos[j] = DRIFT_MIN(nanos[j], DriftTimeNanos() - t0);
+			sums[j] = sum;
+		}
+	}
+	DRIFT_ASSERT(sums[0] == sums[1], "Backends found different rows.");
+	
+	size_t sparse_bytes = 0;
+	for(uint page = 0; page < components[1].c.sparse_page_count; page++) sparse_bytes += components[1].c.sparse_page_counts[page] ? SPARSE_PAGE_BYTES : 0;
+	DriftTable* map = &components[0].c.map.table;
+	DRIFT_LOG("DriftComponentFind() with %u of %u entities: map %.2f ns (%.0f kB), sparse %.2f ns (%.0f kB).",
+		components[0].c.count, n, (double)nanos[0]/lookups, map->row_capacity*map->row_size/1e3, (double)nanos[1]/lookups, sparse_bytes/1e3
+	);
+	
+	// Reusing an index replaces the dead entity's row.
+	WaveComponent* sparse = components + 1;
+	DriftEntity dead = sparse->entity[1];
+	DriftEntity reused = DriftEntityMake(DriftEntityIndex(dead), DriftEntityGeneration(dead) + 1, 0);
+	uint count = sparse->c.count;
+	DriftComponentAdd(&sparse->c, reused);
+	DRIFT_ASSERT(sparse->c.count == count && DriftComponentFind(&sparse->c, dead) == 0 && DriftComponentFind(&sparse->c, reused), "Stale row not replaced.");
+	
+	// Emptied pages are released when compacting.
+	for(uint i = 0; i < n; i++) DriftComponentRemove(&sparse->c, list[i]);
+	DriftComponentRemove(&sparse->c, reused);
+	DRIFT_ASSERT(sparse->c.count == 0 && DriftComponentCompact(&sparse->c), "Sparse pages not released.");
+	for(uint page = 0; page < sparse->c.sparse_page_count; page++) DRIFT_ASSERT(sparse->c.sparse_pages[page] == SPARSE_EMPTY_PAGE, "Sparse page not released.");
+	
+	DriftDealloc(DriftSystemMem, keys, lookups*sizeof(*keys));
+	DriftDealloc(DriftSystemMem, list, n*sizeof(*list));
+	for(uint j = 0; j < 2; j++) DriftComponentDestroy(&components[j].c);
+	DriftEntitySetFree(&entities);
+}
+
+#define GC_BENCH_COMPONENTS 20
+
+static void gc_bench_fill(DriftEntitySet* entities, WaveComponent* components, uint n, uint* live){
+	DriftEntitySetInit(entities, DriftSystemMem);
+	for(uint i = 0; i < GC_BENCH_COMPONENTS; i++){
+		WaveComponent* c = components + i;
+		DriftComponentInit(&c->c, (DriftTableDesc){
+			.name = "@GC", .mem = DriftSystemMem,
+			.columns.arr = {DRIFT_DEFINE_COLUMN(c->entity), DRIFT_DEFINE_COLUMN(c->position), DRIFT_DEFINE_COLUMN(c->velocity)},
+		});
+		if(i % 2) DriftComponentMakeSparse(&c->c);
+		live[i] = 0;
+	}
+	
+	// Give every entity a few components, then retire every other one without removing its rows.
+	DriftRandom rand = {};
+	for(uint i = 0; i < n; i++){
+		DriftEntity e = DriftEntitySetAquire(entities, 0);
+		for(uint j = 0; j < 5; j++){
+			WaveComponent* c = components + DriftRand32(&rand) % GC_BENCH_COMPONENTS;
+			if(DriftComponentFind(&c->c, e)) continue;
+			
+			uint idx = DriftComponentAdd(&c->c, e);
+			c->position[idx] = (DriftVec2){(float)DriftEntityIndex(e), 0};
+			if(i % 2) live[c - components]++;
+		}
+		if(i % 2 == 0) DriftEntitySetRetire(entities, e);
+	}
+}
+
+// Drain 20 components that are half full of dead rows incrementally and in bulk.
+void unit_test_component_gc_bench(void){
+	uint n = 64*1024;
+	DriftEntitySet entities;
+	WaveComponent components[GC_BENCH_COMPONENTS];
+	uint live[GC_BENCH_COMPONENTS], rows = 0;
+	
+	// The incremental GC as it's called every tick.
+	gc_bench_fill(&entities, components, n, live);
+	for(uint i = 0; i < GC_BENCH_COMPONENTS; i++) rows += components[i].c.count;
+	uint ticks = 0;
+	u64 t0 = DriftTimeNanos();
+	for(bool dirty = true; dirty; ticks++){
+		dirty = false;
+		for(uint i = 0; i < GC_BENCH_COMPONENTS; i++){
+			DriftComponentGC(&components[i].c, &entities, 16);
+			dirty |= components[i].c.count != live[i];
+		}
+	}
+	u64 incremental_nanos = DriftTimeNanos() - t0;
+	for(uint i = 0; i < GC_BENCH_COMPONENTS; i++) DriftComponentDestroy(&components[i].c);
+	DriftEntitySetFree(&entities);
+	
+	// All at once.
+	gc_bench_fill(&entities, components, n, live);
+	DriftComponent* list[GC_BENCH_COMPONENTS];
+	for(uint i = 0; i < GC_BENCH_COMPONENTS; i++) list[i] = &components[i].c;
+	t0 = DriftTimeNanos();
+	uint removed = DriftComponentGCAll(NULL, list, GC_BENCH_COMPONENTS, &entities);
+	u64 bulk_nanos = DriftTimeNanos() - t0;
+	
+	uint expected = 0;
+	for(uint i = 0; i < GC_BENCH_COMPONENTS; i++){
+		WaveComponent* c = components + i;
+		DRIFT_ASSERT(c->c.count == live[i], "Wrong number of rows left.");
+		expected += live[i];
+		DRIFT_COMPONENT_FOREACH(&c->c, idx){
+			DriftEntity e = c->entity[idx];
+			DRIFT_ASSERT(DriftEntitySetCheck(&entities, e), "Dead row was kept.");
+			DRIFT_ASSERT(DriftComponentFind(&c->c, e) == idx, "Index is wrong after GC.");
+			DRIFT_ASSERT(c->position[idx].x == DriftEntityIndex(e), "Row data was not moved with the entity.");
+		}
+	}
+	DRIFT_ASSERT(removed == rows - expected, "Wrong number of rows removed.");
+	
+	for(uint i = 0; i < GC_BENCH_COMPONENTS; i++) DriftComponentDestroy(&components[i].c);
+	DriftEntitySetFree(&entities);
+	
+	DRIFT_LOG("GC %u of %u rows in %u components: incremental %u ticks %.3f ms, bulk %.3f ms.",
+		removed, rows, GC_BENCH_COMPONENTS, ticks, incremental_nanos/1e6, bulk_nanos/1e6
+	);
+}
+
+typedef struct {
+	DriftComponent c;
+	DriftEntity* entity;
+	DriftVec2* position;
+	DriftVec2* velocity;
+	DriftVec2* rotation;
+	float* angular_velocity;
+	float* mass_inv;
+	float* moment_inv;
+	float* radius;
+} SpatialBodies;
+
+#define SPATIAL_BENCH_SIZE 2048.0f
+#define SPATIAL_BENCH_CELLS 128u
+
+// Find overlapping bodies with a uniform grid, a stand in for the RTree's pairs.
+static DRIFT_ARRAY(DriftIndexPair) spatial_bench_pairs(SpatialBodies* bodies){
+	uint* head = DriftAlloc(DriftSystemMem, SPATIAL_BENCH_CELLS*SPATIAL_BENCH_CELLS*sizeof(*head));
+	uint* next = DriftAlloc(DriftSystemMem, bodies->c.table.row_count*sizeof(*next));
+	memset(head, 0, SPATIAL_BENCH_CELLS*SPATIAL_BENCH_CELLS*sizeof(*head));
+	
+	float cell_size = SPATIAL_BENCH_SIZE/SPATIAL_BENCH_CELLS;
+	DRIFT_COMPONENT_FOREACH(&bodies->c, idx){
+		uint cx = (uint)(bodies->position[idx].x/cell_size), cy = (uint)(bodies->position[idx].y/cell_size);
+		uint cell = cx + cy*SPATIAL_BENCH_CELLS;
+		next[idx] = head[cell];
+		head[cell] = idx;
+	}
+	
+	DRIFT_ARRAY(DriftIndexPair) pairs = DRIFT_ARRAY_NEW(DriftSystemMem, 4*bodies->c.count, DriftIndexPair);
+	DRIFT_COMPONENT_FOREACH(&bodies->c, i){
+		DriftVec2 p = bodies->position[i];
+		int cx = (int)(p.x/cell_size), cy = (int)(p.y/cell_size);
+		for(int y = DRIFT_MAX(cy - 1, 0); y <= DRIFT_MIN(cy + 1, (int)SPATIAL_BENCH_CELLS - 1); y++){
+			for(int x = DRIFT_MAX(cx - 1, 0); x <= DRIFT_MIN(cx + 1, (int)SPATIAL_BENCH_CELLS - 1); x++){
+				for(uint j = head[x + y*SPATIAL_BENCH_CELLS]; j; j = next[j]){
+					float r = bodies->radius[i] + bodies->radius[j];
+					if(i < j && DriftVec2DistanceSq(p, bodies->position[j]) < r*r) DRIFT_ARRAY_PUSH(pairs, ((DriftIndexPair){i, j}));
+				}
+			}
+		}
+	}
+	
+	DriftDealloc(DriftSystemMem, next, bodies->c.table.row_count*sizeof(*next));
+	DriftDealloc(DriftSystemMem, head, SPATIAL_BENCH_CELLS*SPATIAL_BENCH_CELLS*sizeof(*head));
+	return pairs;
+}
+
+// Push overlapping pairs apart, touching the same columns as a contact solver.
+static void spatial_bench_solve(SpatialBodies* bodies, DRIFT_ARRAY(DriftIndexPair) pairs){
+	DRIFT_ARRAY_FOREACH(pairs, pair){
+		uint i = pair->idx0, j = pair->idx1;
+		DriftVec2 n = DriftVec2Normalize(DriftVec2Sub(bodies->position[i], bodies->position[j]));
+		float vn = DriftVec2Dot(n, DriftVec2Sub(bodies->velocity[i], bodies->velocity[j]));
+		float jn = -vn/(bodies->mass_inv[i] + bodies->mass_inv[j]);
+		bodies->velocity[i] = DriftVec2FMA(bodies->velocity[i], n, jn*bodies->mass_inv[i]);
+		bodies->velocity[j] = DriftVec2FMA(bodies->velocity[j], n, -jn*bodies->mass_inv[j]);
+		bodies->angular_velocity[i] += 1e-3f*bodies->moment_inv[i]*bodies->rotation[i].y;
+		bodies->angular_velocity[j] -= 1e-3f*bodies->moment_inv[j]*bodies->rotation[j].y;
+	}
+}
+
+// Time a physics step like workload on 20k bodies added in random order, then again after sorting them spatially.
+void unit_test_component_spatial_bench(void){
+	uint n = 20000;
+	DriftEntitySet entities;
+	DriftEntitySetInit(&entities, DriftSystemMem);
+	
+	SpatialBodies bodies = {};
+	DriftComponentInit(&bodies.c, (DriftTableDesc){
+		.name = "@Bodies", .mem = DriftSystemMem,
+		.columns.arr = {
+			DRIFT_DEFINE_COLUMN(bodies.entity), DRIFT_DEFINE_COLUMN(bodies.position), DRIFT_DEFINE_COLUMN(bodies.velocity),
+			DRIFT_DEFINE_COLUMN(bodies.rotation), DRIFT_DEFINE_COLUMN(bodies.angular_velocity),
+			DRIFT_DEFINE_COLUMN(bodies.mass_inv), DRIFT_DEFINE_COLUMN(bodies.moment_inv), DRIFT_DEFINE_COLUMN(bodies.radius),
+		},
+	});
+	DriftComponentMakeSparse(&bodies.c);
+	
+	BenchTransforms transforms = {};
+	DriftComponentInit(&transforms.c, (DriftTableDesc){
+		.name = "@Transforms", .mem = DriftSystemMem,
+		.columns.arr = {DRIFT_DEFINE_COLUMN(transforms.entity), DRIFT_DEFINE_COLUMN(transforms.matrix)},
+	});
+	DriftComponentMakeSparse(&transforms.c);
+	
+	// Bodies are created in a random order all over the world, and transforms in a different one.
+	DriftRandom rand = {};
+	DriftEntity* list = DriftAlloc(DriftSystemMem, n*sizeof(*list));
+	for(uint i = 0; i < n; i++){
+		DriftEntity e = list[i] = DriftEntitySetAquire(&entities, 0);
+		uint idx = DriftComponentAdd(&bodies.c, e);
+		bodies.position[idx] = (DriftVec2){(SPATIAL_BENCH_SIZE - 1)*DriftRandomUNorm(&rand), (SPATIAL_BENCH_SIZE - 1)*DriftRandomUNorm(&rand)};
+		bodies.velocity[idx] = (DriftVec2){DriftRandomSNorm(&rand), DriftRandomSNorm(&rand)};
+		bodies.rotation[idx] = (DriftVec2){1, 0};
+		bodies.mass_inv[idx] = bodies.moment_inv[idx] = 1;
+		bodies.radius[idx] = 6;
+	}
+	for(uint i = n - 1; i > 0; i--){
+		uint j = DriftRand32(&rand) % (i + 1);
+		DriftEntity tmp = list[i]; list[i] = list[j]; list[j] = tmp;
+	}
+	for(uint i = 0; i < n; i++) DriftComponentAdd(&transforms.c, list[i]);
+	
+	u64 nanos[2][3];
+	uint pair_count = 0;
+	for(uint pass = 0; pass < 2; pass++){
+		if(pass == 1){
+			u64 t0 = DriftTimeNanos();
+			DriftComponentSortSpatial(&bodies.c, bodies.position, (DriftComponent*[]){&transforms.c, NULL});
+			DRIFT_LOG("Spatially sorted %u bodies and transforms in %.3f ms.", n, (DriftTimeNanos() - t0)/1e6);
+		}
+		
+		for(uint i = 0; i < 3; i++) nanos[pass][i] = UINT64_MAX;
+		for(uint rep = 0; rep < 10; rep++){
+			u64 t0 = DriftTimeNanos();
+			DRIFT_ARRAY(DriftIndexPair) pairs = spatial_bench_pairs(&bodies);
+			u64 t1 = DriftTimeNanos();
+			for(uint i = 0; i < 4; i++) spatial_bench_solve(&bodies, pairs);
+			u64 t2 = DriftTimeNanos();
+			
+			uint body_idx, transform_idx;
+			DriftJoin join = DriftJoinMake((DriftComponentJoin[]){{&body_idx, &bodies.c}, {&transform_idx, &transforms.c}, {}});
+			while(DriftJoinNext(&join)){
+				DriftVec2 p = bodies.position[body_idx], q = bodies.rotation[body_idx];
+				transforms.matrix[transform_idx] = (DriftAffine){q.x, q.y, -q.y, q.x, p.x, p.y};
+			}
+			u64 t3 = DriftTimeNanos();
+			
+			nanos[pass][0] = DRIFT_MIN(nanos[pass][0], t1 - t0);
+			nanos[pass][1] = DRIFT_MIN(nanos[pass][1], t2 - t1);
+			nanos[pass][2] = DRIFT_MIN(nanos[pass][2], t3 - t2);
+			pair_count = DriftArrayLength(pairs);
+			DriftArrayFree(pairs);
+		}
+	}
+	
+	// The index must follow the rows, and the transforms must line up with the bodies.
+	for(uint i = 0; i < n; i++){
+		uint body_idx = DriftComponentFind(&bodies.c, list[i]), transform_idx = DriftComponentFind(&transforms.c, list[i]);
+		DRIFT_ASSERT(bodies.entity[body_idx].id == list[i].id, "Body index is wrong after sorting.");
+		DRIFT_ASSERT(body_idx == transform_idx, "Transforms not in the same order as bodies.");
+		DRIFT_ASSERT(transforms.matrix[transform_idx].x == bodies.position[body_idx].x, "Transform data not moved with its row.");
+	}
+	
+	DRIFT_LOG("Spatial bench, %u bodies with %u pairs. Pairs %.3f -> %.3f ms, solve %.3f -> %.3f ms, sync transforms %.3f -> %.3f ms.", n, pair_count,
+		nanos[0][0]/1e6, nanos[1][0]/1e6, nanos[0][1]/1e6, nanos[1][1]/1e6, nanos[0][2]/1e6, nanos[1][2]/1e6
+	);
+	
+	DriftDealloc(DriftSystemMem, list, n*sizeof(*list));
+	DriftComponentDestroy(&bodies.c);
+	DriftComponentDestroy(&transforms.c);
+	DriftEntitySetFree(&entities);
+}
 #endif
@@ -13,28 +13,90 @@ You should have received a copy of the GNU General Public License along with Ver
 #include "drift_base.h"
 
 _Static_assert(DRIFT_ENTITY_INDEX_BITS + DRIFT_ENTITY_GENERATION_BITS + DRIFT_ENTITY_TAG_BITS <= 8*sizeof(DriftEntity), "Too many Entity bits.");
-_Static_assert(DRIFT_ENTITY_INDEX_BITS <= 24, "Sanity check on entity array size.");
-_Static_assert(DRIFT_ENTITY_GENERATION_BITS <= 8, "Generation needs to fit into a u8.");
+_Static_assert(DRIFT_ENTITY_INDEX_BITS <= 32, "Entity indexes need to fit into a u32.");
+_Static_assert(DRIFT_ENTITY_GENERATION_BITS <= 32, "Generation needs to fit into a u32.");
 
-#define DRIFT_ENTITY_SET_INDEX_MASK (DRIFT_ENTITY_SET_INDEX_COUNT - 1)
+#define MIN_INDEX_CAPACITY 1024u
 
-DriftEntitySet* DriftEntitySetInit(DriftEntitySet* set){
-	memset(set, 0x00, sizeof(*set));
+DriftEntitySet* DriftEntitySetInit(DriftEntitySet* set, DriftMem* mem){
+	*set = (DriftEntitySet){.mem = mem};
 	// Pre-allocate the null entity.
 	DriftEntitySetAquire(set, 0);
 	return set;
 }
 
+void DriftEntitySetFree(DriftEntitySet* set){
+	DriftDealloc(set->mem, set->pooled_indexes, set->pool_capacity*sizeof(*set->pooled_indexes));
+	DriftDealloc(set->mem, set->generations, set->index_capacity*sizeof(*set->generations));
+	DriftDealloc(set->mem, set->component_masks, set->index_capacity*sizeof(*set->component_masks));
+}
+
+static void resize_indexes(DriftEntitySet* set, uint capacity){
+	uint old_capacity = set->index_capacity;
+	set->generations = DriftRealloc(set->mem, set->generations, old_capacity*sizeof(*set->generations), capacity*sizeof(*set->generations));
+	set->component_masks = DriftRealloc(set->mem, set->component_masks, old_capacity*sizeof(*set->component_masks), capacity*sizeof(*set->component_masks));
+	set->index_capacity = capacity;
+}
+
+// Resize the ring buffer, unwrapping it so it starts at 0.
+static void resize_pool(DriftEntitySet* set, uint capacity){
+	u32* pool = DriftAlloc(set->mem, capacity*sizeof(*pool));
+	uint count = set->pool_head - set->pool_tail;
+	for(uint i = 0; i < count; i++) pool[i] = set->pooled_indexes[(set->pool_tail + i) & (set->pool_capacity - 1)];
+	
+	DriftDealloc(set->mem, set->pooled_indexes, set->pool_capacity*sizeof(*set->pooled_indexes));
+	set->pooled_indexes = pool;
+	set->pool_capacity = capacity;
+	set->pool_tail = 0;
+	set->pool_head = count;
+}
+
+void DriftEntitySetIO(DriftEntitySet* set, DriftIO* io){
+	struct {uint entity_count, pool_count;} header = {set->entity_count, set->pool_head - set->pool_tail};
+	DriftIOBlock(io, "entities", &header, sizeof(header));
+	if(io->read){
+		bool valid = 0 < header.entity_count && header.entity_count <= DRIFT_ENTITY_SET_MAX_ENTITIES && header.pool_count < header.entity_count;
+		if(!valid){
+			DRIFT_LOG("Bad entity set header (%u entities, %u pooled).", header.entity_count, header.pool_count);
+			io->abort = true;
+			return;
+		}
+		
+		// Replace the arrays with ones sized for the loaded set, the pool is loaded unwrapped.
+		DriftEntitySetFree(set);
+		DriftEntitySet loaded = {.mem = set->mem, .entity_count = header.entity_count};
+		memcpy(loaded.components, set->components, sizeof(loaded.components));
+		*set = loaded;
+		
+		resize_pool(set, DRIFT_MAX((uint)DriftNextPOT(header.pool_count), MIN_INDEX_CAPACITY));
+		set->pool_head = header.pool_count;
+		resize_indexes(set, DRIFT_MAX((uint)DriftNextPOT(header.entity_count), MIN_INDEX_CAPACITY));
+		memset(set->component_masks, 0, set->index_capacity*sizeof(*set->component_masks));
+	}
+	
+	DriftIOBlock(io, "generations", set->generations, set->entity_count*sizeof(*set->generations));
+	
+	// Write the ring buffer in two parts when it wraps around.
+	uint tail = set->pool_tail & (set->pool_capacity - 1), count = set->pool_head - set->pool_tail;
+	uint first = DRIFT_MIN(count, set->pool_capacity - tail);
+	DriftIOBlock(io, "pooled_indexes", set->pooled_indexes + tail, first*sizeof(*set->pooled_indexes));
+	DriftIOBlock(io, "pooled_indexes", set->pooled_indexes, (count - first)*sizeof(*set->pooled_indexes));
+}
+
 DriftEntity DriftEntitySetAquire(DriftEntitySet* set, uint tag){
-	uint pool_size = (set->pool_head - set->pool_tail) & DRIFT_ENTITY_SET_INDEX_MASK;
+	uint pool_size = set->pool_head - set->pool_tail;
 	if(pool_size < DRIFT_ENTITY_SET_MIN_FREE_INDEXES){
 		// Start tracking a new index.
 		uint idx = set->entity_count++;
-		DRIFT_ASSERT_HARD(idx < DRIFT_ENTITY_SET_INDEX_COUNT, "Entity index overflow.");
+		DRIFT_ASSERT_HARD(set->entity_count <= DRIFT_ENTITY_SET_MAX_ENTITIES, "Entity index overflow.");
+		if(idx == set->index_capacity) resize_indexes(set, DRIFT_MAX(2*set->index_capacity, MIN_INDEX_CAPACITY));
+		
+		set->generations[idx] = 0;
+		set->component_masks[idx] = 0;
 		return DriftEntityMake(idx, 0, tag);
 	} else {
 		// A free index was available, reuse it.
-		uint idx = set->pooled_indexes[set->pool_tail++ & DRIFT_ENTITY_SET_INDEX_MASK];
+		uint idx = set->pooled_indexes[set->pool_tail++ & (set->pool_capacity - 1)];
 		return DriftEntityMake(idx, set->generations[idx], tag);
 	}
 }
@@ -43,8 +105,77 @@ void DriftEntitySetRetire(DriftEntitySet* set, DriftEntity entity){
 	DRIFT_ASSERT_WARN(DriftEntitySetCheck(set, entity), "Trying to Retire an entity that does not exist.");
 	
 	uint idx = DriftEntityIndex(entity);
-	set->generations[idx]++;
-	set->pooled_indexes[set->pool_head++ & DRIFT_ENTITY_SET_INDEX_MASK] = idx;
+	set->generations[idx] = (set->generations[idx] + 1) & DRIFT_ENTITY_GENERATION_MASK;
+	set->component_masks[idx] = 0;
+	
+	if(set->pool_head - set->pool_tail == set->pool_capacity) resize_pool(set, DRIFT_MAX(2*set->pool_capacity, MIN_INDEX_CAPACITY));
+	set->pooled_indexes[set->pool_head++ & (set->pool_capacity - 1)] = idx;
+}
+
+void DriftEntitySetAddComponent(DriftEntitySet* set, DriftComponent* component){
+	uint bit = 0;
+	while(bit < DRIFT_ENTITY_SET_MAX_COMPONENTS && set->components[bit]) bit++;
+	DRIFT_ASSERT_HARD(bit < DRIFT_ENTITY_SET_MAX_COMPONENTS, "Too many components in entity set.");
+	
+	set->components[bit] = component;
+	component->entities = set;
+	component->entity_mask = 1llu << bit;
+	
+	// Add any entities the component already has.
+	DriftEntity* entities = DriftComponentGetEntities(component);
+	DRIFT_COMPONENT_FOREACH(component, idx) set->component_masks[DriftEntityIndex(entities[idx])] |= component->entity_mask;
+}
+
+static u64 entity_components(DriftEntitySet* set, DriftEntity entity, u64 all_components){
+	// Dead entities may have left components behind for the GC, and their index may have been reused.
+	return DriftEntitySetCheck(set, entity) ? set->component_masks[DriftEntityIndex(entity)] : all_components;
+}
+
+void DriftEntitySetDestroy(DriftEntitySet* set, DriftEntity* entities, uint count){
+	u64 all_components = 0;
+	for(uint bit = 0; bit < DRIFT_ENTITY_SET_MAX_COMPONENTS; bit++) if(set->components[bit]) all_components |= 1llu << bit;
+	
+	// Bucket the entities by component so each component's table and map are processed together.
+	uint offsets[DRIFT_ENTITY_SET_MAX_COMPONENTS + 1] = {};
+	for(uint i = 0; i < count; i++){
+		for(u64 mask = entity_components(set, entities[i], all_components); mask; mask &= mask - 1) offsets[__builtin_ctzll(mask) + 1]++;
+	}
+	for(uint bit = 0; bit < DRIFT_ENTITY_SET_MAX_COMPONENTS; bit++) offsets[bit + 1] += offsets[bit];
+	
+	uint total = offsets[DRIFT_ENTITY_SET_MAX_COMPONENTS];
+	DriftEntity* batches = total ? DriftAlloc(DriftSystemMem, total*sizeof(*batches)) : NULL;
+	uint cursors[DRIFT_ENTITY_SET_MAX_COMPONENTS];
+	memcpy(cursors, offsets, sizeof(cursors));
+	for(uint i = 0; i < count; i++){
+		for(u64 mask = entity_components(set, entities[i], all_components); mask; mask &= mask - 1) batches[cursors[__builtin_ctzll(mask)]++] = entities[i];
+	}
+	
+	for(uint bit = 0; bit < DRIFT_ENTITY_SET_MAX_COMPONENTS; bit++){
+		DriftComponent* component = set->components[bit];
+		for(uint i = offsets[bit]; i < offsets[bit + 1]; i++) DriftComponentRemove(component, batches[i]);
+	}
+	if(batches) DriftDealloc(DriftSystemMem, batches, total*sizeof(*batches));
+	
+	// Retire the entities.
+	for(uint i = 0; i < count; i++){
+		if(DriftEntitySetCheck(set, entities[i])) DriftEntitySetRetire(set, entities[i]);
+	}
+}
+
+u64* DriftEntitySetLiveBits(DriftEntitySet* set, DriftMem* mem){
+	size_t size = DriftEntitySetLiveBitsSize(set);
+	u64* bits = DriftAlloc(mem, size);
+	memset(bits, 0xFF, size);
+	
+	// Clear the null entity, the unused tail of the last word and everything waiting in the pool.
+	bits[0] &= ~1llu;
+	if(set->entity_count & 63) bits[set->entity_count/64] &= (1llu << (set->entity_count & 63)) - 1;
+	for(uint i = set->pool_tail; i != set->pool_head; i++){
+		uint idx = set->pooled_indexes[i & (set->pool_capacity - 1)];
+		bits[idx/64] &= ~(1llu << (idx & 63));
+	}
+	
+	return bits;
 }
 
 #if DRIFT_DEBUG
@@ -56,17 +187,17 @@ void unit_test_entity(void){
 		DRIFT_ASSERT(DriftEntityTag(entity) == 6, "Incorrect tag.");
 	}{
 		DriftEntity entity = DriftEntityMake(~0, ~0, ~0);
-		DRIFT_ASSERT(DriftEntityIndex(entity) == (1 << DRIFT_ENTITY_INDEX_BITS) - 1, "Incorrect index.");
-		DRIFT_ASSERT(DriftEntityGeneration(entity) == (1 << DRIFT_ENTITY_GENERATION_BITS) - 1, "Incorrect generation.");
+		DRIFT_ASSERT(DriftEntityIndex(entity) == (u32)~0, "Incorrect index.");
+		DRIFT_ASSERT(DriftEntityGeneration(entity) == DRIFT_ENTITY_GENERATION_MASK, "Incorrect generation.");
 		DRIFT_ASSERT(DriftEntityTag(entity) == (1 << DRIFT_ENTITY_TAG_BITS) - 1, "Incorrect tag.");
 	}
 	
 	DRIFT_LOG("Entity tests passed.");
 	
-	static DriftEntitySet entities = {};
-	DriftEntitySetInit(&entities);
+	DriftEntitySet entities;
+	DriftEntitySetInit(&entities, DriftSystemMem);
 	
-	uint generations = (1 << DRIFT_ENTITY_GENERATION_BITS);
+	uint generations = 4;
 	uint tag = 0;//(1 << DRIFT_ENTITY_TAG_BITS) - 1;
 
 	DriftEntity zero = {0};
@@ -85,10 +216,167 @@ void unit_test_entity(void){
 		}
 	}
 	
+	// Cycling through all 2^24 generations is too slow, so skip ahead to the last one.
+	for(uint idx = 1; idx < DRIFT_ENTITY_SET_MIN_FREE_INDEXES + 1; idx++) entities.generations[idx] = DRIFT_ENTITY_GENERATION_MASK;
+	for(uint idx = 1; idx < DRIFT_ENTITY_SET_MIN_FREE_INDEXES + 1; idx++){
+		DriftEntity entity = DriftEntitySetAquire(&entities, tag);
+		DRIFT_ASSERT(DriftEntityGeneration(entity) == DRIFT_ENTITY_GENERATION_MASK, "Incorrect generation.");
+		DriftEntitySetRetire(&entities, entity);
+	}
+	
 	// Expected to wrap around finally.
 	DriftEntity entity = DriftEntitySetAquire(&entities, 0);
 	DRIFT_ASSERT(entity.id == 1, "Incorrect id.");
+	DriftEntitySetFree(&entities);
 	
 	DRIFT_LOG("EntitySet tests passed.");
 }
+
+#define DESTROY_COMPONENTS 20
+
+typedef struct {
+	DriftComponent c;
+	DriftEntity* entity;
+	DriftVec2* value;
+} DestroyComponent;
+
+// Destroy 10k entities at once, comparing a search of every component against the membership masks.
+void unit_test_entity_destroy(void){
+	uint n = 10000;
+	DriftEntitySet entities;
+	static DestroyComponent components[DESTROY_COMPONENTS];
+	DriftEntity* list = DriftAlloc(DriftSystemMem, n*sizeof(*list));
+	DriftRandom rand = {};
+	
+	for(uint pass = 0; pass < 2; pass++){
+		bool masked = pass == 1;
+		DriftEntitySetInit(&entities, DriftSystemMem);
+		for(uint i = 0; i < DESTROY_COMPONENTS; i++){
+			DestroyComponent* component = components + i;
+			DriftComponentInit(&component->c, (DriftTableDesc){
+				.name = "@Destroy", .mem = DriftSystemMem,
+				.columns.arr = {DRIFT_DEFINE_COLUMN(component->entity), DRIFT_DEFINE_COLUMN(component->value)},
+			});
+			if(masked) DriftEntitySetAddComponent(&entities, &component->c);
+		}
+		
+		// Like most game entities, give each one a few components.
+		for(uint i = 0; i < n; i++){
+			DriftEntity e = list[i] = DriftEntitySetAquire(&entities, 0);
+			for(uint j = 0; j < 3; j++) DriftComponentAdd2(&components[DriftRand32(&rand) % DESTROY_COMPONENTS].c, e, false);
+		}
+		
+		u64 t0 = DriftTimeNanos();
+		if(masked){
+			DriftEntitySetDestroy(&entities, list, n);
+		} else {
+			for(uint i = 0; i < DESTROY_COMPONENTS; i++){
+				for(uint j = 0; j < n; j++) DriftComponentRemove(&components[i].c, list[j]);
+			}
+			for(uint j = 0; j < n; j++) DriftEntitySetRetire(&entities, list[j]);
+		}
+		u64 nanos = DriftTimeNanos() - t0;
+		
+		for(uint i = 0; i < DESTROY_COMPONENTS; i++){
+			DRIFT_ASSERT(components[i].c.count == 0, "Components not removed.");
+			DriftComponentDestroy(&components[i].c);
+		}
+		DriftEntitySetFree(&entities);
+		DRIFT_LOG("Destroyed %u entities with %u components in %.3f ms (%s).", n, DESTROY_COMPONENTS, nanos/1e6, masked ? "masks" : "search");
+	}
+	
+	DriftDealloc(DriftSystemMem, list, n*sizeof(*list));
+}
+
+#define STRESS_COMPONENTS 4
+
+// Create, iterate and destroy a million entities spread across a few components.
+void unit_test_entity_stress(void){
+	uint n = 1 << 20;
+	DriftEntitySet entities;
+	DriftEntitySetInit(&entities, DriftSystemMem);
+	
+	// Bodies and positions on everything, health on half and a rare tag.
+	DestroyComponent components[STRESS_COMPONENTS] = {};
+	const char* names[STRESS_COMPONENTS] = {"@Bodies", "@Positions", "@Health", "@Tag"};
+	uint percent[STRESS_COMPONENTS] = {100, 100, 50, 5};
+	for(uint i = 0; i < STRESS_COMPONENTS; i++){
+		DestroyComponent* component = components + i;
+		DriftComponentInit(&component->c, (DriftTableDesc){
+			.name = names[i], .mem = DriftSystemMem,
+			.columns.arr = {DRIFT_DEFINE_COLUMN(component->entity), DRIFT_DEFINE_COLUMN(component->value)},
+		});
+		DriftEntitySetAddComponent(&entities, &component->c);
+	}
+	DriftComponentMakeSparse(&components[0].c);
+	DriftComponentMakeSparse(&components[1].c);
+	
+	DriftEntity* list = DriftAlloc(DriftSystemMem, n*sizeof(*list));
+	DriftRandom rand = {};
+	uint adds = 0;
+	
+	u64 t0 = DriftTimeNanos();
+	for(uint i = 0; i < n; i++){
+		DriftEntity e = list[i] = DriftEntitySetAquire(&entities, 0);
+		uint roll = DriftRand32(&rand) % 100;
+		for(uint j = 0; j < STRESS_COMPONENTS; j++){
+			if(roll < percent[j]){
+				uint idx = DriftComponentAdd(&components[j].c, e);
+				components[j].value[idx] = (DriftVec2){(float)i, 1};
+				adds++;
+			}
+		}
+	}
+	u64 create_nanos = DriftTimeNanos() - t0;
+	
+	uint body_idx, position_idx, health_idx, visited = 0;
+	t0 = DriftTimeNanos();
+	DriftJoin join = DriftJoinMake((DriftComponentJoin[]){
+		{&body_idx, &components[0].c},
+		{&position_idx, &components[1].c},
+		{&health_idx, &components[2].c},
+		{},
+	});
+	while(DriftJoinNext(&join)){
+		components[1].value[position_idx].x += components[0].value[body_idx].y*components[2].value[health_idx].y;
+		visited++;
+	}
+	u64 iterate_nanos = DriftTimeNanos() - t0;
+	DRIFT_ASSERT(visited == components[2].c.count, "Join visited the wrong number of entities.");
+	
+	t0 = DriftTimeNanos();
+	DriftEntitySetDestroy(&entities, list, n);
+	u64 destroy_nanos = DriftTimeNanos() - t0;
+	
+	for(uint i = 0; i < STRESS_COMPONENTS; i++){
+		DRIFT_ASSERT(components[i].c.count == 0, "Components not removed.");
+		DriftComponentDestroy(&components[i].c);
+	}
+	DRIFT_ASSERT(!DriftEntitySetCheck(&entities, list[n - 1]), "Entity not retired.");
+	
+	// Indexes are recycled from the pool once it's large enough.
+	DriftEntity reused = DriftEntitySetAquire(&entities, 0);
+	DRIFT_ASSERT(DriftEntityIndex(reused) <= n && DriftEntityGeneration(reused) == 1, "Index was not recycled.");
+	
+	// Collecting a row left behind by the index's previous entity must not clear the membership of the new one.
+	DestroyComponent stale = {};
+	DriftComponentInit(&stale.c, (DriftTableDesc){
+		.name = "@Stale", .mem = DriftSystemMem,
+		.columns.arr = {DRIFT_DEFINE_COLUMN(stale.entity), DRIFT_DEFINE_COLUMN(stale.value)},
+	});
+	DriftEntitySetAddComponent(&entities, &stale.c);
+	DriftComponentAdd(&stale.c, DriftEntityMake(DriftEntityIndex(reused), 0, 0));
+	DriftComponentAdd(&stale.c, reused);
+	DriftComponentGC(&stale.c, &entities, 16);
+	DRIFT_ASSERT(stale.c.count == 1 && DriftComponentFind(&stale.c, reused), "Live row was collected.");
+	DRIFT_ASSERT(entities.component_masks[DriftEntityIndex(reused)] & stale.c.entity_mask, "Membership of the reused index was cleared.");
+	DriftComponentDestroy(&stale.c);
+	
+	DriftDealloc(DriftSystemMem, list, n*sizeof(*list));
+	DriftEntitySetFree(&entities);
+	
+	DRIFT_LOG("Entity stress, %u entities with %u component rows: create %.1f ns/entity (%.1f ns/add), iterate %.1f ns/entity, destroy %.1f ns/entity.",
+		n, adds, (double)create_nanos/n, (double)create_nanos/adds, (double)iterate_nanos/n, (double)destroy_nanos/n
+	);
+}
 #endif
@@ -20,22 +20,246 @@ You should have received a copy of the GNU General Public License along with Ver
 #include "qoi/qoi.h"
 
 
-void DriftGfxFreeObjects(const DriftGfxDriver* driver, DriftMap* destructors, void* objects[], uint count){
+// MARK: Object cache.
+
+typedef struct {
+	const DriftGfxShader* shader;
+	const DriftGfxRenderTarget* target;
+	DriftGfxCullMode cull_mode;
+	bool has_blend;
+	DriftGfxBlendMode blend;
+} PipelineKey;
+
+typedef struct {
+	void* obj;
+	// Map the entry is findable in, or NULL once it's been evicted.
+	DriftMap* map;
+	uintptr_t hash;
+	// Number of holders. Parked objects have none until they are found again.
+	uint refs;
+	uint key_size;
+	u8 key[];
+} CacheEntry;
+
+static PipelineKey pipeline_key(const DriftGfxPipelineOptions* options){
+	// Zero first so padding bytes can be hashed and compared.
+	PipelineKey key;
+	memset(&key, 0, sizeof(key));
+	key.shader = options->shader, key.target = options->target, key.cull_mode = options->cull_mode;
+	
+	// Blend modes are compared by value since callers often declare their own copies.
+	const DriftGfxBlendMode* blend = options->blend;
+	if(blend){
+		key.has_blend = true;
+		key.blend.color_op = blend->color_op, key.blend.alpha_op = blend->alpha_op;
+		key.blend.color_src_factor = blend->color_src_factor, key.blend.color_dst_factor = blend->color_dst_factor;
+		key.blend.alpha_src_factor = blend->alpha_src_factor, key.blend.alpha_dst_factor = blend->alpha_dst_factor;
+		key.blend.enable_blend_color = blend->enable_blend_color;
+	}
+	
+	return key;
+}
+
+#define SHADER_KEY_MAX 2048
+
+typedef struct {
+	u8 bytes[SHADER_KEY_MAX];
+	uint size;
+} ShaderKey;
+
+static void shader_key_push(ShaderKey* key, const void* ptr, size_t size){
+	DRIFT_ASSERT_HARD(key->size + size <= SHADER_KEY_MAX, "Shader key overflow.");
+	memcpy(key->bytes + key->size, ptr, size);
+	key->size += (uint)size;
+}
+
+static void shader_key_push_str(ShaderKey* key, const char* str){
+	// Unused bindings are NULL, treat them like empty names.
+	str = str ? str : "";
+	shader_key_push(key, str, strlen(str) + 1);
+}
+
+// Shaders are keyed by content rather than pointers so they still match after the game module is reloaded.
+static void shader_key(ShaderKey* key, const char* name, const DriftGfxShaderDesc* desc, const DriftData sources[], uint source_count){
+	key->size = 0;
+	shader_key_push_str(key, name);
+	
+	for(uint i = 0; i < DRIFT_GFX_VERTEX_ATTRIB_COUNT; i++){
+		const DriftGfxVertexAttrib* attr = desc->vertex + i;
+		u32 fields[] = {attr->type, attr->offset, attr->instanced};
+		shader_key_push(key, fields, sizeof(fields));
+	}
+	
+	u64 strides[] = {desc->vertex_stride, desc->instance_stride};
+	shader_key_push(key, strides, sizeof(strides));
+	for(uint i = 0; i < DRIFT_GFX_UNIFORM_BINDING_COUNT; i++) shader_key_push_str(key, desc->uniform[i]);
+	for(uint i = 0; i < DRIFT_GFX_SAMPLER_BINDING_COUNT; i++) shader_key_push_str(key, desc->sampler[i]);
+	for(uint i = 0; i < DRIFT_GFX_TEXTURE_BINDING_COUNT; i++) shader_key_push_str(key, desc->texture[i]);
+	
+	// Hash the sources so edited shaders are rebuilt on a hotload.
+	for(uint i = 0; i < source_count; i++){
+		u64 hash = DriftFNV64(sources[i].ptr, sources[i].size);
+		shader_key_push(key, &hash, sizeof(hash));
+	}
+}
+
+void DriftGfxObjectCacheInit(DriftGfxObjectCache* cache){
+	(*cache) = (DriftGfxObjectCache){};
+	DriftMapInit(&cache->shaders, DriftSystemMem, "#GfxShaderCache", 0);
+	DriftMapInit(&cache->pipelines, DriftSystemMem, "#GfxPipelineCache", 0);
+	DriftMapInit(&cache->samplers, DriftSystemMem, "#GfxSamplerCache", 0);
+	DriftMapInit(&cache->entries, DriftSystemMem, "#GfxCacheEntries", 0);
+}
+
+static void cache_entry_free(CacheEntry* entry){
+	DriftDealloc(DriftSystemMem, entry, sizeof(*entry) + entry->key_size);
+}
+
+void DriftGfxObjectCacheDestroy(DriftGfxObjectCache* cache){
+	for(uint i = 0; i < cache->entries.table.row_capacity; i++){
+		if(DriftMapActiveIndex(&cache->entries, i)) cache_entry_free((CacheEntry*)cache->entries.values[i]);
+	}
+	
+	DriftMapDestroy(&cache->shaders);
+	DriftMapDestroy(&cache->pipelines);
+	DriftMapDestroy(&cache->samplers);
+	DriftMapDestroy(&cache->entries);
+}
+
+static void* cache_find(DriftGfxObjectCache* cache, DriftMap* map, const void* key, uint key_size){
+	CacheEntry* entry = (CacheEntry*)DriftMapFind(map, DriftFNV64(key, key_size));
+	if(entry && entry->key_size == key_size && memcmp(entry->key, key, key_size) == 0){
+		cache->hits++;
+		entry->refs++;
+		return entry->obj;
+	}
+	
+	cache->misses++;
+	return NULL;
+}
+
+static void* cache_add(DriftGfxObjectCache* cache, DriftMap* map, const void* key, uint key_size, void* obj){
+	uintptr_t hash = DriftFNV64(key, key_size);
+	
+	// Hash collisions are left uncached, they only cost a duplicate object.
+	if(DriftMapFind(map, hash) == 0){
+		CacheEntry* entry = DriftAlloc(DriftSystemMem, sizeof(*entry) + key_size);
+		(*entry) = (CacheEntry){.obj = obj, .map = map, .hash = hash, .refs = 1, .key_size = key_size};
+		memcpy(entry->key, key, key_size);
+		DriftMapInsert(map, hash, (uintptr_t)entry);
+		DriftMapInsert(&cache->entries, (uintptr_t)obj, (uintptr_t)entry);
+	}
+	
+	return obj;
+}
+
+static void cache_evict(CacheEntry* entry){
+	if(entry->map) DriftMapRemove(entry->map, entry->hash);
+	entry->map = NULL;
+}
+
+static void cache_remove(DriftGfxObjectCache* cache, CacheEntry* entry){
+	cache_evict(entry);
+	DriftMapRemove(&cache->entries, (uintptr_t)entry->obj);
+	cache_entry_free(entry);
+}
+
+DriftGfxShader* DriftGfxCacheFindShader(DriftGfxObjectCache* cache, const char* name, const DriftGfxShaderDesc* desc, const DriftData sources[], uint source_count){
+	ShaderKey key;
+	shader_key(&key, name, desc, sources, source_count);
+	DriftGfxShader* shader = cache_find(cache, &cache->shaders, key.bytes, key.size);
+	
+	// The old name and desc may point into a game module that has since been reloaded.
+	if(shader) shader->name = name, shader->desc = desc;
+	return shader;
+}
+
+DriftGfxShader* DriftGfxCacheAddShader(DriftGfxObjectCache* cache, DriftGfxShader* shader, const DriftData sources[], uint source_count){
+	ShaderKey key;
+	shader_key(&key, shader->name, shader->desc, sources, source_count);
+	return cache_add(cache, &cache->shaders, key.bytes, key.size, shader);
+}
+
+DriftGfxPipeline* DriftGfxCacheFindPipeline(DriftGfxObjectCache* cache, const DriftGfxPipelineOptions* options){
+	PipelineKey key = pipeline_key(options);
+	return cache_find(cache, &cache->pipelines, &key, sizeof(key));
+}
+
+DriftGfxPipeline* DriftGfxCacheAddPipeline(DriftGfxObjectCache* cache, DriftGfxPipeline* pipeline){
+	PipelineKey key = pipeline_key(&pipeline->options);
+	return cache_add(cache, &cache->pipelines, &key, sizeof(key), pipeline);
+}
+
+DriftGfxSampler* DriftGfxCacheFindSampler(DriftGfxObjectCache* cache, const DriftGfxSamplerOptions* options){
+	return cache_find(cache, &cache->samplers, options, sizeof(*options));
+}
+
+DriftGfxSampler* DriftGfxCacheAddSampler(DriftGfxObjectCache* cache, DriftGfxSampler* sampler){
+	return cache_add(cache, &cache->samplers, &sampler->options, sizeof(sampler->options), sampler);
+}
+
+static int find_pipeline_entry(DriftGfxObjectCache* cache, const void* obj){
+	for(uint i = 0; i < cache->pipelines.table.row_capacity; i++){
+		if(!DriftMapActiveIndex(&cache->pipelines, i)) continue;
+		const PipelineKey* key = (PipelineKey*)((CacheEntry*)cache->pipelines.values[i])->key;
+		if(key->shader == obj || key->target == obj) return (int)i;
+	}
+	
+	return -1;
+}
+
+// Drop a holder of 'obj'. Returns true when it was the last one and the object should be destroyed.
+static bool cache_release(DriftGfxObjectCache* cache, const void* obj){
+	CacheEntry* entry = (CacheEntry*)DriftMapFind(&cache->entries, (uintptr_t)obj);
+	if(entry && entry->refs > 1){
+		entry->refs--;
+		return false;
+	}
+	
+	if(entry) cache_remove(cache, entry);
+	
+	// Pipelines built from a freed shader or target can't be handed out anymore, but stay alive for their holders.
+	// Removing can move other entries, so search again after each one.
+	// Only a handful of objects are freed outside of DriftGfxFreeAll() so this stays cheap.
+	for(int idx; (idx = find_pipeline_entry(cache, obj)) >= 0;) cache_evict((CacheEntry*)cache->pipelines.values[idx]);
+	return true;
+}
+
+void DriftGfxFreeObjects(const DriftGfxDriver* driver, DriftMap* destructors, DriftGfxObjectCache* cache, void* objects[], uint count){
 	for(uint i = 0; i < count; i++){
+		if(!cache_release(cache, objects[i])) continue;
+		
 		DriftGfxDestructor* destructor = (DriftGfxDestructor*)DriftMapRemove(destructors, (uintptr_t)objects[i]);
 		destructor(driver, objects[i]);
 	}
 }
 
-void DriftGfxFreeAll(const DriftGfxDriver* driver, DriftMap* destructors){
+void DriftGfxFreeAll(const DriftGfxDriver* driver, DriftMap* destructors, DriftGfxObjectCache* cache){
+	// Shaders and samplers outlive their holders so the next startup (ex: after a hotload) can find them again.
+	// Anything still parked from the previous call wasn't picked back up and is destroyed with the rest.
+	DriftMap parked;
+	DriftMapInit(&parked, DriftSystemMem, "#GfxParked", 0);
 	for(uint i = 0; i < destructors->table.row_capacity; i++){
-		if(DriftMapActiveIndex(destructors, i)){
-			((DriftGfxDestructor*)destructors->values[i])(driver, (void*)destructors->keys[i]);
+		if(!DriftMapActiveIndex(destructors, i)) continue;
+		
+		void* obj = (void*)destructors->keys[i];
+		CacheEntry* entry = (CacheEntry*)DriftMapFind(&cache->entries, (uintptr_t)obj);
+		bool park = entry && entry->refs > 0 && (entry->map == &cache->shaders || entry->map == &cache->samplers);
+		if(park){
+			entry->refs = 0;
+			DriftMapInsert(&parked, (uintptr_t)obj, destructors->values[i]);
+		} else {
+			if(entry) cache_remove(cache, entry);
+			((DriftGfxDestructor*)destructors->values[i])(driver, obj);
 		}
 	}
 	
 	DriftMapDestroy(destructors);
 	DriftMapInit(destructors, destructors->table.desc.mem, destructors->table.desc.name, 0);
+	for(uint i = 0; i < parked.table.row_capacity; i++){
+		if(DriftMapActiveIndex(&parked, i)) DriftMapInsert(destructors, parked.keys[i], parked.values[i]);
+	}
+	DriftMapDestroy(&parked);
 }
 
 DriftGfxBlendMode DriftGfxBlendModeAlpha = {
@@ -59,7 +283,35 @@ DriftGfxBlendMode DriftGfxBlendModeMultiply = {
 };
 
 void DriftGfxRendererInit(DriftGfxRenderer* renderer, DriftGfxVTable vtable){
-	(*renderer) = (DriftGfxRenderer){.vtable = vtable};
+	(*renderer) = (DriftGfxRenderer){.vtable = vtable, .streams = {
+		[DRIFT_GFX_STREAM_VERTEX].min_capacity = DRIFT_GFX_VERTEX_BUFFER_SIZE,
+		[DRIFT_GFX_STREAM_INDEX].min_capacity = DRIFT_GFX_INDEX_BUFFER_SIZE,
+		[DRIFT_GFX_STREAM_UNIFORM].min_capacity = DRIFT_GFX_UNIFORM_BUFFER_SIZE,
+	}};
+}
+
+static size_t DriftGfxStreamHighWater(const DriftGfxStream* stream){
+	size_t peak = stream->cursor;
+	for(uint i = 0; i < DRIFT_GFX_STREAM_HISTORY; i++) peak = DRIFT_MAX(peak, stream->history[i]);
+	return peak;
+}
+
+size_t DriftGfxStreamNextCapacity(const DriftGfxStream* stream){
+	size_t peak = DriftGfxStreamHighWater(stream), capacity = DRIFT_MAX(stream->capacity, stream->min_capacity);
+	
+	// Keep 25% headroom over the peak, and only halve the capacity when the padded peak fits in a quarter of it.
+	// The gap keeps a frame rate's worth of jitter from resizing the buffer back and forth.
+	while(capacity < peak + peak/4) capacity *= 2;
+	while(capacity/2 >= stream->min_capacity && peak + peak/4 <= capacity/4) capacity /= 2;
+	return capacity;
+}
+
+static void DriftGfxStreamReset(DriftGfxStream* stream){
+	stream->history[stream->frame++ % DRIFT_GFX_STREAM_HISTORY] = stream->cursor;
+	stream->cursor = 0;
+	
+	for(uint i = 0; i < stream->page_count; i++) DriftDealloc(DriftSystemMem, stream->pages[i].ptr, stream->pages[i].size);
+	stream->page_count = 0;
 }
 
 void DriftGfxRendererPrepare(DriftGfxRenderer* renderer, DriftVec2 default_extent, DriftMem* mem){
@@ -69,7 +321,8 @@ void DriftGfxRendererPrepare(DriftGfxRenderer* renderer, DriftVec2 default_exten
 	// Reset cursors.
 	renderer->first_command = NULL;
 	renderer->command_cursor = &renderer->first_command;
-	renderer->cursor = renderer->ptr;
+	renderer->stats = (DriftGfxRendererStats){};
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++) DriftGfxStreamReset(renderer->streams + i);
 	renderer->mem = mem;
 }
 
@@ -77,35 +330,63 @@ DriftVec2 DriftGfxRendererDefaultExtent(DriftGfxRenderer* renderer){
 	return renderer->default_extent;
 }
 
+// Slow path for data that doesn't fit into the mapped buffer.
+// Pages double in size so a runaway frame only needs a handful of them.
+static void* DriftGfxStreamOverflow(DriftGfxStream* stream, size_t size, size_t* offset){
+	DriftGfxStreamPage* page = stream->page_count ? stream->pages + stream->page_count - 1 : NULL;
+	if(page == NULL || stream->cursor + size > page->offset + page->size){
+		size_t page_size = page ? 2*page->size : DRIFT_MAX(stream->capacity, DRIFT_GFX_STREAM_GRANULARITY);
+		page_size = DRIFT_MAX(page_size, -(-size & -DRIFT_GFX_STREAM_GRANULARITY));
+		
+		DRIFT_ASSERT_HARD(stream->page_count < DRIFT_GFX_STREAM_MAX_PAGES, "Gfx stream overflow.");
+		stream->cursor = page ? page->offset + page->size : stream->capacity;
+		page = stream->pages + stream->page_count++;
+		(*page) = (DriftGfxStreamPage){.ptr = DriftAlloc(DriftSystemMem, page_size), .offset = stream->cursor, .size = page_size};
+	}
+	
+	*offset = stream->cursor;
+	stream->cursor += size;
+	return page->ptr + (*offset - page->offset);
+}
+
+static inline void* DriftGfxStreamPush(DriftGfxStream* stream, size_t size, size_t* offset){
+	if(stream->cursor + size > stream->capacity) return DriftGfxStreamOverflow(stream, size, offset);
+	
+	*offset = stream->cursor;
+	stream->cursor += size;
+	return stream->ptr + *offset;
+}
+
+void DriftGfxRendererCapture(DriftGfxRenderer* renderer, const char* filename){
+	renderer->capture_filename = filename;
+}
+
 DriftGfxBufferSlice DriftGfxRendererPushGeometry(DriftGfxRenderer* renderer, const void* ptr, size_t size){
-	void* cursor = renderer->cursor.vertex;
-	renderer->cursor.vertex = cursor + size;
-	DRIFT_ASSERT(renderer->cursor.vertex - renderer->ptr.vertex < DRIFT_GFX_VERTEX_BUFFER_SIZE, "Vertex buffer overflow.");
+	size_t offset;
+	void* cursor = DriftGfxStreamPush(renderer->streams + DRIFT_GFX_STREAM_VERTEX, size, &offset);
 	if(ptr) memcpy(cursor, ptr, size);
-	return (DriftGfxBufferSlice){.ptr = cursor, .binding = {.offset = cursor - renderer->ptr.vertex, .size = size}};
+	return (DriftGfxBufferSlice){.ptr = cursor, .binding = {.offset = offset, .size = size}};
 }
 
 DriftGfxBufferSlice DriftGfxRendererPushIndexes(DriftGfxRenderer* renderer, const void* ptr, size_t size){
-	void* cursor = renderer->cursor.index;
-	renderer->cursor.index = cursor + size;
-	DRIFT_ASSERT(renderer->cursor.index - renderer->ptr.index < DRIFT_GFX_INDEX_BUFFER_SIZE, "Index buffer overflow.");
+	size_t offset;
+	void* cursor = DriftGfxStreamPush(renderer->streams + DRIFT_GFX_STREAM_INDEX, size, &offset);
 	if(ptr) memcpy(cursor, ptr, size);
-	return (DriftGfxBufferSlice){.ptr = cursor, .binding = {.offset = cursor - renderer->ptr.index, .size = size}};
+	return (DriftGfxBufferSlice){.ptr = cursor, .binding = {.offset = offset, .size = size}};
 }
 
 
 DriftGfxBufferSlice DriftGfxRendererPushUniforms(DriftGfxRenderer* renderer, const void* ptr, size_t size){
-	void* cursor = renderer->cursor.uniform;
-	DriftGfxBufferBinding binding = {.offset = cursor - renderer->ptr.uniform, .size = -(-size & -renderer->uniform_alignment)};
-	renderer->cursor.uniform += binding.size;
-	DRIFT_ASSERT(renderer->cursor.uniform - renderer->ptr.uniform < DRIFT_GFX_UNIFORM_BUFFER_SIZE, "Uniform buffer overflow.");
+	size_t offset, aligned_size = -(-size & -renderer->uniform_alignment);
+	void* cursor = DriftGfxStreamPush(renderer->streams + DRIFT_GFX_STREAM_UNIFORM, aligned_size, &offset);
 	if(ptr) memcpy(cursor, ptr, size);
-	return (DriftGfxBufferSlice){.ptr = cursor, .binding = binding};
+	return (DriftGfxBufferSlice){.ptr = cursor, .binding = {.offset = offset, .size = aligned_size}};
 }
 
 static void DriftGfxRendererPushCommand(DriftGfxRenderer* renderer, DriftGfxCommand* command){
 	(*renderer->command_cursor) = command;
 	renderer->command_cursor = &command->next;
+	renderer->stats.submitted.commands[command->type]++;
 }
 
 DriftGfxPipelineBindings* DriftGfxRendererPushBindPipelineCommand(DriftGfxRenderer* renderer, DriftGfxPipeline* pipeline){
@@ -113,37 +394,339 @@ DriftGfxPipelineBindings* DriftGfxRendererPushBindPipelineCommand(DriftGfxRender
 	
 	DriftGfxPipelineBindings* bindings = DRIFT_COPY(renderer->mem, ((DriftGfxPipelineBindings){}));
 	DriftGfxRendererPushCommand(renderer, &DRIFT_COPY(renderer->mem, ((DriftGfxCommandPipeline){
-		.base.func = renderer->vtable.bind_pipeline, .pipeline = pipeline, .bindings = bindings
+		.base.func = renderer->vtable.bind_pipeline, .base.type = DRIFT_GFX_COMMAND_PIPELINE, .pipeline = pipeline, .bindings = bindings
 	}))->base);
 	
 	return bindings;
 }
 
 void DriftGfxRendererPushDrawIndexedCommand(DriftGfxRenderer* renderer, DriftGfxBufferBinding index_binding, u32 index_count, u32 instance_count){
-	DRIFT_ASSERT(index_binding.offset <= DRIFT_GFX_INDEX_BUFFER_SIZE, "Invalid index array pointer.");
+	DRIFT_ASSERT(index_binding.offset <= renderer->streams[DRIFT_GFX_STREAM_INDEX].cursor, "Invalid index array pointer.");
 	DriftGfxRendererPushCommand(renderer, &DRIFT_COPY(renderer->mem, ((DriftGfxCommandDraw){
-		.base.func = renderer->vtable.draw_indexed,
+		.base.func = renderer->vtable.draw_indexed, .base.type = DRIFT_GFX_COMMAND_DRAW,
 		.index_binding = index_binding, .index_count = index_count, .instance_count = instance_count,
 	}))->base);
 }
 
 void DriftGfxRendererPushBindTargetCommand(DriftGfxRenderer* renderer, 	DriftGfxRenderTarget* rt, DriftVec4 clear_color){
 	DriftGfxRendererPushCommand(renderer, &DRIFT_COPY(renderer->mem, ((DriftGfxCommandTarget){
-		.base.func = renderer->vtable.bind_target,
+		.base.func = renderer->vtable.bind_target, .base.type = DRIFT_GFX_COMMAND_TARGET,
 		.rt = rt, .clear_color = clear_color,
 	}))->base);
 }
 
 void DriftGfxRendererPushScissorCommand(DriftGfxRenderer* renderer, DriftAABB2 bounds){
 	DriftGfxRendererPushCommand(renderer, &DRIFT_COPY(renderer->mem, ((DriftGfxCommandScissor){
-		.base.func = renderer->vtable.set_scissor, .bounds = bounds
+		.base.func = renderer->vtable.set_scissor, .base.type = DRIFT_GFX_COMMAND_SCISSOR, .bounds = bounds
 	}))->base);
 }
 
+static bool buffer_binding_equal(DriftGfxBufferBinding a, DriftGfxBufferBinding b){
+	return a.offset == b.offset && a.size == b.size;
+}
+
+static bool bindings_equal(const DriftGfxPipelineBindings* a, const DriftGfxPipelineBindings* b, bool ignore_instance){
+	if(a == b) return true;
+	if(!buffer_binding_equal(a->vertex, b->vertex) || (!ignore_instance && !buffer_binding_equal(a->instance, b->instance))) return false;
+	
+	// Everything after the instance binding is plain old data.
+	size_t offset = offsetof(DriftGfxPipelineBindings, uniforms);
+	return memcmp((u8*)a + offset, (u8*)b + offset, sizeof(*a) - offset) == 0;
+}
+
+static bool scissor_equal(DriftAABB2 a, DriftAABB2 b){
+	return a.l == b.l && a.b == b.b && a.r == b.r && a.t == b.t;
+}
+
+// Can the draw be extended to cover the instances bound by 'next'?
+static bool can_merge(const DriftGfxCommandPipeline* bound, const DriftGfxCommandDraw* draw, const DriftGfxCommandPipeline* next){
+	if(bound == NULL || draw == NULL || next->pipeline != bound->pipeline) return false;
+	if(!bindings_equal(bound->bindings, next->bindings, true)) return false;
+	
+	// Instances must be tightly packed after the ones already drawn.
+	size_t stride = bound->pipeline->options.shader->desc->instance_stride;
+	DriftGfxBufferBinding instance = bound->bindings->instance;
+	return stride > 0 && instance.size == draw->instance_count*stride && instance.offset + instance.size == next->bindings->instance.offset;
+}
+
+void DriftGfxRendererOptimizeCommands(DriftGfxRenderer* renderer){
+	DRIFT_PROFILE_SCOPE("Optimize Commands");
+	
+	// Last bind and scissor left in the stream, and if a draw has used them yet.
+	DriftGfxCommandPipeline* bound = NULL;
+	DriftGfxCommandScissor* scissor = NULL;
+	bool bound_used = false, scissor_used = false;
+	// The scissor is unknown until a target is bound, NaN never compares equal.
+	DriftAABB2 scissor_bounds = {NAN, NAN, NAN, NAN};
+	// Last draw while nothing else but a mergeable bind follows it.
+	DriftGfxCommandDraw* draw = NULL;
+	DriftGfxCommandPipeline* merge = NULL;
+	
+	// Walking the list is mostly waiting on memory, so only do it once and relink the survivors from an array.
+	uint command_count = 0;
+	for(uint i = 0; i < _DRIFT_GFX_COMMAND_COUNT; i++) command_count += renderer->stats.submitted.commands[i];
+	DriftGfxCommand** commands = DriftAlloc(renderer->mem, command_count*sizeof(*commands));
+	
+	uint idx = 0;
+	for(DriftGfxCommand* command = renderer->first_command; command; command = command->next){
+		commands[idx++] = command;
+		if(merge){
+			DriftGfxCommandDraw* next_draw = (DriftGfxCommandDraw*)command;
+			size_t stride = bound->pipeline->options.shader->desc->instance_stride;
+			if(
+				command->type == DRIFT_GFX_COMMAND_DRAW && next_draw->index_binding.offset == draw->index_binding.offset &&
+				next_draw->index_count == draw->index_count && merge->bindings->instance.size == next_draw->instance_count*stride
+			){
+				draw->instance_count += next_draw->instance_count;
+				((DriftGfxPipelineBindings*)bound->bindings)->instance.size += merge->bindings->instance.size;
+				merge->base.type = command->type = DRIFT_GFX_COMMAND_DROPPED;
+				merge = NULL;
+				continue;
+			}
+			
+			// Didn't pan out, keep the bind after all.
+			if(!bound_used) bound->base.type = DRIFT_GFX_COMMAND_DROPPED;
+			bound = merge, bound_used = false, merge = NULL, draw = NULL;
+		}
+		
+		switch(command->type){
+			case DRIFT_GFX_COMMAND_TARGET: {
+				// Binding a target resets the scissor, and drivers may need to bind pipelines again for a new pass.
+				if(scissor && !scissor_used) scissor->base.type = DRIFT_GFX_COMMAND_DROPPED;
+				scissor = NULL, scissor_bounds = DRIFT_AABB2_ALL;
+				bound = NULL, draw = NULL;
+			} break;
+			
+			case DRIFT_GFX_COMMAND_SCISSOR: {
+				DriftGfxCommandScissor* next = (DriftGfxCommandScissor*)command;
+				if(scissor_equal(next->bounds, scissor_bounds)){
+					command->type = DRIFT_GFX_COMMAND_DROPPED;
+				} else {
+					if(scissor && !scissor_used) scissor->base.type = DRIFT_GFX_COMMAND_DROPPED;
+					scissor = next, scissor_used = false, scissor_bounds = next->bounds;
+					draw = NULL;
+				}
+			} break;
+			
+			case DRIFT_GFX_COMMAND_PIPELINE: {
+				DriftGfxCommandPipeline* next = (DriftGfxCommandPipeline*)command;
+				if(bound && next->pipeline == bound->pipeline && bindings_equal(next->bindings, bound->bindings, false)){
+					command->type = DRIFT_GFX_COMMAND_DROPPED;
+				} else if(can_merge(bound, draw, next)){
+					// Decide once the next command is known.
+					merge = next;
+				} else {
+					if(bound && !bound_used) bound->base.type = DRIFT_GFX_COMMAND_DROPPED;
+					bound = next, bound_used = false;
+					draw = NULL;
+				}
+			} break;
+			
+			case DRIFT_GFX_COMMAND_DRAW: {
+				DriftGfxCommandDraw* next = (DriftGfxCommandDraw*)command;
+				if(next->instance_count == 0 || next->index_count == 0){
+					command->type = DRIFT_GFX_COMMAND_DROPPED;
+				} else {
+					bound_used = scissor_used = true;
+					draw = next;
+				}
+			} break;
+			
+			default: break;
+		}
+	}
+	
+	// A trailing bind or scissor doesn't affect anything.
+	if(merge) merge->base.type = DRIFT_GFX_COMMAND_DROPPED;
+	if(bound && !bound_used) bound->base.type = DRIFT_GFX_COMMAND_DROPPED;
+	if(scissor && !scissor_used) scissor->base.type = DRIFT_GFX_COMMAND_DROPPED;
+	
+	// Unlink the dropped commands.
+	DRIFT_ASSERT(idx == command_count, "Command count mismatch.");
+	DriftGfxCommandCounts* executed = &renderer->stats.executed;
+	*executed = (DriftGfxCommandCounts){};
+	DriftGfxCommand** cursor = &renderer->first_command;
+	for(uint i = 0; i < command_count; i++){
+		DriftGfxCommand* command = commands[i];
+		if(command->type != DRIFT_GFX_COMMAND_DROPPED){
+			*cursor = command;
+			cursor = &command->next;
+			executed->commands[command->type]++;
+		}
+	}
+	*cursor = NULL;
+	renderer->command_cursor = cursor;
+	
+	DriftDealloc(renderer->mem, commands, command_count*sizeof(*commands));
+}
+
 void DriftRendererExecuteCommands(DriftGfxRenderer* renderer){
+	DriftGfxRendererStats* stats = &renderer->stats;
+	stats->executed = stats->submitted;
+	
+	u64 t0 = DriftTimeNanos();
+	if(!renderer->skip_optimize) DriftGfxRendererOptimizeCommands(renderer);
+	u64 t1 = DriftTimeNanos();
+	
 	DriftGfxRenderState state = {.pipeline = &(DriftGfxPipeline){}};
+	if(renderer->time_commands){
+		for(const DriftGfxCommand* command = renderer->first_command; command; command = command->next){
+			u64 command_start = DriftTimeNanos();
+			command->func(renderer, command, &state);
+			stats->command_nanos[command->type] += DriftTimeNanos() - command_start;
+		}
+	} else {
+		for(const DriftGfxCommand* command = renderer->first_command; command; command = command->next){
+			command->func(renderer, command, &state);
+		}
+	}
+	
+	stats->optimize_nanos = t1 - t0;
+	stats->execute_nanos = DriftTimeNanos() - t1;
 	
-	for(const DriftGfxCommand* command = renderer->first_command; command; command = command->next){
-		command->func(renderer, command, &state);
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++){
+		DriftGfxStream* stream = renderer->streams + i;
+		stats->streams[i] = (DriftGfxStreamStats){
+			.used = stream->cursor, .high_water = DriftGfxStreamHighWater(stream),
+			.capacity = stream->capacity, .overflow_pages = stream->page_count,
+		};
 	}
 }
+
+#if DRIFT_DEBUG
+// A driver that only counts commands and checksums what would be drawn.
+static struct {
+	uint binds, draws, scissors, targets;
+	u64 instances, checksum;
+	const DriftGfxPipelineBindings* bindings;
+	DriftAABB2 scissor;
+} COUNTING;
+
+static void counting_target(const DriftGfxRenderer* renderer, const DriftGfxCommand* command, DriftGfxRenderState* state){
+	COUNTING.targets++;
+	COUNTING.scissor = DRIFT_AABB2_ALL;
+	state->target = ((DriftGfxCommandTarget*)command)->rt;
+}
+
+static void counting_scissor(const DriftGfxRenderer* renderer, const DriftGfxCommand* command, DriftGfxRenderState* state){
+	COUNTING.scissors++;
+	COUNTING.scissor = ((DriftGfxCommandScissor*)command)->bounds;
+}
+
+static void counting_pipeline(const DriftGfxRenderer* renderer, const DriftGfxCommand* command, DriftGfxRenderState* state){
+	COUNTING.binds++;
+	COUNTING.bindings = ((DriftGfxCommandPipeline*)command)->bindings;
+	state->pipeline = ((DriftGfxCommandPipeline*)command)->pipeline;
+}
+
+static void counting_draw(const DriftGfxRenderer* renderer, const DriftGfxCommand* command, DriftGfxRenderState* state){
+	const DriftGfxCommandDraw* draw = (DriftGfxCommandDraw*)command;
+	COUNTING.draws++;
+	COUNTING.instances += draw->instance_count;
+	
+	// Order independent hash of every instance drawn along with the state it was drawn with.
+	size_t stride = state->pipeline->options.shader->desc->instance_stride;
+	u64 state_hash = (uintptr_t)state->pipeline*31 + (uintptr_t)state->target*17 + COUNTING.bindings->uniforms[1].offset*7 + (u64)DriftClamp(COUNTING.scissor.r, 0, 1e6f)*3;
+	for(uint i = 0; i < draw->instance_count; i++) COUNTING.checksum += (state_hash ^ (COUNTING.bindings->instance.offset + i*stride))*1099511628211u;
+}
+
+#define BENCH_PIPELINES 8
+
+// Roughly the shape of a busy frame: sprite batches, per light shadow passes and UI clipping.
+static void push_bench_frame(DriftGfxRenderer* renderer, DriftGfxPipeline* pipelines, DriftGfxRenderTarget* target, DriftGfxBufferBinding quad){
+	size_t stride = pipelines[0].options.shader->desc->instance_stride;
+	DriftGfxRendererPushBindTargetCommand(renderer, target, DRIFT_VEC4_CLEAR);
+	
+	// Batches, many are empty and runs of them are drawn with the same pipeline.
+	for(uint i = 0; i < 64; i++){
+		uint count = (i % 3 == 0 ? 0 : 1 + i*7 % 200);
+		DriftGfxPipelineBindings* bindings = DriftGfxRendererPushBindPipelineCommand(renderer, pipelines + i/16);
+		bindings->instance = DriftGfxRendererPushGeometry(renderer, NULL, count*stride).binding;
+		DriftGfxRendererPushDrawIndexedCommand(renderer, quad, 6, count);
+	}
+	
+	// Shadows, a scissor per light and the same bindings bound twice in a row.
+	DriftGfxRendererPushBindTargetCommand(renderer, NULL, DRIFT_VEC4_CLEAR);
+	DriftGfxBufferBinding masks = DriftGfxRendererPushGeometry(renderer, NULL, 256*stride).binding;
+	for(uint i = 0; i < 32; i++){
+		DriftGfxRendererPushScissorCommand(renderer, (DriftAABB2){i*8, 0, i*8 + 64, 64});
+		DriftGfxRendererPushBindPipelineCommand(renderer, pipelines + 4)->instance = masks;
+		DriftGfxRendererPushDrawIndexedCommand(renderer, quad, 6, 256);
+		DriftGfxRendererPushBindPipelineCommand(renderer, pipelines + 4)->instance = masks;
+		DriftGfxRendererPushDrawIndexedCommand(renderer, quad, 6, 1);
+	}
+	DriftGfxRendererPushScissorCommand(renderer, DRIFT_AABB2_ALL);
+	
+	// UI, clip rects that are often empty or set back to back.
+	DriftGfxBufferBinding ui = DriftGfxRendererPushGeometry(renderer, NULL, 4096*stride).binding;
+	for(uint i = 0; i < 256; i++){
+		uint count = (i % 4 == 0 ? 0 : i % 16);
+		DriftGfxRendererPushBindPipelineCommand(renderer, pipelines + 7)->instance = ui;
+		DriftGfxRendererPushDrawIndexedCommand(renderer, quad, 6, count);
+		ui.offset += count*stride;
+		DriftGfxRendererPushScissorCommand(renderer, (DriftAABB2){0, 0, 100 + i % 2, 100});
+	}
+	DriftGfxRendererPushScissorCommand(renderer, DRIFT_AABB2_ALL);
+}
+
+void unit_test_gfx_commands(void){
+	DriftGfxRenderer* renderer = DriftAlloc(DriftSystemMem, sizeof(*renderer));
+	DriftGfxRendererInit(renderer, (DriftGfxVTable){
+		.bind_target = counting_target, .set_scissor = counting_scissor,
+		.bind_pipeline = counting_pipeline, .draw_indexed = counting_draw,
+	});
+	renderer->uniform_alignment = 256;
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++){
+		DriftGfxStream* stream = renderer->streams + i;
+		stream->capacity = stream->min_capacity;
+		stream->ptr = DriftAlloc(DriftSystemMem, stream->capacity);
+	}
+	
+	DriftGfxShaderDesc desc = {.instance_stride = 48};
+	DriftGfxShader shader = {.name = "bench", .desc = &desc};
+	DriftGfxPipeline pipelines[BENCH_PIPELINES];
+	for(uint i = 0; i < BENCH_PIPELINES; i++) pipelines[i] = (DriftGfxPipeline){.options.shader = &shader};
+	DriftGfxRenderTarget target = {.framebuffer_size = {256, 256}};
+	
+	size_t mem_size = 1 << 20;
+	void* mem_buffer = DriftAlloc(DriftSystemMem, mem_size);
+	
+	uint frames = 1000;
+	u64 checksum[2] = {}, instances[2] = {}, submit_nanos[2] = {}, optimize_nanos = 0;
+	uint draws[2], binds[2], scissors[2];
+	for(uint optimize = 0; optimize < 2; optimize++){
+		COUNTING.binds = COUNTING.draws = COUNTING.scissors = COUNTING.targets = 0;
+		for(uint frame = 0; frame < frames; frame++){
+			DriftGfxRendererPrepare(renderer, (DriftVec2){256, 256}, DriftLinearMemMake(mem_buffer, mem_size, "gfx bench"));
+			DriftGfxBufferBinding quad = DriftGfxRendererPushIndexes(renderer, NULL, 6*sizeof(u16)).binding;
+			push_bench_frame(renderer, pipelines, &target, quad);
+			
+			renderer->skip_optimize = !optimize;
+			COUNTING.instances = COUNTING.checksum = 0;
+			DriftRendererExecuteCommands(renderer);
+			
+			checksum[optimize] = COUNTING.checksum, instances[optimize] = COUNTING.instances;
+			submit_nanos[optimize] += renderer->stats.optimize_nanos + renderer->stats.execute_nanos;
+			optimize_nanos += renderer->stats.optimize_nanos;
+		}
+		
+		draws[optimize] = COUNTING.draws/frames, binds[optimize] = COUNTING.binds/frames, scissors[optimize] = COUNTING.scissors/frames;
+	}
+	
+	DRIFT_ASSERT(instances[0] == instances[1], "Optimized commands drew %"PRIu64" instances instead of %"PRIu64".", instances[1], instances[0]);
+	DRIFT_ASSERT(checksum[0] == checksum[1], "Optimized commands drew different instances or state.");
+	
+	DriftGfxCommandCounts* submitted = &renderer->stats.submitted;
+	DRIFT_LOG("Gfx commands per frame: draws %u -> %u, binds %u -> %u, scissors %u -> %u.",
+		submitted->commands[DRIFT_GFX_COMMAND_DRAW], draws[1], submitted->commands[DRIFT_GFX_COMMAND_PIPELINE], binds[1],
+		submitted->commands[DRIFT_GFX_COMMAND_SCISSOR], scissors[1]
+	);
+	DRIFT_LOG("Gfx submission per frame (counting driver): %.1f us unoptimized, %.1f us optimized (%.1f us optimizing).",
+		submit_nanos[0]/1e3/frames, submit_nanos[1]/1e3/frames, optimize_nanos/1e3/frames
+	);
+	
+	DriftDealloc(DriftSystemMem, mem_buffer, mem_size);
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++) DriftDealloc(DriftSystemMem, renderer->streams[i].ptr, renderer->streams[i].capacity);
+	DriftDealloc(DriftSystemMem, renderer, sizeof(*renderer));
+}
+#endif
@@ -28,6 +28,8 @@ typedef enum {
 	DRIFT_GFX_TYPE_FLOAT32_2,
 	DRIFT_GFX_TYPE_FLOAT32_3,
 	DRIFT_GFX_TYPE_FLOAT32_4,
+	DRIFT_GFX_TYPE_FLOAT16_2,
+	DRIFT_GFX_TYPE_FLOAT16_4,
 	_DRIFT_GFX_TYPE_COUNT,
 } DriftGfxType;
 
@@ -207,9 +209,13 @@ void DriftGfxRendererPushScissorCommand(DriftGfxRenderer* renderer, DriftAABB2 b
 DriftGfxPipelineBindings* DriftGfxRendererPushBindPipelineCommand(DriftGfxRenderer* renderer, DriftGfxPipeline* pipeline);
 void DriftGfxRendererPushDrawIndexedCommand(DriftGfxRenderer* renderer, DriftGfxBufferBinding index_binding, u32 index_count, u32 instance_count);
 
+// Write the frame to 'filename' when it's presented so it can be run again with --gfx-replay.
+void DriftGfxRendererCapture(DriftGfxRenderer* renderer, const char* filename);
+
 struct DriftGfxDriver {
 	void* ctx;
 	DriftGfxShader* (*load_shader)(const DriftGfxDriver* driver, const char* name, const DriftGfxShaderDesc* desc);
+	// Pipelines and samplers with identical options are shared, so only free them once.
 	DriftGfxPipeline* (*new_pipeline)(const DriftGfxDriver* driver, DriftGfxPipelineOptions options);
 	DriftGfxSampler* (*new_sampler)(const DriftGfxDriver* driver, DriftGfxSamplerOptions options);
 	DriftGfxTexture* (*new_texture)(const DriftGfxDriver* driver, uint width, uint height, DriftGfxTextureOptions options);
@@ -0,0 +1,558 @@
+/*
+This file is part of Veridian Expanse.
+
+Veridian Expanse is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Veridian Expanse is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Veridian Expanse. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "drift_base.h"
+#include "drift_gfx_internal.h"
+
+#define CAPTURE_MAGIC "DRIFTGFX"
+#define CAPTURE_VERSION 1
+#define CAPTURE_NAME_SIZE 64
+
+// Resources are referenced by index + 1 so that 0 can stand in for NULL.
+typedef struct {
+	char magic[8];
+	u32 version, uniform_alignment;
+	DriftVec2 default_extent;
+	u32 texture_count, sampler_count, target_count, shader_count, pipeline_count, command_count;
+	u32 stream_size[_DRIFT_GFX_STREAM_COUNT];
+} CaptureHeader;
+
+typedef struct {
+	char name[CAPTURE_NAME_SIZE];
+	u32 width, height, layers;
+	DriftGfxTextureType type;
+	DriftGfxTextureFormat format;
+	bool render_target;
+} CaptureTexture;
+
+typedef struct {
+	char name[CAPTURE_NAME_SIZE];
+	DriftGfxLoadAction load;
+	DriftGfxStoreAction store;
+	struct {u32 texture, layer;} bindings[DRIFT_GFX_RENDER_TARGET_COUNT];
+} CaptureTarget;
+
+typedef struct {
+	char name[CAPTURE_NAME_SIZE];
+	DriftGfxVertexAttrib vertex[DRIFT_GFX_VERTEX_ATTRIB_COUNT];
+	u32 vertex_stride, instance_stride;
+	char uniform[DRIFT_GFX_UNIFORM_BINDING_COUNT][CAPTURE_NAME_SIZE];
+	char sampler[DRIFT_GFX_SAMPLER_BINDING_COUNT][CAPTURE_NAME_SIZE];
+	char texture[DRIFT_GFX_TEXTURE_BINDING_COUNT][CAPTURE_NAME_SIZE];
+} CaptureShader;
+
+typedef struct {
+	u32 shader, target;
+	DriftGfxCullMode cull_mode;
+	bool has_blend;
+	DriftGfxBlendMode blend;
+} CapturePipeline;
+
+typedef struct {
+	DriftGfxCommandType type;
+	union {
+		struct {u32 target; DriftVec4 clear_color;} target;
+		DriftAABB2 scissor;
+		struct {
+			u32 pipeline;
+			DriftGfxBufferBinding vertex, instance;
+			DriftGfxBufferBinding uniforms[DRIFT_GFX_UNIFORM_BINDING_COUNT];
+			u32 samplers[DRIFT_GFX_SAMPLER_BINDING_COUNT];
+			u32 textures[DRIFT_GFX_TEXTURE_BINDING_COUNT];
+			DriftVec4 blend_color;
+		} pipeline;
+		struct {DriftGfxBufferBinding index_binding; u32 index_count, instance_count;} draw;
+	};
+} CaptureCommand;
+
+struct DriftGfxCapture {
+	CaptureHeader header;
+	DRIFT_ARRAY(CaptureTexture) textures;
+	DRIFT_ARRAY(DriftGfxSamplerOptions) samplers;
+	DRIFT_ARRAY(CaptureTarget) targets;
+	DRIFT_ARRAY(CaptureShader) shaders;
+	DRIFT_ARRAY(CapturePipeline) pipelines;
+	DRIFT_ARRAY(CaptureCommand) commands;
+	DRIFT_ARRAY(u8) streams[_DRIFT_GFX_STREAM_COUNT];
+
+	// Resources created for the replay, index 0 is NULL.
+	const DriftGfxDriver* driver;
+	DriftGfxTexture** texture_objs;
+	DriftGfxSampler** sampler_objs;
+	DriftGfxRenderTarget** target_objs;
+	DriftGfxShader** shader_objs;
+	DriftGfxPipeline** pipeline_objs;
+	DriftGfxShaderDesc* shader_descs;
+};
+
+static void CaptureIO(DriftIO* io){
+	DriftGfxCapture* capture = io->user_ptr;
+	CaptureHeader* header = &capture->header;
+	DriftIOBlock(io, "header", header, sizeof(*header));
+
+	if(io->read){
+		DRIFT_ASSERT_HARD(memcmp(header->magic, CAPTURE_MAGIC, sizeof(header->magic)) == 0, "Not a gfx capture file.");
+		DRIFT_ASSERT_HARD(header->version == CAPTURE_VERSION, "Unsupported gfx capture version %d.", header->version);
+
+		capture->textures = DRIFT_ARRAY_NEW(DriftSystemMem, header->texture_count, CaptureTexture);
+		capture->samplers = DRIFT_ARRAY_NEW(DriftSystemMem, header->sampler_count, DriftGfxSamplerOptions);
+		capture->targets = DRIFT_ARRAY_NEW(DriftSystemMem, header->target_count, CaptureTarget);
+		capture->shaders = DRIFT_ARRAY_NEW(DriftSystemMem, header->shader_count, CaptureShader);
+		capture->pipelines = DRIFT_ARRAY_NEW(DriftSystemMem, header->pipeline_count, CapturePipeline);
+		capture->commands = DRIFT_ARRAY_NEW(DriftSystemMem, header->command_count, CaptureCommand);
+		DriftArrayHeader(capture->textures)->count = header->texture_count;
+		DriftArrayHeader(capture->samplers)->count = header->sampler_count;
+		DriftArrayHeader(capture->targets)->count = header->target_count;
+		DriftArrayHeader(capture->shaders)->count = header->shader_count;
+		DriftArrayHeader(capture->pipelines)->count = header->pipeline_count;
+		DriftArrayHeader(capture->commands)->count = header->command_count;
+
+		for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++){
+			capture->streams[i] = DRIFT_ARRAY_NEW(DriftSystemMem, header->stream_size[i], u8);
+			DriftArrayHeader(capture->streams[i])->count = header->stream_size[i];
+		}
+	}
+
+	DriftIOBlock(io, "textures", capture->textures, header->texture_count*sizeof(*capture->textures));
+	DriftIOBlock(io, "samplers", capture->samplers, header->sampler_count*sizeof(*capture->samplers));
+	DriftIOBlock(io, "targets", capture->targets, header->target_count*sizeof(*capture->targets));
+	DriftIOBlock(io, "shaders", capture->shaders, header->shader_count*sizeof(*capture->shaders));
+	DriftIOBlock(io, "pipelines", capture->pipelines, header->pipeline_count*sizeof(*capture->pipelines));
+	DriftIOBlock(io, "commands", capture->commands, header->command_count*sizeof(*capture->commands));
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++) DriftIOBlock(io, "stream", capture->streams[i], header->stream_size[i]);
+}
+
+// MARK: Capture.
+
+typedef struct {
+	DriftGfxCapture* capture;
+	// Maps resource pointers to their capture index.
+	DriftMap indexes;
+} CaptureContext;
+
+static void copy_name(char dst[CAPTURE_NAME_SIZE], const char* name){
+	snprintf(dst, CAPTURE_NAME_SIZE, "%s", name ? name : "");
+}
+
+static u32 capture_find(CaptureContext* ctx, const void* ptr){
+	return (u32)DriftMapFind(&ctx->indexes, (uintptr_t)ptr);
+}
+
+static u32 capture_texture(CaptureContext* ctx, const DriftGfxTexture* texture){
+	if(texture == NULL) return 0;
+	u32 idx = capture_find(ctx, texture);
+	if(idx) return idx;
+
+	CaptureTexture t;
+	memset(&t, 0, sizeof(t));
+	copy_name(t.name, texture->options.name);
+	t.width = texture->width, t.height = texture->height, t.layers = texture->options.layers;
+	t.type = texture->options.type, t.format = texture->options.format, t.render_target = texture->options.render_target;
+	DRIFT_ARRAY_PUSH(ctx->capture->textures, t);
+
+	idx = (u32)DriftArrayLength(ctx->capture->textures);
+	DriftMapInsert(&ctx->indexes, (uintptr_t)texture, idx);
+	return idx;
+}
+
+static u32 capture_sampler(CaptureContext* ctx, const DriftGfxSampler* sampler){
+	if(sampler == NULL) return 0;
+	u32 idx = capture_find(ctx, sampler);
+	if(idx) return idx;
+
+	DRIFT_ARRAY_PUSH(ctx->capture->samplers, sampler->options);
+	idx = (u32)DriftArrayLength(ctx->capture->samplers);
+	DriftMapInsert(&ctx->indexes, (uintptr_t)sampler, idx);
+	return idx;
+}
+
+static u32 capture_target(CaptureContext* ctx, const DriftGfxRenderTarget* rt){
+	if(rt == NULL) return 0;
+	u32 idx = capture_find(ctx, rt);
+	if(idx) return idx;
+
+	CaptureTarget t;
+	memset(&t, 0, sizeof(t));
+	copy_name(t.name, rt->options.name);
+	t.load = rt->options.load, t.store = rt->options.store;
+	for(uint i = 0; i < DRIFT_GFX_RENDER_TARGET_COUNT; i++){
+		t.bindings[i].texture = capture_texture(ctx, rt->options.bindings[i].texture);
+		t.bindings[i].layer = rt->options.bindings[i].layer;
+	}
+	DRIFT_ARRAY_PUSH(ctx->capture->targets, t);
+
+	idx = (u32)DriftArrayLength(ctx->capture->targets);
+	DriftMapInsert(&ctx->indexes, (uintptr_t)rt, idx);
+	return idx;
+}
+
+static u32 capture_shader(CaptureContext* ctx, const DriftGfxShader* shader){
+	u32 idx = capture_find(ctx, shader);
+	if(idx) return idx;
+
+	const DriftGfxShaderDesc* desc = shader->desc;
+	CaptureShader s;
+	memset(&s, 0, sizeof(s));
+	copy_name(s.name, shader->name);
+	memcpy(s.vertex, desc->vertex, sizeof(s.vertex));
+	s.vertex_stride = (u32)desc->vertex_stride, s.instance_stride = (u32)desc->instance_stride;
+	for(uint i = 0; i < DRIFT_GFX_UNIFORM_BINDING_COUNT; i++) copy_name(s.uniform[i], desc->uniform[i]);
+	for(uint i = 0; i < DRIFT_GFX_SAMPLER_BINDING_COUNT; i++) copy_name(s.sampler[i], desc->sampler[i]);
+	for(uint i = 0; i < DRIFT_GFX_TEXTURE_BINDING_COUNT; i++) copy_name(s.texture[i], desc->texture[i]);
+	DRIFT_ARRAY_PUSH(ctx->capture->shaders, s);
+
+	idx = (u32)DriftArrayLength(ctx->capture->shaders);
+	DriftMapInsert(&ctx->indexes, (uintptr_t)shader, idx);
+	return idx;
+}
+
+static u32 capture_pipeline(CaptureContext* ctx, const DriftGfxPipeline* pipeline){
+	u32 idx = capture_find(ctx, pipeline);
+	if(idx) return idx;
+
+	const DriftGfxPipelineOptions* options = &pipeline->options;
+	CapturePipeline p;
+	memset(&p, 0, sizeof(p));
+	p.shader = capture_shader(ctx, options->shader);
+	p.target = capture_target(ctx, options->target);
+	p.cull_mode = options->cull_mode;
+	if(options->blend) p.has_blend = true, p.blend = *options->blend;
+	DRIFT_ARRAY_PUSH(ctx->capture->pipelines, p);
+
+	idx = (u32)DriftArrayLength(ctx->capture->pipelines);
+	DriftMapInsert(&ctx->indexes, (uintptr_t)pipeline, idx);
+	return idx;
+}
+
+static CaptureCommand capture_command(CaptureContext* ctx, const DriftGfxCommand* command){
+	// Zero first so padding bytes compress well and files are reproducible.
+	CaptureCommand c;
+	memset(&c, 0, sizeof(c));
+	c.type = command->type;
+
+	switch(command->type){
+		case DRIFT_GFX_COMMAND_TARGET: {
+			const DriftGfxCommandTarget* target = (DriftGfxCommandTarget*)command;
+			c.target.target = capture_target(ctx, target->rt);
+			c.target.clear_color = target->clear_color;
+		} break;
+
+		case DRIFT_GFX_COMMAND_SCISSOR: {
+			c.scissor = ((DriftGfxCommandScissor*)command)->bounds;
+		} break;
+
+		case DRIFT_GFX_COMMAND_PIPELINE: {
+			const DriftGfxCommandPipeline* pipeline = (DriftGfxCommandPipeline*)command;
+			const DriftGfxPipelineBindings* bindings = pipeline->bindings;
+			c.pipeline.pipeline = capture_pipeline(ctx, pipeline->pipeline);
+			c.pipeline.vertex = bindings->vertex;
+			c.pipeline.instance = bindings->instance;
+			memcpy(c.pipeline.uniforms, bindings->uniforms, sizeof(c.pipeline.uniforms));
+			for(uint i = 0; i < DRIFT_GFX_SAMPLER_BINDING_COUNT; i++) c.pipeline.samplers[i] = capture_sampler(ctx, bindings->samplers[i]);
+			for(uint i = 0; i < DRIFT_GFX_TEXTURE_BINDING_COUNT; i++) c.pipeline.textures[i] = capture_texture(ctx, bindings->textures[i]);
+			c.pipeline.blend_color = bindings->blend_color;
+		} break;
+
+		case DRIFT_GFX_COMMAND_DRAW: {
+			const DriftGfxCommandDraw* draw = (DriftGfxCommandDraw*)command;
+			c.draw.index_binding = draw->index_binding;
+			c.draw.index_count = draw->index_count, c.draw.instance_count = draw->instance_count;
+		} break;
+
+		default: DRIFT_ABORT("Invalid command type %d.", command->type);
+	}
+
+	return c;
+}
+
+// Gather the stream back into one contiguous block, overflow pages included.
+static DRIFT_ARRAY(u8) capture_stream(const DriftGfxStream* stream){
+	DRIFT_ARRAY(u8) data = DRIFT_ARRAY_NEW(DriftSystemMem, stream->cursor, u8);
+	DriftArrayHeader(data)->count = stream->cursor;
+	
+	// Zero the unused tails of overflow pages so files are reproducible.
+	memset(data, 0, stream->cursor);
+	memcpy(data, stream->ptr, DRIFT_MIN(stream->cursor, stream->capacity));
+	for(uint i = 0; i < stream->page_count; i++){
+		const DriftGfxStreamPage* page = stream->pages + i;
+		memcpy(data + page->offset, page->ptr, DriftGfxStreamPageUsed(stream, page));
+	}
+
+	return data;
+}
+
+static void capture_free_arrays(DriftGfxCapture* capture){
+	DriftArrayFree(capture->textures);
+	DriftArrayFree(capture->samplers);
+	DriftArrayFree(capture->targets);
+	DriftArrayFree(capture->shaders);
+	DriftArrayFree(capture->pipelines);
+	DriftArrayFree(capture->commands);
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++) DriftArrayFree(capture->streams[i]);
+}
+
+bool DriftGfxCaptureWrite(const DriftGfxRenderer* renderer, const char* filename){
+	u64 t0 = DriftTimeNanos();
+	DriftGfxCapture capture = {
+		.header = {
+			.magic = CAPTURE_MAGIC, .version = CAPTURE_VERSION,
+			.uniform_alignment = (u32)renderer->uniform_alignment, .default_extent = renderer->default_extent,
+		},
+		.textures = DRIFT_ARRAY_NEW(DriftSystemMem, 16, CaptureTexture),
+		.samplers = DRIFT_ARRAY_NEW(DriftSystemMem, 8, DriftGfxSamplerOptions),
+		.targets = DRIFT_ARRAY_NEW(DriftSystemMem, 16, CaptureTarget),
+		.shaders = DRIFT_ARRAY_NEW(DriftSystemMem, 32, CaptureShader),
+		.pipelines = DRIFT_ARRAY_NEW(DriftSystemMem, 32, CapturePipeline),
+		.commands = DRIFT_ARRAY_NEW(DriftSystemMem, 1024, CaptureCommand),
+	};
+
+	CaptureContext ctx = {.capture = &capture};
+	DriftMapInit(&ctx.indexes, DriftSystemMem, "#GfxCapture", 0);
+	for(const DriftGfxCommand* command = renderer->first_command; command; command = command->next){
+		DRIFT_ARRAY_PUSH(capture.commands, capture_command(&ctx, command));
+	}
+	DriftMapDestroy(&ctx.indexes);
+
+	for(uint i = 0; i < _DRIFT_GFX_STREAM_COUNT; i++){
+		capture.streams[i] = capture_stream(renderer->streams + i);
+		capture.header.stream_size[i] = (u32)renderer->streams[i].cursor;
+	}
+
+	CaptureHeader* header = &capture.header;
+	header->texture_count = (u32)DriftArrayLength(capture.textures);
+	header->sampler_count = (u32)DriftArrayLength(capture.samplers);
+	header->target_count = (u32)DriftArrayLength(capture.targets);
+	header->shader_count = (u32)DriftArrayLength(capture.shaders);
+	header->pipeline_count = (u32)DriftArrayLength(capture.pipelines);
+	header->command_count = (u32)DriftArrayLength(capture.commands);
+
+	DriftData data = DriftIOSnapshot(DriftSystemMem, CaptureIO, &capture);
+	bool success = DriftIOSnapshotWrite(filename, data);
+	DriftDealloc(DriftSystemMem, data.ptr, data.size);
+	capture_free_arrays(&capture);
+
+	if(success) DRIFT_LOG("Captured %u gfx commands to '%s' in %.1f ms.", header->command_count, filename, (DriftTimeNanos() - t0)/1e6);
+	return success;
+}
+
+// MARK: Replay.
+
+static const char* name_or_null(const char* name){return name[0] ? name : NULL;}
+
+DriftGfxCapture* DriftGfxCaptureLoad(const char* filename, const DriftGfxDriver* driver){
+	DriftGfxCapture* capture = DRIFT_COPY(DriftSystemMem, ((DriftGfxCapture){.driver = driver}));
+	if(!DriftIOSnapshotRead(filename, CaptureIO, capture)){
+		DRIFT_LOG("Failed to open gfx capture '%s'.", filename);
+		DriftDealloc(DriftSystemMem, capture, sizeof(*capture));
+		return NULL;
+	}
+
+	// Texture contents aren't captured, only their size and format matter to the CPU side.
+	CaptureHeader* header = &capture->header;
+	capture->texture_objs = DriftAlloc(DriftSystemMem, (header->texture_count + 1)*sizeof(*capture->texture_objs));
+	capture->texture_objs[0] = NULL;
+	for(uint i = 0; i < header->texture_count; i++){
+		CaptureTexture* t = capture->textures + i;
+		capture->texture_objs[i + 1] = driver->new_texture(driver, t->width, t->height, (DriftGfxTextureOptions){
+			.name = name_or_null(t->name), .type = t->type, .format = t->format, .layers = t->layers, .render_target = t->render_target,
+		});
+	}
+
+	capture->sampler_objs = DriftAlloc(DriftSystemMem, (header->sampler_count + 1)*sizeof(*capture->sampler_objs));
+	capture->sampler_objs[0] = NULL;
+	for(uint i = 0; i < header->sampler_count; i++) capture->sampler_objs[i + 1] = driver->new_sampler(driver, capture->samplers[i]);
+
+	capture->target_objs = DriftAlloc(DriftSystemMem, (header->target_count + 1)*sizeof(*capture->target_objs));
+	capture->target_objs[0] = NULL;
+	for(uint i = 0; i < header->target_count; i++){
+		CaptureTarget* t = capture->targets + i;
+		DriftGfxRenderTargetOptions options = {.name = name_or_null(t->name), .load = t->load, .store = t->store};
+		for(uint j = 0; j < DRIFT_GFX_RENDER_TARGET_COUNT; j++){
+			options.bindings[j].texture = capture->texture_objs[t->bindings[j].texture];
+			options.bindings[j].layer = t->bindings[j].layer;
+		}
+		capture->target_objs[i + 1] = driver->new_target(driver, options);
+	}
+
+	// Shaders keep a pointer to their description, so they need to outlive them.
+	capture->shader_descs = DriftAlloc(DriftSystemMem, header->shader_count*sizeof(*capture->shader_descs));
+	capture->shader_objs = DriftAlloc(DriftSystemMem, (header->shader_count + 1)*sizeof(*capture->shader_objs));
+	capture->shader_objs[0] = NULL;
+	for(uint i = 0; i < header->shader_count; i++){
+		CaptureShader* s = capture->shaders + i;
+		DriftGfxShaderDesc* desc = capture->shader_descs + i;
+		(*desc) = (DriftGfxShaderDesc){.vertex_stride = s->vertex_stride, .instance_stride = s->instance_stride};
+		memcpy(desc->vertex, s->vertex, sizeof(desc->vertex));
+		for(uint j = 0; j < DRIFT_GFX_UNIFORM_BINDING_COUNT; j++) desc->uniform[j] = name_or_null(s->uniform[j]);
+		for(uint j = 0; j < DRIFT_GFX_SAMPLER_BINDING_COUNT; j++) desc->sampler[j] = name_or_null(s->sampler[j]);
+		for(uint j = 0; j < DRIFT_GFX_TEXTURE_BINDING_COUNT; j++) desc->texture[j] = name_or_null(s->texture[j]);
+		capture->shader_objs[i + 1] = driver->load_shader(driver, s->name, desc);
+	}
+
+	capture->pipeline_objs = DriftAlloc(DriftSystemMem, (header->pipeline_count + 1)*sizeof(*capture->pipeline_objs));
+	capture->pipeline_objs[0] = NULL;
+	for(uint i = 0; i < header->pipeline_count; i++){
+		CapturePipeline* p = capture->pipelines + i;
+		capture->pipeline_objs[i + 1] = driver->new_pipeline(driver, (DriftGfxPipelineOptions){
+			.shader = capture->shader_objs[p->shader], .target = capture->target_objs[p->target],
+			.blend = p->has_blend ? &p->blend : NULL, .cull_mode = p->cull_mode,
+		});
+	}
+
+	DRIFT_LOG("Loaded gfx capture '%s' with %u commands and %u pipelines.", filename, header->command_count, header->pipeline_count);
+	return capture;
+}
+
+typedef DriftGfxBufferSlice PushFunc(DriftGfxRenderer* renderer, const void* ptr, size_t size);
+
+// Fill the mapped buffer first so the remainder lands in a single page at the offset it was captured at.
+static void push_stream(DriftGfxRenderer* renderer, DriftGfxStreamType type, PushFunc* push, const u8* data){
+	size_t size = DriftArrayLength((void*)data), head = DRIFT_MIN(size, renderer->streams[type].capacity);
+	DriftGfxBufferSlice slice = push(renderer, data, head);
+	DRIFT_ASSERT_HARD(slice.binding.offset == 0, "Gfx stream %d was not empty.", type);
+	if(size > head){
+		slice = push(renderer, data + head, size - head);
+		DRIFT_ASSERT_HARD(slice.binding.offset == head, "Gfx stream %d did not overflow contiguously.", type);
+	}
+}
+
+void DriftGfxCapturePush(const DriftGfxCapture* capture, DriftGfxRenderer* renderer){
+	const CaptureHeader* header = &capture->header;
+	DRIFT_ASSERT_HARD(header->uniform_alignment % renderer->uniform_alignment == 0,
+		"Gfx capture uniform alignment (%u) is not compatible with the driver's (%u).", header->uniform_alignment, (uint)renderer->uniform_alignment
+	);
+
+	DRIFT_ASSERT_HARD(renderer->first_command == NULL, "Renderer must be freshly prepared.");
+	push_stream(renderer, DRIFT_GFX_STREAM_VERTEX, DriftGfxRendererPushGeometry, capture->streams[DRIFT_GFX_STREAM_VERTEX]);
+	push_stream(renderer, DRIFT_GFX_STREAM_INDEX, DriftGfxRendererPushIndexes, capture->streams[DRIFT_GFX_STREAM_INDEX]);
+	push_stream(renderer, DRIFT_GFX_STREAM_UNIFORM, DriftGfxRendererPushUniforms, capture->streams[DRIFT_GFX_STREAM_UNIFORM]);
+	
+	for(uint idx = 0; idx < header->command_count; idx++){
+		const CaptureCommand* c = capture->commands + idx;
+		switch(c->type){
+			case DRIFT_GFX_COMMAND_TARGET: {
+				DriftGfxRendererPushBindTargetCommand(renderer, capture->target_objs[c->target.target], c->target.clear_color);
+			} break;
+
+			case DRIFT_GFX_COMMAND_SCISSOR: {
+				DriftGfxRendererPushScissorCommand(renderer, c->scissor);
+			} break;
+
+			case DRIFT_GFX_COMMAND_PIPELINE: {
+				DriftGfxPipelineBindings* bindings = DriftGfxRendererPushBindPipelineCommand(renderer, capture->pipeline_objs[c->pipeline.pipeline]);
+				bindings->vertex = c->pipeline.vertex;
+				bindings->instance = c->pipeline.instance;
+				memcpy(bindings->uniforms, c->pipeline.uniforms, sizeof(bindings->uniforms));
+				for(uint i = 0; i < DRIFT_GFX_SAMPLER_BINDING_COUNT; i++) bindings->samplers[i] = capture->sampler_objs[c->pipeline.samplers[i]];
+				for(uint i = 0; i < DRIFT_GFX_TEXTURE_BINDING_COUNT; i++) bindings->textures[i] = capture->texture_objs[c->pipeline.textures[i]];
+				bindings->blend_color = c->pipeline.blend_color;
+			} break;
+
+			case DRIFT_GFX_COMMAND_DRAW: {
+				DriftGfxRendererPushDrawIndexedCommand(renderer, c->draw.index_binding, c->draw.index_count, c->draw.instance_count);
+			} break;
+
+			default: DRIFT_ABORT("Invalid command type %d.", c->type);
+		}
+	}
+}
+
+void DriftGfxCaptureFree(DriftGfxCapture* capture){
+	const DriftGfxDriver* driver = capture->driver;
+	CaptureHeader* header = &capture->header;
+
+	// Free in reverse order of creation so nothing outlives what it references.
+	driver->free_objects(driver, (void**)capture->pipeline_objs + 1, header->pipeline_count);
+	driver->free_objects(driver, (void**)capture->shader_objs + 1, header->shader_count);
+	driver->free_objects(driver, (void**)capture->target_objs + 1, header->target_count);
+	driver->free_objects(driver, (void**)capture->sampler_objs + 1, header->sampler_count);
+	driver->free_objects(driver, (void**)capture->texture_objs + 1, header->texture_count);
+
+	DriftDealloc(DriftSystemMem, capture->pipeline_objs, (header->pipeline_count + 1)*sizeof(*capture->pipeline_objs));
+	DriftDealloc(DriftSystemMem, capture->shader_objs, (header->shader_count + 1)*sizeof(*capture->shader_objs));
+	DriftDealloc(DriftSystemMem, capture->shader_descs, header->shader_count*sizeof(*capture->shader_descs));
+	DriftDealloc(DriftSystemMem, capture->target_objs, (header->target_count + 1)*sizeof(*capture->target_objs));
+	DriftDealloc(DriftSystemMem, capture->sampler_objs, (header->sampler_count + 1)*sizeof(*capture->sampler_objs));
+	DriftDealloc(DriftSystemMem, capture->texture_objs, (header->texture_count + 1)*sizeof(*capture->texture_objs));
+
+	capture_free_arrays(capture);
+	DriftDealloc(DriftSystemMem, capture, sizeof(*capture));
+}
+
+static const char* COMMAND_NAMES[_DRIFT_GFX_COMMAND_COUNT] = {
+	[DRIFT_GFX_COMMAND_DROPPED] = "dropped",
+	[DRIFT_GFX_COMMAND_TARGET] = "target",
+	[DRIFT_GFX_COMMAND_SCISSOR] = "scissor",
+	[DRIFT_GFX_COMMAND_PIPELINE] = "pipeline",
+	[DRIFT_GFX_COMMAND_DRAW] = "draw",
+};
+
+void DriftGfxReplayRun(tina_job* job){
+	const char* filename = APP->gfx_replay.filename;
+	uint frames = APP->gfx_replay.count ? APP->gfx_replay.count : 100;
+
+	uint queue = tina_job_switch_queue(job, DRIFT_JOB_QUEUE_GFX);
+	DriftGfxCapture* capture = DriftGfxCaptureLoad(filename, APP->gfx_driver);
+	tina_job_switch_queue(job, queue);
+
+	if(capture){
+		u64 push_nanos = 0, present_nanos = 0, optimize_nanos = 0, execute_nanos = 0;
+		u64 command_nanos[_DRIFT_GFX_COMMAND_COUNT] = {};
+		DriftGfxCommandCounts executed = {};
+
+		// The first frame isn't counted since drivers do a lot of lazy setup on it.
+		for(uint frame = 0; frame <= frames; frame++){
+			DriftMem* mem = DriftZoneMemAquire(APP->zone_heap, "GfxReplayMem");
+			DriftGfxRenderer* renderer = DriftAppBeginFrame(mem);
+
+			u64 t0 = DriftTimeNanos();
+			DriftGfxCapturePush(capture, renderer);
+			renderer->time_commands = true;
+			u64 t1 = DriftTimeNanos();
+
+			tina_job_switch_queue(job, DRIFT_JOB_QUEUE_GFX);
+			DriftAppPresentFrame(renderer);
+			tina_job_switch_queue(job, queue);
+			u64 t2 = DriftTimeNanos();
+
+			DriftGfxRendererStats* stats = &renderer->stats;
+			renderer->time_commands = false;
+			if(frame > 0){
+				push_nanos += t1 - t0, present_nanos += t2 - t1;
+				optimize_nanos += stats->optimize_nanos, execute_nanos += stats->execute_nanos;
+				for(uint i = 0; i < _DRIFT_GFX_COMMAND_COUNT; i++) command_nanos[i] += stats->command_nanos[i];
+				executed = stats->executed;
+			}
+
+			DriftZoneMemRelease(mem);
+			DriftProfileFrameMark();
+		}
+
+		DRIFT_LOG("Gfx replay: %u frames of '%s'.", frames, filename);
+		for(uint i = DRIFT_GFX_COMMAND_TARGET; i < _DRIFT_GFX_COMMAND_COUNT; i++){
+			uint calls = executed.commands[i];
+			DRIFT_LOG("Gfx replay: %-10s %6u calls % 9.2f us/frame % 8.3f us/call",
+				COMMAND_NAMES[i], calls, command_nanos[i]/1e3/frames, calls ? command_nanos[i]/1e3/frames/calls : 0
+			);
+		}
+		DRIFT_LOG("Gfx replay: push %.2f ms, optimize %.2f ms, execute %.2f ms, present %.2f ms per frame.",
+			push_nanos/1e6/frames, optimize_nanos/1e6/frames, execute_nanos/1e6/frames, present_nanos/1e6/frames
+		);
+
+		queue = tina_job_switch_queue(job, DRIFT_JOB_QUEUE_GFX);
+		DriftGfxCaptureFree(capture);
+		tina_job_switch_queue(job, queue);
+	}
+
+	DriftAppHaltScheduler();
+}
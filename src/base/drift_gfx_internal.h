@@ -8,15 +8,42 @@ Veridian Expanse is distributed in the hope that it will be useful, but WITHOUT
 You should have received a copy of the GNU General Public License along with Veridian Expanse. If not, see <https://www.gnu.org/licenses/>.
 */
 
-#define DRIFT_GFX_VERTEX_BUFFER_SIZE (6 << 20)
-#define DRIFT_GFX_INDEX_BUFFER_SIZE (1 << 20)
-#define DRIFT_GFX_UNIFORM_BUFFER_SIZE (1 << 20)
+// Starting (and minimum) sizes of the streamed buffers. They grow to fit busier frames.
+#define DRIFT_GFX_VERTEX_BUFFER_SIZE (1 << 20)
+#define DRIFT_GFX_INDEX_BUFFER_SIZE (256 << 10)
+#define DRIFT_GFX_UNIFORM_BUFFER_SIZE (256 << 10)
+// Stream capacities and pages are a multiple of this so offsets past them stay aligned.
+#define DRIFT_GFX_STREAM_GRANULARITY ((size_t)64 << 10)
+#define DRIFT_GFX_STREAM_MAX_PAGES 32
+#define DRIFT_GFX_STREAM_HISTORY 64
+
+// Shares shaders, pipelines, and samplers between identical requests so drivers only create each one once.
+// Shared objects are refcounted, and only destroyed once every holder has freed them.
+// DriftGfxFreeAll() parks shaders and samplers instead so they can be found again after a hotload.
+typedef struct {
+	DriftMap shaders, pipelines, samplers;
+	// Entries by object pointer.
+	DriftMap entries;
+	uint hits, misses;
+} DriftGfxObjectCache;
+
+void DriftGfxObjectCacheInit(DriftGfxObjectCache* cache);
+void DriftGfxObjectCacheDestroy(DriftGfxObjectCache* cache);
+// Return a cached object or NULL. Drivers create the object on a miss and add it.
+// Shaders are matched on their name, desc, and sources. Drivers pass whatever source data they load.
+DriftGfxShader* DriftGfxCacheFindShader(DriftGfxObjectCache* cache, const char* name, const DriftGfxShaderDesc* desc, const DriftData sources[], uint source_count);
+DriftGfxShader* DriftGfxCacheAddShader(DriftGfxObjectCache* cache, DriftGfxShader* shader, const DriftData sources[], uint source_count);
+DriftGfxPipeline* DriftGfxCacheFindPipeline(DriftGfxObjectCache* cache, const DriftGfxPipelineOptions* options);
+DriftGfxPipeline* DriftGfxCacheAddPipeline(DriftGfxObjectCache* cache, DriftGfxPipeline* pipeline);
+DriftGfxSampler* DriftGfxCacheFindSampler(DriftGfxObjectCache* cache, const DriftGfxSamplerOptions* options);
+DriftGfxSampler* DriftGfxCacheAddSampler(DriftGfxObjectCache* cache, DriftGfxSampler* sampler);
 
 typedef void DriftGfxDestructor(const DriftGfxDriver* driver, void* obj);
-void DriftGfxFreeObjects(const DriftGfxDriver* driver, DriftMap* destructors, void* objects[], uint count);
-void DriftGfxFreeAll(const DriftGfxDriver* driver, DriftMap* destructors);
+void DriftGfxFreeObjects(const DriftGfxDriver* driver, DriftMap* destructors, DriftGfxObjectCache* cache, void* objects[], uint count);
+void DriftGfxFreeAll(const DriftGfxDriver* driver, DriftMap* destructors, DriftGfxObjectCache* cache);
 
 typedef struct DriftGfxSampler {
+	DriftGfxSamplerOptions options;
 } DriftGfxSampler;
 
 struct DriftGfxTexture {
@@ -25,6 +52,7 @@ struct DriftGfxTexture {
 };
 
 typedef struct DriftGfxRenderTarget {
+	DriftGfxRenderTargetOptions options;
 	DriftGfxLoadAction load;
 	DriftGfxStoreAction store;
 	DriftVec2 framebuffer_size;
@@ -53,9 +81,20 @@ typedef	void DriftGfxCommandFunc(
 	DriftGfxRenderState* state
 );
 
+typedef enum {
+	// Commands removed by the optimizer before they are unlinked.
+	DRIFT_GFX_COMMAND_DROPPED,
+	DRIFT_GFX_COMMAND_TARGET,
+	DRIFT_GFX_COMMAND_SCISSOR,
+	DRIFT_GFX_COMMAND_PIPELINE,
+	DRIFT_GFX_COMMAND_DRAW,
+	_DRIFT_GFX_COMMAND_COUNT,
+} DriftGfxCommandType;
+
 struct DriftGfxCommand {
 	DriftGfxCommandFunc* func;
 	DriftGfxCommand* next;
+	DriftGfxCommandType type;
 };
 
 typedef struct {
@@ -88,11 +127,60 @@ typedef struct {
 	DriftGfxCommandFunc* draw_indexed;
 } DriftGfxVTable;
 
+typedef enum {
+	DRIFT_GFX_STREAM_VERTEX,
+	DRIFT_GFX_STREAM_INDEX,
+	DRIFT_GFX_STREAM_UNIFORM,
+	_DRIFT_GFX_STREAM_COUNT,
+} DriftGfxStreamType;
+
+// Memory for data that didn't fit into the mapped buffer.
+// Drivers upload it to 'offset' after growing the buffer.
 typedef struct {
-	void* vertex;
-	void* index;
-	void* uniform;
-} DriftGfxBufferPointers;
+	u8* ptr;
+	size_t offset, size;
+} DriftGfxStreamPage;
+
+// Per frame vertex, index or uniform data written into memory the driver maps.
+typedef struct {
+	u8* ptr;
+	size_t capacity, min_capacity;
+	// Bytes used by the frame. Runs past 'capacity' once the frame overflows into pages.
+	size_t cursor;
+	uint page_count;
+	DriftGfxStreamPage pages[DRIFT_GFX_STREAM_MAX_PAGES];
+	
+	// Bytes used by the renderer's previous frames.
+	size_t history[DRIFT_GFX_STREAM_HISTORY];
+	uint frame;
+} DriftGfxStream;
+
+// Capacity the driver should map for the stream's next frame.
+// Grows geometrically to fit the busiest recent frame, and shrinks once recent frames leave it mostly empty.
+size_t DriftGfxStreamNextCapacity(const DriftGfxStream* stream);
+
+static inline size_t DriftGfxStreamPageUsed(const DriftGfxStream* stream, const DriftGfxStreamPage* page){
+	return DRIFT_MIN(page->size, stream->cursor - page->offset);
+}
+
+typedef struct {
+	uint commands[_DRIFT_GFX_COMMAND_COUNT];
+} DriftGfxCommandCounts;
+
+typedef struct {
+	// Bytes used by the frame, the most used by recent frames, and the mapped capacity.
+	size_t used, high_water, capacity;
+	uint overflow_pages;
+} DriftGfxStreamStats;
+
+typedef struct {
+	// Command counts as pushed and as sent to the driver.
+	DriftGfxCommandCounts submitted, executed;
+	u64 optimize_nanos, execute_nanos;
+	// Time spent in each command type's driver function, only measured when 'time_commands' is set.
+	u64 command_nanos[_DRIFT_GFX_COMMAND_COUNT];
+	DriftGfxStreamStats streams[_DRIFT_GFX_STREAM_COUNT];
+} DriftGfxRendererStats;
 
 struct DriftGfxRenderer {
 	DriftGfxVTable vtable;
@@ -104,11 +192,31 @@ struct DriftGfxRenderer {
 	DriftGfxCommand** command_cursor;
 	
 	size_t uniform_alignment;
-	DriftGfxBufferPointers ptr, cursor;
+	DriftGfxStream streams[_DRIFT_GFX_STREAM_COUNT];
 	
 	u8 temp_buffer[64*1024];
+	
+	bool skip_optimize, time_commands;
+	DriftGfxRendererStats stats;
+	
+	// Write a capture of the frame to this file when it's presented.
+	const char* capture_filename;
 };
 
 void DriftGfxRendererInit(DriftGfxRenderer* renderer, DriftGfxVTable vtable);
+// Drop redundant binds and scissors, and merge adjacent instanced draws that can share a bind.
+void DriftGfxRendererOptimizeCommands(DriftGfxRenderer* renderer);
 void DriftRendererExecuteCommands(DriftGfxRenderer* renderer);
 void DriftGfxRendererPrepare(DriftGfxRenderer* renderer, DriftVec2 default_framebuffer_size, DriftMem* mem);
+
+typedef struct DriftGfxCapture DriftGfxCapture;
+
+// Write the renderer's submitted commands, stream data and descriptions of the resources they use.
+// Reads back the mapped stream memory, so it's slow and only meant for debugging.
+bool DriftGfxCaptureWrite(const DriftGfxRenderer* renderer, const char* filename);
+// Load a capture and create the resources it uses with 'driver'. Call from the gfx queue.
+DriftGfxCapture* DriftGfxCaptureLoad(const char* filename, const DriftGfxDriver* driver);
+// Push the captured commands and stream data onto a freshly prepared renderer.
+void DriftGfxCapturePush(const DriftGfxCapture* capture, DriftGfxRenderer* renderer);
+// Free the capture and its resources. Call from the gfx queue.
+void DriftGfxCaptureFree(DriftGfxCapture* capture);
@@ -13,6 +13,10 @@ You should have received a copy of the GNU General Public License along with Ver
 
 #include "drift_base.h"
 
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+
 // https://martin.ankerl.com/2016/09/21/very-fast-hashmap-in-c-part-2/
 #define DRIFT_INDEXMAP_NOT_FOUND (~0u)
 #define DRIFT_INDEXMAP_BUCKET_TAKEN 0x80u
@@ -23,7 +27,11 @@ You should have received a copy of the GNU General Public License along with Ver
 
 #define SWAP(a, b) {__typeof(a) tmp; tmp = a; a = b; b = tmp;}
 
-static inline uint DriftMapHash(DriftMap const* map, uintptr_t key){return key & (map->table.row_capacity - 1);}
+// Keys are often entity ids or pointers with structured low bits, so mix them instead of masking.
+// Fibonacci hashing takes the top bits of the product, which depend on all of the key's bits.
+static inline uint DriftMapHash(DriftMap const* map, uintptr_t key){
+	return (key*0x9E3779B97F4A7C15u) >> (64 - __builtin_ctzll(map->table.row_capacity));
+}
 static inline uint DriftMapNextIndex(DriftMap const* map, uint index){return (index + 1) & (map->table.row_capacity - 1);}
 
 // Lookup the hash table index for a given key.
@@ -31,6 +39,29 @@ static uint DriftMapFindIndex(DriftMap const* map, uintptr_t key){
 	uint index = DriftMapHash(map, key);
 	u8 info = DRIFT_INDEXMAP_BUCKET_TAKEN;
 	
+#if __SSE2__
+	// Check 16 buckets at a time. Bucket 'index + i' can only hold the key if its info is 'info + i'.
+	// Buckets are sorted by probe length, so the key can't be past a bucket with a shorter probe than that.
+	const __m128i lanes = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	for(; index + 16 <= map->table.row_capacity; info += 16, index += 16){
+		__m128i expected = _mm_add_epi8(lanes, _mm_set1_epi8((char)info));
+		__m128i infobytes = _mm_loadu_si128((const __m128i*)(map->infobytes + index));
+		uint match = _mm_movemask_epi8(_mm_cmpeq_epi8(infobytes, expected));
+		uint below = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(infobytes, expected), expected)) & ~match;
+		if(below) match &= (below & -below) - 1;
+		
+		for(; match; match &= match - 1){
+			uint i = index + __builtin_ctz(match);
+			if(key == map->keys[i]) return i;
+		}
+		
+		if(below) return DRIFT_INDEXMAP_NOT_FOUND;
+	}
+	
+	// Finish near the end of the table where the buckets wrap around.
+	index &= map->table.row_capacity - 1;
+#endif
+	
 	// Skip buckets that are empty or taken by an earlier index.
 	for(; info < map->infobytes[index]; info++) index = DriftMapNextIndex(map, index);
 	
@@ -54,14 +85,15 @@ static void DriftMapInitTable(DriftMap* map, DriftTableDesc desc){
 	DRIFT_ASSERT(DriftIsPOT(map->table.row_capacity), "DriftMap table not a power of two size.");
 }
 
-static void DriftMapResize(DriftMap* map){
+static void DriftMapResize(DriftMap* map, size_t capacity){
 	// Make a copy of the old map/table.
 	DriftMap copy = *map;
 	DriftTableDesc desc = map->table.desc;
 	
-	// Re allocate the table with double the capacity.
-	desc.min_row_capacity = 2*copy.table.row_capacity;
+	// Re allocate the table with the new capacity.
+	desc.min_row_capacity = capacity;
 	DriftMapInitTable(map, desc);
+	map->table._shrink_capacity = copy.table._shrink_capacity;
 	
 	// Reinsert then dispose of the old table.
 	for(uint index = 0; index < copy.table.row_capacity; index++){
@@ -96,7 +128,7 @@ void DriftMapDestroy(DriftMap* map){
 // Returns the old index value (or the default value).
 uintptr_t DriftMapInsert(DriftMap *map, uintptr_t key, uintptr_t value){
 	// Hard coded load factor. Doesn't seem to be much reason to change it though.
-	if(5*map->table.row_count > 4*map->table.row_capacity) DriftMapResize(map);
+	if(5*map->table.row_count > 4*map->table.row_capacity) DriftMapResize(map, 2*map->table.row_capacity);
 	
 	uint index = DriftMapHash(map, key);
 	for(u8 info = DRIFT_INDEXMAP_BUCKET_TAKEN; info < DRIFT_INDEXMAP_MAX_INFO; info++){
@@ -120,7 +152,7 @@ uintptr_t DriftMapInsert(DriftMap *map, uintptr_t key, uintptr_t value){
 	}
 	
 	// DRIFT_INDEXMAP_MAX_INFO has been overflown.
-	DriftMapResize(map);
+	DriftMapResize(map, 2*map->table.row_capacity);
 	return DriftMapInsert(map, key, value);
 }
 
@@ -153,6 +185,20 @@ uintptr_t DriftMapRemove(DriftMap* map, uintptr_t key){
 	}
 }
 
+void DriftMapClear(DriftMap* map){
+	memset(map->infobytes, 0x00, map->table.row_capacity*sizeof(*map->infobytes));
+	map->table.row_count = 0;
+}
+
+bool DriftMapShrink(DriftMap* map){
+	// Same hysteresis as tables, the load factor after shrinking is at most 1/2.
+	size_t capacity = map->table.row_capacity;
+	if(capacity <= map->table._shrink_capacity || map->table.row_count >= capacity/DRIFT_TABLE_SHRINK_FACTOR) return false;
+	
+	DriftMapResize(map, DRIFT_MAX(DriftNextPOT(2*map->table.row_count), map->table._shrink_capacity));
+	return true;
+}
+
 // http://www.isthe.com/chongo/tech/comp/fnv/index.html#xor-fold
 uintptr_t DriftFNV64(const u8* ptr, size_t size){
 	_Static_assert(sizeof(uintptr_t) == 8);
@@ -242,4 +288,57 @@ void unit_test_map(void){
 	DriftMapDestroy(&map);
 	DRIFT_LOG("IndexMap tests passed.");
 }
+
+static uintptr_t bench_key(uint pattern, uint i){
+	switch(pattern){
+		// Sequential entity indexes.
+		default: return i + 1;
+		// Entities with the same index bits and varying generations or tags.
+		case 1: return (uintptr_t)(i + 1) << DRIFT_ENTITY_INDEX_BITS;
+		// 64 byte aligned pointers.
+		case 2: return 0x7F0000000000u + 64*(uintptr_t)i;
+		case 3: return DriftFNV64((const u8*)&i, sizeof(i));
+	}
+}
+
+void unit_test_map_bench(void){
+	static const char* PATTERN_NAMES[] = {"sequential", "strided", "pointers", "random"};
+	static const float LOAD_FACTORS[] = {0.25f, 0.5f, 0.75f};
+	uint capacity = 1 << 16;
+	
+	for(uint pattern = 0; pattern < 4; pattern++){
+		for(uint lf = 0; lf < 3; lf++){
+			DriftMap map;
+			DriftMapInit(&map, DriftSystemMem, "bench", capacity);
+			uint n = (uint)(LOAD_FACTORS[lf]*capacity);
+			
+			u64 t0 = DriftTimeNanos();
+			for(uint i = 0; i < n; i++) DriftMapInsert(&map, bench_key(pattern, i), i + 1);
+			u64 t1 = DriftTimeNanos();
+			uintptr_t sum = 0;
+			for(uint i = 0; i < n; i++) sum += DriftMapFind(&map, bench_key(pattern, i));
+			u64 t2 = DriftTimeNanos();
+			for(uint i = n; i < 2*n; i++) sum += DriftMapFind(&map, bench_key(pattern, i));
+			u64 t3 = DriftTimeNanos();
+			
+			uint probe_sum = 0;
+			for(uint i = 0; i < map.table.row_capacity; i++){
+				if(map.infobytes[i]) probe_sum += map.infobytes[i] - DRIFT_INDEXMAP_BUCKET_TAKEN;
+			}
+			DRIFT_ASSERT(sum == (uintptr_t)n*(n + 1)/2, "Incorrect values found.");
+			
+			size_t final_capacity = map.table.row_capacity;
+			u64 t4 = DriftTimeNanos();
+			for(uint i = 0; i < n; i++) DriftMapRemove(&map, bench_key(pattern, i));
+			u64 t5 = DriftTimeNanos();
+			DRIFT_ASSERT(map.table.row_count == 0, "Keys not removed.");
+			
+			DRIFT_LOG("Map %10s @ %.2f: insert %5.1f ns, find %5.1f ns, miss %5.1f ns, remove %5.1f ns, avg probe %.2f%s", PATTERN_NAMES[pattern], LOAD_FACTORS[lf],
+				(double)(t1 - t0)/n, (double)(t2 - t1)/n, (double)(t3 - t2)/n, (double)(t5 - t4)/n, (double)probe_sum/n,
+				final_capacity > capacity ? " (rehashed)" : ""
+			);
+			DriftMapDestroy(&map);
+		}
+	}
+}
 #endif
@@ -111,6 +111,24 @@ static inline DriftVec4 DriftVec4Mul(DriftVec4 v, float s){return (DriftVec4){{v
 static inline DriftVec4 DriftVec4CMul(DriftVec4 a, DriftVec4 b){return (DriftVec4){{a.x*b.x, a.y*b.y, a.z*b.z, a.w*b.w}};}
 static inline DriftVec4 DriftVec4Lerp(DriftVec4 a, DriftVec4 b, float t){return DriftVec4Add(DriftVec4Mul(a, 1 - t), DriftVec4Mul(b, t));}
 
+// IEEE half floats for packed GPU data.
+// Rounds to nearest even, clamps to the largest finite half, and flushes denormals to zero.
+typedef u16 DriftHalf;
+static inline DriftHalf DriftHalfFromFloat(float f){
+	union {float f; u32 u;} v = {f};
+	u32 sign = (v.u >> 16) & 0x8000, mag = v.u & 0x7FFFFFFF;
+	if(mag >= 0x477FF000) return (DriftHalf)(sign | 0x7BFF);
+	if(mag < 0x38800000) return (DriftHalf)sign;
+	mag += 0xFFF + ((mag >> 13) & 1);
+	return (DriftHalf)(sign | ((mag - 0x38000000) >> 13));
+}
+
+static inline float DriftHalfToFloat(DriftHalf h){
+	u32 sign = (h & 0x8000u) << 16, mag = h & 0x7FFFu;
+	union {u32 u; float f;} v = {sign | (mag ? (mag << 13) + 0x38000000 : 0)};
+	return v.f;
+}
+
 typedef struct {u8 r, g, b, a;} DriftRGBA8;
 static inline DriftRGBA8 DriftRGBA8FromColor(DriftVec4 color){
 	return (DriftRGBA8){
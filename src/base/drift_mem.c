@@ -13,6 +13,7 @@ You should have received a copy of the GNU General Public License along with Ver
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdatomic.h>
 
 #include <SDL.h>
 
@@ -158,98 +159,224 @@ void DriftListMemFree(DriftMem* mem){
 
 // MARK: Zone Allocator.
 
-#define MAX_BLOCKS 256
-#define MAX_ZONES 8
 #define BLOCK_SIZE (1 << 20)
+// Block descriptors are allocated in chunks that never move so they can be read without a lock.
+#define BLOCK_CHUNK_SIZE 256
+#define MAX_BLOCK_CHUNKS 256
+#define INITIAL_BLOCKS 16u
+#define THREAD_CACHE_SIZE 4
+#define NIL_BLOCK UINT32_MAX
+
+typedef struct {
+	void* ptr;
+	// Link in a heap free list while pooled, or in a zone's block list while claimed.
+	_Atomic(u32) next;
+} DriftZoneBlock;
 
 typedef struct {
 	DriftMem mem;
 	DriftZoneMemHeap* parent_heap;
 	DriftLinearMem* current_allocator[DRIFT_APP_MAX_THREADS];
 	
-	uint block_count;
-	void* blocks[MAX_BLOCKS];
+	// Lock-free list of claimed blocks, threads only ever push to it.
+	_Atomic(u32) block_list;
+	_Atomic(uint) block_count;
 } DriftZone;
 
+// Only touched by the owning thread, padded to avoid false sharing.
+typedef struct {
+	u32 count;
+	u32 blocks[THREAD_CACHE_SIZE];
+	u8 _pad[64 - (THREAD_CACHE_SIZE + 1)*sizeof(u32)];
+} DriftZoneBlockCache;
+
 struct DriftZoneMemHeap {
 	const char* label;
 	DriftMem* parent_mem;
+	// Only guards the zone pool and growing the block descriptors.
 	SDL_mutex* lock;
 	
-	DRIFT_ARRAY(void*) blocks;
-	DRIFT_ARRAY(void*) pooled_blocks;
+	DriftZoneBlock* block_chunks[MAX_BLOCK_CHUNKS];
+	uint block_capacity;
+	
+	// Treiber stacks of block indexes, tagged with a counter in the high bits to avoid ABA.
+	// 'free_list' blocks have memory, 'empty_list' blocks were released to the OS by a trim.
+	_Atomic(u64) free_list, empty_list;
+	DriftZoneBlockCache caches[DRIFT_APP_MAX_THREADS];
+	
+	_Atomic(uint) blocks_allocated, blocks_used, blocks_peak, blocks_released;
+	// Peak number of used blocks since the last trim.
+	_Atomic(uint) trim_peak;
 	
-	DriftZone zones[MAX_ZONES];
+	DRIFT_ARRAY(DriftZone*) zones;
 	DRIFT_ARRAY(DriftZone*) pooled_zones;
+	uint zones_peak;
 };
 
-static void* alloc_block(DriftZoneMemHeap* heap){
-	DriftArray* header = DriftArrayHeader(heap->blocks);
-	DRIFT_ASSERT_HARD(header->count < header->capacity, "Zone heap '%s' is full!", heap->label);
-	
-	void* block = DriftAlloc(heap->parent_mem, BLOCK_SIZE);
-	DRIFT_ASSERT_HARD(block, "Zone heap '%s' failed to allocate block.", heap->label);
+static inline DriftZoneBlock* get_desc(DriftZoneMemHeap* heap, u32 idx){
+	return heap->block_chunks[idx/BLOCK_CHUNK_SIZE] + idx%BLOCK_CHUNK_SIZE;
+}
+
+static void list_push(DriftZoneMemHeap* heap, _Atomic(u64)* list, u32 idx){
+	DriftZoneBlock* block = get_desc(heap, idx);
+	u64 head = atomic_load_explicit(list, memory_order_relaxed);
+	do {
+		atomic_store_explicit(&block->next, (u32)head, memory_order_relaxed);
+	} while(!atomic_compare_exchange_weak_explicit(list, &head, (((head >> 32) + 1) << 32) | idx, memory_order_release, memory_order_relaxed));
+}
+
+static u32 list_pop(DriftZoneMemHeap* heap, _Atomic(u64)* list){
+	u64 head = atomic_load_explicit(list, memory_order_acquire);
+	while((u32)head != NIL_BLOCK){
+		// The descriptor may be popped and reused concurrently, but the tag makes the CAS fail if so.
+		u32 next = atomic_load_explicit(&get_desc(heap, (u32)head)->next, memory_order_relaxed);
+		u64 new_head = (((head >> 32) + 1) << 32) | next;
+		if(atomic_compare_exchange_weak_explicit(list, &head, new_head, memory_order_acquire, memory_order_acquire)) return (u32)head;
+	}
 	
-	DRIFT_ARRAY_PUSH(heap->blocks, block);
-	return block;
+	return NIL_BLOCK;
+}
+
+static void atomic_max(_Atomic(uint)* value, uint x){
+	uint v = atomic_load_explicit(value, memory_order_relaxed);
+	while(v < x && !atomic_compare_exchange_weak_explicit(value, &v, x, memory_order_relaxed, memory_order_relaxed));
 }
 
-static void* get_block(DriftZoneMemHeap* heap){
+static u32 new_desc(DriftZoneMemHeap* heap){
 	SDL_LockMutex(heap->lock);
-	if(DriftArrayLength(heap->pooled_blocks) == 0){
+	u32 idx = heap->block_capacity;
+	DRIFT_ASSERT_HARD(idx < MAX_BLOCK_CHUNKS*BLOCK_CHUNK_SIZE, "Zone heap '%s' is full!", heap->label);
+	
+	DriftZoneBlock** chunk = heap->block_chunks + idx/BLOCK_CHUNK_SIZE;
+	if(*chunk == NULL) *chunk = DriftAlloc(heap->parent_mem, BLOCK_CHUNK_SIZE*sizeof(**chunk));
+	(*chunk)[idx%BLOCK_CHUNK_SIZE] = (DriftZoneBlock){};
+	heap->block_capacity++;
+	SDL_UnlockMutex(heap->lock);
+	
+	return idx;
+}
+
+static u32 alloc_block(DriftZoneMemHeap* heap){
+	// Reuse a descriptor from a block released by a trim before making a new one.
+	u32 idx = list_pop(heap, &heap->empty_list);
+	if(idx == NIL_BLOCK) idx = new_desc(heap);
+	
+	DriftZoneBlock* block = get_desc(heap, idx);
+	block->ptr = DriftAlloc(heap->parent_mem, BLOCK_SIZE);
+	DRIFT_ASSERT_HARD(block->ptr, "Zone heap '%s' failed to allocate block.", heap->label);
+	ASAN_POISON_MEMORY_REGION(block->ptr, BLOCK_SIZE);
+	
+	atomic_fetch_add_explicit(&heap->blocks_allocated, 1, memory_order_relaxed);
+	return idx;
+}
+
+static u32 get_block(DriftZoneMemHeap* heap, uint thread_id){
+	DriftZoneBlockCache* cache = heap->caches + thread_id;
+	u32 idx = cache->count ? cache->blocks[--cache->count] : list_pop(heap, &heap->free_list);
+	if(idx == NIL_BLOCK){
 		// Allocate a new one if there are no free blocks.
-		DRIFT_ARRAY_PUSH(heap->pooled_blocks, alloc_block(heap));
-		DriftArray* header = DriftArrayHeader(heap->blocks);
-		DRIFT_LOG("Zone heap '%s' allocated new block. (%d/%d)", heap->label, header->count, header->capacity);
+		idx = alloc_block(heap);
+		DRIFT_LOG("Zone heap '%s' allocated new block. (%d)", heap->label, heap->blocks_allocated);
 	}
 	
-	void* block = DRIFT_ARRAY_POP(heap->pooled_blocks, NULL);
-	SDL_UnlockMutex(heap->lock);
+	uint used = atomic_fetch_add_explicit(&heap->blocks_used, 1, memory_order_relaxed) + 1;
+	atomic_max(&heap->blocks_peak, used);
+	atomic_max(&heap->trim_peak, used);
+	return idx;
+}
+
+static void put_block(DriftZoneMemHeap* heap, uint thread_id, u32 idx){
+	ASAN_POISON_MEMORY_REGION(get_desc(heap, idx)->ptr, BLOCK_SIZE);
+	atomic_fetch_sub_explicit(&heap->blocks_used, 1, memory_order_relaxed);
 	
-	return block;
+	DriftZoneBlockCache* cache = heap->caches + thread_id;
+	if(cache->count < THREAD_CACHE_SIZE){
+		cache->blocks[cache->count++] = idx;
+	} else {
+		list_push(heap, &heap->free_list, idx);
+	}
 }
 
 DriftZoneMemHeap* DriftZoneMemHeapNew(DriftMem* mem, const char* label){
 	DriftZoneMemHeap* heap = DRIFT_COPY(mem, ((DriftZoneMemHeap){
 		.label = label, .parent_mem = mem,
-		.blocks = DRIFT_ARRAY_NEW(mem, MAX_BLOCKS, void*),
-		.pooled_blocks = DRIFT_ARRAY_NEW(mem, MAX_BLOCKS, void*),
-		.pooled_zones = DRIFT_ARRAY_NEW(mem, MAX_ZONES, DriftZone*),
+		.free_list = NIL_BLOCK, .empty_list = NIL_BLOCK,
+		.zones = DRIFT_ARRAY_NEW(mem, 16, DriftZone*),
+		.pooled_zones = DRIFT_ARRAY_NEW(mem, 16, DriftZone*),
 	}));
-	
-	// Pool the zones.
-	for(uint i = 0; i < MAX_ZONES; i++) DRIFT_ARRAY_PUSH(heap->pooled_zones, heap->zones + i);
+	heap->lock = SDL_CreateMutex();
 	
 	// Allocate some initial blocks for the pool.
-	for(uint i = 0; i < 16; i++) DRIFT_ARRAY_PUSH(heap->pooled_blocks, alloc_block(heap));
+	for(uint i = 0; i < INITIAL_BLOCKS; i++) list_push(heap, &heap->free_list, alloc_block(heap));
 	
-	heap->lock = SDL_CreateMutex();
 	return heap;
 }
 
 void DriftZoneMemHeapFree(DriftZoneMemHeap* heap){
 	SDL_DestroyMutex(heap->lock);
-	DRIFT_ARRAY_FOREACH(heap->blocks, block) DriftDealloc(heap->parent_mem, *block, BLOCK_SIZE);
-	DriftArrayFree(heap->blocks);
-	DriftArrayFree(heap->pooled_blocks);
+	for(uint i = 0; i < heap->block_capacity; i++){
+		DriftZoneBlock* block = get_desc(heap, i);
+		if(block->ptr == NULL) continue;
+		
+		ASAN_UNPOISON_MEMORY_REGION(block->ptr, BLOCK_SIZE);
+		DriftDealloc(heap->parent_mem, block->ptr, BLOCK_SIZE);
+	}
+	
+	for(uint i = 0; i < MAX_BLOCK_CHUNKS; i++){
+		if(heap->block_chunks[i]) DriftDealloc(heap->parent_mem, heap->block_chunks[i], BLOCK_CHUNK_SIZE*sizeof(DriftZoneBlock));
+	}
+	
+	DRIFT_ARRAY_FOREACH(heap->zones, zone) DriftDealloc(heap->parent_mem, *zone, sizeof(**zone));
+	DriftArrayFree(heap->zones);
 	DriftArrayFree(heap->pooled_zones);
-	DriftDealloc(DriftSystemMem, heap, sizeof(*heap));
+	DriftDealloc(heap->parent_mem, heap, sizeof(*heap));
+}
+
+uint DriftZoneMemHeapTrim(DriftZoneMemHeap* heap){
+	// Keep enough blocks to cover the peak usage since the last trim.
+	uint keep = DRIFT_MAX(atomic_exchange(&heap->trim_peak, heap->blocks_used), INITIAL_BLOCKS);
+	
+	uint released = 0;
+	while(heap->blocks_allocated > keep){
+		u32 idx = list_pop(heap, &heap->free_list);
+		if(idx == NIL_BLOCK) break;
+		
+		// Popping the block gives exclusive ownership of its memory, only the descriptor is shared.
+		DriftZoneBlock* block = get_desc(heap, idx);
+		ASAN_UNPOISON_MEMORY_REGION(block->ptr, BLOCK_SIZE);
+		DriftDealloc(heap->parent_mem, block->ptr, BLOCK_SIZE);
+		block->ptr = NULL;
+		
+		list_push(heap, &heap->empty_list, idx);
+		atomic_fetch_sub(&heap->blocks_allocated, 1);
+		released++;
+	}
+	
+	atomic_fetch_add(&heap->blocks_released, released);
+	if(released) DRIFT_LOG("Zone heap '%s' released %u blocks. (%u)", heap->label, released, heap->blocks_allocated);
+	return released;
 }
 
 DriftZoneHeapInfo DriftZoneHeapGetInfo(DriftZoneMemHeap* heap){
-	uint blocks = DriftArrayLength(heap->blocks);
+	SDL_LockMutex(heap->lock);
+	uint zones = DriftArrayLength(heap->zones);
 	DriftZoneHeapInfo info = {
-		.blocks_allocated = blocks, .blocks_used = blocks - DriftArrayLength(heap->pooled_blocks),
-		.zones_allocated = MAX_ZONES, .zones_used = MAX_ZONES - DriftArrayLength(heap->pooled_zones),
+		.blocks_allocated = heap->blocks_allocated, .blocks_used = heap->blocks_used,
+		.zones_allocated = zones, .zones_used = zones - DriftArrayLength(heap->pooled_zones),
+		.blocks_peak = heap->blocks_peak, .zones_peak = heap->zones_peak, .blocks_released = heap->blocks_released,
 	};
 	
-	for(uint i = 0; i < MAX_ZONES; i++) info.zone_names[i] = heap->zones[i].mem.label;
+	for(uint i = 0; i < DRIFT_MIN(zones, 64u); i++){
+		DriftZone* zone = heap->zones[i];
+		info.zone_names[i] = zone->mem.label;
+		info.zone_blocks[i] = zone->block_count;
+	}
+	SDL_UnlockMutex(heap->lock);
 	
 	return info;
 }
 
-static void* DriftZoneMemAlloc(DriftZone* zone, size_t size){
-	uint thread_id = DriftGetThreadID();
+static void* zone_alloc(DriftZone* zone, uint thread_id, size_t size){
 	DRIFT_ASSERT_HARD(thread_id < DRIFT_APP_MAX_THREADS, "DriftZoneMalloc(): Invalid thread id.");
 	
 	// Fast path when there is an allocator with enough space.
@@ -260,11 +387,19 @@ static void* DriftZoneMemAlloc(DriftZone* zone, size_t size){
 	
 	size_t block_size = BLOCK_SIZE;
 	DRIFT_ASSERT(size < block_size, "Allocation size exceeds block size.");
-	void* block = get_block(zone->parent_heap);
+	DriftZoneMemHeap* heap = zone->parent_heap;
+	u32 idx = get_block(heap, thread_id);
+	DriftZoneBlock* desc = get_desc(heap, idx);
 	
 	// Claim the block.
-	zone->blocks[zone->block_count++] = block;
+	u32 head = atomic_load_explicit(&zone->block_list, memory_order_relaxed);
+	do {
+		atomic_store_explicit(&desc->next, head, memory_order_relaxed);
+	} while(!atomic_compare_exchange_weak_explicit(&zone->block_list, &head, idx, memory_order_release, memory_order_relaxed));
+	atomic_fetch_add_explicit(&zone->block_count, 1, memory_order_relaxed);
+	
 	// Initialize the allocator.
+	void* block = desc->ptr;
 	ASAN_UNPOISON_MEMORY_REGION(block + block_size - sizeof(DriftLinearMem), sizeof(DriftLinearMem));
 	zone->current_allocator[thread_id] = _DriftLinearMemMake(block, block_size, zone->mem.label);
 	return DriftLinearMemAlloc(zone->current_allocator[thread_id], size);
@@ -276,7 +411,7 @@ static void* DriftZoneMemFunc(DriftMem* mem, void* ptr, size_t osize, size_t nsi
 		return (nsize > 0 ? ptr : NULL);
 	} else {
 		// Combined alloc/grow.
-		void* new_ptr = DriftZoneMemAlloc((DriftZone*)mem, nsize);
+		void* new_ptr = zone_alloc((DriftZone*)mem, DriftGetThreadID(), nsize);
 		DRIFT_ASSERT_HARD(new_ptr, "Failed to resize memory for '%s'", mem->label);
 		
 		ASAN_UNPOISON_MEMORY_REGION(new_ptr, nsize);
@@ -287,29 +422,150 @@ static void* DriftZoneMemFunc(DriftMem* mem, void* ptr, size_t osize, size_t nsi
 DriftMem* DriftZoneMemAquire(DriftZoneMemHeap* heap, const char* label){
 	SDL_LockMutex(heap->lock);
 	DriftZone* zone = DRIFT_ARRAY_POP(heap->pooled_zones, NULL);
+	if(zone == NULL){
+		// Grow the pool if all the zones are in use.
+		zone = DriftAlloc(heap->parent_mem, sizeof(*zone));
+		DRIFT_ARRAY_PUSH(heap->zones, zone);
+	}
+	
+	uint zones_used = DriftArrayLength(heap->zones) - DriftArrayLength(heap->pooled_zones);
+	heap->zones_peak = DRIFT_MAX(heap->zones_peak, zones_used);
+	*zone = (DriftZone){.mem.func = DriftZoneMemFunc, .mem.label = label, .parent_heap = heap, .block_list = NIL_BLOCK};
 	SDL_UnlockMutex(heap->lock);
 	
-	DRIFT_ASSERT(zone, "Ran out of pooled zones.");
-	*zone = (DriftZone){.mem.func = DriftZoneMemFunc, .mem.label = label, .parent_heap = heap};
 	// DRIFT_LOG("zone aquired '%s' %p", label, zone);
 	return &zone->mem;
 }
 
-void DriftZoneMemRelease(DriftMem* mem){
-	DRIFT_ASSERT(mem->func == DriftZoneMemFunc, "Invalid zone mem object.");
-	DriftZone* zone = (DriftZone*)mem;
+static void zone_release(DriftZone* zone, uint thread_id){
 	// DRIFT_LOG("releasing zone: '%s' %p", mem->label, zone);
 	DriftZoneMemHeap* heap = zone->parent_heap;
 	
 	// Re-pool the resources.
-	zone->mem.label = "<pooled>";
+	u32 idx = atomic_load_explicit(&zone->block_list, memory_order_acquire);
+	while(idx != NIL_BLOCK){
+		u32 next = atomic_load_explicit(&get_desc(heap, idx)->next, memory_order_relaxed);
+		put_block(heap, thread_id, idx);
+		idx = next;
+	}
+	
 	SDL_LockMutex(heap->lock);
-	for(uint i = 0; i < zone->block_count; i++) ASAN_POISON_MEMORY_REGION(zone->blocks[i], BLOCK_SIZE);
-	while(zone->block_count--) DRIFT_ARRAY_PUSH(heap->pooled_blocks, zone->blocks[zone->block_count]);
+	zone->mem.label = "<pooled>";
+	zone->block_count = 0;
 	DRIFT_ARRAY_PUSH(heap->pooled_zones, zone);
 	SDL_UnlockMutex(heap->lock);
 }
 
+void DriftZoneMemRelease(DriftMem* mem){
+	DRIFT_ASSERT(mem->func == DriftZoneMemFunc, "Invalid zone mem object.");
+	zone_release((DriftZone*)mem, DriftGetThreadID());
+}
+
+#if DRIFT_DEBUG
+#define BENCH_THREADS 8
+#define BENCH_ROUNDS 64
+#define BENCH_ALLOCS (16*1024)
+
+typedef struct {
+	DriftZone* zone;
+	uint thread_id;
+	SDL_sem* start;
+	SDL_sem* done;
+	bool quit;
+	u64 nanos;
+} ZoneBenchThread;
+
+static int zone_bench_thread(void* user_data){
+	ZoneBenchThread* ctx = user_data;
+	void* allocs[BENCH_ALLOCS];
+	
+	while(true){
+		SDL_SemWait(ctx->start);
+		if(ctx->quit) return 0;
+		
+		u64 t0 = DriftTimeNanos();
+		for(uint i = 0; i < BENCH_ALLOCS; i++){
+			size_t size = 16 + (i*2654435761u)%1024;
+			allocs[i] = zone_alloc(ctx->zone, ctx->thread_id, size);
+			ASAN_UNPOISON_MEMORY_REGION(allocs[i], size);
+			*(uint*)allocs[i] = ctx->thread_id << 16 | i;
+		}
+		ctx->nanos += DriftTimeNanos() - t0;
+		
+		// Allocations must not be shared with other threads.
+		for(uint i = 0; i < BENCH_ALLOCS; i++){
+			DRIFT_ASSERT_HARD(*(uint*)allocs[i] == (ctx->thread_id << 16 | i), "Zone allocation overlap.");
+		}
+		SDL_SemPost(ctx->done);
+	}
+}
+
+void unit_test_zone_mem(void){
+	DriftZoneMemHeap* heap = DriftZoneMemHeapNew(DriftSystemMem, "unit_test_zone_mem");
+	
+	// Acquire more zones than the heap used to be limited to.
+	DriftMem* zones[32];
+	for(uint i = 0; i < 32; i++) zones[i] = DriftZoneMemAquire(heap, "unit_test");
+	for(uint i = 0; i < 32; i++) DriftZoneMemRelease(zones[i]);
+	DRIFT_ASSERT(DriftZoneHeapGetInfo(heap).zones_peak == 32, "Zone pool didn't grow.");
+	
+	ZoneBenchThread threads[BENCH_THREADS];
+	SDL_Thread* handles[BENCH_THREADS];
+	SDL_sem* done = SDL_CreateSemaphore(0);
+	for(uint i = 0; i < BENCH_THREADS; i++){
+		// Thread 0 is reserved for the caller.
+		threads[i] = (ZoneBenchThread){.thread_id = i + 1, .start = SDL_CreateSemaphore(0), .done = done};
+		handles[i] = SDL_CreateThread(zone_bench_thread, "zone bench", threads + i);
+	}
+	
+	u64 t0 = DriftTimeNanos();
+	for(uint round = 0; round < BENCH_ROUNDS; round++){
+		DriftZone* zone = (DriftZone*)DriftZoneMemAquire(heap, "unit_test");
+		for(uint i = 0; i < BENCH_THREADS; i++){
+			threads[i].zone = zone;
+			SDL_SemPost(threads[i].start);
+		}
+		for(uint i = 0; i < BENCH_THREADS; i++) SDL_SemWait(done);
+		
+		DRIFT_ASSERT(heap->blocks_used == zone->block_count, "Block count mismatch.");
+		zone_release(zone, DRIFT_THREAD_ID_MAIN);
+	}
+	double seconds = (DriftTimeNanos() - t0)/1e9;
+	
+	u64 thread_nanos = 0;
+	for(uint i = 0; i < BENCH_THREADS; i++){
+		threads[i].quit = true;
+		SDL_SemPost(threads[i].start);
+		SDL_WaitThread(handles[i], NULL);
+		SDL_DestroySemaphore(threads[i].start);
+		thread_nanos += threads[i].nanos;
+	}
+	SDL_DestroySemaphore(done);
+	
+	DriftZoneHeapInfo info = DriftZoneHeapGetInfo(heap);
+	DRIFT_ASSERT(info.blocks_used == 0, "Blocks leaked.");
+	DRIFT_ASSERT(info.blocks_peak <= info.blocks_allocated, "Invalid high-water mark.");
+	
+	uint allocs = BENCH_THREADS*BENCH_ROUNDS*BENCH_ALLOCS;
+	DRIFT_LOG("Zone heap: %d threads, %.1f M allocs/s, %.1f ns/alloc per thread, peak %d blocks.",
+		BENCH_THREADS, allocs/seconds/1e6, (double)thread_nanos/allocs, info.blocks_peak
+	);
+	
+	// With no blocks in use, a trim after the next one releases everything beyond the initial reserve.
+	DriftZoneMemHeapTrim(heap);
+	DriftZoneMemHeapTrim(heap);
+	info = DriftZoneHeapGetInfo(heap);
+	DRIFT_ASSERT(info.blocks_allocated <= INITIAL_BLOCKS + THREAD_CACHE_SIZE*(BENCH_THREADS + 1), "Trim didn't release blocks.");
+	
+	// Released descriptors are reused.
+	DriftMem* mem = DriftZoneMemAquire(heap, "unit_test");
+	for(uint i = 0; i < 64; i++) DriftAlloc(mem, 512*1024);
+	DriftZoneMemRelease(mem);
+	
+	DriftZoneMemHeapFree(heap);
+}
+#endif
+
 
 // MARK: Strings
 
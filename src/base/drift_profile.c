@@ -0,0 +1,276 @@
+/*
+This file is part of Veridian Expanse.
+
+Veridian Expanse is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Veridian Expanse is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Veridian Expanse. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+#include "drift_base.h"
+
+#define RING_SIZE (16*1024u)
+#define MAX_NAMES 256u
+#define HISTORY_SIZE 128u
+#define MAX_CAPTURE (1024*1024u)
+
+typedef struct {
+	const char* name;
+	u64 start, end;
+	uint thread;
+} ProfileEvent;
+
+// Single producer (the owning thread), single consumer (the main thread).
+typedef struct {
+	ProfileEvent events[RING_SIZE];
+	uint head, tail, dropped;
+} ProfileRing;
+
+typedef struct {
+	const char* name;
+	u64 frame_nanos;
+	uint frame_calls, calls;
+	u64 history[HISTORY_SIZE];
+} ProfileEntry;
+
+bool DRIFT_PROFILE_ENABLED;
+
+static struct {
+	ProfileRing* rings[DRIFT_APP_MAX_THREADS];
+	u64 base_nanos;
+	
+	ProfileEntry entries[MAX_NAMES];
+	uint entry_count, frame_count;
+	
+	DRIFT_ARRAY(ProfileEvent) capture;
+	uint capture_dropped;
+} PROFILE;
+
+void DriftProfileSetEnabled(bool enabled){
+	DriftAssertMainThread();
+	if(enabled && PROFILE.rings[0] == NULL){
+		for(uint i = 0; i < DRIFT_APP_MAX_THREADS; i++) PROFILE.rings[i] = DRIFT_COPY(DriftSystemMem, ((ProfileRing){}));
+		PROFILE.capture = DRIFT_ARRAY_NEW(DriftSystemMem, 64*1024, ProfileEvent);
+		PROFILE.base_nanos = DriftTimeNanos();
+	}
+	
+	// Make sure the rings are visible before any thread can write to them.
+	atomic_thread_fence(memory_order_release);
+	DRIFT_PROFILE_ENABLED = enabled;
+}
+
+void _DriftProfileEnd(DriftProfileZone zone){
+	ProfileRing* ring = PROFILE.rings[DriftGetThreadID()];
+	atomic_thread_fence(memory_order_acquire);
+	if(ring->head - ring->tail == RING_SIZE){
+		ring->dropped++;
+		return;
+	}
+	
+	ring->events[ring->head & (RING_SIZE - 1)] = (ProfileEvent){.name = zone.name, .start = zone.start, .end = DriftTimeNanos(), .thread = zone.thread};
+	atomic_thread_fence(memory_order_release);
+	ring->head++;
+}
+
+static ProfileEntry* find_entry(const char* name){
+	for(uint i = 0; i < PROFILE.entry_count; i++){
+		ProfileEntry* entry = PROFILE.entries + i;
+		if(entry->name == name || strcmp(entry->name, name) == 0) return entry;
+	}
+	
+	if(PROFILE.entry_count == MAX_NAMES) return NULL;
+	ProfileEntry* entry = PROFILE.entries + PROFILE.entry_count++;
+	*entry = (ProfileEntry){.name = name};
+	return entry;
+}
+
+void DriftProfileFrameMark(void){
+	if(PROFILE.rings[0] == NULL) return;
+	DriftAssertMainThread();
+	DRIFT_PROFILE_SCOPE("Profile Collect");
+	
+	for(uint thread = 0; thread < DRIFT_APP_MAX_THREADS; thread++){
+		ProfileRing* ring = PROFILE.rings[thread];
+		uint head = ring->head;
+		atomic_thread_fence(memory_order_acquire);
+		
+		for(uint i = ring->tail; i != head; i++){
+			ProfileEvent* event = ring->events + (i & (RING_SIZE - 1));
+			ProfileEntry* entry = find_entry(event->name);
+			if(entry){
+				entry->frame_nanos += event->end - event->start;
+				entry->frame_calls++;
+			}
+			
+			if(DriftArrayLength(PROFILE.capture) < MAX_CAPTURE){
+				DRIFT_ARRAY_PUSH(PROFILE.capture, *event);
+			} else {
+				PROFILE.capture_dropped++;
+			}
+		}
+		
+		atomic_thread_fence(memory_order_release);
+		ring->tail = head;
+	}
+	
+	uint history_idx = PROFILE.frame_count++ % HISTORY_SIZE;
+	for(uint i = 0; i < PROFILE.entry_count; i++){
+		ProfileEntry* entry = PROFILE.entries + i;
+		entry->history[history_idx] = entry->frame_nanos;
+		entry->calls = entry->frame_calls;
+		entry->frame_nanos = 0;
+		entry->frame_calls = 0;
+	}
+}
+
+static int compare_u64(const void* a, const void* b){
+	u64 x = *(const u64*)a, y = *(const u64*)b;
+	return (x > y) - (x < y);
+}
+
+static int compare_stats(const void* a, const void* b){
+	double x = ((const DriftProfileStat*)a)->avg_ms, y = ((const DriftProfileStat*)b)->avg_ms;
+	return (x < y) - (x > y);
+}
+
+uint DriftProfileGetStats(DriftProfileStat* stats, uint max_count){
+	uint frames = DRIFT_MIN(PROFILE.frame_count, HISTORY_SIZE);
+	if(frames == 0) return 0;
+	
+	uint count = DRIFT_MIN(PROFILE.entry_count, max_count);
+	for(uint i = 0; i < count; i++){
+		ProfileEntry* entry = PROFILE.entries + i;
+		
+		u64 sorted[HISTORY_SIZE], sum = 0;
+		memcpy(sorted, entry->history, frames*sizeof(*sorted));
+		qsort(sorted, frames, sizeof(*sorted), compare_u64);
+		for(uint j = 0; j < frames; j++) sum += sorted[j];
+		
+		uint p99_idx = (uint)ceil(0.99*frames) - 1;
+		stats[i] = (DriftProfileStat){
+			.name = entry->name, .calls = entry->calls,
+			.min_ms = sorted[0]/1e6, .avg_ms = sum/1e6/frames,
+			.p99_ms = sorted[p99_idx]/1e6, .max_ms = sorted[frames - 1]/1e6,
+		};
+	}
+	
+	qsort(stats, count, sizeof(*stats), compare_stats);
+	return count;
+}
+
+static void write_json_string(FILE* file, const char* str){
+	fputc('"', file);
+	for(; *str; str++){
+		if(*str == '"' || *str == '\\') fputc('\\', file);
+		fputc(*str, file);
+	}
+	fputc('"', file);
+}
+
+bool DriftProfileWriteTrace(const char* filename){
+	DriftAssertMainThread();
+	if(PROFILE.capture == NULL) return false;
+	
+	FILE* file = fopen(filename, "w");
+	DRIFT_ASSERT_WARN(file, "Failed to open '%s'.", filename);
+	if(file == NULL) return false;
+	
+	fprintf(file, "{\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"main\"}},\n", DRIFT_THREAD_ID_MAIN);
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"gfx\"}},\n", DRIFT_THREAD_ID_GFX);
+	
+	uint count = (uint)DriftArrayLength(PROFILE.capture);
+	for(uint i = 0; i < count; i++){
+		ProfileEvent* event = PROFILE.capture + i;
+		fprintf(file, "{\"name\":");
+		write_json_string(file, event->name);
+		fprintf(file, ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+			event->thread, (event->start - PROFILE.base_nanos)/1e3, (event->end - event->start)/1e3, i + 1 < count ? "," : ""
+		);
+	}
+	
+	fprintf(file, "]}\n");
+	fclose(file);
+	
+	uint dropped = PROFILE.capture_dropped;
+	for(uint i = 0; i < DRIFT_APP_MAX_THREADS; i++) dropped += PROFILE.rings[i]->dropped;
+	DRIFT_LOG("Wrote %u profile zones to '%s' (%u dropped).", count, filename, dropped);
+	
+	DriftArrayHeader(PROFILE.capture)->count = 0;
+	PROFILE.capture_dropped = 0;
+	return true;
+}
+
+bool DriftProfileWriteCSV(const char* filename){
+	FILE* file = fopen(filename, "w");
+	DRIFT_ASSERT_WARN(file, "Failed to open '%s'.", filename);
+	if(file == NULL) return false;
+	
+	DriftProfileStat stats[MAX_NAMES];
+	uint count = DriftProfileGetStats(stats, MAX_NAMES);
+	
+	fprintf(file, "name,calls,min_ms,avg_ms,p99_ms,max_ms\n");
+	for(uint i = 0; i < count; i++){
+		DriftProfileStat* s = stats + i;
+		fprintf(file, "\"%s\",%u,%.4f,%.4f,%.4f,%.4f\n", s->name, s->calls, s->min_ms, s->avg_ms, s->p99_ms, s->max_ms);
+	}
+	
+	fclose(file);
+	DRIFT_LOG("Wrote %u profile stats to '%s'.", count, filename);
+	return true;
+}
+
+#if DRIFT_DEBUG
+void unit_test_profile(void){
+	bool was_enabled = DRIFT_PROFILE_ENABLED;
+	uint n = 1000000;
+	
+	// Measure the cost of a zone with the profiler disabled.
+	DRIFT_PROFILE_ENABLED = false;
+	u64 t0 = DriftTimeNanos();
+	for(uint i = 0; i < n; i++){
+		DRIFT_PROFILE_SCOPE("unit_test_profile");
+		__asm__ volatile("" ::: "memory");
+	}
+	double disabled_ns = (double)(DriftTimeNanos() - t0)/n;
+	
+	// Measure the cost of an enabled zone, collecting periodically so the ring doesn't overflow.
+	DriftProfileSetEnabled(true);
+	t0 = DriftTimeNanos();
+	for(uint i = 0; i < n; i++){
+		{DRIFT_PROFILE_SCOPE("unit_test_profile");}
+		if(i % (RING_SIZE/2) == 0) DriftProfileFrameMark();
+	}
+	double enabled_ns = (double)(DriftTimeNanos() - t0)/n;
+	DriftProfileFrameMark();
+	
+	DriftProfileStat stats[MAX_NAMES];
+	uint count = DriftProfileGetStats(stats, MAX_NAMES);
+	bool found = false;
+	for(uint i = 0; i < count; i++) found |= strcmp(stats[i].name, "unit_test_profile") == 0;
+	DRIFT_ASSERT(found, "Zone not found in profile stats.");
+	
+	// Nested zones are both recorded.
+	{
+		DRIFT_PROFILE_SCOPE("unit_test_outer");
+		DRIFT_PROFILE_SCOPE("unit_test_inner");
+	}
+	DriftProfileFrameMark();
+	uint nested = 0;
+	count = DriftProfileGetStats(stats, MAX_NAMES);
+	for(uint i = 0; i < count; i++){
+		if(strcmp(stats[i].name, "unit_test_outer") == 0 || strcmp(stats[i].name, "unit_test_inner") == 0) nested += stats[i].calls;
+	}
+	DRIFT_ASSERT(nested == 2, "Nested zones not recorded.");
+	
+	DriftArrayHeader(PROFILE.capture)->count = 0;
+	DriftProfileSetEnabled(was_enabled);
+	DRIFT_LOG("Profile zone overhead: %.1f ns disabled, %.1f ns enabled.", disabled_ns, enabled_ns);
+}
+#endif
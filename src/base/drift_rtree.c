@@ -280,6 +280,13 @@ static DriftAABB2 node_update_rec(TreeUpdateCtx* ctx, DriftRNode* node, uint dep
 	return node_bb;
 }
 
+void DriftRTreeReset(DriftRTree* tree){
+	tree->t.row_count = 0;
+	tree->count = tree->leaf_depth = tree->pool_idx = 0;
+	tree->root = DriftTablePushRow(&tree->t);
+	tree->node[tree->root] = (DriftRNode){};
+}
+
 void DriftRTreeUpdate(DriftRTree* tree, uint obj_count, DriftRTreeBoundFunc bound_func, void* bound_data, tina_job* job, DriftMem* mem){
 	TracyCZoneN(ZONE_UPDATE, "RTree Update", true);
 	TreeUpdateCtx ctx = {
@@ -14,6 +14,16 @@ You should have received a copy of the GNU General Public License along with Ver
 
 static size_t TableSize(DriftTable* table){return table->row_capacity*table->row_size;}
 
+// Reserved tables give each column it's own page aligned range of address space.
+static size_t PageSize(size_t size){return -(-size & -DRIFT_VIRTUAL_PAGE_SIZE);}
+static size_t ReservedColumnSize(DriftTable* table, DriftColumn* column){return PageSize(table->desc.reserve_rows*column->size);}
+static size_t ReservedTableSize(DriftTable* table){
+	size_t size = 0;
+	DriftColumn *columns = table->desc.columns.arr;
+	for(uint i = 0; i < DRIFT_TABLE_MAX_COLUMNS && columns[i].size; i++) size += ReservedColumnSize(table, columns + i);
+	return size;
+}
+
 DriftTable* DriftTableInit(DriftTable* table, DriftTableDesc desc){
 	if(desc.name == NULL || desc.name[0] == '\0') desc.name = "<noname>";
 	table->desc = desc;
@@ -22,6 +32,7 @@ DriftTable* DriftTableInit(DriftTable* table, DriftTableDesc desc){
 	table->row_size = 0;
 	
 	table->row_capacity = DRIFT_MAX(DRIFT_TABLE_MIN_ROW_CAPACITY, -(-desc.min_row_capacity & -DRIFT_TABLE_MIN_ALIGNMENT));
+	table->_shrink_capacity = table->row_capacity;
 	
 	// Copy the name so static strings don't break hotloading.
 	DriftName* name_cursor = table->_names;
@@ -33,13 +44,26 @@ DriftTable* DriftTableInit(DriftTable* table, DriftTableDesc desc){
 		table->row_size += columns[i].size;
 	}
 	
-	table->buffer = DriftAlloc(table->desc.mem, TableSize(table));
+	bool reserved = desc.reserve_rows > 0;
+	if(reserved){
+		table->desc.reserve_rows = -(-desc.reserve_rows & -DRIFT_TABLE_MIN_ALIGNMENT);
+		DRIFT_ASSERT_HARD(table->row_capacity <= table->desc.reserve_rows, "DriftTable '%s' capacity exceeds it's reservation.", desc.name);
+		table->buffer = DriftVirtualReserve(ReservedTableSize(table));
+		DRIFT_ASSERT_HARD(table->buffer, "DriftTable '%s' failed to reserve memory.", desc.name);
+	} else {
+		table->buffer = DriftAlloc(table->desc.mem, TableSize(table));
+	}
 	
 	// Init column pointers.
 	void* cursor = table->buffer;
 	for(uint i = 0; i < DRIFT_TABLE_MAX_COLUMNS && columns[i].size; i++){
 		columns[i].ptr = *columns[i].user = cursor;
-		cursor += table->row_capacity*columns[i].size;
+		if(reserved){
+			DriftVirtualCommit(cursor, PageSize(table->row_capacity*columns[i].size));
+			cursor += ReservedColumnSize(table, columns + i);
+		} else {
+			cursor += table->row_capacity*columns[i].size;
+		}
 		
 		DriftNameCopy(name_cursor, columns[i].name);
 		columns[i].name = name_cursor->str;
@@ -50,7 +74,11 @@ DriftTable* DriftTableInit(DriftTable* table, DriftTableDesc desc){
 }
 
 void DriftTableDestroy(DriftTable* table){
-	DriftDealloc(table->desc.mem, table->buffer, TableSize(table));
+	if(table->desc.reserve_rows){
+		DriftVirtualRelease(table->buffer, ReservedTableSize(table));
+	} else {
+		DriftDealloc(table->desc.mem, table->buffer, TableSize(table));
+	}
 	table->buffer = NULL;
 	table->row_capacity = 0;
 }
@@ -61,7 +89,8 @@ void DriftTableIO(DriftTable* table, DriftIO* io){
 	// Handle the capacity.
 	size_t capacity = table->row_capacity;
 	DriftIOBlock(io, table->desc.name, &capacity, sizeof(capacity));
-	if(io->read) DriftTableEnsureCapacity(table, capacity);
+	// Reserved tables can't grow past their reservation, so only ask for what's needed.
+	if(io->read) DriftTableEnsureCapacity(table, table->desc.reserve_rows ? table->row_count : capacity);
 	
 	// Handle the columns.
 	DriftColumn* columns = table->desc.columns.arr;
@@ -71,20 +100,36 @@ void DriftTableIO(DriftTable* table, DriftIO* io){
 }
 
 void DriftTableResize(DriftTable* table, size_t row_capacity){
-	DRIFT_ASSERT(table->row_capacity <= row_capacity, "NYI Cannot shrink DriftTable.");
+	DRIFT_ASSERT(table->row_count <= row_capacity, "Cannot shrink DriftTable '%s' below its row count.", table->desc.name);
+	
+	if(table->desc.reserve_rows){
+		// Commit or decommit pages in place, nothing moves.
+		row_capacity = DRIFT_MIN(-(-row_capacity & -DRIFT_TABLE_MIN_ALIGNMENT), table->desc.reserve_rows);
+		DriftColumn* columns = table->desc.columns.arr;
+		for(uint i = 0; i < DRIFT_TABLE_MAX_COLUMNS && columns[i].size; i++){
+			size_t old_size = PageSize(table->row_capacity*columns[i].size), new_size = PageSize(row_capacity*columns[i].size);
+			if(new_size > old_size) DriftVirtualCommit(columns[i].ptr + old_size, new_size - old_size);
+			if(new_size < old_size) DriftVirtualDecommit(columns[i].ptr + new_size, old_size - new_size);
+		}
+		
+		table->row_capacity = row_capacity;
+		return;
+	}
 	
 	DriftTable copy = *table;
 	
 	// Re-init the table with the new minimum row count.
 	table->desc.min_row_capacity = row_capacity;
 	DriftTableInit(table, table->desc);
+	table->_shrink_capacity = copy._shrink_capacity;
 	
 	// Copy data to new table.
 	table->row_count = copy.row_count;
+	size_t copy_rows = DRIFT_MIN(copy.row_capacity, table->row_capacity);
 	DriftColumn* src = copy.desc.columns.arr;
 	DriftColumn* dst = table->desc.columns.arr;
 	for(uint i = 0; i < DRIFT_TABLE_MAX_COLUMNS && src[i].size; i++){
-		memcpy(dst[i].ptr, src[i].ptr, copy.row_capacity*src[i].size);
+		memcpy(dst[i].ptr, src[i].ptr, copy_rows*src[i].size);
 	}
 	
 	DRIFT_LOG("DriftTable '%s' resized from %d to %d", table->desc.name, copy.row_capacity, table->row_capacity);
@@ -93,6 +138,16 @@ void DriftTableResize(DriftTable* table, size_t row_capacity){
 	DriftTableDestroy(&copy);
 }
 
+bool DriftTableShrink(DriftTable* table){
+	// Wait until the table is mostly empty so a table hovering around a power of two doesn't thrash.
+	size_t threshold = table->row_capacity/DRIFT_TABLE_SHRINK_FACTOR;
+	if(table->row_capacity <= table->_shrink_capacity || table->row_count >= threshold) return false;
+	
+	// Leave the same headroom growing would have.
+	DriftTableResize(table, DRIFT_MAX(table->row_count*DRIFT_TABLE_GROWTH_FACTOR, table->_shrink_capacity));
+	return true;
+}
+
 void DriftTableClearRow(DriftTable* table, uint idx){
 	DriftTableCopyRow(table, idx, 0);
 	// DriftColumn *columns = table->desc.columns.arr;
@@ -110,4 +165,94 @@ void DriftTableCopyRow(DriftTable* table, uint dst_idx, uint src_idx){
 	}
 }
 
-// TODO Unit Tests
+#if DRIFT_DEBUG
+void unit_test_table(void){
+	u32* values;
+	DriftTable table;
+	DriftTableInit(&table, (DriftTableDesc){
+		.name = "@Table", .mem = DriftSystemMem, .min_row_capacity = 100,
+		.columns.arr = {DRIFT_DEFINE_COLUMN(values)},
+	});
+	size_t min_capacity = table.row_capacity;
+	
+	uint n = 10000;
+	for(uint i = 0; i < n; i++){
+		uint idx = DriftTablePushRow(&table);
+		values[idx] = i;
+	}
+	size_t peak_capacity = table.row_capacity;
+	
+	// Removing a few rows shouldn't shrink the table.
+	table.row_count = n/2;
+	DRIFT_ASSERT(!DriftTableShrink(&table), "Table shrank too early.");
+	
+	table.row_count = n/16;
+	DRIFT_ASSERT(DriftTableShrink(&table), "Table didn't shrink.");
+	DRIFT_ASSERT(table.row_capacity < peak_capacity && table.row_capacity >= table.row_count, "Invalid capacity after shrinking.");
+	for(uint i = 0; i < table.row_count; i++) DRIFT_ASSERT(values[i] == i, "Shrinking lost values.");
+	
+	// Shrinking again immediately should do nothing.
+	DRIFT_ASSERT(!DriftTableShrink(&table), "Table shrank without hysteresis.");
+	
+	// Never shrink below the initial capacity.
+	table.row_count = 0;
+	while(DriftTableShrink(&table));
+	DRIFT_ASSERT(table.row_capacity == min_capacity, "Table shrank below it's minimum capacity.");
+	
+	DriftTableDestroy(&table);
+	
+	// Reserved tables keep their column pointers when growing or shrinking.
+	DriftTableInit(&table, (DriftTableDesc){
+		.name = "@Reserved", .reserve_rows = n,
+		.columns.arr = {DRIFT_DEFINE_COLUMN(values)},
+	});
+	u32* values_ptr = values;
+	for(uint i = 0; i < n; i++){
+		uint idx = DriftTablePushRow(&table);
+		values[idx] = i;
+	}
+	DRIFT_ASSERT(values == values_ptr && table.row_capacity >= n, "Reserved table moved.");
+	
+	table.row_count = n/16;
+	DRIFT_ASSERT(DriftTableShrink(&table) && values == values_ptr, "Reserved table didn't shrink in place.");
+	for(uint i = 0; i < table.row_count; i++) DRIFT_ASSERT(values[i] == i, "Shrinking lost values.");
+	DriftTableDestroy(&table);
+	
+	DRIFT_LOG("Table tests passed.");
+}
+
+typedef struct {
+	DriftVec4 *a, *b, *c, *d, *e, *f, *g, *h;
+} HitchRow;
+
+// Compare the worst case time to push a row for heap and reserved tables.
+void unit_test_table_hitch(void){
+	uint n = 1 << 20;
+	for(uint reserved = 0; reserved < 2; reserved++){
+		HitchRow row;
+		DriftTable table;
+		DriftTableInit(&table, (DriftTableDesc){
+			.name = "@Hitch", .mem = DriftSystemMem, .reserve_rows = reserved ? n : 0,
+			.columns.arr = {
+				DRIFT_DEFINE_COLUMN(row.a), DRIFT_DEFINE_COLUMN(row.b), DRIFT_DEFINE_COLUMN(row.c), DRIFT_DEFINE_COLUMN(row.d),
+				DRIFT_DEFINE_COLUMN(row.e), DRIFT_DEFINE_COLUMN(row.f), DRIFT_DEFINE_COLUMN(row.g), DRIFT_DEFINE_COLUMN(row.h),
+			},
+		});
+		
+		u64 worst = 0, t0 = DriftTimeNanos();
+		for(uint i = 0; i < n; i++){
+			u64 start = DriftTimeNanos();
+			uint idx = DriftTablePushRow(&table);
+			// Touch the new row like a component add would.
+			DriftColumn* columns = table.desc.columns.arr;
+			for(uint j = 0; j < 8; j++) memset(columns[j].ptr + idx*sizeof(DriftVec4), 0, sizeof(DriftVec4));
+			worst = DRIFT_MAX(worst, DriftTimeNanos() - start);
+		}
+		
+		DRIFT_LOG("Table hitch (%s): %u rows in %.2f ms, worst push %.3f ms.",
+			reserved ? "reserved" : "heap", n, (DriftTimeNanos() - t0)/1e6, worst/1e6
+		);
+		DriftTableDestroy(&table);
+	}
+}
+#endif
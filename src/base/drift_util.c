@@ -24,8 +24,14 @@ static SDL_mutex* log_mtx;
 static FILE* log_out;
 static FILE* log_err;
 
+#if __unix__ || __APPLE__
+#include <sys/resource.h>
+#include <sys/mman.h>
+#endif
+
 #if __WIN64__
 #include <windows.h>
+#include <psapi.h>
 static LARGE_INTEGER queryPerfFreq;
 #endif
 
@@ -280,7 +286,8 @@ static void* io_body(tina* coro, void* value){
 size_t DriftIOSize(DriftIOFunc* io_func, void* user_ptr){
 	size_t size = 0;
 	
-	IO_FOREACH(io_func, user_ptr, true, data){
+	// Walk the blocks in write mode so the io_func doesn't try to fix up any state.
+	IO_FOREACH(io_func, user_ptr, false, data){
 		size += data->size;
 	}
 	
@@ -297,7 +304,7 @@ bool DriftIOFileRead(const char* filename, DriftIOFunc* io_func, void* user_ptr)
 	
 	// DRIFT_LOG("Read '%s'.", filename);
 	fclose(file);
-	return true;
+	return !_io_.abort;
 }
 
 void DriftIOFileWrite(const char* filename, DriftIOFunc* io_func, void* user_ptr){
@@ -312,6 +319,133 @@ void DriftIOFileWrite(const char* filename, DriftIOFunc* io_func, void* user_ptr
 	fclose(file);
 }
 
+DriftData DriftIOSnapshot(DriftMem* mem, DriftIOFunc* io_func, void* user_ptr){
+	size_t size = DriftIOSize(io_func, user_ptr);
+	u8* ptr = DriftAlloc(mem, size);
+	
+	size_t cursor = 0;
+	IO_FOREACH(io_func, user_ptr, false, data){
+		DRIFT_ASSERT_HARD(cursor + data->size <= size, "IO snapshot overflow.");
+		memcpy(ptr + cursor, data->ptr, data->size);
+		cursor += data->size;
+	}
+	
+	return (DriftData){.ptr = ptr, .size = cursor};
+}
+
+#define SNAPSHOT_MAGIC "DRIFTSNP"
+
+typedef struct {
+	char magic[8];
+	u64 size, compressed_size;
+} SnapshotHeader;
+
+static bool write_file_atomic(const char* filename, const SnapshotHeader* header, const void* ptr){
+	// Write to a temp file and rename it over the original so a crash can't leave a partial file.
+	char tmp_filename[256];
+	snprintf(tmp_filename, sizeof(tmp_filename), "%s.tmp", filename);
+	FILE* file = fopen(tmp_filename, "wb");
+	DRIFT_ASSERT_WARN(file, "Failed to open '%s' for writing.", tmp_filename);
+	if(file == NULL) return false;
+	
+	bool success = fwrite(header, sizeof(*header), 1, file) == 1 && fwrite(ptr, header->compressed_size, 1, file) == 1;
+	success &= fflush(file) == 0;
+	success &= fclose(file) == 0;
+	DRIFT_ASSERT_WARN(success, "Failed to write '%s'.", tmp_filename);
+	if(!success){
+		remove(tmp_filename);
+		return false;
+	}
+	
+#if __WIN64__
+	success = MoveFileExA(tmp_filename, filename, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+	success = rename(tmp_filename, filename) == 0;
+#endif
+	DRIFT_ASSERT_WARN(success, "Failed to replace '%s'.", filename);
+	return success;
+}
+
+bool DriftIOSnapshotWrite(const char* filename, DriftData snapshot){
+	mz_ulong capacity = mz_compressBound(snapshot.size), compressed_size = capacity;
+	void* compressed = DriftAlloc(DriftSystemMem, capacity);
+	int status = mz_compress2(compressed, &compressed_size, snapshot.ptr, snapshot.size, MZ_BEST_SPEED);
+	DRIFT_ASSERT_WARN(status == MZ_OK, "Failed to compress '%s' (%d).", filename, status);
+	
+	bool success = false;
+	if(status == MZ_OK){
+		SnapshotHeader header = {.magic = SNAPSHOT_MAGIC, .size = snapshot.size, .compressed_size = compressed_size};
+		success = write_file_atomic(filename, &header, compressed);
+		if(success) DRIFT_LOG("Wrote '%s' (%.1f MB -> %.1f MB).", filename, snapshot.size/1e6, compressed_size/1e6);
+	}
+	
+	DriftDealloc(DriftSystemMem, compressed, capacity);
+	return success;
+}
+
+// Deflate can't do better than ~1032:1, anything claiming more is corrupt.
+#define SNAPSHOT_MAX_RATIO 1032
+
+bool DriftIOSnapshotRead(const char* filename, DriftIOFunc* io_func, void* user_ptr){
+	FILE* file = fopen(filename, "rb");
+	if(file == NULL) return false;
+	
+	fseek(file, 0, SEEK_END);
+	long file_size = ftell(file);
+	rewind(file);
+	
+	SnapshotHeader header = {};
+	if(fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0){
+		DRIFT_LOG("'%s' is not a snapshot file.", filename);
+		fclose(file);
+		return false;
+	}
+	
+	bool valid = file_size >= 0 && header.compressed_size <= (u64)file_size - sizeof(header);
+	valid &= 0 < header.size && header.size <= header.compressed_size*SNAPSHOT_MAX_RATIO;
+	if(!valid){
+		DRIFT_LOG("Bad snapshot header in '%s'.", filename);
+		fclose(file);
+		return false;
+	}
+	
+	void* compressed = DriftAlloc(DriftSystemMem, header.compressed_size);
+	bool success = fread(compressed, header.compressed_size, 1, file) == 1;
+	fclose(file);
+	
+	u8* ptr = NULL;
+	mz_ulong size = header.size;
+	if(success){
+		ptr = DriftAlloc(DriftSystemMem, header.size);
+		int status = mz_uncompress(ptr, &size, compressed, header.compressed_size);
+		success = status == MZ_OK && size == header.size;
+		if(!success) DRIFT_LOG("Failed to decompress '%s' (%d).", filename, status);
+	} else {
+		DRIFT_LOG("Failed to read '%s'.", filename);
+	}
+	DriftDealloc(DriftSystemMem, compressed, header.compressed_size);
+	
+	if(success){
+		size_t cursor = 0;
+		IO_FOREACH(io_func, user_ptr, true, data){
+			if(cursor + data->size <= size){
+				memcpy(data->ptr, ptr + cursor, data->size);
+				cursor += data->size;
+			} else {
+				// Zero the rest so the io_func can finish with consistent state, but fail the read.
+				if(!_io_.abort) DRIFT_LOG("Unexpected end of '%s'.", filename);
+				memset(data->ptr, 0, data->size);
+				_io_.abort = true;
+			}
+		}
+		
+		success = !_io_.abort;
+	}
+	
+	if(ptr) DriftDealloc(DriftSystemMem, ptr, header.size);
+	return success;
+}
+
 static mz_zip_archive ZipHandles[DRIFT_APP_MAX_THREADS];
 static const char* ResourcesZipName = "resources.zip";
 
@@ -429,6 +563,63 @@ u64 DriftTimeNanos(void){
 #endif
 }
 
+void* DriftVirtualReserve(size_t size){
+#if __unix__ || __APPLE__
+	void* ptr = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return ptr == MAP_FAILED ? NULL : ptr;
+#elif __WIN64__
+	return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+	#error Unhandled platform
+#endif
+}
+
+void DriftVirtualRelease(void* ptr, size_t size){
+#if __unix__ || __APPLE__
+	munmap(ptr, size);
+#elif __WIN64__
+	VirtualFree(ptr, 0, MEM_RELEASE);
+#endif
+}
+
+void DriftVirtualCommit(void* ptr, size_t size){
+#if __unix__ || __APPLE__
+	int err = mprotect(ptr, size, PROT_READ | PROT_WRITE);
+#elif __WIN64__
+	int err = VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) == NULL;
+#endif
+	DRIFT_ASSERT_HARD(err == 0, "Failed to commit %zu bytes of virtual memory.", size);
+}
+
+void DriftVirtualDecommit(void* ptr, size_t size){
+#if __unix__ || __APPLE__
+	// Drop the pages first so the memory is returned immediately.
+	madvise(ptr, size, MADV_DONTNEED);
+	mprotect(ptr, size, PROT_NONE);
+#elif __WIN64__
+	VirtualFree(ptr, size, MEM_DECOMMIT);
+#endif
+}
+
+size_t DriftPeakMemoryBytes(void){
+#if __APPLE__
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (size_t)usage.ru_maxrss;
+#elif __unix__
+	// Linux reports in KiB.
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return 1024*(size_t)usage.ru_maxrss;
+#elif __WIN64__
+	PROCESS_MEMORY_COUNTERS counters;
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize;
+#else
+	return 0;
+#endif
+}
+
 #if DRIFT_DEBUG
 void unit_test_util(void){
 	DRIFT_ASSERT(DriftNextPOT(0) == 0, "Invalid result");
@@ -20,12 +20,29 @@ int main(int argc, const char* argv[argc+1]){
 	// unit_test_util();
 	// unit_test_math();
 	// unit_test_entity();
+	// unit_test_entity_destroy();
+	// unit_test_entity_stress();
 	// unit_test_map();
+	// unit_test_map_bench();
 	// unit_test_component();
+	// unit_test_component_waves();
+	// unit_test_join_bench();
+	// unit_test_component_find_bench();
+	// unit_test_component_gc_bench();
+	// unit_test_component_spatial_bench();
+	// unit_test_table();
+	// unit_test_table_hitch();
 	// unit_test_rtree();
+	// unit_test_profile();
+	// unit_test_zone_mem();
+	// unit_test_gfx_commands();
+	// unit_test_gfx_streams();
+	// unit_test_gfx_capture();
+	// unit_test_gfx_object_cache();
 #endif
 
 	extern tina_job_func DriftGameStart;
+	extern tina_job_func DriftGameHeadless;
 	DriftApp app = {
 #if DRIFT_MODULES
 		.module_libname = "libdrift-game",
@@ -44,6 +61,31 @@ int main(int argc, const char* argv[argc+1]){
 		if(strcmp(argv[i], "--gl") == 0) app.shell_func = DriftShellSDLGL;
 		if(strcmp(argv[i], "--fullscreen") == 0) app.fullscreen = true;
 		if(strcmp(argv[i], "--quickstart") == 0) app.no_splash = true;
+		if(strcmp(argv[i], "--unpacked-instances") == 0) app.unpacked_instances = true;
+		
+		if(strcmp(argv[i], "--record") == 0 && i + 1 < argc) app.record_filename = argv[++i];
+		if(strcmp(argv[i], "--replay") == 0 && i + 1 < argc) app.headless.replay_filename = argv[++i];
+		
+		if(strcmp(argv[i], "--headless") == 0 || app.headless.replay_filename){
+			app.shell_func = DriftShellConsole;
+#if DRIFT_MODULES
+			app.module_entrypoint = "DriftGameHeadless";
+#else
+			app.entry_func = DriftGameHeadless;
+#endif
+			if(app.headless.ticks == 0) app.headless.ticks = DRIFT_APP_DEFAULT_HEADLESS_TICKS;
+		}
+		if(strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) app.headless.ticks = (uint)strtoul(argv[++i], NULL, 0);
+		if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc) app.headless.seed = strtoull(argv[++i], NULL, 0);
+		if(strcmp(argv[i], "--draw") == 0) app.headless.draw = true;
+		if(strcmp(argv[i], "--draw-sprites") == 0 && i + 1 < argc) app.headless.draw_sprites = (uint)strtoul(argv[++i], NULL, 0);
+		if(strcmp(argv[i], "--serial-draw") == 0) app.headless.serial_draw = true;
+		if(strcmp(argv[i], "--gfx-capture") == 0 && i + 1 < argc) app.headless.gfx_capture = argv[++i];
+		if(strcmp(argv[i], "--camera-path") == 0) app.headless.draw = app.headless.camera_path = true;
+		if(strcmp(argv[i], "--craft-ui") == 0) app.headless.draw = app.headless.craft_ui = true;
+		
+		if(strcmp(argv[i], "--gfx-replay") == 0 && i + 1 < argc) app.gfx_replay.filename = argv[++i];
+		if(strcmp(argv[i], "--gfx-replay-count") == 0 && i + 1 < argc) app.gfx_replay.count = (uint)strtoul(argv[++i], NULL, 0);
 		
 #if DRIFT_VULKAN
 		if(strcmp(argv[i], "--vk") == 0) app.shell_func = DriftShellSDLVk;
@@ -54,5 +96,8 @@ int main(int argc, const char* argv[argc+1]){
 #endif
 	}
 	
+	// Runs on whichever driver was selected, including the headless one.
+	if(app.gfx_replay.filename) app.entry_func = DriftGfxReplayRun;
+	
 	return DriftMain(&app);
 }
@@ -299,6 +299,7 @@ void DriftDebugUI(DriftUpdate* _update, DriftDraw* _draw){
 				nk_checkbox_label(NK, "Boost Ambient", &CTX->debug.boost_ambient);
 				if(nk_menu_item_label(NK, "Full Visibility", NK_TEXT_LEFT)){
 					memset(STATE->terra->tilemap.visibility, 0xFF, sizeof(STATE->terra->tilemap.visibility));
+					DriftTerrainMarkUnsaved(STATE->terra);
 				}
 				
 				static const char* BIOME_NAMES[_DRIFT_BIOME_COUNT] = {
@@ -645,12 +646,35 @@ void DriftDebugUI(DriftUpdate* _update, DriftDraw* _draw){
 				nk_layout_row_dynamic(NK, UI_LINE_HEIGHT, 1);
 				
 				DriftZoneHeapInfo info = DriftZoneHeapGetInfo(APP->zone_heap);
-				nk_labelf(NK, NK_TEXT_LEFT, "Blocks: %d/%d", info.blocks_used, info.blocks_allocated);
-				nk_labelf(NK, NK_TEXT_LEFT, "Zones: %d/%d", info.zones_used, info.zones_allocated);
+				nk_labelf(NK, NK_TEXT_LEFT, "Blocks: %d/%d (peak %d)", info.blocks_used, info.blocks_allocated, info.blocks_peak);
+				nk_labelf(NK, NK_TEXT_LEFT, "Zones: %d/%d (peak %d)", info.zones_used, info.zones_allocated, info.zones_peak);
+				nk_labelf(NK, NK_TEXT_LEFT, "Released: %d", info.blocks_released);
+				if(nk_button_label(NK, "Trim")) DriftZoneMemHeapTrim(APP->zone_heap);
 				
 				for(uint i = 0; i < 16; i++){
 					const char* name = info.zone_names[i];
-					if(name) nk_labelf(NK, NK_TEXT_LEFT, "[%d]: %s", i, name);
+					if(name) nk_labelf(NK, NK_TEXT_LEFT, "[%d]: %s (%d blocks)", i, name, info.zone_blocks[i]);
+				}
+				
+				nk_tree_pop(NK);
+			}
+			
+			if(nk_tree_push(NK, NK_TREE_TAB, "Profiler", NK_MINIMIZED)){
+				nk_layout_row_dynamic(NK, UI_LINE_HEIGHT, 1);
+				nk_bool enabled = DRIFT_PROFILE_ENABLED;
+				if(nk_checkbox_label(NK, "Enabled", &enabled)) DriftProfileSetEnabled(enabled);
+				
+				nk_layout_row_dynamic(NK, 1.5f*UI_LINE_HEIGHT, 3);
+				if(nk_button_label(NK, "Export Trace")) DriftProfileWriteTrace("profile.json");
+				if(nk_button_label(NK, "Export CSV")) DriftProfileWriteCSV("profile.csv");
+				if(nk_button_label(NK, "Capture Frame")) DriftGfxRendererCapture(DRAW->renderer, "frame.gfxcap");
+				
+				nk_layout_row_dynamic(NK, UI_LINE_HEIGHT, 1);
+				nk_label(NK, "avg / p99 ms:", NK_TEXT_LEFT);
+				DriftProfileStat stats[32];
+				uint count = DriftProfileGetStats(stats, 32);
+				for(uint i = 0; i < count; i++){
+					nk_labelf(NK, NK_TEXT_LEFT, "%6.2f / %6.2f %s", stats[i].avg_ms, stats[i].p99_ms, stats[i].name);
 				}
 				
 				nk_tree_pop(NK);
@@ -691,6 +715,7 @@ void DriftDebugUI(DriftUpdate* _update, DriftDraw* _draw){
 						STATE->terra->tilemap.resources[i] = 3;
 						STATE->terra->tilemap.biomass[i] = 1;
 					}
+					DriftTerrainMarkUnsaved(STATE->terra);
 				}
 				
 				nk_tree_pop(NK);
@@ -776,7 +801,7 @@ void DriftDebugUI(DriftUpdate* _update, DriftDraw* _draw){
 					
 					DriftAffine m = {1, 0, 0, 1, p0.x + 10, p0.y};
 					DriftDrawTextF(DRAW, &STATE->debug.sprites, (DriftVec2){p0.x + 10, p0.y}, "%sidx:%d\n{#FFFFFFFF}%d:%.1f",
-						fmap->is_valid[idx] ? "{#00FF0000}" : "{#FF000000}", STATE->power_nodes.entity[idx].id,
+						fmap->is_valid[idx] ? "{#00FF0000}" : "{#FF000000}", DriftEntityIndex(STATE->power_nodes.entity[idx]),
 						fmap->stamp - fmap->flow[idx].stamp, fmap->flow[idx].dist
 					);
 					
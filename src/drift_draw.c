@@ -178,7 +178,9 @@ static DriftVec2 calculate_internal_extents(DriftVec2 virtual_extent, float ligh
 
 DriftDrawShared* DriftDrawSharedNew(tina_job* job, float lightfield_scale){
 	const DriftGfxDriver* driver = APP->gfx_driver;
-	DriftDrawShared* draw_shared = DRIFT_COPY(DriftSystemMem, ((DriftDrawShared){.driver = driver}));
+	DriftDrawShared* draw_shared = DRIFT_COPY(DriftSystemMem, ((DriftDrawShared){.driver = driver, .packed_instances = !APP->unpacked_instances}));
+	draw_shared->sprite_stride = draw_shared->packed_instances ? sizeof(DriftGPUSprite) : sizeof(DriftSprite);
+	draw_shared->light_stride = draw_shared->packed_instances ? sizeof(DriftGPULight) : sizeof(DriftLight);
 	
 	draw_shared->atlas_texture = driver->new_texture(driver, DRIFT_ATLAS_SIZE, DRIFT_ATLAS_SIZE, (DriftGfxTextureOptions){
 		.name = "atlas", .type = DRIFT_GFX_TEXTURE_2D_ARRAY, .format = DRIFT_GFX_TEXTURE_FORMAT_RGBA8, .layers = _DRIFT_ATLAS_COUNT,
@@ -219,8 +221,24 @@ DriftDrawShared* DriftDrawSharedNew(tina_job* job, float lightfield_scale){
 		.instance_stride = sizeof(DriftLight),
 		DRIFT_GLOBAL_BINDINGS,
 	};
-	draw_shared->light_pipeline[0] = MakePipeline(driver, "light0", &light_desc, &DriftGfxBlendModeAdd, draw_shared->lightfield_target[0], DRIFT_GFX_CULL_MODE_NONE);
-	draw_shared->light_pipeline[1] = MakePipeline(driver, "light1", &light_desc, &DriftGfxBlendModeAdd, draw_shared->lightfield_target[1], DRIFT_GFX_CULL_MODE_NONE);
+	
+	// Same attributes, the half floats are widened by the vertex fetch so the shaders don't change.
+	static const DriftGfxShaderDesc packed_light_desc = {
+		.vertex[0] = {.type = DRIFT_GFX_TYPE_FLOAT32_2},
+		.vertex_stride = sizeof(DriftVec2),
+		.vertex[1] = {.type = DRIFT_GFX_TYPE_FLOAT16_4, .offset = offsetof(DriftGPULight, matrix), .instanced = true},
+		.vertex[2] = {.type = DRIFT_GFX_TYPE_FLOAT32_2, .offset = offsetof(DriftGPULight, x), .instanced = true},
+		.vertex[3] = {.type = DRIFT_GFX_TYPE_FLOAT16_4, .offset = offsetof(DriftGPULight, color), .instanced = true},
+		.vertex[4] = {.type = DRIFT_GFX_TYPE_U8_4, .offset = offsetof(DriftGPULight, frame.bounds), .instanced = true},
+		.vertex[5] = {.type = DRIFT_GFX_TYPE_U8_2, .offset = offsetof(DriftGPULight, frame.anchor), .instanced = true},
+		.vertex[6] = {.type = DRIFT_GFX_TYPE_U16, .offset = offsetof(DriftGPULight, frame.layer), .instanced = true},
+		.instance_stride = sizeof(DriftGPULight),
+		DRIFT_GLOBAL_BINDINGS,
+	};
+	const DriftGfxShaderDesc* light_instance_desc = draw_shared->packed_instances ? &packed_light_desc : &light_desc;
+	
+	draw_shared->light_pipeline[0] = MakePipeline(driver, "light0", light_instance_desc, &DriftGfxBlendModeAdd, draw_shared->lightfield_target[0], DRIFT_GFX_CULL_MODE_NONE);
+	draw_shared->light_pipeline[1] = MakePipeline(driver, "light1", light_instance_desc, &DriftGfxBlendModeAdd, draw_shared->lightfield_target[1], DRIFT_GFX_CULL_MODE_NONE);
 	
 	draw_shared->light_blit_pipeline[0] = MakePipeline(driver, "light_blit0", &basic_quad_desc, NULL, draw_shared->shadowfield_target[0], DRIFT_GFX_CULL_MODE_NONE);
 	draw_shared->light_blit_pipeline[1] = MakePipeline(driver, "light_blit1", &basic_quad_desc, NULL, draw_shared->shadowfield_target[1], DRIFT_GFX_CULL_MODE_NONE);
@@ -277,8 +295,8 @@ DriftDrawShared* DriftDrawSharedNew(tina_job* job, float lightfield_scale){
 		.alpha_src_factor = DRIFT_GFX_BLEND_FACTOR_ONE, .alpha_dst_factor = DRIFT_GFX_BLEND_FACTOR_ZERO,
 	};
 	
-	draw_shared->shadow_pipeline[0] = MakePipeline(driver, "shadow0", &light_desc, &shadow_blend, draw_shared->shadowfield_target[0], DRIFT_GFX_CULL_MODE_NONE);
-	draw_shared->shadow_pipeline[1] = MakePipeline(driver, "shadow1", &light_desc, &shadow_blend, draw_shared->shadowfield_target[1], DRIFT_GFX_CULL_MODE_NONE);
+	draw_shared->shadow_pipeline[0] = MakePipeline(driver, "shadow0", light_instance_desc, &shadow_blend, draw_shared->shadowfield_target[0], DRIFT_GFX_CULL_MODE_NONE);
+	draw_shared->shadow_pipeline[1] = MakePipeline(driver, "shadow1", light_instance_desc, &shadow_blend, draw_shared->shadowfield_target[1], DRIFT_GFX_CULL_MODE_NONE);
 	
 	static const DriftGfxShaderDesc terrain_desc = {
 		.vertex[0] = {.type = DRIFT_GFX_TYPE_FLOAT32_2},
@@ -306,14 +324,28 @@ DriftDrawShared* DriftDrawSharedNew(tina_job* job, float lightfield_scale){
 		DRIFT_GLOBAL_BINDINGS,
 	};
 	
+	static const DriftGfxShaderDesc packed_sprite_desc = {
+		.vertex[0] = {.type = DRIFT_GFX_TYPE_FLOAT32_2,},
+		.vertex_stride = sizeof(DriftVec2),
+		.vertex[1] = {.type = DRIFT_GFX_TYPE_FLOAT16_4, .offset = offsetof(DriftGPUSprite, matrix), .instanced = true},
+		.vertex[2] = {.type = DRIFT_GFX_TYPE_FLOAT32_2, .offset = offsetof(DriftGPUSprite, x), .instanced = true},
+		.vertex[3] = {.type = DRIFT_GFX_TYPE_UNORM8_4, .offset = offsetof(DriftGPUSprite, color), .instanced = true},
+		.vertex[4] = {.type = DRIFT_GFX_TYPE_U8_4, .offset = offsetof(DriftGPUSprite, frame.bounds), .instanced = true},
+		.vertex[5] = {.type = DRIFT_GFX_TYPE_U8_2, .offset = offsetof(DriftGPUSprite, frame.anchor), .instanced = true},
+		.vertex[6] = {.type = DRIFT_GFX_TYPE_U8_4, .offset = offsetof(DriftGPUSprite, frame.layer), .instanced = true},
+		.instance_stride = sizeof(DriftGPUSprite),
+		DRIFT_GLOBAL_BINDINGS,
+	};
+	const DriftGfxShaderDesc* sprite_instance_desc = draw_shared->packed_instances ? &packed_sprite_desc : &sprite_desc;
+	
 	static const DriftGfxBlendMode premultiplied = {
 		.color_src_factor = DRIFT_GFX_BLEND_FACTOR_ONE, .color_dst_factor = DRIFT_GFX_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
 		.alpha_src_factor = DRIFT_GFX_BLEND_FACTOR_ZERO, .alpha_dst_factor = DRIFT_GFX_BLEND_FACTOR_ONE,
 	};
 	
-	draw_shared->sprite_pipeline = MakePipeline(driver, "sprite", &sprite_desc, &premultiplied, color_target, DRIFT_GFX_CULL_MODE_NONE);
-	draw_shared->flash_sprite_pipeline = MakePipeline(driver, "sprite_flash", &sprite_desc, &premultiplied, color_target, DRIFT_GFX_CULL_MODE_NONE);
-	draw_shared->overlay_sprite_pipeline = MakePipeline(driver, "sprite_overlay", &sprite_desc, &premultiplied, draw_shared->resolve_target, DRIFT_GFX_CULL_MODE_NONE);
+	draw_shared->sprite_pipeline = MakePipeline(driver, "sprite", sprite_instance_desc, &premultiplied, color_target, DRIFT_GFX_CULL_MODE_NONE);
+	draw_shared->flash_sprite_pipeline = MakePipeline(driver, "sprite_flash", sprite_instance_desc, &premultiplied, color_target, DRIFT_GFX_CULL_MODE_NONE);
+	draw_shared->overlay_sprite_pipeline = MakePipeline(driver, "sprite_overlay", sprite_instance_desc, &premultiplied, draw_shared->resolve_target, DRIFT_GFX_CULL_MODE_NONE);
 	
 	draw_shared->debug_lightfield_pipeline = MakePipeline(driver, "debug_lightfield", &basic_quad_desc, &DriftGfxBlendModePremultipliedAlpha, color_target, DRIFT_GFX_CULL_MODE_NONE);
 	
@@ -415,7 +447,7 @@ DriftDraw* DriftDrawBeginBase(tina_job* job, DriftGameContext* ctx, DriftAffine
 	uint prev_buffer_idx = (ctx->current_frame + 1) % 2;
 	
 	return DRIFT_COPY(mem, ((DriftDraw){
-		.job = job, .mem = mem, .renderer = renderer,
+		.job = job, .mem = mem, .renderer = renderer, .parts = 1,
 		.ctx = ctx, .state = ctx->state, .shared = ctx->draw_shared,
 		.frame = ctx->current_frame, .tick = ctx->current_tick,
 		.clock_nanos = ctx->clock_nanos, .update_nanos = ctx->update_nanos,
@@ -455,6 +487,48 @@ DriftDraw* DriftDrawBegin(DriftUpdate* update, float dt_before_tick, DriftAffine
 	return draw;
 }
 
+void DriftDrawLocalBegin(DriftDraw* local, const DriftDraw* draw, uint part, uint parts){
+	DRIFT_ASSERT(part < parts, "Invalid draw part.");
+	DriftMem* mem = draw->mem;
+	
+	*local = *draw;
+	local->part = part, local->parts = parts;
+	local->terrain_chunks = DRIFT_ARRAY_NEW(mem, 16, DriftTerrainChunk);
+	local->lights = DRIFT_ARRAY_NEW(mem, 64, DriftLight);
+	local->shadow_masks = DRIFT_ARRAY_NEW(mem, 64, DriftSegment);
+	local->bg_sprites = DRIFT_ARRAY_NEW(mem, 64, DriftSprite);
+	local->bg_prims = DRIFT_ARRAY_NEW(mem, 64, DriftPrimitive);
+	local->plasma_strands = DRIFT_ARRAY_NEW(mem, 64, DriftSegment);
+	local->fg_sprites = DRIFT_ARRAY_NEW(mem, 256, DriftSprite);
+	local->flash_sprites = DRIFT_ARRAY_NEW(mem, 64, DriftSprite);
+	local->bullet_sprites = DRIFT_ARRAY_NEW(mem, 64, DriftSprite);
+	local->overlay_sprites = DRIFT_ARRAY_NEW(mem, 64, DriftSprite);
+	local->overlay_prims = DRIFT_ARRAY_NEW(mem, 64, DriftPrimitive);
+	local->hud_sprites = DRIFT_ARRAY_NEW(mem, 64, DriftSprite);
+}
+
+#define MERGE_ARRAY(_dst_, _src_) { \
+	size_t _count_ = DriftArrayLength(_src_); \
+	typeof(_dst_) _cursor_ = DRIFT_ARRAY_RANGE(_dst_, _count_); \
+	memcpy(_cursor_, _src_, _count_*sizeof(*_cursor_)); \
+	DriftArrayRangeCommit(_dst_, _cursor_ + _count_); \
+}
+
+void DriftDrawLocalMerge(DriftDraw* draw, const DriftDraw* local){
+	MERGE_ARRAY(draw->terrain_chunks, local->terrain_chunks);
+	MERGE_ARRAY(draw->lights, local->lights);
+	MERGE_ARRAY(draw->shadow_masks, local->shadow_masks);
+	MERGE_ARRAY(draw->bg_sprites, local->bg_sprites);
+	MERGE_ARRAY(draw->bg_prims, local->bg_prims);
+	MERGE_ARRAY(draw->plasma_strands, local->plasma_strands);
+	MERGE_ARRAY(draw->fg_sprites, local->fg_sprites);
+	MERGE_ARRAY(draw->flash_sprites, local->flash_sprites);
+	MERGE_ARRAY(draw->bullet_sprites, local->bullet_sprites);
+	MERGE_ARRAY(draw->overlay_sprites, local->overlay_sprites);
+	MERGE_ARRAY(draw->overlay_prims, local->overlay_prims);
+	MERGE_ARRAY(draw->hud_sprites, local->hud_sprites);
+}
+
 void DriftDrawBindGlobals(DriftDraw* draw){
 	DriftAffine terrain_matrix = draw->state ? draw->state->terra->map_to_world : DRIFT_AFFINE_IDENTITY;
 	
@@ -761,6 +835,33 @@ DriftVec2 DriftDrawTextF(DriftDraw* draw, DRIFT_ARRAY(DriftSprite)* array, Drift
 	return DriftAffineOrigin(t);
 }
 
+DriftGfxBufferBinding DriftDrawPushSprites(DriftDraw* draw, const DriftSprite* sprites, uint count){
+	size_t size = count*draw->shared->sprite_stride;
+	draw->instance_bytes += size;
+	if(!draw->shared->packed_instances) return DriftGfxRendererPushGeometry(draw->renderer, sprites, size).binding;
+	
+	// Pack straight into the mapped buffer.
+	DriftGfxBufferSlice slice = DriftGfxRendererPushGeometry(draw->renderer, NULL, size);
+	DriftGPUSprite* dst = slice.ptr;
+	for(uint i = 0; i < count; i++) dst[i] = DriftSpritePack(sprites + i);
+	return slice.binding;
+}
+
+DriftGfxBufferBinding DriftDrawPushLights(DriftDraw* draw, const DriftLight* lights, uint count){
+	size_t size = count*draw->shared->light_stride;
+	draw->instance_bytes += size;
+	if(!draw->shared->packed_instances) return DriftGfxRendererPushGeometry(draw->renderer, lights, size).binding;
+	
+	DriftGfxBufferSlice slice = DriftGfxRendererPushGeometry(draw->renderer, NULL, size);
+	DriftGPULight* dst = slice.ptr;
+	for(uint i = 0; i < count; i++) dst[i] = DriftLightPack(lights + i);
+	return slice.binding;
+}
+
+static bool is_sprite_pipeline(DriftDrawShared* shared, DriftGfxPipeline* pipeline){
+	return pipeline == shared->sprite_pipeline || pipeline == shared->flash_sprite_pipeline || pipeline == shared->overlay_sprite_pipeline;
+}
+
 void DriftDrawBatches(DriftDraw* draw, DriftDrawBatch batches[]){
 	for(uint i = 0; batches[i].arr; i++){
 		DriftDrawBatch* batch = batches + i;
@@ -768,7 +869,259 @@ void DriftDrawBatches(DriftDraw* draw, DriftDrawBatch batches[]){
 		
 		DriftGfxPipelineBindings* bindings = DriftGfxRendererPushBindPipelineCommand(draw->renderer, batch->pipeline);
 		*bindings = *batch->bindings;
-		bindings->instance = DriftGfxRendererPushGeometry(draw->renderer, batch->arr, header->count*header->elt_size).binding;
+		if(is_sprite_pipeline(draw->shared, batch->pipeline)){
+			bindings->instance = DriftDrawPushSprites(draw, batch->arr, header->count);
+		} else {
+			bindings->instance = DriftGfxRendererPushGeometry(draw->renderer, batch->arr, header->count*header->elt_size).binding;
+		}
 		DriftGfxRendererPushDrawIndexedCommand(draw->renderer, draw->quad_index_binding, 6, header->count);
 	}
 }
+
+bool DriftSpriteCacheBegin(DriftSpriteCache* cache, u64 hash, DRIFT_ARRAY(DriftSprite)* arr){
+	if(cache->sprites && cache->hash == hash){
+		uint count = DriftArrayLength(cache->sprites);
+		DriftSprite* cursor = DRIFT_ARRAY_RANGE(*arr, count);
+		memcpy(cursor, cache->sprites, count*sizeof(DriftSprite));
+		DriftArrayRangeCommit(*arr, cursor + count);
+		return true;
+	} else {
+		cache->hash = hash;
+		cache->start = DriftArrayLength(*arr);
+		return false;
+	}
+}
+
+void DriftSpriteCacheEnd(DriftSpriteCache* cache, DRIFT_ARRAY(DriftSprite) arr){
+	uint count = DriftArrayLength(arr) - cache->start;
+	if(cache->sprites == NULL) cache->sprites = DRIFT_ARRAY_NEW(DriftSystemMem, count, DriftSprite);
+	DriftArrayHeader(cache->sprites)->count = 0;
+	
+	DriftSprite* cursor = DRIFT_ARRAY_RANGE(cache->sprites, count);
+	memcpy(cursor, arr + cache->start, count*sizeof(DriftSprite));
+	DriftArrayRangeCommit(cache->sprites, cursor + count);
+}
+
+void DriftSpriteCacheFree(DriftSpriteCache* cache){
+	DriftArrayFree(cache->sprites);
+	*cache = (DriftSpriteCache){};
+}
+
+#define SHADOW_BIN_GRID 16u
+
+typedef struct {
+	u8 x0, y0, x1, y1;
+} CellRange;
+
+static u8 cell_coord(float x){return (u8)(x < 0 ? 0 : (x < SHADOW_BIN_GRID - 1 ? x : SHADOW_BIN_GRID - 1));}
+
+static bool cell_range(DriftAABB2 bounds, DriftAABB2 bb, DriftVec2 scale, CellRange* range){
+	if(!DriftAABB2Overlap(bounds, bb)) return false;
+	
+	range->x0 = cell_coord((bb.l - bounds.l)*scale.x);
+	range->y0 = cell_coord((bb.b - bounds.b)*scale.y);
+	range->x1 = cell_coord((bb.r - bounds.l)*scale.x);
+	range->y1 = cell_coord((bb.t - bounds.b)*scale.y);
+	return true;
+}
+
+static DriftAABB2 segment_bounds(DriftSegment seg){
+	DriftAABB2 bb = {seg.a.x, seg.a.y, seg.b.x, seg.b.y};
+	if(bb.l > bb.r) bb.l = seg.b.x, bb.r = seg.a.x;
+	if(bb.b > bb.t) bb.b = seg.b.y, bb.t = seg.a.y;
+	return bb;
+}
+
+typedef struct {
+	DriftAABB2 bb;
+	CellRange range;
+	uint idx;
+} CellEntry;
+
+DRIFT_ARRAY(DriftSegment) DriftDrawBinShadowMasks(DriftMem* mem, DRIFT_ARRAY(DriftSegment) segments, DriftAABB2 bounds, const DriftAABB2 light_bounds[], uint light_count, uint light_offsets[]){
+	DRIFT_PROFILE_SCOPE("Bin Shadow Masks");
+	uint segment_count = DriftArrayLength(segments);
+	DRIFT_ARRAY(DriftSegment) binned = DRIFT_ARRAY_NEW(mem, DRIFT_MAX(segment_count, 64u), DriftSegment);
+	if(segment_count == 0 || light_count == 0){
+		memset(light_offsets, 0, (light_count + 1)*sizeof(*light_offsets));
+		return binned;
+	}
+	
+	// Each segment is stored once for every cell it overlaps, bucketed with a counting sort.
+	const uint cell_count = SHADOW_BIN_GRID*SHADOW_BIN_GRID;
+	uint* cell_starts = DriftAlloc(mem, (cell_count + 1)*sizeof(*cell_starts));
+	memset(cell_starts, 0, (cell_count + 1)*sizeof(*cell_starts));
+	CellEntry* entries = DriftAlloc(mem, segment_count*sizeof(*entries));
+	DriftVec2 scale = {SHADOW_BIN_GRID/fmaxf(bounds.r - bounds.l, 1), SHADOW_BIN_GRID/fmaxf(bounds.t - bounds.b, 1)};
+	
+	uint entry_count = 0;
+	for(uint i = 0; i < segment_count; i++){
+		CellEntry* entry = entries + entry_count;
+		entry->bb = segment_bounds(segments[i]), entry->idx = i;
+		if(!cell_range(bounds, entry->bb, scale, &entry->range)) continue;
+		
+		CellRange r = entry->range;
+		for(uint y = r.y0; y <= r.y1; y++){
+			for(uint x = r.x0; x <= r.x1; x++) cell_starts[y*SHADOW_BIN_GRID + x + 1]++;
+		}
+		entry_count++;
+	}
+	
+	for(uint i = 0; i < cell_count; i++) cell_starts[i + 1] += cell_starts[i];
+	CellEntry* cells = DriftAlloc(mem, cell_starts[cell_count]*sizeof(*cells));
+	uint* cell_cursors = DriftAlloc(mem, cell_count*sizeof(*cell_cursors));
+	memcpy(cell_cursors, cell_starts, cell_count*sizeof(*cell_cursors));
+	
+	for(uint i = 0; i < entry_count; i++){
+		CellRange r = entries[i].range;
+		for(uint y = r.y0; y <= r.y1; y++){
+			for(uint x = r.x0; x <= r.x1; x++) cells[cell_cursors[y*SHADOW_BIN_GRID + x]++] = entries[i];
+		}
+	}
+	
+	light_offsets[0] = 0;
+	for(uint light = 0; light < light_count; light++){
+		DriftAABB2 light_bb = light_bounds[light];
+		CellRange r;
+		if(cell_range(bounds, light_bb, scale, &r)){
+			uint max_count = 0;
+			for(uint y = r.y0; y <= r.y1; y++){
+				uint row = y*SHADOW_BIN_GRID;
+				max_count += cell_starts[row + r.x1 + 1] - cell_starts[row + r.x0];
+			}
+			
+			// Most tests fail unpredictably, so write every candidate and only advance the cursor for the ones that pass.
+			DriftSegment* cursor = DRIFT_ARRAY_RANGE(binned, max_count + 1);
+			for(uint y = r.y0; y <= r.y1; y++){
+				for(uint x = r.x0; x <= r.x1; x++){
+					uint cell = y*SHADOW_BIN_GRID + x;
+					for(uint j = cell_starts[cell]; j < cell_starts[cell + 1]; j++){
+						const CellEntry* entry = cells + j;
+						// Segments in several cells are only gathered from the first one the light overlaps.
+						bool first = x == DRIFT_MAX(r.x0, entry->range.x0) && y == DRIFT_MAX(r.y0, entry->range.y0);
+						*cursor = segments[entry->idx];
+						cursor += first & DriftAABB2Overlap(light_bb, entry->bb);
+					}
+				}
+			}
+			DriftArrayRangeCommit(binned, cursor);
+		}
+		
+		light_offsets[light + 1] = DriftArrayLength(binned);
+	}
+	
+	DriftDealloc(mem, cell_cursors, cell_count*sizeof(*cell_cursors));
+	DriftDealloc(mem, cells, cell_starts[cell_count]*sizeof(*cells));
+	DriftDealloc(mem, entries, segment_count*sizeof(*entries));
+	DriftDealloc(mem, cell_starts, (cell_count + 1)*sizeof(*cell_starts));
+	return binned;
+}
+
+#if DRIFT_DEBUG
+void unit_test_shadow_bins(void){
+	DriftRandom rand[1] = {{12345}};
+	DriftAABB2 bounds = {-640, -360, 640, 360};
+	
+	// Short terrain-like segments scattered over a screen sized area, and some that poke outside of it.
+	uint segment_count = 20000;
+	DRIFT_ARRAY(DriftSegment) segments = DRIFT_ARRAY_NEW(DriftSystemMem, segment_count, DriftSegment);
+	for(uint i = 0; i < segment_count; i++){
+		DriftVec2 a = {700*DriftRandomSNorm(rand), 400*DriftRandomSNorm(rand)};
+		DriftVec2 b = DriftVec2FMA(a, DriftRandomInUnitCircle(rand), 8);
+		DRIFT_ARRAY_PUSH(segments, ((DriftSegment){a, b}));
+	}
+	
+	uint light_count = 500;
+	DriftAABB2 light_bounds[light_count];
+	for(uint i = 0; i < light_count; i++){
+		DriftVec2 p = {640*DriftRandomSNorm(rand), 360*DriftRandomSNorm(rand)};
+		// Mostly small lights, with a few big ones.
+		float r = i % 50 == 0 ? 400 : 20 + 60*DriftRandomUNorm(rand);
+		light_bounds[i] = (DriftAABB2){p.x - r, p.y - r, p.x + r, p.y + r};
+	}
+	
+	uint light_offsets[light_count + 1];
+	DRIFT_ARRAY(DriftSegment) binned = DriftDrawBinShadowMasks(DriftSystemMem, segments, bounds, light_bounds, light_count, light_offsets);
+	
+	// Compare against brute force.
+	for(uint i = 0; i < light_count; i++){
+		uint count = 0;
+		double sum = 0;
+		for(uint j = 0; j < segment_count; j++){
+			DriftAABB2 bb = segment_bounds(segments[j]);
+			if(DriftAABB2Overlap(bounds, bb) && DriftAABB2Overlap(light_bounds[i], bb)){
+				count++;
+				sum += segments[j].a.x + segments[j].b.y;
+			}
+		}
+		
+		double binned_sum = 0;
+		for(uint j = light_offsets[i]; j < light_offsets[i + 1]; j++) binned_sum += binned[j].a.x + binned[j].b.y;
+		DRIFT_ASSERT(light_offsets[i + 1] - light_offsets[i] == count, "Light %d binned %d segments, expected %d.", i, light_offsets[i + 1] - light_offsets[i], count);
+		DRIFT_ASSERT(fabs(sum - binned_sum) < 1e-3*(1 + fabs(sum)), "Light %d binned the wrong segments.", i);
+	}
+	
+	uint reps = 20;
+	u64 t0 = DriftTimeNanos();
+	for(uint i = 0; i < reps; i++){
+		DriftArrayFree(binned);
+		binned = DriftDrawBinShadowMasks(DriftSystemMem, segments, bounds, light_bounds, light_count, light_offsets);
+	}
+	double bin_ms = (DriftTimeNanos() - t0)/1e6/reps;
+	
+	DRIFT_LOG("Shadow bins: %d lights x %d segments, %d instances instead of %d (%.1f%%), binning takes %.3f ms.",
+		light_count, segment_count, light_offsets[light_count], light_count*segment_count,
+		100.0*light_offsets[light_count]/(light_count*segment_count), bin_ms
+	);
+	
+	DriftArrayFree(binned);
+	DriftArrayFree(segments);
+}
+
+static bool half_close(DriftHalf h, float f){
+	// Halves have 11 significant bits, denormals flush to zero.
+	return fabsf(DriftHalfToFloat(h) - f) <= fabsf(f)/2048 + 6.2e-5f;
+}
+
+void unit_test_sprite_packing(void){
+	DriftRandom rand[1] = {{54321}};
+	
+	DRIFT_ASSERT(DriftHalfToFloat(DriftHalfFromFloat(1)) == 1, "1.0 doesn't round trip.");
+	DRIFT_ASSERT(DriftHalfToFloat(DriftHalfFromFloat(-0.5f)) == -0.5f, "-0.5 doesn't round trip.");
+	DRIFT_ASSERT(DriftHalfToFloat(DriftHalfFromFloat(1e6f)) == 65504, "Large values should clamp.");
+	DRIFT_ASSERT(DriftHalfToFloat(DriftHalfFromFloat(1e-6f)) == 0, "Tiny values should flush to zero.");
+	
+	for(uint i = 0; i < 100000; i++){
+		DriftAffine m = DriftAffineTRS(
+			(DriftVec2){4096*DriftRandomSNorm(rand), 4096*DriftRandomSNorm(rand)},
+			(float)(2*M_PI)*DriftRandomUNorm(rand), DriftVec2Mul(DRIFT_VEC2_ONE, 0.1f + 8*DriftRandomUNorm(rand))
+		);
+		
+		DriftSprite sprite = {
+			.matrix = m, .color = {(u8)i, (u8)(i >> 8), (u8)(i >> 16), 255}, .z = (u8)(i*7),
+			.frame = DRIFT_FRAMES[i % _DRIFT_SPRITE_COUNT],
+		};
+		DriftGPUSprite gpu_sprite = DriftSpritePack(&sprite);
+		DRIFT_ASSERT(half_close(gpu_sprite.matrix[0], m.a) && half_close(gpu_sprite.matrix[1], m.b), "Sprite matrix out of tolerance.");
+		DRIFT_ASSERT(half_close(gpu_sprite.matrix[2], m.c) && half_close(gpu_sprite.matrix[3], m.d), "Sprite matrix out of tolerance.");
+		DRIFT_ASSERT(gpu_sprite.x == m.x && gpu_sprite.y == m.y, "Sprite position must be exact.");
+		DRIFT_ASSERT(memcmp(&gpu_sprite.frame, &sprite.frame, sizeof(sprite.frame)) == 0, "Sprite frame mismatch.");
+		DRIFT_ASSERT(memcmp(&gpu_sprite.color, &sprite.color, sizeof(sprite.color)) == 0 && gpu_sprite.z == sprite.z, "Sprite color mismatch.");
+		
+		DriftLight light = {
+			.matrix = m, .frame = sprite.frame,
+			.color = {{4*DriftRandomUNorm(rand), 4*DriftRandomUNorm(rand), 4*DriftRandomUNorm(rand), DriftRandomUNorm(rand)}},
+		};
+		DriftGPULight gpu_light = DriftLightPack(&light);
+		DRIFT_ASSERT(half_close(gpu_light.matrix[0], m.a) && half_close(gpu_light.matrix[3], m.d), "Light matrix out of tolerance.");
+		DRIFT_ASSERT(gpu_light.x == m.x && gpu_light.y == m.y, "Light position must be exact.");
+		const float* color = &light.color.r;
+		for(uint j = 0; j < 4; j++) DRIFT_ASSERT(half_close(gpu_light.color[j], color[j]), "Light color out of tolerance.");
+		DRIFT_ASSERT(memcmp(&gpu_light.frame, &light.frame, sizeof(light.frame)) == 0, "Light frame mismatch.");
+	}
+	
+	DRIFT_LOG("Sprite packing: sprites %d -> %d bytes, lights %d -> %d bytes.",
+		(int)sizeof(DriftSprite), (int)sizeof(DriftGPUSprite), (int)sizeof(DriftLight), (int)sizeof(DriftGPULight)
+	);
+}
+#endif
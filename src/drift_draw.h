@@ -56,6 +56,11 @@ typedef struct {
 	
 	DriftGfxTexture* atlas_texture;
 	DriftGfxTexture* terrain_tiles;
+	
+	// Upload sprites and lights as DriftGPUSprite/DriftGPULight instead of their full float layouts.
+	bool packed_instances;
+	// Instance strides matching the sprite and light pipelines.
+	size_t sprite_stride, light_stride;
 } DriftDrawShared;
 
 DriftDrawShared* DriftDrawSharedNew(tina_job* job, float lightfield_scale);
@@ -99,6 +104,8 @@ struct DriftDraw {
 	tina_job* job;
 	tina_group jobs;
 	DriftMem* mem;
+	// Slice of the entities to draw when a draw system is split across jobs, see DriftJoinSplit().
+	uint part, parts;
 	
 	DriftDrawShared* shared;
 	DriftGameContext* ctx;
@@ -133,6 +140,8 @@ struct DriftDraw {
 	DRIFT_ARRAY(DriftSprite) hud_sprites;
 	
 	DriftGfxRenderer* renderer;
+	// Sprite and light instance bytes uploaded this frame.
+	size_t instance_bytes;
 	DriftGlobalUniforms global_uniforms;
 	DriftGfxBufferBinding globals_binding;
 	DriftGfxBufferBinding ui_binding;
@@ -150,7 +159,15 @@ DriftDraw* DriftDrawBeginBase(tina_job* job, DriftGameContext* ctx, DriftAffine
 DriftDraw* DriftDrawBegin(DriftUpdate* update, float dt_before_tick, DriftAffine v_matrix, DriftAffine prev_vp_matrix);
 void DriftDrawBindGlobals(DriftDraw* draw);
 
+// Copy 'draw' into 'local' with its own empty draw lists so it can be filled from another job.
+void DriftDrawLocalBegin(DriftDraw* local, const DriftDraw* draw, uint part, uint parts);
+// Append the draw lists from 'local' onto 'draw'.
+void DriftDrawLocalMerge(DriftDraw* draw, const DriftDraw* local);
+
 DriftGfxPipelineBindings* DriftDrawQuads(DriftDraw* draw, DriftGfxPipeline* pipeline, u32 count);
+// Upload instances in the layout the sprite and light pipelines expect.
+DriftGfxBufferBinding DriftDrawPushSprites(DriftDraw* draw, const DriftSprite* sprites, uint count);
+DriftGfxBufferBinding DriftDrawPushLights(DriftDraw* draw, const DriftLight* lights, uint count);
 
 #define DRIFT_TEXT_BLACK  "{#00000000}"
 #define DRIFT_TEXT_GRAY   "{#80808080}"
@@ -188,3 +205,25 @@ typedef struct {
 } DriftDrawBatch;
 
 void DriftDrawBatches(DriftDraw* draw, DriftDrawBatch batches[]);
+
+// Retained sprites for overlay geometry that only changes when its inputs do.
+typedef struct {
+	u64 hash;
+	uint start;
+	DRIFT_ARRAY(DriftSprite) sprites;
+} DriftSpriteCache;
+
+// Appends the cached sprites to 'arr' and returns true if 'hash' matches the last generated geometry.
+// Otherwise generate the sprites into 'arr' and call DriftSpriteCacheEnd() to retain them.
+bool DriftSpriteCacheBegin(DriftSpriteCache* cache, u64 hash, DRIFT_ARRAY(DriftSprite)* arr);
+void DriftSpriteCacheEnd(DriftSpriteCache* cache, DRIFT_ARRAY(DriftSprite) arr);
+void DriftSpriteCacheFree(DriftSpriteCache* cache);
+
+// Find the shadow mask segments that overlap each light's bounds, segments outside of 'bounds' are ignored.
+// Returns the gathered segments, light 'i' uses the range [light_offsets[i], light_offsets[i + 1]).
+DRIFT_ARRAY(DriftSegment) DriftDrawBinShadowMasks(DriftMem* mem, DRIFT_ARRAY(DriftSegment) segments, DriftAABB2 bounds, const DriftAABB2 light_bounds[], uint light_count, uint light_offsets[]);
+
+#if DRIFT_DEBUG
+void unit_test_shadow_bins(void);
+void unit_test_sprite_packing(void);
+#endif
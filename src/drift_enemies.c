@@ -57,8 +57,6 @@ void DriftSystemsInitEnemies(DriftGameState* state){
 	hives->data[0] = (DriftHiveData){.health = 1000};
 }
 
-DriftEntity DriftSpawnEnemy(DriftGameState* state, DriftEnemyType type, DriftVec2 pos, DriftVec2 rot);
-
 static DriftRGBA8 health_flash(uint tick, DriftHealth* health){
 	return DriftRGBA8Fade(DRIFT_RGBA8_RED, 0.8f*DriftSaturate(1 - (tick - health->damage_tick0)/15.0f));
 }
@@ -566,8 +564,8 @@ bool DriftWorkerDroneCollide(DriftUpdate* update, DriftPhysics* phys, DriftIndex
 }
 
 static void tick_spawns(DriftUpdate* update, DriftVec2 player_pos){
-	static DriftRandom rand[1]; // TODO static global
 	DriftGameState* state = update->state;
+	DriftRandom* rand = state->rand;
 	DriftTerrain* terra = state->terra;
 	DriftTutorialSpawnPhase spawn_phase = state->status.spawn_phase;
 	
@@ -893,6 +891,7 @@ void DriftDrawEnemies(DriftDraw* draw){
 		{.component = &state->health.c, .variable = &health_idx},
 		{},
 	});
+	DriftJoinSplit(&join, draw->part, draw->parts);
 	
 	DriftAffine vp_matrix = draw->vp_matrix;
 	while(DriftJoinNext(&join)){
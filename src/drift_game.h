@@ -76,6 +76,14 @@ typedef enum {
 	_DRIFT_UI_STATE_MAX,
 } DriftUIState;
 
+// Retained sprites for each MicroUI window, see DriftUIPresent().
+typedef struct DriftUIPanelCache DriftUIPanelCache;
+typedef struct {
+	DriftUIPanelCache* panels;
+	// Windows that reused or regenerated their sprites during the last present.
+	uint hits, misses;
+} DriftUICache;
+
 typedef enum {
 	DRIFT_COLLISION_NONE,
 	DRIFT_COLLISION_TERRAIN,
@@ -230,6 +238,7 @@ enum {
 #include "drift_tools.h"
 #include "drift_systems.h"
 #include "drift_game_context.h"
+#include "drift_replay.h"
 
 // Loops
 
@@ -246,6 +255,7 @@ DriftLoopYield DriftMenuLoop(tina_job* job, DriftGameContext* ctx);
 DriftLoopYield DriftGameContextLoop(tina_job* job);
 
 void DriftGameStart(tina_job* job);
+void DriftGameHeadless(tina_job* job);
 
 // Physics
 
@@ -296,6 +306,8 @@ bool DriftCollisionFilter(DriftCollisionType a, DriftCollisionType b);
 void DriftPhysicsTick(DriftUpdate* update, DriftMem* mem);
 void DriftPhysicsSubstep(DriftUpdate* update);
 void DriftPhysicsSyncTransforms(DriftUpdate* update, float dt_diff);
+// Reorder the bodies and transforms spatially, and reset the RTree to match.
+void DriftPhysicsSortBodies(DriftGameState* state);
 
 // UI
 
@@ -305,6 +317,7 @@ void DriftUIHotload(mu_Context* mu);
 void DriftUIHandleEvent(mu_Context* mu, SDL_Event* event, float scale);
 void DriftUIBegin(mu_Context* mu, DriftDraw* draw);
 void DriftUIPresent(mu_Context* mu, DriftDraw* draw);
+void DriftUICacheFree(DriftUICache* cache);
 
 DriftLoopYield DriftPauseLoop(DriftGameContext* ctx, tina_job* job, DriftAffine vp_matrix, bool* exit_to_menu);
 DriftLoopYield DriftGameContextMapLoop(DriftGameContext* ctx, tina_job* job, DriftAffine game_vp_matrix, uintptr_t data);
@@ -370,6 +383,7 @@ void DriftPowerNodeActivate(DriftGameState* state, DriftEntity e, DriftMem* mem)
 
 extern DriftCollisionCallback DriftWorkerDroneCollide;
 
+DriftEntity DriftSpawnEnemy(DriftGameState* state, DriftEnemyType type, DriftVec2 pos, DriftVec2 rot);
 void DriftTickEnemies(DriftUpdate* update);
 void DriftDrawEnemies(DriftDraw* draw);
 
@@ -8,6 +8,7 @@ Veridian Expanse is distributed in the hope that it will be useful, but WITHOUT
 You should have received a copy of the GNU General Public License along with Veridian Expanse. If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "tina/tina.h"
@@ -17,21 +18,37 @@ You should have received a copy of the GNU General Public License along with Ver
 #include "drift_game.h"
 #include "base/drift_nuklear.h"
 
-static void DriftGameStateIO(DriftIO* io){
+// Blocks before the terrain.
+static void DriftGameStateHeadIO(DriftIO* io){
 	DriftGameState* state = io->user_ptr;
 	
+	u32 version = DRIFT_SAVE_VERSION;
+	DriftIOBlock(io, "version", &version, sizeof(version));
+	if(version != DRIFT_SAVE_VERSION){
+		DRIFT_LOG("Save version %u is not supported (expected %u).", version, DRIFT_SAVE_VERSION);
+		io->abort = true;
+		return;
+	}
+	
 	// Handle ECS data.
-	DriftIOBlock(io, "entities", &state->entities, sizeof(state->entities));
+	DriftEntitySetIO(&state->entities, io);
+	if(io->abort) return;
+	
 	DRIFT_ARRAY_FOREACH(state->components, component) DriftComponentIO(*component, io);
 	DriftIOBlock(io, "player", &state->player, sizeof(state->player));
-	
-	// Handle terrain.
+}
+
+static void DriftTerrainBlocksIO(DriftIO* io, DriftTerrainDensity* density, u8* resources, u8* biomass, DriftRGBA8* visibility){
 	// TODO this saves density mips
-	DriftIOBlock(io, "density", state->terra->tilemap.density, sizeof(state->terra->tilemap.density));
-	DriftIOBlock(io, "resources", state->terra->tilemap.resources, sizeof(state->terra->tilemap.resources));
-	DriftIOBlock(io, "biomass", state->terra->tilemap.biomass, sizeof(state->terra->tilemap.biomass));
-	DriftIOBlock(io, "visibility", state->terra->tilemap.visibility, sizeof(state->terra->tilemap.visibility));
-	if(io->read) DriftTerrainResetCache(state->terra);
+	DriftIOBlock(io, "density", density, DRIFT_TERRAIN_TILE_COUNT*sizeof(*density));
+	DriftIOBlock(io, "resources", resources, DRIFT_TERRAIN_TILEMAP_SIZE_SQ*sizeof(*resources));
+	DriftIOBlock(io, "biomass", biomass, DRIFT_TERRAIN_TILEMAP_SIZE_SQ*sizeof(*biomass));
+	DriftIOBlock(io, "visibility", visibility, DRIFT_TERRAIN_TILEMAP_SIZE_SQ*sizeof(*visibility));
+}
+
+// Blocks after the terrain.
+static void DriftGameStateTailIO(DriftIO* io){
+	DriftGameState* state = io->user_ptr;
 	
 	// Handle other tables.
 	DRIFT_ARRAY_FOREACH(state->tables, table) DriftTableIO(*table, io);
@@ -42,12 +59,111 @@ static void DriftGameStateIO(DriftIO* io){
 	DriftIOBlock(io, "scan_progress", state->scan_progress, sizeof(state->scan_progress));
 }
 
-void DriftGameStateSave(DriftGameState* state){
-	DriftIOFileWrite(TMP_SAVE_FILENAME, DriftGameStateIO, state);
+void DriftGameStateIO(DriftIO* io){
+	DriftGameState* state = io->user_ptr;
+	DriftGameStateHeadIO(io);
+	if(io->abort) return;
+	
+	// Handle terrain.
+	DriftTerrain* terra = state->terra;
+	DriftTerrainBlocksIO(io, terra->tilemap.density, terra->tilemap.resources, terra->tilemap.biomass, terra->tilemap.visibility);
+	if(io->read) DriftTerrainResetCache(terra);
+	
+	DriftGameStateTailIO(io);
+}
+
+// Terrain as of the last save. Saves only copy the tiles modified since then on the main thread.
+// Mips are rebuilt after loading, so they are left zeroed.
+struct DriftSaveTerrain {
+	DriftTerrainDensity density[DRIFT_TERRAIN_TILE_COUNT];
+	u8 resources[DRIFT_TERRAIN_TILEMAP_SIZE_SQ];
+	u8 biomass[DRIFT_TERRAIN_TILEMAP_SIZE_SQ];
+	DriftRGBA8 visibility[DRIFT_TERRAIN_TILEMAP_SIZE_SQ];
+};
+
+static uint DriftSaveTerrainUpdate(DriftSaveTerrain* save, DriftTerrain* terra){
+	uint count = 0;
+	for(uint i = 0; i < DRIFT_TERRAIN_TILEMAP_SIZE_SQ; i++){
+		if(!terra->tilemap.unsaved[i]) continue;
+		
+		save->density[i + DRIFT_TERRAIN_MIP0] = terra->tilemap.density[i + DRIFT_TERRAIN_MIP0];
+		save->resources[i] = terra->tilemap.resources[i];
+		save->biomass[i] = terra->tilemap.biomass[i];
+		save->visibility[i] = terra->tilemap.visibility[i];
+		terra->tilemap.unsaved[i] = false;
+		count++;
+	}
+	
+	return count;
+}
+
+typedef struct {
+	DriftData head, tail;
+	DriftSaveTerrain* terrain;
+} DriftSaveJobContext;
+
+static void DriftSaveJobIO(DriftIO* io){
+	DriftSaveJobContext* ctx = io->user_ptr;
+	DriftSaveTerrain* terrain = ctx->terrain;
+	DriftIOBlock(io, "head", ctx->head.ptr, ctx->head.size);
+	DriftTerrainBlocksIO(io, terrain->density, terrain->resources, terrain->biomass, terrain->visibility);
+	DriftIOBlock(io, "tail", ctx->tail.ptr, ctx->tail.size);
+}
+
+// Only one save is allowed in flight at a time.
+static tina_group SAVE_GROUP;
+
+static void DriftGameStateSaveJob(tina_job* job){
+	DriftSaveJobContext* ctx = tina_job_get_description(job)->user_data;
+	TracyCZoneN(ZONE_SAVE, "Save Game", true);
+	DriftData snapshot = DriftIOSnapshot(DriftSystemMem, DriftSaveJobIO, ctx);
+	DriftIOSnapshotWrite(TMP_SAVE_FILENAME, snapshot);
+	TracyCZoneEnd(ZONE_SAVE);
+	
+	DriftDealloc(DriftSystemMem, snapshot.ptr, snapshot.size);
+	DriftDealloc(DriftSystemMem, ctx->head.ptr, ctx->head.size);
+	DriftDealloc(DriftSystemMem, ctx->tail.ptr, ctx->tail.size);
+	DriftDealloc(DriftSystemMem, ctx, sizeof(*ctx));
 }
 
-bool DriftGameStateLoad(DriftGameState* state){
-	return DriftIOFileRead(TMP_SAVE_FILENAME, DriftGameStateIO, state);
+void DriftGameStateSave(DriftGameState* state, tina_job* job){
+	DriftAssertMainThread();
+	// Also keeps the job from reading the saved terrain while it's updated.
+	DriftGameStateSaveWait(job);
+	
+	// Snapshot the state on the main thread between ticks, then assemble, compress, and write it in the background.
+	u64 nanos = DriftTimeNanos();
+	if(state->save_terrain == NULL){
+		state->save_terrain = DriftAlloc(DriftSystemMem, sizeof(*state->save_terrain));
+		memset(state->save_terrain, 0, sizeof(*state->save_terrain));
+		DriftTerrainMarkUnsaved(state->terra);
+	}
+	
+	uint tile_count = DriftSaveTerrainUpdate(state->save_terrain, state->terra);
+	DriftSaveJobContext* ctx = DRIFT_COPY(DriftSystemMem, ((DriftSaveJobContext){
+		.head = DriftIOSnapshot(DriftSystemMem, DriftGameStateHeadIO, state),
+		.tail = DriftIOSnapshot(DriftSystemMem, DriftGameStateTailIO, state),
+		.terrain = state->save_terrain,
+	}));
+	
+	size_t size = ctx->head.size + ctx->tail.size;
+	DRIFT_LOG("Save snapshot: %.1f MB and %u terrain tiles, main thread stalled for %.2f ms.", size/1e6, tile_count, (DriftTimeNanos() - nanos)/1e6);
+	
+	tina_scheduler_enqueue(APP->scheduler, DriftGameStateSaveJob, ctx, 0, DRIFT_JOB_QUEUE_WORK, &SAVE_GROUP);
+}
+
+void DriftGameStateSaveWait(tina_job* job){
+	tina_job_wait(job, &SAVE_GROUP, 0);
+}
+
+bool DriftGameStateLoad(DriftGameState* state, tina_job* job){
+	DriftGameStateSaveWait(job);
+	if(!DriftIOSnapshotRead(TMP_SAVE_FILENAME, DriftGameStateIO, state)) return false;
+	
+	// Drop any rows left behind for dead entities before the first tick.
+	uint removed = DriftComponentGCAll(job, state->components, DriftArrayLength(state->components), &state->entities);
+	if(removed) DRIFT_LOG("Removed %u dead component rows after loading.", removed);
+	return true;
 }
 
 DriftEntity DriftMakeEntity(DriftGameState* state){
@@ -83,14 +199,20 @@ DriftGameState* DriftGameStateNew(tina_job* job){
 	state->debug.sprites = DRIFT_ARRAY_NEW(state->mem, 0, DriftSprite);
 	state->debug.prims = DRIFT_ARRAY_NEW(state->mem, 0, DriftPrimitive);
 	
-	DriftEntitySetInit(&state->entities);
+	DriftEntitySetInit(&state->entities, state->mem);
 	DriftSystemsInit(state);
 	state->terra = DriftTerrainNew(job, false);
 	
 	return state;
 }
 
-void DriftGameStateFree(DriftGameState* state){
+void DriftGameStateFree(DriftGameState* state, tina_job* job){
+	// An in flight save may still be reading the saved terrain.
+	DriftGameStateSaveWait(job);
+	if(state->save_terrain) DriftDealloc(DriftSystemMem, state->save_terrain, sizeof(*state->save_terrain));
+	
+	// Component tables reserve their own address space instead of using the state's memory.
+	DRIFT_ARRAY_FOREACH(state->components, component) DriftTableDestroy(&(*component)->table);
 	DriftListMemFree(state->mem);
 }
 
@@ -149,9 +271,20 @@ static DriftGameContext* DriftGameContextCreate(tina_job* job){
 	return ctx;
 }
 
+static void free_ui_caches(DriftGameContext* ctx){
+	DriftUICacheFree(&ctx->ui_cache);
+	DriftSpriteCacheFree(&ctx->hud_cache.status);
+	DriftSpriteCacheFree(&ctx->hud_cache.cargo);
+}
+
 void DriftGameStart(tina_job* job){
 	TracyCZoneN(ZONE_START, "Game start", true);
 	
+	// unit_test_parallel_for(job);
+	// unit_test_shadow_bins();
+	// unit_test_sprite_packing();
+	// unit_test_terrain_shadows(job);
+	
 	// TODO need to move this deeper into the event loop
 	DriftGameContext* ctx = APP->app_context;
 	if(ctx == NULL){
@@ -188,6 +321,8 @@ void DriftGameStart(tina_job* job){
 	DriftAppShowWindow();
 	DriftLoopYield yield = DriftMenuLoop(job, ctx);
 	
+	// The retained UI sprites are rebuilt on the next start, which may be running new code after a hotload.
+	free_ui_caches(ctx);
 	DriftDrawSharedFree(ctx->draw_shared);
 	queue = tina_job_switch_queue(job, DRIFT_JOB_QUEUE_GFX);
 	APP->gfx_driver->free_all(APP->gfx_driver);
@@ -198,6 +333,8 @@ void DriftGameStart(tina_job* job){
 		DriftAudioPause(true);
 	}
 	
+	// Don't exit with a save still in flight.
+	DriftGameStateSaveWait(job);
 	if(yield != DRIFT_LOOP_YIELD_HOTLOAD) DriftAppHaltScheduler();
 }
 
@@ -263,7 +400,13 @@ void DriftGameStateRender(DriftDraw* draw){
 		}));
 	}
 	
-	uint light_count = DriftArrayLength(draw->lights);
+	// Cull lights outside of the view so they don't cost any fill rate or shadow passes.
+	uint light_count = 0;
+	DRIFT_ARRAY_FOREACH(draw->lights, light){
+		DriftVec2 center = light_frame_center(light->frame);
+		if(DriftAffineVisibility(DriftAffineMul(draw->vp_matrix, light->matrix), center, DRIFT_VEC2_ONE)) draw->lights[light_count++] = *light;
+	}
+	DriftArrayHeader(draw->lights)->count = light_count;
 	
 	// Debug draw lights.
 	if(false){
@@ -282,7 +425,7 @@ void DriftGameStateRender(DriftDraw* draw){
 	}
 	
 	// Render the lightfield buffer.
-	DriftGfxBufferBinding light_instances_binding = DriftGfxRendererPushGeometry(draw->renderer, draw->lights, light_count*sizeof(*draw->lights)).binding;
+	DriftGfxBufferBinding light_instances_binding = DriftDrawPushLights(draw, draw->lights, light_count);
 	for(uint pass = 0; pass < 2; pass++){
 		DriftGfxRendererPushBindTargetCommand(renderer, draw_shared->lightfield_target[pass], DRIFT_VEC4_CLEAR);
 		DriftGfxPipelineBindings* bindings = DriftDrawQuads(draw, draw_shared->light_pipeline[pass], light_count);
@@ -303,21 +446,11 @@ void DriftGameStateRender(DriftDraw* draw){
 		
 		float radius = draw->lights[i].radius;
 		if(radius > 0){
-			DriftAffine light_matrix = draw->lights[i].matrix;
-			// DriftDebugCircle2(draw->state, DriftAffineOrigin(light_matrix), radius, radius - 1, (DriftRGBA8){0xFF, 0xFF, 0x00, 0x80});
-			
-			DriftVec2 center = light_frame_center(draw->lights[i].frame);
-			if(DriftAffineVisibility(DriftAffineMul(draw->vp_matrix, light_matrix), center, DRIFT_VEC2_ONE)){
-				// Expand the bounds to include the light + radius;
-				DriftVec2 origin = DriftAffineOrigin(light_matrix);
-				float radius = draw->lights[i].radius;
-				DriftAABB2 light_bounds = {origin.x - radius, origin.y - radius, origin.x + radius, origin.y + radius};
-				shadow_bounds = DriftAABB2Merge(shadow_bounds, light_bounds);
-				shadow_count++;
-			} else {
-				// Light is not visible, clear it's shadow flag.
-				draw->lights[i].radius = 0;
-			}
+			// Expand the bounds to include the light + radius;
+			DriftVec2 origin = DriftAffineOrigin(draw->lights[i].matrix);
+			DriftAABB2 light_bounds = {origin.x - radius, origin.y - radius, origin.x + radius, origin.y + radius};
+			shadow_bounds = DriftAABB2Merge(shadow_bounds, light_bounds);
+			shadow_count++;
 		}
 	}
 	
@@ -325,6 +458,8 @@ void DriftGameStateRender(DriftDraw* draw){
 	DriftGfxBufferBinding shadow_uniform_bindings[shadow_count + 1];
 	DriftGfxBufferBinding light_instance_bindings[shadow_count + 1];
 	DriftAABB2 scissor_bounds[shadow_count + 1];
+	// World space area each shadowed light can reach, used to bin the shadow masks.
+	DriftAABB2 lit_bounds[shadow_count + 1];
 	
 	// Need to convert light bounds from world to pixel coords for scissoring.
 	DriftVec2 shadowfield_extent = DriftVec2Mul(draw->internal_extent, 1.0f/draw->shared->lightfield_scale);
@@ -334,20 +469,21 @@ void DriftGameStateRender(DriftDraw* draw){
 	for(uint i = 0, j = 0; i < light_count; i++){
 		if(draw->lights[i].radius > 0){
 			DriftAffine light_matrix = draw->lights[i].matrix;
+			float radius = draw->lights[i].radius;
 			
 			struct {
 				DriftGPUMatrix matrix;
 				float radius;
 			} uniforms = {
 				.matrix = DriftAffineToGPU(light_matrix),
-				.radius = draw->lights[i].radius,
+				.radius = radius,
 			};
 			
 			shadow_uniform_bindings[j] = DriftGfxRendererPushUniforms(renderer, &uniforms, sizeof(uniforms)).binding;
 			light_instance_bindings[j] = light_instances_binding;
 			
-			DriftAffine m_bound = DriftAffineMul(scissor_matrix, light_matrix);
 			DriftVec2 center = light_frame_center(draw->lights[i].frame);
+			DriftAffine m_bound = DriftAffineMul(scissor_matrix, light_matrix);
 			m_bound.x += m_bound.a*center.x + m_bound.c*center.y;
 			m_bound.y += m_bound.b*center.x + m_bound.d*center.y;
 			
@@ -355,18 +491,37 @@ void DriftGameStateRender(DriftDraw* draw){
 			float hw = fabsf(m_bound.a) + fabsf(m_bound.c), hh = fabsf(m_bound.b) + fabsf(m_bound.d);
 			scissor_bounds[j] = (DriftAABB2){m_bound.x - hw, m_bound.y - hh, m_bound.x + hw, m_bound.y + hh};
 			
+			// Occluders between the light's origin and its sprite are all that can cast into the scissor rect.
+			DriftAffine m_lit = light_matrix;
+			m_lit.x += m_lit.a*center.x + m_lit.c*center.y;
+			m_lit.y += m_lit.b*center.x + m_lit.d*center.y;
+			hw = fabsf(m_lit.a) + fabsf(m_lit.c), hh = fabsf(m_lit.b) + fabsf(m_lit.d);
+			DriftVec2 origin = DriftAffineOrigin(light_matrix);
+			lit_bounds[j] = DriftAABB2Merge(
+				(DriftAABB2){m_lit.x - hw, m_lit.y - hh, m_lit.x + hw, m_lit.y + hh},
+				(DriftAABB2){origin.x - radius, origin.y - radius, origin.x + radius, origin.y + radius}
+			);
+			
 			j++;
 		}
 
 		// These are already buffered by the lightfield step, so it needs to skip over non-shadow lights.
-		light_instances_binding.offset += sizeof(DriftLight);
+		light_instances_binding.offset += draw_shared->light_stride;
 	}
 	
-	DriftTerrainGatherShadows(draw, draw->state->terra, shadow_bounds);
+	DriftTerrainGatherShadows(draw, draw->state->terra, lit_bounds, shadow_count);
+	
+	// Push the shadow mask data binned by light so each light only draws the masks it can reach.
+	uint shadow_mask_offsets[shadow_count + 1];
+	DRIFT_ARRAY(DriftSegment) shadow_masks = DriftDrawBinShadowMasks(draw->mem, draw->shadow_masks, shadow_bounds, lit_bounds, shadow_count, shadow_mask_offsets);
 	
-	// Push the shadow mask data.
+	// Lots of big overlapping lights duplicate too many masks, share the whole list instead.
 	uint shadow_mask_count = DriftArrayLength(draw->shadow_masks);
-	DriftGfxBufferBinding shadow_mask_instances = DriftGfxRendererPushGeometry(renderer, draw->shadow_masks, shadow_mask_count*sizeof(*draw->shadow_masks)).binding;
+	if(DriftArrayLength(shadow_masks) > 4*shadow_mask_count + 1024){
+		shadow_masks = draw->shadow_masks;
+		for(uint i = 0; i <= shadow_count; i++) shadow_mask_offsets[i] = 0;
+	}
+	DriftGfxBufferBinding shadow_mask_instances = DriftGfxRendererPushGeometry(renderer, shadow_masks, DriftArraySize(shadow_masks)).binding;
 	
 	for(uint pass = 0; pass < 2; pass++){
 		DriftGfxRendererPushBindTargetCommand(renderer, draw_shared->shadowfield_target[pass], DRIFT_VEC4_CLEAR);
@@ -376,9 +531,15 @@ void DriftGameStateRender(DriftDraw* draw){
 			DriftGfxRendererPushScissorCommand(renderer, scissor_bounds[i]);
 
 			// Render shadow mask.
-			DriftGfxPipelineBindings* shadow_mask_bindings = DriftDrawQuads(draw, draw_shared->shadow_mask_pipeline[pass], shadow_mask_count);
-			shadow_mask_bindings->instance = shadow_mask_instances;
-			shadow_mask_bindings->uniforms[1] = shadow_uniform_bindings[i];
+			uint mask_first = shadow_mask_offsets[i], mask_count = shadow_mask_offsets[i + 1] - mask_first;
+			if(shadow_masks == draw->shadow_masks) mask_count = shadow_mask_count;
+			if(mask_count){
+				DriftGfxPipelineBindings* shadow_mask_bindings = DriftDrawQuads(draw, draw_shared->shadow_mask_pipeline[pass], mask_count);
+				shadow_mask_bindings->instance = shadow_mask_instances;
+				shadow_mask_bindings->instance.offset += mask_first*sizeof(DriftSegment);
+				shadow_mask_bindings->instance.size = mask_count*sizeof(DriftSegment);
+				shadow_mask_bindings->uniforms[1] = shadow_uniform_bindings[i];
+			}
 
 			// Accumulate shadowfield and clear the mask.
 			DriftGfxPipelineBindings* shadow_bindings = DriftDrawQuads(draw, draw_shared->shadow_pipeline[pass], 1);
@@ -499,9 +660,16 @@ void DriftGameStateRender(DriftDraw* draw){
 	});
 }
 
+#define COMPONENT_RESERVE_ROWS (4u*1024*1024)
+
 DriftComponent* DriftGameStateNamedComponentMake(DriftGameState* state, DriftComponent* component, const char* name, DriftColumnSet columns, uint capacity){
-	DriftComponentInit(component, (DriftTableDesc){.name = name, .mem = state->mem, .min_row_capacity = capacity, .columns = columns});
+	// Reserve address space for far more rows than a game will use so tables never copy when growing.
+	DriftComponentInit(component, (DriftTableDesc){
+		.name = name, .mem = state->mem, .min_row_capacity = capacity,
+		.reserve_rows = COMPONENT_RESERVE_ROWS, .columns = columns,
+	});
 	DRIFT_ARRAY_PUSH(state->components, component);
+	DriftEntitySetAddComponent(&state->entities, component);
 	
 	uintptr_t check = DriftMapInsert(&state->named_components, DriftFNV64Str(component->table.desc.name), (uintptr_t)component);
 	DRIFT_ASSERT_HARD(check == 0, "Duplicate hash in named components.");
@@ -512,16 +680,7 @@ DriftComponent* DriftGameStateNamedComponentMake(DriftGameState* state, DriftCom
 static void destroy_entities(DriftGameState* state, DriftEntity* list){
 	DriftAssertMainThread();
 	
-	// Remove all components for the entities.
-	DRIFT_ARRAY_FOREACH(state->components, component){
-		DRIFT_ARRAY_FOREACH(list, e) DriftComponentRemove(*component, *e);
-	}
-	
-	// Retire the entities.
-	DRIFT_ARRAY_FOREACH(list, e){
-		if(DriftEntitySetCheck(&state->entities, *e)) DriftEntitySetRetire(&state->entities, *e);
-	}
-	
+	DriftEntitySetDestroy(&state->entities, list, DriftArrayLength(list));
 	DriftArrayHeader(list)->count = 0;
 }
 
@@ -566,6 +725,19 @@ static void DriftGameStateCleanup(DriftUpdate* update){
 			DriftTableCopyRow(table, idx, --table->row_count);
 		}
 	}
+	
+	// Restore the order of components that want it so joins can merge them.
+	DRIFT_ARRAY_FOREACH(state->components, c){
+		if((*c)->keep_sorted) DriftComponentSort(*c);
+	}
+	
+	// Release memory left over from spikes in entity counts a component at a time.
+	uint component_count = DriftArrayLength(state->components);
+	if(state->compact_cursor < component_count) DriftComponentCompact(state->components[state->compact_cursor]);
+	if(++state->compact_cursor > component_count){
+		DriftTableShrink(table);
+		state->compact_cursor = 0;
+	}
 }
 
 static void update_reverb(tina_job* job){
@@ -606,12 +778,54 @@ static const char* DRIFT_FRAME_TRACY = "DRIFT_FRAME_TRACY";
 static void DriftGameContextPresent(tina_job* job){
 	static const char* FRAME_PRESENT = "Present";
 	TracyCFrameMarkStart(FRAME_PRESENT);
+	DRIFT_PROFILE_SCOPE(FRAME_PRESENT);
 	DriftDraw* draw = tina_job_get_description(job)->user_data;
 	DriftAppPresentFrame(draw->renderer);
 	DriftZoneMemRelease(draw->mem);
 	TracyCFrameMarkEnd(FRAME_PRESENT);
 }
 
+// Ticks between re-sorting the rigid bodies into spatial order, about every 10 seconds.
+#define SPATIAL_SORT_TICKS (uint)(10*DRIFT_TICK_HZ)
+
+// Run a single fixed timestep tick of the game state.
+static void DriftGameContextTick(DriftUpdate* update){
+	DriftGameState* state = update->state;
+	
+	if(state->tutorial && !DriftScriptTick(state->tutorial, update)){
+		DriftScriptFree(state->tutorial);
+		state->tutorial = NULL;
+	}
+	
+	if(state->script && !DriftScriptTick(state->script, update)){
+		DriftScriptFree(state->script);
+		state->script = NULL;
+	}
+	
+	TracyCZoneN(ZONE_TICK, "Tick", true);
+	DriftProfileZone tick_zone = DriftProfileBegin("Tick");
+	DriftSystemsTick(update);
+	DriftProfileEnd(tick_zone);
+	TracyCZoneEnd(ZONE_TICK);
+	
+	TracyCZoneN(ZONE_PHYSICS, "Physics", true);
+	DriftProfileZone physics_zone = DriftProfileBegin("Physics");
+	u64 physics_nanos = DriftTimeNanos();
+	DRIFT_ASSERT(DriftVec2Length(state->bodies.velocity[0]) == 0, "Velocity 0 before physics.");
+	DriftPhysicsTick(update, update->mem);
+	for(uint i = 0; i < DRIFT_SUBSTEPS; i++) DriftPhysicsSubstep(update);
+	DRIFT_ASSERT(DriftVec2Length(state->bodies.velocity[0]) == 0, "Velocity 0 after physics.");
+	if(DRIFT_SYSTEM_TIMINGS.enabled) DriftSystemTimingAdd("Physics", DriftTimeNanos() - physics_nanos);
+	DriftProfileEnd(physics_zone);
+	TracyCZoneEnd(ZONE_PHYSICS);
+	
+	destroy_entities(state, state->dead_entities);
+	
+	// Bodies get scattered in memory as they are created and removed, periodically put them back in spatial order.
+	// Done on a tick boundary so replays reorder them at the same time.
+	if(update->tick % SPATIAL_SORT_TICKS == 0) DriftPhysicsSortBodies(state);
+}
+
 static double qtrunc(double f, double q){return trunc(f/q - 1)*q + q;}
 static double iir_filter(double sample, uint n, double* x, double* y, const double* b, const double* a){
 	double value = b[0]*sample;
@@ -672,6 +886,7 @@ DriftLoopYield DriftGameContextLoop(tina_job* job){
 	DriftAffine debug_view = DRIFT_AFFINE_IDENTITY;
 	
 	DriftAudioBusSetActive(DRIFT_BUS_SFX, true);
+	DriftReplay* recording = APP->record_filename ? DriftReplayRecordBegin(ctx) : NULL;
 	
 	tina_group reverb_job = {}, present_job = {};
 	while(!APP->request_quit && !APP->shell_restart){
@@ -700,7 +915,7 @@ DriftLoopYield DriftGameContextLoop(tina_job* job){
 			bool exit_to_menu = false;
 			if(DriftInputButtonPress(DRIFT_INPUT_PAUSE)) DriftPauseLoop(ctx, job, prev_vp_matrix, &exit_to_menu);
 			if(exit_to_menu){
-				DriftGameStateFree(ctx->state);
+				DriftGameStateFree(ctx->state, job);
 				ctx->state = NULL;
 				break;
 			}
@@ -729,46 +944,31 @@ DriftLoopYield DriftGameContextLoop(tina_job* job){
 		};
 		
 		TracyCZoneN(UPDATE_ZONE, "Update", true);
+		DriftProfileZone update_zone = DriftProfileBegin("Update");
 		if(update_nanos > 0){
 			DriftSystemsUpdate(&update);
 		}
 		
 		if(ctx->reverb.dynamic) tina_scheduler_enqueue(APP->scheduler, update_reverb, &update, 0, DRIFT_JOB_QUEUE_WORK, &reverb_job);
+		DriftProfileEnd(update_zone);
 		TracyCZoneEnd(UPDATE_ZONE);
 		
 		u64 tick_dt_nanos = (u64)(1e9f/DRIFT_TICK_HZ);
+		uint tick_count = 0;
 		while(ctx->tick_nanos < ctx->update_nanos){
 			update.tick = ctx->current_tick = ctx->_tick_counter;
 			update.nanos = ctx->tick_nanos;
+			DriftGameContextTick(&update);
 			
-			if(state->tutorial && !DriftScriptTick(state->tutorial, &update)){
-				DriftScriptFree(state->tutorial);
-				state->tutorial = NULL;
-			}
-			
-			if(state->script && !DriftScriptTick(state->script, &update)){
-				DriftScriptFree(state->script);
-				state->script = NULL;
-			}
-			
-			TracyCZoneN(ZONE_TICK, "Tick", true);
-			DriftSystemsTick(&update);
-			TracyCZoneEnd(ZONE_TICK);
-			
-			TracyCZoneN(ZONE_PHYSICS, "Physics", true);
-			DRIFT_ASSERT(DriftVec2Length(state->bodies.velocity[0]) == 0, "Velocity 0 before physics.");
-			DriftPhysicsTick(&update, update.mem);
-			for(uint i = 0; i < DRIFT_SUBSTEPS; i++) DriftPhysicsSubstep(&update);
-			DRIFT_ASSERT(DriftVec2Length(state->bodies.velocity[0]) == 0, "Velocity 0 after physics.");
-			TracyCZoneEnd(ZONE_PHYSICS);
-			
-			destroy_entities(state, state->dead_entities);
 			ctx->tick_nanos += tick_dt_nanos;
 			ctx->_tick_counter++;
+			tick_count++;
 		}
 		
 		TracyCZoneN(CLEANUP_ZONE, "Cleanup", true);
+		DriftProfileZone cleanup_zone = DriftProfileBegin("Cleanup");
 		DriftGameStateCleanup(&update);
+		DriftProfileEnd(cleanup_zone);
 		TracyCZoneEnd(CLEANUP_ZONE);
 		
 		float dt_tick_diff = (ctx->tick_nanos - ctx->update_nanos)/-1e9f;
@@ -778,7 +978,10 @@ DriftLoopYield DriftGameContextLoop(tina_job* job){
 		DriftPhysicsSyncTransforms(&update, dt_tick_diff);
 		TracyCZoneEnd(INTERPOLATE_ZONE);
 		
+		if(recording) DriftReplayRecordFrame(recording, &update, update_nanos, tick_count);
+		
 		TracyCZoneN(DRAW_ZONE, "Draw", true);
+		DriftProfileZone draw_zone = DriftProfileBegin("Draw");
 		TracyCZoneN(DRAW_ZONE_DRAW_SETUP, "Draw Setup", true);
 		DriftVec2 prev_origin = DriftAffineOrigin(DriftAffineInverse(prev_vp_matrix));
 		DriftAffine v_matrix = {1, 0, 0, 1, -prev_origin.x, -prev_origin.y};
@@ -875,9 +1078,11 @@ DriftLoopYield DriftGameContextLoop(tina_job* job){
 		TracyCZoneN(DEBUG_UI_ZONE, "Debug UI", true);
 		DriftDebugUI(&update, draw);
 		TracyCZoneEnd(DEBUG_UI_ZONE);
+		DriftProfileEnd(draw_zone);
 		TracyCZoneEnd(DRAW_ZONE);
 		
 		TracyCZoneN(RENDER_ZONE, "Render", true);
+		DriftProfileZone render_zone = DriftProfileBegin("Render");
 		DriftGameStateRender(draw);
 		DriftArrayHeader(state->debug.sprites)->count = 0;
 		DriftArrayHeader(state->debug.prims)->count = 0;
@@ -897,6 +1102,7 @@ DriftLoopYield DriftGameContextLoop(tina_job* job){
 		TracyCZoneN(DEBUG_UI_RENDER_ZONE, "Debug UI Draw", true);
 		DriftNuklearDraw(ctx->debug.ui, draw);
 		TracyCZoneEnd(DEBUG_UI_RENDER_ZONE);
+		DriftProfileEnd(render_zone);
 		TracyCZoneEnd(RENDER_ZONE);
 		
 		tina_job_wait(job, &present_job, 0);
@@ -904,8 +1110,11 @@ DriftLoopYield DriftGameContextLoop(tina_job* job){
 		
 		tina_job_wait(job, &reverb_job, 0);
 		DriftZoneMemRelease(update.mem);
+		// Give blocks left over from a load spike back to the OS every so often.
+		if(ctx->current_frame % (10*60) == 0) DriftZoneMemHeapTrim(APP->zone_heap);
 		
 		TracyCFrameMark;
+		DriftProfileFrameMark();
 		ctx->current_frame = ++ctx->_frame_counter;
 		
 		// Yield to other tasks on the main queue.
@@ -932,6 +1141,7 @@ DriftLoopYield DriftGameContextLoop(tina_job* job){
 			
 			tina_job_wait(job, &reverb_job, 0);
 			tina_job_wait(job, &present_job, 0);
+			if(recording) DriftReplayRecordEnd(recording, APP->record_filename);
 			return DRIFT_LOOP_YIELD_HOTLOAD;
 		}
 #endif
@@ -946,5 +1156,238 @@ DriftLoopYield DriftGameContextLoop(tina_job* job){
 	DriftAudioBusSetActive(DRIFT_BUS_SFX, false);
 	tina_job_wait(job, &reverb_job, 0);
 	tina_job_wait(job, &present_job, 0);
+	if(recording) DriftReplayRecordEnd(recording, APP->record_filename);
 	return (APP->shell_restart ? DRIFT_LOOP_YIELD_RELOAD : DRIFT_LOOP_YIELD_DONE);
 }
+
+static int compare_timings(const void* a, const void* b){
+	u64 nanos_a = ((const DriftSystemTiming*)a)->nanos, nanos_b = ((const DriftSystemTiming*)b)->nanos;
+	return (nanos_a < nanos_b) - (nanos_a > nanos_b);
+}
+
+// Run the fixed step simulation as fast as possible without a window.
+// Used for soak tests and measuring tick performance.
+void DriftGameHeadless(tina_job* job){
+	DriftGameContext* ctx = APP->app_context = DriftGameContextCreate(job);
+	if(APP->input_context == NULL) APP->input_context = DRIFT_COPY(DriftSystemMem, ((DriftInput){}));
+	
+	bool draw_enabled = APP->headless.draw;
+	if(draw_enabled){
+		uint queue = tina_job_switch_queue(job, DRIFT_JOB_QUEUE_GFX);
+		ctx->draw_shared = DriftDrawSharedNew(job, 2);
+		tina_job_switch_queue(job, queue);
+	}
+	
+	DriftGameState* state = ctx->state = DriftGameStateNew(job);
+	state->rand[0] = (DriftRandom){APP->headless.seed};
+	DriftGameStateSetupIntro(state);
+	state->status.needs_tutorial = false;
+	
+	state->player = DriftMakeEntity(state);
+	DriftTempPlayerInit(state, state->player, DRIFT_START_POSITION);
+	DriftTerrainResetCache(state->terra);
+	
+	// Fill the screen around the player with items and glow bugs.
+	DriftRandom sprite_rand = {APP->headless.seed};
+	for(uint i = 0; i < APP->headless.draw_sprites; i++){
+		DriftVec2 offset = {600*DriftRandomSNorm(&sprite_rand), 340*DriftRandomSNorm(&sprite_rand)};
+		DriftVec2 pos = DriftVec2Add(DRIFT_START_POSITION, offset);
+		if(i % 4 == 3){
+			DriftSpawnEnemy(state, DRIFT_ENEMY_GLOW_BUG, pos, DriftRandomOnUnitCircle(&sprite_rand));
+		} else {
+			DriftItemMake(state, DRIFT_ITEM_SCRAP, pos, DRIFT_VEC2_ZERO, 0);
+		}
+	}
+	
+	if(APP->headless.craft_ui){
+		// Open the fabricator while docked with everything scanned and plenty of materials.
+		DriftUIHotload(ctx->mu);
+		ctx->ui_state = DRIFT_UI_STATE_CRAFT;
+		ctx->is_docked = true;
+		state->status.factory.needs_reboot = state->status.factory.needs_scroll = false;
+		for(uint i = 0; i < _DRIFT_SCAN_COUNT; i++) state->scan_progress[i] = 1;
+		for(uint i = 0; i < _DRIFT_ITEM_COUNT; i++) state->inventory.skiff[i] = 50;
+	}
+	
+	DriftReplay* replay = NULL;
+	if(APP->headless.replay_filename){
+		replay = DriftReplayLoad(ctx, APP->headless.replay_filename);
+		if(replay == NULL){
+			APP->request_quit = true;
+		} else if(state->status.needs_tutorial){
+			// The game loop restarts the tutorial when recording starts, so match it.
+			state->tutorial = DriftScriptNew(DriftTutorialScript, NULL, ctx);
+		}
+	} else {
+		DRIFT_LOG("Headless: running %u ticks with seed %llu%s.", APP->headless.ticks, (unsigned long long)APP->headless.seed, draw_enabled ? " (draw enabled)" : "");
+	}
+	DRIFT_SYSTEM_TIMINGS.enabled = true;
+	
+	u64 tick_dt_nanos = (u64)(1e9f/DRIFT_TICK_HZ);
+	DriftVec2 screen_extent = {DRIFT_APP_DEFAULT_SCREEN_W, DRIFT_APP_DEFAULT_SCREEN_H};
+	DriftAffine p_matrix = DriftAffineOrtho(-0.5f*screen_extent.x, 0.5f*screen_extent.x, -0.5f*screen_extent.y, 0.5f*screen_extent.y);
+	DriftAffine prev_vp_matrix = DriftAffineMul(p_matrix, (DriftAffine){1, 0, 0, 1, -DRIFT_START_POSITION.x, -DRIFT_START_POSITION.y});
+	
+	tina_group present_job = {};
+	u64 instance_bytes = 0;
+	uint draw_frames = 0, terrain_misses = 0, terrain_prefetches = 0;
+	uint ui_hits = 0, ui_misses = 0;
+	uint start_tick = ctx->_tick_counter;
+	u64 start_nanos = DriftTimeNanos();
+	while(!APP->request_quit){
+		// Frames follow the recording when replaying, otherwise run exactly one tick per frame.
+		u64 update_nanos = tick_dt_nanos;
+		if(replay){
+			const DriftReplayFrame* frame = DriftReplayNextFrame(replay);
+			if(frame == NULL) break;
+			update_nanos = frame->update_nanos;
+			prev_vp_matrix = frame->prev_vp_matrix;
+		} else if(ctx->_tick_counter - start_tick >= APP->headless.ticks){
+			break;
+		}
+		
+		DriftUpdate update = {
+			.ctx = ctx, .state = state, .job = job, .mem = DriftZoneMemAquire(APP->zone_heap, "UpdateMem"),
+			.frame = ctx->current_frame, .tick = ctx->current_tick, .nanos = update_nanos,
+			.dt = update_nanos/1e9f, .tick_dt = 1/DRIFT_TICK_HZ,
+			.prev_vp_matrix = prev_vp_matrix,
+		};
+		
+		if(update_nanos > 0) DriftSystemsUpdate(&update);
+		
+		uint tick_count = 0;
+		while(ctx->tick_nanos < ctx->update_nanos){
+			update.tick = ctx->current_tick = ctx->_tick_counter;
+			update.nanos = ctx->tick_nanos;
+			DriftGameContextTick(&update);
+			
+			ctx->tick_nanos += tick_dt_nanos;
+			ctx->_tick_counter++;
+			tick_count++;
+		}
+		
+		u64 cleanup_nanos = DriftTimeNanos();
+		DriftGameStateCleanup(&update);
+		float dt_tick_diff = (ctx->tick_nanos - ctx->update_nanos)/-1e9f;
+		ctx->update_nanos += update_nanos;
+		DriftPhysicsSyncTransforms(&update, dt_tick_diff);
+		DriftSystemTimingAdd("Cleanup", DriftTimeNanos() - cleanup_nanos);
+		
+		if(replay) DriftReplayCheckFrame(replay, state, tick_count);
+		
+		DriftAffine v_matrix = DriftAffineMul(DriftAffineInverse(p_matrix), prev_vp_matrix);
+		uint transform_idx = DriftComponentFind(&state->transforms.c, state->player);
+		if(transform_idx){
+			DriftVec2 player_pos = {state->transforms.matrix[transform_idx].x, state->transforms.matrix[transform_idx].y};
+			DriftTerrainUpdateVisibility(state->terra, player_pos);
+			v_matrix = (DriftAffine){1, 0, 0, 1, -player_pos.x, -player_pos.y};
+		}
+		
+		if(APP->headless.camera_path){
+			// Sweep a figure eight around the start position, fast enough to keep streaming in new terrain tiles.
+			float t = ctx->update_nanos/1e9f;
+			DriftVec2 pos = {DRIFT_START_POSITION.x + 4096*sinf(t/8), DRIFT_START_POSITION.y + 2048*sinf(t/4)};
+			v_matrix = (DriftAffine){1, 0, 0, 1, -pos.x, -pos.y};
+		}
+		
+		if(draw_enabled){
+			u64 draw_nanos = DriftTimeNanos();
+			DriftDraw* draw = DriftDrawBegin(&update, dt_tick_diff, v_matrix, prev_vp_matrix);
+			prev_vp_matrix = draw->vp_matrix;
+			DriftDrawBindGlobals(draw);
+			
+			u64 terrain_nanos = DriftTimeNanos();
+			DriftTerrainDrawTiles(draw, false);
+			DriftSystemTimingAdd("Terrain", DriftTimeNanos() - terrain_nanos);
+			terrain_misses += state->terra->cache_stats.misses;
+			terrain_prefetches += state->terra->cache_stats.prefetches;
+			
+			DriftSystemsDraw(draw);
+			if(state->tutorial) DriftScriptDraw(state->tutorial, draw);
+			if(APP->headless.craft_ui){
+				u64 hud_nanos = DriftTimeNanos();
+				DriftDrawHud(draw);
+				DriftSystemTimingAdd("HUD", DriftTimeNanos() - hud_nanos);
+			}
+			
+			DriftGameStateRender(draw);
+			DriftArrayHeader(state->debug.sprites)->count = 0;
+			DriftArrayHeader(state->debug.prims)->count = 0;
+			
+			if(APP->headless.craft_ui){
+				u64 ui_nanos = DriftTimeNanos();
+				DriftUIBegin(ctx->mu, draw);
+				DriftCraftUI(ctx->mu, draw, &ctx->ui_state);
+				DriftUIPresent(ctx->mu, draw);
+				DriftSystemTimingAdd("UI", DriftTimeNanos() - ui_nanos);
+				ui_hits += ctx->ui_cache.hits;
+				ui_misses += ctx->ui_cache.misses;
+			}
+			DriftSystemTimingAdd("Draw", DriftTimeNanos() - draw_nanos);
+			instance_bytes += draw->instance_bytes;
+			draw_frames++;
+			
+			bool last_frame = !replay && ctx->_tick_counter - start_tick >= APP->headless.ticks;
+			if(last_frame && APP->headless.gfx_capture) DriftGfxRendererCapture(draw->renderer, APP->headless.gfx_capture);
+			
+			tina_job_wait(job, &present_job, 0);
+			tina_scheduler_enqueue(APP->scheduler, DriftGameContextPresent, draw, 0, DRIFT_JOB_QUEUE_GFX, &present_job);
+		} else {
+			prev_vp_matrix = DriftAffineMul(p_matrix, v_matrix);
+			DriftArrayHeader(state->debug.sprites)->count = 0;
+			DriftArrayHeader(state->debug.prims)->count = 0;
+		}
+		
+		DriftZoneMemRelease(update.mem);
+		DriftProfileFrameMark();
+		ctx->current_frame = ++ctx->_frame_counter;
+		
+		// Let other main queue jobs run.
+		tina_job_yield(job);
+	}
+	tina_job_wait(job, &present_job, 0);
+	
+	double seconds = (DriftTimeNanos() - start_nanos)/1e9;
+	uint ticks_run = ctx->_tick_counter - start_tick;
+	DRIFT_LOG("Headless: %u ticks in %.2f s, %.1f ticks/s (%.1fx realtime).", ticks_run, seconds, ticks_run/seconds, ticks_run/seconds/DRIFT_TICK_HZ);
+	
+	DriftSystemTiming timings[DRIFT_SYSTEM_TIMING_MAX];
+	uint timing_count = DRIFT_SYSTEM_TIMINGS.count;
+	memcpy(timings, DRIFT_SYSTEM_TIMINGS.arr, timing_count*sizeof(*timings));
+	qsort(timings, timing_count, sizeof(*timings), compare_timings);
+	for(uint i = 0; i < timing_count; i++){
+		DriftSystemTiming* t = timings + i;
+		DRIFT_LOG("Headless: %-24s % 10.2f ms total % 8.2f us/call", t->name, t->nanos/1e6, t->calls ? t->nanos/1e3/t->calls : 0);
+	}
+	
+	DRIFT_LOG("Headless: peak zone memory %u MB, peak process memory %.1f MB.", DriftZoneHeapGetInfo(APP->zone_heap).blocks_peak, DriftPeakMemoryBytes()/1e6);
+	if(draw_frames){
+		const char* layout = ctx->draw_shared->packed_instances ? "packed" : "unpacked";
+		DRIFT_LOG("Headless: %.1f KB of %s sprite and light instances uploaded per frame.", instance_bytes/1e3/draw_frames, layout);
+		DRIFT_LOG("Headless: %.2f terrain cache misses and %.2f prefetches per frame.", (float)terrain_misses/draw_frames, (float)terrain_prefetches/draw_frames);
+		if(APP->headless.craft_ui) DRIFT_LOG("Headless: %.2f UI windows reused and %.2f regenerated per frame.", (float)ui_hits/draw_frames, (float)ui_misses/draw_frames);
+	}
+	DRIFT_SYSTEM_TIMINGS.enabled = false;
+	
+	if(replay){
+		int desync = DriftReplayDesyncFrame(replay);
+		if(desync < 0){
+			DRIFT_LOG("Headless: replay stayed in sync.");
+		} else {
+			DRIFT_LOG("Headless: replay desynced at frame %d.", desync);
+		}
+		DriftReplayFree(replay);
+	}
+	
+	DriftGameStateFree(state, job);
+	ctx->state = NULL;
+	if(draw_enabled){
+		free_ui_caches(ctx);
+		DriftDrawSharedFree(ctx->draw_shared);
+		uint queue = tina_job_switch_queue(job, DRIFT_JOB_QUEUE_GFX);
+		APP->gfx_driver->free_all(APP->gfx_driver);
+		tina_job_switch_queue(job, queue);
+	}
+	
+	DriftAppHaltScheduler();
+}
@@ -16,10 +16,14 @@ typedef enum {
 } DriftFlowMapID;
 
 #define TMP_SAVE_FILENAME "dump.bin"
+// Bump whenever the blocks written by DriftGameStateIO() change.
+// 2: 64 bit entity ids and the resizable entity set.
+#define DRIFT_SAVE_VERSION 2
 
 typedef struct DriftNuklear DriftNuklear;
 typedef struct DriftGameContext DriftGameContext;
 typedef struct DriftGameState DriftGameState;
+typedef struct DriftSaveTerrain DriftSaveTerrain;
 
 typedef enum {
 	DRIFT_TUTORIAL_SPAWN_NORMAL,
@@ -37,6 +41,8 @@ struct DriftGameState {
 	DriftMem* mem;
 	DRIFT_ARRAY(DriftComponent*) components;
 	DriftMap named_components;
+	// Next component to compact during cleanup.
+	uint compact_cursor;
 	
 	DRIFT_ARRAY(DriftTable*) tables;
 	DRIFT_ARRAY(DriftEntity) hot_entities;
@@ -58,12 +64,17 @@ struct DriftGameState {
 	DriftComponentEnemy enemies;
 	
 	DriftTerrain* terra;
+	// Terrain as of the last save, created by the first one.
+	DriftSaveTerrain* save_terrain;
 	DriftRTree rtree;
 	DriftPhysics* physics;
 	
 	DriftEntity player;
 	float scan_progress[_DRIFT_SCAN_COUNT];
 	
+	// Gameplay random state, not saved.
+	DriftRandom rand[1];
+	
 	struct {
 		u16 skiff[_DRIFT_ITEM_COUNT];
 		u16 transit[_DRIFT_ITEM_COUNT];
@@ -109,7 +120,7 @@ struct DriftGameState {
 };
 
 DriftGameState* DriftGameStateNew(tina_job* job);
-void DriftGameStateFree(DriftGameState* state);
+void DriftGameStateFree(DriftGameState* state, tina_job* job);
 void DriftGameStateSetupIntro(DriftGameState* state);
 
 void DriftGameStateRender(DriftDraw* draw);
@@ -158,6 +169,12 @@ struct DriftGameContext {
 	uint current_frame, _frame_counter;
 	
 	mu_Context* mu;
+	DriftUICache ui_cache;
+	// Retained HUD sprites, see DriftDrawHud().
+	struct {
+		DriftSpriteCache status, cargo;
+		DriftVec2 inv_cursor;
+	} hud_cache;
 	DriftUIState ui_state;
 	DriftScanType last_scan;
 	bool is_docked;
@@ -187,8 +204,13 @@ typedef struct DriftUpdate {
 	DriftAffine prev_vp_matrix;
 } DriftUpdate;
 
-void DriftGameStateSave(DriftGameState* state);
-bool DriftGameStateLoad(DriftGameState* state);
+void DriftGameStateIO(DriftIO* io);
+
+// Snapshots the state immediately and writes it in the background.
+void DriftGameStateSave(DriftGameState* state, tina_job* job);
+// Wait for any in flight save to finish writing.
+void DriftGameStateSaveWait(tina_job* job);
+bool DriftGameStateLoad(DriftGameState* state, tina_job* job);
 
 void DriftDebugUI(DriftUpdate* _update, DriftDraw* _draw);
 
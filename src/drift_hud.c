@@ -161,34 +161,51 @@ void DriftDrawHud(DriftDraw* draw){
 	uint health_idx = DriftComponentFind(&state->health.c, state->player);
 	DriftHealth* health = state->health.data + health_idx;
 	
-	DriftVec2 status_cursor = {8, roundf(draw->virtual_extent.y) - 8};
-	float panel_width = state->status.disable_scan ? 154 : 262;
-	status_cursor = DriftHUDDrawPanel(draw, status_cursor, (DriftVec2){panel_width, 40}, 1);
-	
-	DriftVec2 inv_cursor = status_cursor;
-	inv_cursor.x += 150;
-	
-	// Draw temp status bars
-	const char* health_bar = BAR + 15 -  (uint)(15*health->value/health->maximum);
-	status_cursor = DriftDrawTextF(draw, &draw->hud_sprites, status_cursor, DRIFT_TEXT_GRAY"Shield |%.15s|\n", health_bar);
-	
-	const char* energy_bar = BAR + 15 -  (uint)(15*player->energy/DriftPlayerEnergyCap(state));
-	status_cursor = DriftDrawTextF(draw, &draw->hud_sprites, status_cursor, "{#23ADB4FF}Energy |%.15s|\n", energy_bar);
-	
-	const char* temp_bar = BAR + 15 -  (uint)(15*player->temp);
-	status_cursor = DriftDrawTextF(draw, &draw->hud_sprites, status_cursor, "{#DA4C4CFF}Temp   |%.15s|\n", temp_bar);
+	uint health_bars = (uint)(15*health->value/health->maximum);
+	uint energy_bars = (uint)(15*player->energy/DriftPlayerEnergyCap(state));
+	uint temp_bars = (uint)(15*player->temp);
+	uint power_nodes = state->inventory.cargo[DRIFT_ITEM_POWER_NODE];
+	
+	// The status panel only changes when one of its bars or counts does, so reuse its sprites until then.
+	DriftVec2 inv_cursor = ctx->hud_cache.inv_cursor;
+	struct {
+		float height;
+		uint disable_scan, health_bars, energy_bars, temp_bars, power_nodes;
+	} status_key = {screen_size.y, state->status.disable_scan, health_bars, energy_bars, temp_bars, power_nodes};
+	
+	if(!DriftSpriteCacheBegin(&ctx->hud_cache.status, DriftFNV64((const u8*)&status_key, sizeof(status_key)), &draw->hud_sprites)){
+		DriftVec2 status_cursor = {8, screen_size.y - 8};
+		float panel_width = state->status.disable_scan ? 154 : 262;
+		status_cursor = DriftHUDDrawPanel(draw, status_cursor, (DriftVec2){panel_width, 40}, 1);
+		
+		inv_cursor = status_cursor;
+		inv_cursor.x += 150;
+		
+		// Draw temp status bars
+		status_cursor = DriftDrawTextF(draw, &draw->hud_sprites, status_cursor, DRIFT_TEXT_GRAY"Shield |%.15s|\n", BAR + 15 - health_bars);
+		status_cursor = DriftDrawTextF(draw, &draw->hud_sprites, status_cursor, "{#23ADB4FF}Energy |%.15s|\n", BAR + 15 - energy_bars);
+		status_cursor = DriftDrawTextF(draw, &draw->hud_sprites, status_cursor, "{#DA4C4CFF}Temp   |%.15s|\n", BAR + 15 - temp_bars);
+		
+		if(!state->status.disable_scan){
+			inv_cursor = DriftDrawTextF(draw, &draw->hud_sprites, inv_cursor, DRIFT_TEXT_GRAY"Power Nodes:"DRIFT_TEXT_WHITE" %2d\n", power_nodes);
+		}
+		DriftSpriteCacheEnd(&ctx->hud_cache.status, draw->hud_sprites);
+		ctx->hud_cache.inv_cursor = inv_cursor;
+	}
 	
 	uint cargo_mass = DriftPlayerCalculateCargo(state), cargo_max = DriftPlayerCargoCap(state);
 	if(!state->status.disable_scan){
-		inv_cursor = DriftDrawTextF(draw, &draw->hud_sprites, inv_cursor, DRIFT_TEXT_GRAY"Power Nodes:"DRIFT_TEXT_WHITE" %2d\n", state->inventory.cargo[DRIFT_ITEM_POWER_NODE]);
-		
 		update_swoops(draw);
 		draw_swoops(draw, inv_cursor);
 		
-		inv_cursor = DriftDrawTextF(draw, &draw->hud_sprites, inv_cursor, DRIFT_TEXT_GRAY"Cargo:"DRIFT_TEXT_WHITE" %3d/%3d kg\n", cargo_mass, cargo_max);
-		
-		const char* bar = BAR + (cargo_mass > cargo_max ? 0 : 15 -  15*cargo_mass/cargo_max);
-		inv_cursor = DriftDrawTextF(draw, &draw->hud_sprites, inv_cursor, DRIFT_TEXT_GRAY"|%.15s|\n", bar);
+		struct {DriftVec2 cursor; uint mass, max;} cargo_key = {inv_cursor, cargo_mass, cargo_max};
+		if(!DriftSpriteCacheBegin(&ctx->hud_cache.cargo, DriftFNV64((const u8*)&cargo_key, sizeof(cargo_key)), &draw->hud_sprites)){
+			DriftVec2 cargo_cursor = DriftDrawTextF(draw, &draw->hud_sprites, inv_cursor, DRIFT_TEXT_GRAY"Cargo:"DRIFT_TEXT_WHITE" %3d/%3d kg\n", cargo_mass, cargo_max);
+			
+			const char* bar = BAR + (cargo_mass > cargo_max ? 0 : 15 -  15*cargo_mass/cargo_max);
+			DriftDrawTextF(draw, &draw->hud_sprites, cargo_cursor, DRIFT_TEXT_GRAY"|%.15s|\n", bar);
+			DriftSpriteCacheEnd(&ctx->hud_cache.cargo, draw->hud_sprites);
+		}
 	}
 	
 	// Temporary prompt for unfinished areas
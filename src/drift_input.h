@@ -78,6 +78,8 @@ typedef struct {
 	DriftVec2 mouse_pos_clip, mouse_pos_world, mouse_rel, mouse_rel_world;
 	bool mouse_up[_DRIFT_MOUSE_COUNT], mouse_down[_DRIFT_MOUSE_COUNT], mouse_state[_DRIFT_MOUSE_COUNT];
 	float mouse_wheel;
+	// Accumulated relative mouse motion used for aiming.
+	DriftVec2 mouse_look;
 	
 	bool mouse_captured;
 	void* gamepad;
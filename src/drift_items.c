@@ -433,6 +433,7 @@ void DriftDrawItems(DriftDraw* draw){
 		{&transform_idx, &state->transforms.c},
 		{},
 	});
+	DriftJoinSplit(&join, draw->part, draw->parts);
 	while(DriftJoinNext(&join)){
 		DriftAffine m = state->transforms.matrix[transform_idx];
 		DriftVec2 pos = DriftAffineOrigin(m);
@@ -460,8 +461,8 @@ void DriftDrawItems(DriftDraw* draw){
 }
 
 void DriftTickItemSpawns(DriftUpdate* update){
-	static DriftRandom rand[1]; // TODO static global
 	DriftGameState* state = update->state;
+	DriftRandom* rand = state->rand;
 	DriftTerrain* terra = state->terra;
 
 	DriftVec2 player_pos = ({
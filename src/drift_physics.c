@@ -94,6 +94,12 @@ void DriftPhysicsSyncTransforms(DriftUpdate* update, float dt_diff){
 	}
 }
 
+void DriftPhysicsSortBodies(DriftGameState* state){
+	DriftComponentSortSpatial(&state->bodies.c, state->bodies.position, (DriftComponent*[]){&state->transforms.c, NULL});
+	// The RTree refers to bodies by row, reinserting them in their new order also gives it tighter leaves.
+	DriftRTreeReset(&state->rtree);
+}
+
 static inline float generalized_mass_inv(float mass_inv, float moment_inv, DriftVec2 r, DriftVec2 n){
 	float rcn = DriftVec2Cross(r, n);
 	return mass_inv + rcn*rcn*moment_inv;
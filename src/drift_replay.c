@@ -0,0 +1,201 @@
+/*
+This file is part of Veridian Expanse.
+
+Veridian Expanse is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Veridian Expanse is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Veridian Expanse. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#include "drift_game.h"
+
+#define REPLAY_MAGIC "DRIFTREP"
+#define REPLAY_VERSION 2
+
+typedef struct {
+	char magic[8];
+	u32 version, frame_count;
+	
+	// Context and state that isn't saved, but the simulation depends on.
+	DriftRandom rand;
+	u64 update_nanos, tick_nanos;
+	u32 current_tick, tick_counter;
+	u32 current_frame, frame_counter;
+	DriftVec2 mouse_look;
+	float mouse_sensitivity, joy_deadzone;
+	u8 status[sizeof(((DriftGameState*)NULL)->status)];
+} ReplayHeader;
+
+struct DriftReplay {
+	ReplayHeader header;
+	// Game state when recording started.
+	DriftData snapshot;
+	// Game state to read into when loading.
+	DriftGameState* state;
+	
+	DRIFT_ARRAY(DriftReplayFrame) frames;
+	uint cursor;
+	int desync_frame;
+};
+
+static u64 hash_block(u64 hash, const void* ptr, size_t size){
+	return (hash ^ DriftFNV64(ptr, size))*1099511628211u;
+}
+
+u64 DriftGameStateChecksum(DriftGameState* state){
+	u64 hash = 14695981039346656037u;
+	hash = hash_block(hash, &state->entities.entity_count, sizeof(state->entities.entity_count));
+	hash = hash_block(hash, &state->player, sizeof(state->player));
+	hash = hash_block(hash, state->rand, sizeof(state->rand));
+	hash = hash_block(hash, &state->inventory, sizeof(state->inventory));
+	
+	// Catches entities being created or destroyed differently.
+	DRIFT_ARRAY_FOREACH(state->components, component) hash = hash_block(hash, &(*component)->count, sizeof((*component)->count));
+	
+	// Body motion diverges quickly once the simulation desyncs.
+	// Hashing only these columns keeps the check cheap and avoids padding bytes.
+	DriftComponentRigidBody* bodies = &state->bodies;
+	uint count = bodies->c.table.row_count;
+	hash = hash_block(hash, bodies->entity, count*sizeof(*bodies->entity));
+	hash = hash_block(hash, bodies->position, count*sizeof(*bodies->position));
+	hash = hash_block(hash, bodies->velocity, count*sizeof(*bodies->velocity));
+	hash = hash_block(hash, bodies->rotation, count*sizeof(*bodies->rotation));
+	hash = hash_block(hash, bodies->angular_velocity, count*sizeof(*bodies->angular_velocity));
+	
+	return hash;
+}
+
+static void DriftReplayIO(DriftIO* io){
+	DriftReplay* replay = io->user_ptr;
+	ReplayHeader* header = &replay->header;
+	DriftIOBlock(io, "header", header, sizeof(*header));
+	
+	if(io->read){
+		DRIFT_ASSERT_HARD(memcmp(header->magic, REPLAY_MAGIC, sizeof(header->magic)) == 0, "Not a replay file.");
+		DRIFT_ASSERT_HARD(header->version == REPLAY_VERSION, "Unsupported replay version %d.", header->version);
+		
+		// Read the starting state directly into the game state.
+		io->user_ptr = replay->state;
+		DriftGameStateIO(io);
+		io->user_ptr = replay;
+		if(io->abort) return;
+		
+		replay->frames = DRIFT_ARRAY_NEW(DriftSystemMem, header->frame_count, DriftReplayFrame);
+		DriftArrayHeader(replay->frames)->count = header->frame_count;
+	} else {
+		DriftIOBlock(io, "state", replay->snapshot.ptr, replay->snapshot.size);
+	}
+	
+	DriftIOBlock(io, "frames", replay->frames, header->frame_count*sizeof(*replay->frames));
+}
+
+DriftReplay* DriftReplayRecordBegin(DriftGameContext* ctx){
+	DriftGameState* state = ctx->state;
+	DriftReplay* replay = DRIFT_COPY(DriftSystemMem, ((DriftReplay){
+		.header = {
+			.magic = REPLAY_MAGIC, .version = REPLAY_VERSION, .rand = state->rand[0],
+			.update_nanos = ctx->update_nanos, .tick_nanos = ctx->tick_nanos,
+			.current_tick = ctx->current_tick, .tick_counter = ctx->_tick_counter,
+			.current_frame = ctx->current_frame, .frame_counter = ctx->_frame_counter,
+			.mouse_look = INPUT->mouse_look,
+			.mouse_sensitivity = APP->prefs.mouse_sensitivity, .joy_deadzone = APP->prefs.joy_deadzone,
+		},
+		.snapshot = DriftIOSnapshot(DriftSystemMem, DriftGameStateIO, state),
+		.frames = DRIFT_ARRAY_NEW(DriftSystemMem, 64*1024, DriftReplayFrame),
+		.desync_frame = -1,
+	}));
+	memcpy(replay->header.status, &state->status, sizeof(state->status));
+	
+	DRIFT_LOG("Recording replay.");
+	return replay;
+}
+
+void DriftReplayRecordFrame(DriftReplay* replay, DriftUpdate* update, u64 update_nanos, uint tick_count){
+	DRIFT_ASSERT(tick_count <= UINT8_MAX, "Too many ticks in one frame.");
+	
+	// Zero first so padding bytes compress well and files are reproducible.
+	DriftReplayFrame frame;
+	memset(&frame, 0, sizeof(frame));
+	frame.update_nanos = update_nanos;
+	frame.checksum = DriftGameStateChecksum(update->state);
+	frame.prev_vp_matrix = update->prev_vp_matrix;
+	frame.player = INPUT->player;
+	frame.mouse_rel = INPUT->mouse_rel;
+	frame.mouse_captured = INPUT->mouse_captured;
+	frame.tick_count = (u8)tick_count;
+	DRIFT_ARRAY_PUSH(replay->frames, frame);
+}
+
+void DriftReplayRecordEnd(DriftReplay* replay, const char* filename){
+	replay->header.frame_count = (u32)DriftArrayLength(replay->frames);
+	
+	DriftData data = DriftIOSnapshot(DriftSystemMem, DriftReplayIO, replay);
+	DriftIOSnapshotWrite(filename, data);
+	DriftDealloc(DriftSystemMem, data.ptr, data.size);
+	
+	DRIFT_LOG("Recorded %u frames to '%s'.", replay->header.frame_count, filename);
+	DriftReplayFree(replay);
+}
+
+DriftReplay* DriftReplayLoad(DriftGameContext* ctx, const char* filename){
+	DriftGameState* state = ctx->state;
+	DriftReplay* replay = DRIFT_COPY(DriftSystemMem, ((DriftReplay){.state = state, .desync_frame = -1}));
+	if(!DriftIOSnapshotRead(filename, DriftReplayIO, replay)){
+		DRIFT_LOG("Failed to open replay '%s'.", filename);
+		DriftReplayFree(replay);
+		return NULL;
+	}
+	
+	ReplayHeader* header = &replay->header;
+	state->rand[0] = header->rand;
+	memcpy(&state->status, header->status, sizeof(state->status));
+	
+	ctx->update_nanos = header->update_nanos;
+	ctx->tick_nanos = header->tick_nanos;
+	ctx->current_tick = header->current_tick;
+	ctx->_tick_counter = header->tick_counter;
+	ctx->current_frame = header->current_frame;
+	ctx->_frame_counter = header->frame_counter;
+	
+	INPUT->mouse_look = header->mouse_look;
+	APP->prefs.mouse_sensitivity = header->mouse_sensitivity;
+	APP->prefs.joy_deadzone = header->joy_deadzone;
+	
+	DRIFT_LOG("Loaded replay '%s' with %u frames.", filename, header->frame_count);
+	return replay;
+}
+
+const DriftReplayFrame* DriftReplayNextFrame(DriftReplay* replay){
+	if(replay->cursor == DriftArrayLength(replay->frames)) return NULL;
+	
+	const DriftReplayFrame* frame = replay->frames + replay->cursor++;
+	INPUT->player = frame->player;
+	INPUT->mouse_rel = frame->mouse_rel;
+	INPUT->mouse_captured = frame->mouse_captured;
+	return frame;
+}
+
+bool DriftReplayCheckFrame(DriftReplay* replay, DriftGameState* state, uint tick_count){
+	DRIFT_ASSERT(replay->cursor > 0, "No replay frame to check.");
+	uint idx = replay->cursor - 1;
+	const DriftReplayFrame* frame = replay->frames + idx;
+	
+	bool in_sync = frame->tick_count == tick_count && frame->checksum == DriftGameStateChecksum(state);
+	if(!in_sync && replay->desync_frame < 0){
+		replay->desync_frame = (int)idx;
+		DRIFT_LOG("Replay desync at frame %u (ticks %u, expected %u).", idx, tick_count, frame->tick_count);
+	}
+	
+	return in_sync;
+}
+
+int DriftReplayDesyncFrame(DriftReplay* replay){return replay->desync_frame;}
+
+void DriftReplayFree(DriftReplay* replay){
+	if(replay->frames) DriftArrayFree(replay->frames);
+	if(replay->snapshot.ptr) DriftDealloc(DriftSystemMem, replay->snapshot.ptr, replay->snapshot.size);
+	DriftDealloc(DriftSystemMem, replay, sizeof(*replay));
+}
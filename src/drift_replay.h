@@ -0,0 +1,43 @@
+/*
+This file is part of Veridian Expanse.
+
+Veridian Expanse is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+Veridian Expanse is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Veridian Expanse. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Everything a frame needs to be simulated again exactly as it was played.
+typedef struct {
+	u64 update_nanos;
+	// Checksum of the game state at the end of the frame.
+	u64 checksum;
+	DriftAffine prev_vp_matrix;
+	
+	DriftPlayerInput player;
+	DriftVec2 mouse_rel;
+	bool mouse_captured;
+	u8 tick_count;
+} DriftReplayFrame;
+
+typedef struct DriftReplay DriftReplay;
+
+// Cheap checksum of the gameplay state used to detect a replay desync.
+u64 DriftGameStateChecksum(DriftGameState* state);
+
+// Snapshot the current game state and start recording frames.
+DriftReplay* DriftReplayRecordBegin(DriftGameContext* ctx);
+void DriftReplayRecordFrame(DriftReplay* replay, DriftUpdate* update, u64 update_nanos, uint tick_count);
+// Write the recording to a file and free it.
+void DriftReplayRecordEnd(DriftReplay* replay, const char* filename);
+
+// Load a recording, replacing the context's game state with the recorded one.
+DriftReplay* DriftReplayLoad(DriftGameContext* ctx, const char* filename);
+// Feed the next frame's input, returns NULL at the end of the recording.
+const DriftReplayFrame* DriftReplayNextFrame(DriftReplay* replay);
+// Compare the state against the current frame's checksum, returns false on desync.
+bool DriftReplayCheckFrame(DriftReplay* replay, DriftGameState* state, uint tick_count);
+// Frame index of the first desync, or -1 if the replay is still in sync.
+int DriftReplayDesyncFrame(DriftReplay* replay);
+void DriftReplayFree(DriftReplay* replay);
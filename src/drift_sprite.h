@@ -34,6 +34,41 @@ typedef struct {
 	float radius; // 4 bytes
 } DriftLight;
 
+// Packed instance layouts uploaded to the GPU, see DriftDrawPushSprites().
+// The 2x2 part of the matrix is stored as half floats, but the translation needs full floats for subpixel precision far from the origin.
+typedef struct { // 32 bytes
+	DriftHalf matrix[4]; // 8 bytes
+	float x, y; // 8 bytes
+	DriftRGBA8 color; // 4 bytes
+	DriftFrame frame; // 9 bytes
+	u8 z;
+} DriftGPUSprite;
+
+typedef struct { // 36 bytes
+	DriftHalf matrix[4]; // 8 bytes
+	float x, y; // 8 bytes
+	DriftHalf color[4]; // 8 bytes
+	DriftFrame frame; // 9 bytes
+} DriftGPULight;
+
+static inline DriftGPUSprite DriftSpritePack(const DriftSprite* sprite){
+	const DriftAffine* m = &sprite->matrix;
+	return (DriftGPUSprite){
+		.matrix = {DriftHalfFromFloat(m->a), DriftHalfFromFloat(m->b), DriftHalfFromFloat(m->c), DriftHalfFromFloat(m->d)},
+		.x = m->x, .y = m->y, .color = sprite->color, .frame = sprite->frame, .z = sprite->z,
+	};
+}
+
+static inline DriftGPULight DriftLightPack(const DriftLight* light){
+	const DriftAffine* m = &light->matrix;
+	const DriftVec4* c = &light->color;
+	return (DriftGPULight){
+		.matrix = {DriftHalfFromFloat(m->a), DriftHalfFromFloat(m->b), DriftHalfFromFloat(m->c), DriftHalfFromFloat(m->d)},
+		.x = m->x, .y = m->y, .frame = light->frame,
+		.color = {DriftHalfFromFloat(c->r), DriftHalfFromFloat(c->g), DriftHalfFromFloat(c->b), DriftHalfFromFloat(c->a)},
+	};
+}
+
 extern const DriftFrame DRIFT_FRAMES[];
 
 static inline DriftSprite DriftSpriteMake(uint frame, DriftRGBA8 color, DriftAffine matrix){
@@ -1346,7 +1346,33 @@ void DriftSystemsUpdate(DriftUpdate* update){
 	UpdatePlayer(update);
 }
 
-#define RUN_FUNC(_func_, _arg_) {TracyCZoneN(ZONE, #_func_, true); _func_(_arg_); TracyCZoneEnd(ZONE);}
+DriftSystemTimings DRIFT_SYSTEM_TIMINGS;
+
+void DriftSystemTimingAdd(const char* name, u64 nanos){
+	DriftSystemTimings* timings = &DRIFT_SYSTEM_TIMINGS;
+	if(!timings->enabled) return;
+	
+	uint idx = 0;
+	while(idx < timings->count && strcmp(timings->arr[idx].name, name)) idx++;
+	if(idx == timings->count){
+		DRIFT_ASSERT_WARN(idx < DRIFT_SYSTEM_TIMING_MAX, "Too many system timings.");
+		if(idx == DRIFT_SYSTEM_TIMING_MAX) return;
+		timings->arr[timings->count++] = (DriftSystemTiming){.name = name};
+	}
+	
+	timings->arr[idx].nanos += nanos;
+	timings->arr[idx].calls++;
+}
+
+#define RUN_FUNC(_func_, _arg_) { \
+	TracyCZoneN(ZONE, #_func_, true); \
+	DriftProfileZone _zone_ = DriftProfileBegin(#_func_); \
+	u64 _nanos_ = DRIFT_SYSTEM_TIMINGS.enabled ? DriftTimeNanos() : 0; \
+	_func_(_arg_); \
+	if(_nanos_) DriftSystemTimingAdd(#_func_, DriftTimeNanos() - _nanos_); \
+	DriftProfileEnd(_zone_); \
+	TracyCZoneEnd(ZONE); \
+}
 
 void DriftSystemsTickFab(DriftGameContext* ctx, float dt){
 	DriftGameState* state = ctx->state;
@@ -1698,6 +1724,44 @@ static void draw_decals(DriftDraw* draw){
 	TracyCZoneEnd(ZONE_BIOME);
 }
 
+typedef struct {
+	const char* name;
+	void (*func)(DriftDraw* draw);
+	// Split the system across several jobs, it must respect draw->part and draw->parts.
+	bool split;
+} DrawSystem;
+
+static const DrawSystem DRAW_SYSTEMS[] = {
+	{"DrawPower", DrawPower},
+	{"DriftSystemsDrawWeapons", DriftSystemsDrawWeapons},
+	{"DriftDrawItems", DriftDrawItems, .split = true},
+	{"DrawDrones", DrawDrones},
+	{"DriftDrawEnemies", DriftDrawEnemies, .split = true},
+	{"DrawPlayer", DrawPlayer},
+	{"draw_blasts", draw_blasts},
+};
+#define DRIFT_DRAW_SYSTEM_COUNT (sizeof(DRAW_SYSTEMS)/sizeof(*DRAW_SYSTEMS))
+
+typedef struct {
+	const DrawSystem* system;
+	DriftDraw draw;
+	u64 nanos;
+} DrawJob;
+
+static void draw_system_job(tina_job* job){
+	DrawJob* draw_job = tina_job_get_description(job)->user_data;
+	draw_job += tina_job_get_description(job)->user_idx;
+	draw_job->draw.job = job;
+	
+	TracyCZoneN(ZONE, "Draw System", true);
+	DriftProfileZone zone = DriftProfileBegin(draw_job->system->name);
+	u64 nanos = DriftTimeNanos();
+	draw_job->system->func(&draw_job->draw);
+	draw_job->nanos = DriftTimeNanos() - nanos;
+	DriftProfileEnd(zone);
+	TracyCZoneEnd(ZONE);
+}
+
 void DriftSystemsDraw(DriftDraw* draw){
 	draw_decals(draw);
 	
@@ -1737,13 +1801,38 @@ void DriftSystemsDraw(DriftDraw* draw){
 		}));
 	}
 	
-	RUN_FUNC(DrawPower, draw);
-	RUN_FUNC(DriftSystemsDrawWeapons, draw);
-	RUN_FUNC(DriftDrawItems, draw);
-	RUN_FUNC(DrawDrones, draw);
-	RUN_FUNC(DriftDrawEnemies, draw);
-	RUN_FUNC(DrawPlayer, draw);
-	RUN_FUNC(draw_blasts, draw);
+	if(APP->headless.serial_draw){
+		RUN_FUNC(DrawPower, draw);
+		RUN_FUNC(DriftSystemsDrawWeapons, draw);
+		RUN_FUNC(DriftDrawItems, draw);
+		RUN_FUNC(DrawDrones, draw);
+		RUN_FUNC(DriftDrawEnemies, draw);
+		RUN_FUNC(DrawPlayer, draw);
+		RUN_FUNC(draw_blasts, draw);
+		return;
+	}
+	
+	// Each part gets its own job and draw lists. They are merged in order afterwards so the output matches the serial version.
+	uint parts = DRIFT_MAX(APP->worker_count, 1u);
+	DrawJob* jobs = DRIFT_ARRAY_NEW(draw->mem, 64, DrawJob);
+	for(uint i = 0; i < DRIFT_DRAW_SYSTEM_COUNT; i++){
+		uint count = DRAW_SYSTEMS[i].split ? parts : 1;
+		DrawJob* cursor = DRIFT_ARRAY_RANGE(jobs, count);
+		for(uint part = 0; part < count; part++){
+			cursor[part].system = DRAW_SYSTEMS + i;
+			DriftDrawLocalBegin(&cursor[part].draw, draw, part, count);
+		}
+		DriftArrayRangeCommit(jobs, cursor + count);
+	}
+	uint job_count = (uint)DriftArrayLength(jobs);
+	
+	DriftParallelFor(draw->job, draw_system_job, jobs, job_count);
+	
+	DRIFT_PROFILE_SCOPE("Draw Merge");
+	for(uint i = 0; i < job_count; i++){
+		DriftDrawLocalMerge(draw, &jobs[i].draw);
+		if(DRIFT_SYSTEM_TIMINGS.enabled) DriftSystemTimingAdd(jobs[i].system->name, jobs[i].nanos);
+	}
 }
 
 static void table_init(DriftGameState* state, DriftTable* table, const char* name, DriftColumnSet columns, uint capacity){
@@ -1757,6 +1846,8 @@ void DriftSystemsInit(DriftGameState* state){
 		DRIFT_DEFINE_COLUMN(state->transforms.matrix),
 	}), 1024);
 	state->transforms.matrix[0] = DRIFT_AFFINE_IDENTITY;
+	// Transforms and bodies are looked up constantly, use the sparse index for them.
+	DriftComponentMakeSparse(&state->transforms.c);
 	
 	DRIFT_GAMESTATE_TYPED_COMPONENT_MAKE(state, &state->bodies, DriftComponentRigidBody, ((DriftColumnSet){
 		DRIFT_DEFINE_COLUMN(state->bodies.entity),
@@ -1771,6 +1862,7 @@ void DriftSystemsInit(DriftGameState* state){
 		DRIFT_DEFINE_COLUMN(state->bodies.collision_type),
 	}), 1024);
 	state->bodies.rotation[0] = (DriftVec2){1, 0};
+	DriftComponentMakeSparse(&state->bodies.c);
 	
 	table_init(state, &state->rtree.t, "#rtree", ((DriftColumnSet){
 		DRIFT_DEFINE_COLUMN(state->rtree.node),
@@ -199,6 +199,23 @@ typedef void DriftSystemsDrawFunc(DriftDraw* draw);
 DriftSystemsDrawFunc DriftSystemsDraw;
 DriftSystemsDrawFunc DriftSystemsDrawWeapons;
 
+#define DRIFT_SYSTEM_TIMING_MAX 32
+
+typedef struct {
+	const char* name;
+	u64 nanos, calls;
+} DriftSystemTiming;
+
+// Accumulated wall time for each system, only collected while enabled.
+typedef struct {
+	bool enabled;
+	uint count;
+	DriftSystemTiming arr[DRIFT_SYSTEM_TIMING_MAX];
+} DriftSystemTimings;
+
+extern DriftSystemTimings DRIFT_SYSTEM_TIMINGS;
+void DriftSystemTimingAdd(const char* name, u64 nanos);
+
 void DriftDrawPowerMap(DriftDraw* draw, float scale);
 
 typedef struct {
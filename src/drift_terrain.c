@@ -112,7 +112,17 @@ void DriftTerrainResetCache(DriftTerrain* terra){
 		terra->tilemap.texture_idx[i] = 0;
 	}
 	
+	memset(&terra->visible, 0, sizeof(terra->visible));
 	terra->biome_dirty = true;
+	DriftTerrainMarkUnsaved(terra);
+}
+
+void DriftTerrainMarkUnsaved(DriftTerrain* terra){
+	memset(terra->tilemap.unsaved, true, sizeof(terra->tilemap.unsaved));
+}
+
+static inline void mark_unsaved(DriftTerrain* terra, uint tile_idx){
+	if(tile_idx >= DRIFT_TERRAIN_MIP0) terra->tilemap.unsaved[tile_idx - DRIFT_TERRAIN_MIP0] = true;
 }
 
 DriftTerrain* DriftTerrainNew(tina_job* job, bool force_regen){
@@ -368,19 +378,31 @@ static void update_cache_entry(DriftTerrainCacheEntry* heap, DriftTerrainCacheEn
 	*entry = value;
 }
 
+static inline bool rect_contains(DriftTerrainTileRect rect, int x, int y, uint level){
+	return level == rect.level && rect.x0 <= x && x < rect.x1 && rect.y0 <= y && y < rect.y1;
+}
+
+// Visible tiles aren't touched each frame, so they are implicitly used by the current frame.
+static inline u64 tile_timestamp(DriftTerrain* terra, uint idx){
+	DriftTerrainTileCoord c = terra->tilemap.coord[idx];
+	if(idx && rect_contains(terra->visible.rect, (int)c.x, (int)c.y, c.level)) return terra->timestamp;
+	return terra->tilemap.timestamps[idx];
+}
+
 static DriftTerrainCacheEntry* least_recently_used(DriftTerrain* terra){
 	DriftTerrainCacheEntry* entry = terra->cache_heap;
-	u64 timestamp = terra->tilemap.timestamps[entry->tile_idx];
+	u64 timestamp = tile_timestamp(terra, entry->tile_idx);
 	if(entry->timestamp == timestamp){
 		return entry;
 	} else {
-		entry->timestamp = terra->tilemap.timestamps[entry->tile_idx];
+		entry->timestamp = timestamp;
 		update_cache_entry(terra->cache_heap, entry, *entry);
 		return least_recently_used(terra);
 	}
 }
 
-static void cache_tile(DriftTerrain* terra, uint idx, UploadTilesContext* upload_ctx){
+// Returns true if the tile missed the cache and was uploaded.
+static bool cache_tile(DriftTerrain* terra, uint idx, UploadTilesContext* upload_ctx){
 	u64 timestamp = terra->timestamp;
 	
 	// Mark the tile as recently used.
@@ -389,7 +411,7 @@ static void cache_tile(DriftTerrain* terra, uint idx, UploadTilesContext* upload
 	DriftTerrainTileState state = terra->tilemap.state[idx];
 	
 	// Nothing to do if it's already cached.
-	if(state == DRIFT_TERRAIN_TILE_STATE_CACHED) return;
+	if(state == DRIFT_TERRAIN_TILE_STATE_CACHED) return false;
 	if(state == DRIFT_TERRAIN_TILE_STATE_DIRTY) gather_mip(terra, idx);
 	
 	TracyCZoneN(ZONE_GATHER, "Gather/Shadow", true);
@@ -428,11 +450,11 @@ static void cache_tile(DriftTerrain* terra, uint idx, UploadTilesContext* upload
 	upload->texture_idx = texture_idx;
 	upload->next = upload_ctx->tiles;
 	upload_ctx->tiles = upload;
+	return true;
 }
 
-// TODO Only used in one place, can it be inlined/simplified?
-// Gather indexes of tiles visible given the VP matrix.
-static DRIFT_ARRAY(uint) DriftTerrainVisibleTiles(DriftTerrain* terra, DriftDraw* draw){
+// Calculate the rect of tiles visible given the VP matrix, and it's center in tiles.
+static DriftTerrainTileRect visible_rect(DriftDraw* draw, DriftVec2* center){
 	DriftAffine vp_inv = draw->vp_inverse;
 	float hw = fabsf(vp_inv.a) + fabsf(vp_inv.c), hh = fabsf(vp_inv.b) + fabsf(vp_inv.d);
 	DriftAABB2 bounds = {vp_inv.x - hw, vp_inv.y - hh, vp_inv.x + hw, vp_inv.y + hh};
@@ -443,15 +465,28 @@ static DRIFT_ARRAY(uint) DriftTerrainVisibleTiles(DriftTerrain* terra, DriftDraw
 	float q = powf(0.5, roundf(mip_level))/256;
 	bounds.l = (bounds.l + DRIFT_TERRAIN_MAP_SIZE/2)*q; bounds.r = (bounds.r + DRIFT_TERRAIN_MAP_SIZE/2)*q;
 	bounds.b = (bounds.b + DRIFT_TERRAIN_MAP_SIZE/2)*q; bounds.t = (bounds.t + DRIFT_TERRAIN_MAP_SIZE/2)*q;
+	*center = (DriftVec2){(bounds.l + bounds.r)/2, (bounds.b + bounds.t)/2};
 	
-	int x0 = (int)floorf(bounds.l), x1 = (int)ceilf(bounds.r);
-	int y0 = (int)floorf(bounds.b), y1 = (int)ceilf(bounds.t);
 	uint level = (uint)roundf(mip_level);
+	float max = DRIFT_TERRAIN_TILEMAP_SIZE >> level;
+	return (DriftTerrainTileRect){
+		.x0 = (int)floorf(DriftClamp(bounds.l, 0, max)), .x1 = (int)ceilf(DriftClamp(bounds.r, 0, max)),
+		.y0 = (int)floorf(DriftClamp(bounds.b, 0, max)), .y1 = (int)ceilf(DriftClamp(bounds.t, 0, max)),
+		.level = level,
+	};
+}
 
-	DRIFT_ARRAY(uint) tile_indexes = DRIFT_ARRAY_NEW(draw->mem, 256, uint);
-	for(int y = y0; y < y1; y++){
-		for(int x = x0; x < x1; x++){
-			uint idx = tile_index(terra, (DriftTerrainTileCoord){x, y, level});
+// Gather indexes of tiles in 'a' that are not also in 'b'.
+static DRIFT_ARRAY(uint) rect_difference(DriftTerrain* terra, DriftMem* mem, DriftTerrainTileRect a, DriftTerrainTileRect b){
+	DRIFT_ARRAY(uint) tile_indexes = DRIFT_ARRAY_NEW(mem, 64, uint);
+	for(int y = a.y0; y < a.y1; y++){
+		bool overlap = rect_contains(b, b.x0, y, a.level);
+		for(int x = a.x0; x < a.x1; x++){
+			// Skip the span covered by 'b'.
+			if(overlap && b.x0 <= x && x < b.x1) x = b.x1;
+			if(x >= a.x1) break;
+			
+			uint idx = tile_index(terra, (DriftTerrainTileCoord){x, y, a.level});
 			if(idx) DRIFT_ARRAY_PUSH(tile_indexes, idx);
 		}
 	}
@@ -471,7 +506,10 @@ void DriftTerrainUpdateVisibility(DriftTerrain* terra, DriftVec2 pos){
 		for(int x = x0; x < x1; x++){
 			uint idx = x + y*DRIFT_TERRAIN_TILEMAP_SIZE;
 			u8 value = (u8)(255*DriftSaturate(radius - hypotf(p.x - x, p.y - y)));
-			if(value > visibility[idx].r) visibility[idx] = (DriftRGBA8){value, 0, 0, 0};
+			if(value > visibility[idx].r){
+				visibility[idx] = (DriftRGBA8){value, 0, 0, 0};
+				terra->tilemap.unsaved[idx] = true;
+			}
 		}
 	}
 	
@@ -483,17 +521,62 @@ void DriftTerrainDrawTiles(DriftDraw* draw, bool map_mode){
 	TracyCZoneN(ZONE_TERRAIN, "Terrain", true);
 	DriftTerrain* terra = draw->state->terra;
 	terra->timestamp++;
+	terra->cache_stats.misses = terra->cache_stats.prefetches = 0;
 	
 	DriftMem* upload_mem = DriftZoneMemAquire(APP->zone_heap, "UploadMem");
 	UploadTilesContext* upload_ctx = DRIFT_COPY(upload_mem, ((UploadTilesContext){.draw_shared = draw->shared, .mem = upload_mem}));
 	
-	DRIFT_ARRAY(uint) tile_indexes = DriftTerrainVisibleTiles(terra, draw);
-	DRIFT_ARRAY_FOREACH(tile_indexes, idx_ptr){
-		cache_tile(terra, *idx_ptr, upload_ctx);
-		
-		DriftTerrainTileCoord c = terra->tilemap.coord[*idx_ptr];
-		DriftTerrainChunk chunk = {.x = c.x, .y = c.y, .level = c.level, .texture_idx = terra->tilemap.texture_idx[*idx_ptr]};
-		DRIFT_ARRAY_PUSH(draw->terrain_chunks, chunk);
+	DriftVec2 center;
+	DriftTerrainTileRect rect = visible_rect(draw, &center), prev = terra->visible.rect;
+	bool same_view = terra->visible.timestamp && rect.level == prev.level;
+	
+	// Tiles that scrolled out of view were last used by the previous call.
+	DRIFT_ARRAY(uint) hidden = rect_difference(terra, draw->mem, prev, rect);
+	DRIFT_ARRAY_FOREACH(hidden, idx_ptr) terra->tilemap.timestamps[*idx_ptr] = terra->visible.timestamp;
+	
+	// Track the camera's velocity to prefetch with, ignoring jumps larger than the view.
+	DriftVec2 delta = same_view ? DriftVec2Sub(center, terra->visible.center) : DRIFT_VEC2_ZERO;
+	bool jumped = fabsf(delta.x) > rect.x1 - rect.x0 || fabsf(delta.y) > rect.y1 - rect.y0;
+	terra->visible.velocity = jumped ? DRIFT_VEC2_ZERO : DriftVec2Lerp(terra->visible.velocity, delta, 0.25f);
+	terra->visible.center = center;
+	terra->visible.rect = rect;
+	terra->visible.timestamp = terra->timestamp;
+	
+	// Only newly visible tiles need to be cached unless tiles were edited.
+	DriftTerrainTileRect resident = terra->visible.stale ? (DriftTerrainTileRect){} : prev;
+	DRIFT_ARRAY(uint) shown = rect_difference(terra, draw->mem, rect, resident);
+	DRIFT_ARRAY_FOREACH(shown, idx_ptr) terra->cache_stats.misses += cache_tile(terra, *idx_ptr, upload_ctx);
+	terra->visible.stale = false;
+	
+	for(int y = rect.y0; y < rect.y1; y++){
+		for(int x = rect.x0; x < rect.x1; x++){
+			uint idx = tile_index(terra, (DriftTerrainTileCoord){x, y, rect.level});
+			if(idx){
+				DriftTerrainChunk chunk = {.x = x, .y = y, .level = rect.level, .texture_idx = terra->tilemap.texture_idx[idx]};
+				DRIFT_ARRAY_PUSH(draw->terrain_chunks, chunk);
+			}
+		}
+	}
+	
+	// Cache tiles the camera is heading towards a few at a time to spread out the misses.
+	DriftVec2 lead = DriftVec2Mul(terra->visible.velocity, DRIFT_TERRAIN_PREFETCH_FRAMES);
+	int lead_x = (int)ceilf(fabsf(lead.x) - 0.25f), lead_y = (int)ceilf(fabsf(lead.y) - 0.25f);
+	float max = DRIFT_TERRAIN_TILEMAP_SIZE >> rect.level;
+	DriftTerrainTileRect ahead = rect;
+	if(lead.x > 0) ahead.x1 = (int)DriftClamp(ahead.x1 + lead_x, 0, max); else ahead.x0 = (int)DriftClamp(ahead.x0 - lead_x, 0, max);
+	if(lead.y > 0) ahead.y1 = (int)DriftClamp(ahead.y1 + lead_y, 0, max); else ahead.y0 = (int)DriftClamp(ahead.y0 - lead_y, 0, max);
+	
+	// Don't prefetch when it could evict tiles that are in use.
+	if((ahead.x1 - ahead.x0)*(ahead.y1 - ahead.y0) > DRIFT_TERRAIN_TILECACHE_SIZE/2) ahead = rect;
+	
+	DRIFT_ARRAY(uint) prefetch = rect_difference(terra, draw->mem, ahead, rect);
+	DRIFT_ARRAY_FOREACH(prefetch, idx_ptr){
+		if(terra->tilemap.state[*idx_ptr] == DRIFT_TERRAIN_TILE_STATE_CACHED){
+			// Keep it from being evicted before it's visible.
+			terra->tilemap.timestamps[*idx_ptr] = terra->timestamp;
+		} else if(terra->cache_stats.prefetches < DRIFT_TERRAIN_PREFETCH_LIMIT){
+			terra->cache_stats.prefetches += cache_tile(terra, *idx_ptr, upload_ctx);
+		}
 	}
 	
 	if(terra->biome_dirty){
@@ -515,24 +598,46 @@ void DriftTerrainDrawTiles(DriftDraw* draw, bool map_mode){
 	// gather_shadows(draw, terra, bounds);
 }
 
-void DriftTerrainGatherShadows(DriftDraw* draw, DriftTerrain* terra, DriftAABB2 bounds){
+void DriftTerrainGatherShadows(DriftDraw* draw, DriftTerrain* terra, const DriftAABB2 light_bounds[], uint light_count){
 	DriftAffine v_mat = draw->v_matrix;
 	float v_scale = hypotf(v_mat.a, v_mat.b) + hypotf(v_mat.c, v_mat.d);
-	if(v_scale < 1.5f) return;
-	
-	float half_size = DRIFT_TERRAIN_MAP_SIZE/2;
-	int x0 = (int)floorf((bounds.l + half_size)/256), x1 = (int)ceilf((bounds.r + half_size)/256);
-	int y0 = (int)floorf((bounds.b + half_size)/256), y1 = (int)ceilf((bounds.t + half_size)/256);
-
-	DRIFT_ARRAY(uint) tile_indexes = DRIFT_ARRAY_NEW(draw->mem, 256, uint);
-	for(int y = y0; y < y1; y++){
-		for(int x = x0; x < x1; x++){
-			uint idx = tile_index(terra, (DriftTerrainTileCoord){x, y, 0});
-			if(idx){
-				if(DriftArrayLength(draw->shadow_masks) >= 16*1024){
-					DRIFT_LOG_DEBUG("Ooops, too many shadows!");
-					break;
-				}
+	if(v_scale < 1.5f || light_count == 0) return;
+	
+	// Find the tiles each light can reach, and the range covering all of them.
+	float half_size = DRIFT_TERRAIN_MAP_SIZE/2, tile_size = DRIFT_TERRAIN_TILE_SCALE*DRIFT_TERRAIN_TILE_SIZE;
+	DriftTerrainTileRect ranges[light_count], all = {INT_MAX, INT_MAX, 0, 0};
+	for(uint i = 0; i < light_count; i++){
+		DriftAABB2 bb = light_bounds[i];
+		DriftTerrainTileRect r = {
+			.x0 = (int)floorf(DriftClamp((bb.l + half_size)/tile_size, 0, DRIFT_TERRAIN_TILEMAP_SIZE)),
+			.x1 = (int)ceilf(DriftClamp((bb.r + half_size)/tile_size, 0, DRIFT_TERRAIN_TILEMAP_SIZE)),
+			.y0 = (int)floorf(DriftClamp((bb.b + half_size)/tile_size, 0, DRIFT_TERRAIN_TILEMAP_SIZE)),
+			.y1 = (int)ceilf(DriftClamp((bb.t + half_size)/tile_size, 0, DRIFT_TERRAIN_TILEMAP_SIZE)),
+		};
+		ranges[i] = r;
+		
+		if(r.x0 < r.x1 && r.y0 < r.y1){
+			all.x0 = DRIFT_MIN(all.x0, r.x0), all.x1 = DRIFT_MAX(all.x1, r.x1);
+			all.y0 = DRIFT_MIN(all.y0, r.y0), all.y1 = DRIFT_MAX(all.y1, r.y1);
+		}
+	}
+	if(all.x0 >= all.x1 || all.y0 >= all.y1) return;
+	
+	// Tiles reached by several lights are only gathered once.
+	uint stride = (uint)(all.x1 - all.x0), gathered_size = stride*(uint)(all.y1 - all.y0);
+	u8* gathered = DriftAlloc(draw->mem, gathered_size);
+	memset(gathered, 0, gathered_size);
+	
+	for(uint i = 0; i < light_count; i++){
+		DriftTerrainTileRect r = ranges[i];
+		for(int y = r.y0; y < r.y1; y++){
+			for(int x = r.x0; x < r.x1; x++){
+				u8* mark = gathered + (uint)(x - all.x0) + (uint)(y - all.y0)*stride;
+				if(*mark) continue;
+				*mark = true;
+				
+				uint idx = tile_index(terra, (DriftTerrainTileCoord){x, y, 0});
+				if(idx == 0) continue;
 				
 				DriftTerrainTileState state = terra->tilemap.state[idx];
 				DRIFT_ASSERT(state != DRIFT_TERRAIN_TILE_STATE_DIRTY, "Unexpected tile state");
@@ -550,7 +655,7 @@ void DriftTerrainGatherShadows(DriftDraw* draw, DriftTerrain* terra, DriftAABB2
 		}
 	}
 	
-	// DRIFT_LOG("shadow count %d", DriftArrayLength(draw->shadow_masks));
+	DriftDealloc(draw->mem, gathered, gathered_size);
 }
 
 typedef struct {
@@ -589,6 +694,7 @@ static inline DriftVec3 dist_est(DriftVec3 cmin, float x0, float x1, float dx, f
 
 void DriftTerrainDig(DriftTerrain* terra, DriftVec2 pos, float radius){
 	TracyCZoneN(ZONE_DIG, "Dig", true);
+	terra->visible.stale = true;
 	
 	pos.x -= DRIFT_TERRAIN_TILE_SCALE;
 	pos.y -= DRIFT_TERRAIN_TILE_SCALE;
@@ -665,6 +771,7 @@ void DriftTerrainDig(DriftTerrain* terra, DriftVec2 pos, float radius){
 			*info.sample = DriftSDFEncode(value);
 			
 			terra->tilemap.state[info.tile_idx] = DRIFT_TERRAIN_TILE_STATE_READY;
+			mark_unsaved(terra, info.tile_idx);
 			// Mark parent tiles as dirty.
 			DriftTerrainTileCoord c = terra->tilemap.coord[info.tile_idx];
 			while(c.level < DRIFT_TERRAIN_TILEMAP_SIZE_LOG){
@@ -868,33 +975,37 @@ typedef struct{
 	DriftTerrainEditFunc* func;
 	void* ctx;
 	DriftVec2 pos;
-	float x0, x1, y[DRIFT_TERRAIN_TILEMAP_SIZE*DRIFT_TERRAIN_TILE_SIZE], r;
+	float x0, x1, y0, r;
 } EditJobContext;
 
-static void edit_job(tina_job* job){
-	EditJobContext* edit = tina_job_get_description(job)->user_data;
-	uint idx = tina_job_get_description(job)->user_idx;
-	
+#define EDIT_ROWS_PER_CHUNK 4
+
+static void edit_rows(void* user_data, uint begin, uint end){
+	EditJobContext* edit = user_data;
 	DriftTerrain* terra = edit->terra;
 	DriftTerrainEditFunc* func = edit->func;
-	for(float x = edit->x0; x < edit->x1; x++){
-		DriftVec2 texel_coord = {x, edit->y[idx]};
-		SampleInfo info = sample_info(terra, (uint)texel_coord.x, (uint)texel_coord.y);
-		float value = DriftSDFDecode(*info.sample);
-		float dist = DriftVec2Distance(edit->pos, texel_coord);
-		
-		*info.sample = DriftSDFEncode(func(value, dist, edit->r, texel_coord, edit->ctx));
-		terra->tilemap.state[info.tile_idx] = DRIFT_TERRAIN_TILE_STATE_READY;
-		DriftTerrainTileCoord c = terra->tilemap.coord[info.tile_idx];
-		while(c.level < DRIFT_TERRAIN_TILEMAP_SIZE_LOG){
-			c = (DriftTerrainTileCoord){c.x/2, c.y/2, c.level + 1};
-			terra->tilemap.state[tile_index(terra, c)] = DRIFT_TERRAIN_TILE_STATE_DIRTY;
+	for(uint row = begin; row < end; row++){
+		for(float x = edit->x0; x < edit->x1; x++){
+			DriftVec2 texel_coord = {x, edit->y0 + row};
+			SampleInfo info = sample_info(terra, (uint)texel_coord.x, (uint)texel_coord.y);
+			float value = DriftSDFDecode(*info.sample);
+			float dist = DriftVec2Distance(edit->pos, texel_coord);
+			
+			*info.sample = DriftSDFEncode(func(value, dist, edit->r, texel_coord, edit->ctx));
+			terra->tilemap.state[info.tile_idx] = DRIFT_TERRAIN_TILE_STATE_READY;
+			mark_unsaved(terra, info.tile_idx);
+			DriftTerrainTileCoord c = terra->tilemap.coord[info.tile_idx];
+			while(c.level < DRIFT_TERRAIN_TILEMAP_SIZE_LOG){
+				c = (DriftTerrainTileCoord){c.x/2, c.y/2, c.level + 1};
+				terra->tilemap.state[tile_index(terra, c)] = DRIFT_TERRAIN_TILE_STATE_DIRTY;
+			}
 		}
 	}
 }
 
 void DriftTerrainEdit(DriftUpdate* update, DriftVec2 pos, float radius, DriftTerrainEditFunc* func, void* ctx){
 	DriftTerrain* terra = update->state->terra;
+	terra->visible.stale = true;
 	
 	pos.x -= DRIFT_TERRAIN_TILE_SCALE;
 	pos.y -= DRIFT_TERRAIN_TILE_SCALE;
@@ -907,17 +1018,10 @@ void DriftTerrainEdit(DriftUpdate* update, DriftVec2 pos, float radius, DriftTer
 	float hs = edit.r + DRIFT_SDF_MAX_DIST;
 	float max = DRIFT_TERRAIN_TILEMAP_SIZE*DRIFT_TERRAIN_TILE_SIZE;
 	edit.x0 = DriftClamp(floorf(edit.pos.x - hs), 0, max), edit.x1 = DriftClamp(ceilf(edit.pos.x + hs), 0, max);
-	float y0 = DriftClamp(floorf(edit.pos.y - hs), 0, max), y1 = DriftClamp(ceilf(edit.pos.y + hs), 0, max);
-	
-	uint job_cursor = 0;
-	tina_group group = {};
-	for(float y = y0; y < y1; y++){
-		edit.y[job_cursor] = y;
-		tina_scheduler_enqueue(APP->scheduler, edit_job, &edit, job_cursor, DRIFT_JOB_QUEUE_WORK, &group);
-		job_cursor++;
-		tina_job_wait(update->job, &group, 16);
-	}
-	tina_job_wait(update->job, &group, 0);
+	edit.y0 = DriftClamp(floorf(edit.pos.y - hs), 0, max);
+	float y1 = DriftClamp(ceilf(edit.pos.y + hs), 0, max);
+	
+	DriftParallelForRange(update->job, edit_rows, &edit, (uint)(y1 - edit.y0), EDIT_ROWS_PER_CHUNK);
 }
 
 void DriftBiomeEdit(DriftTerrain* terra, DriftVec2 pos, float radius, DriftRGBA8 _value){
@@ -980,7 +1084,8 @@ void DriftTerrainEditIO(tina_job* job, DriftTerrain* terra, bool save){
 	DRIFT_LOG(save ? "Saved" : "Loaded");
 }
 
-#define ROWS_PER_JOB 64
+// Rows are a few thousand cells each, a handful per chunk is plenty to amortize the scheduling.
+#define ROWS_PER_CHUNK 8
 #define MAP_SIZE (DRIFT_TERRAIN_TILEMAP_SIZE*DRIFT_TERRAIN_TILE_SIZE)
 
 typedef struct {
@@ -989,9 +1094,7 @@ typedef struct {
 	DriftVec3* cells[2];
 } RectifyContext;
 
-static void init_job(tina_job* job){
-	RectifyContext* ctx = tina_job_get_description(job)->user_data;
-	uint j = tina_job_get_description(job)->user_idx;
+static void init_row(RectifyContext* ctx, uint j){
 	uint j0 = (j - 1)&(MAP_SIZE - 1), j1 = j, j2 = (j + 1)&(MAP_SIZE - 1);
 	
 	float* x = ctx->values;
@@ -1014,6 +1117,10 @@ static void init_job(tina_job* job){
 	}
 }
 
+static void init_rows(void* user_data, uint begin, uint end){
+	for(uint j = begin; j < end; j++) init_row(user_data, j);
+}
+
 typedef struct {
 	float* progress;
 	float p0, p1;
@@ -1023,12 +1130,11 @@ typedef struct {
 	int r;
 } FloodContext;
 
-static void flood_job(tina_job* job){
-	FloodContext* ctx = tina_job_get_description(job)->user_data;
-	uint i0 = tina_job_get_description(job)->user_idx*ROWS_PER_JOB;
-	for(uint i = i0; i < i0 + ROWS_PER_JOB; i += 1) DriftSDFFloodRow(ctx->dst + i, MAP_SIZE, ctx->src + i*MAP_SIZE, MAP_SIZE, ctx->r);
+static void flood_rows(void* user_data, uint begin, uint end){
+	FloodContext* ctx = user_data;
+	for(uint i = begin; i < end; i += 1) DriftSDFFloodRow(ctx->dst + i, MAP_SIZE, ctx->src + i*MAP_SIZE, MAP_SIZE, ctx->r);
 	
-	*ctx->progress = DriftLerp(ctx->p0, ctx->p1, (float)i0/(float)MAP_SIZE);
+	*ctx->progress = DriftLerp(ctx->p0, ctx->p1, (float)begin/(float)MAP_SIZE);
 }
 
 static void rectify(tina_job* job){
@@ -1058,7 +1164,7 @@ static void rectify(tina_job* job){
 	
 	ctx->terra->rectify_progress = 0.02f;
 	progress_cursor = 0.05f;
-	DriftThrottledParallelFor(job, init_job, ctx, MAP_SIZE);
+	DriftParallelForRange(job, init_rows, ctx, MAP_SIZE, ROWS_PER_CHUNK);
 	
 	for(uint r = DRIFT_SDF_MAX_DIST/2; r > 0; r >>= 1){
 		FloodContext fctx = {.r = r, .progress = &ctx->terra->rectify_progress};
@@ -1066,11 +1172,11 @@ static void rectify(tina_job* job){
 		
 		fctx.p0 = progress_cursor, progress_cursor += inc, fctx.p1 = progress_cursor;
 		fctx.dst = ctx->cells[1], fctx.src = ctx->cells[0];
-		DriftThrottledParallelFor(job, flood_job, &fctx, MAP_SIZE/ROWS_PER_JOB);
+		DriftParallelForRange(job, flood_rows, &fctx, MAP_SIZE, ROWS_PER_CHUNK);
 		
 		fctx.p0 = progress_cursor, progress_cursor += inc, fctx.p1 = progress_cursor;
 		fctx.dst = ctx->cells[0], fctx.src = ctx->cells[1];
-		DriftThrottledParallelFor(job, flood_job, &fctx, MAP_SIZE/ROWS_PER_JOB);
+		DriftParallelForRange(job, flood_rows, &fctx, MAP_SIZE, ROWS_PER_CHUNK);
 	}
 	
 	ctx->terra->rectify_progress = progress_cursor;
@@ -1163,6 +1269,7 @@ uint DriftTerrainTileResources(DriftTerrain* terra, uint tile_idx){
 	DRIFT_ASSERT(DRIFT_TERRAIN_MIP0 <= tile_idx && tile_idx < DRIFT_TERRAIN_TILE_COUNT, "Bad tile index for resources.");
 	uint count = terra->tilemap.resources[tile_idx - DRIFT_TERRAIN_MIP0];
 	terra->tilemap.resources[tile_idx - DRIFT_TERRAIN_MIP0] = 0;
+	mark_unsaved(terra, tile_idx);
 	return count;
 }
 
@@ -1171,6 +1278,7 @@ void DriftTerrainTileResourcesInc(DriftTerrain* terra, uint tile_idx){
 	
 	DRIFT_ASSERT(DRIFT_TERRAIN_MIP0 <= tile_idx && tile_idx < DRIFT_TERRAIN_TILE_COUNT, "Bad tile index for resources.");
 	int count = ++terra->tilemap.resources[tile_idx - DRIFT_TERRAIN_MIP0];
+	mark_unsaved(terra, tile_idx);
 	DRIFT_ASSERT(count <= 6, "Resource overflow on tile %d of %d", tile_idx, count);
 }
 
@@ -1180,6 +1288,7 @@ uint DriftTerrainTileBiomass(DriftTerrain* terra, uint tile_idx){
 	DRIFT_ASSERT(DRIFT_TERRAIN_MIP0 <= tile_idx && tile_idx < DRIFT_TERRAIN_TILE_COUNT, "Bad tile index for resources.");
 	uint count = terra->tilemap.biomass[tile_idx - DRIFT_TERRAIN_MIP0];
 	terra->tilemap.biomass[tile_idx - DRIFT_TERRAIN_MIP0] = 0;
+	mark_unsaved(terra, tile_idx);
 	return count;
 }
 
@@ -1188,5 +1297,61 @@ void DriftTerrainTileBiomassInc(DriftTerrain* terra, uint tile_idx){
 	
 	DRIFT_ASSERT(DRIFT_TERRAIN_MIP0 <= tile_idx && tile_idx < DRIFT_TERRAIN_TILE_COUNT, "Bad tile index for resources.");
 	int count = ++terra->tilemap.biomass[tile_idx - DRIFT_TERRAIN_MIP0];
+	mark_unsaved(terra, tile_idx);
 	DRIFT_ASSERT(count <= 6, "Resource overflow on tile %d of %d", tile_idx, count);
 }
+
+#if DRIFT_DEBUG
+static uint gather_shadows_bench(DriftDraw* draw, DriftTerrain* terra, const DriftAABB2 light_bounds[], uint light_count, uint reps, double* ms){
+	uint segment_count = 0;
+	u64 t0 = DriftTimeNanos();
+	for(uint i = 0; i < reps; i++){
+		draw->shadow_masks = DRIFT_ARRAY_NEW(draw->mem, 2048, DriftSegment);
+		DriftTerrainGatherShadows(draw, terra, light_bounds, light_count);
+		segment_count = DriftArrayLength(draw->shadow_masks);
+		DriftArrayFree(draw->shadow_masks);
+	}
+	
+	*ms = (DriftTimeNanos() - t0)/1e6/reps;
+	return segment_count;
+}
+
+void unit_test_terrain_shadows(tina_job* job){
+	DriftTerrain* terra = DriftTerrainNew(job, false);
+	DriftRandom rand[1] = {{2468}};
+	
+	// Shadowed lights scattered through the open parts of the caves around the start position.
+	uint light_count = 100;
+	DriftAABB2 light_bounds[2*light_count];
+	DriftAABB2 view_bounds = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+	for(uint i = 0; i < light_count; i++){
+		DriftVec2 p = DRIFT_START_POSITION;
+		for(uint tries = 0; tries < 100; tries++){
+			p = DriftVec2FMA(DRIFT_START_POSITION, (DriftVec2){DriftRandomSNorm(rand), DriftRandomSNorm(rand)}, 2048);
+			if(DriftTerrainSampleFine(terra, p).dist > 0) break;
+		}
+		
+		float r = 100 + 300*DriftRandomUNorm(rand);
+		light_bounds[i] = light_bounds[i + light_count] = (DriftAABB2){p.x - r, p.y - r, p.x + r, p.y + r};
+		view_bounds = DriftAABB2Merge(view_bounds, light_bounds[i]);
+	}
+	
+	DriftDraw draw = {.mem = DriftSystemMem, .v_matrix = DRIFT_AFFINE_IDENTITY};
+	double ms, view_ms, duplicate_ms;
+	
+	// Gather once to generate the tile shadows so only the gathering is timed.
+	gather_shadows_bench(&draw, terra, light_bounds, light_count, 1, &ms);
+	uint segment_count = gather_shadows_bench(&draw, terra, light_bounds, light_count, 100, &ms);
+	uint view_count = gather_shadows_bench(&draw, terra, &view_bounds, 1, 100, &view_ms);
+	uint duplicate_count = gather_shadows_bench(&draw, terra, light_bounds, 2*light_count, 100, &duplicate_ms);
+	
+	DRIFT_ASSERT(segment_count <= view_count, "Lights gathered more segments (%d) than their combined bounds (%d).", segment_count, view_count);
+	DRIFT_ASSERT(segment_count == duplicate_count, "Overlapping lights gathered duplicate segments (%d vs %d).", duplicate_count, segment_count);
+	
+	DRIFT_LOG("Terrain shadows: %d lights gather %d segments in %.3f ms, their combined bounds have %d segments and take %.3f ms.",
+		light_count, segment_count, ms, view_count, view_ms
+	);
+	
+	DriftTerrainFree(terra);
+}
+#endif
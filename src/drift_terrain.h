@@ -21,6 +21,9 @@ You should have received a copy of the GNU General Public License along with Ver
 #define DRIFT_TERRAIN_MIP0 (DRIFT_TERRAIN_TILE_COUNT/4)
 
 #define DRIFT_TERRAIN_TILECACHE_SIZE 1024
+// How many frames ahead along the camera's velocity to prefetch tiles, and the most tiles to prefetch per frame.
+#define DRIFT_TERRAIN_PREFETCH_FRAMES 16
+#define DRIFT_TERRAIN_PREFETCH_LIMIT 4
 
 #define DRIFT_TERRAIN_FILE_CHUNKS 8
 
@@ -48,6 +51,12 @@ typedef struct {
 	u8 samples[DRIFT_TERRAIN_TILE_SIZE_SQ];
 } DriftTerrainDensity;
 
+// Half open range of tile coordinates at a single mip level.
+typedef struct {
+	int x0, y0, x1, y1;
+	uint level;
+} DriftTerrainTileRect;
+
 typedef struct {
 	u64 timestamp;
 	u32 tile_idx;
@@ -63,6 +72,8 @@ typedef struct {
 		DriftRGBA8 visibility[DRIFT_TERRAIN_TILEMAP_SIZE_SQ];
 		u8 resources[DRIFT_TERRAIN_TILEMAP_SIZE_SQ];
 		u8 biomass[DRIFT_TERRAIN_TILEMAP_SIZE_SQ];
+		// Level 0 tiles modified since the last save snapshot.
+		bool unsaved[DRIFT_TERRAIN_TILEMAP_SIZE_SQ];
 		
 		DriftTerrainTileCoord coord[DRIFT_TERRAIN_TILE_COUNT];
 		DriftTerrainTileState state[DRIFT_TERRAIN_TILE_COUNT];
@@ -83,6 +94,22 @@ typedef struct {
 	DriftTerrainCacheEntry cache_heap[DRIFT_TERRAIN_TILECACHE_SIZE];
 	u64 timestamp;
 	
+	// Tiles drawn by the last DriftTerrainDrawTiles() call.
+	// They count as used every frame without touching their timestamps until they scroll out of view.
+	struct {
+		DriftTerrainTileRect rect;
+		u64 timestamp;
+		// Camera center and smoothed velocity in tiles.
+		DriftVec2 center, velocity;
+		// Tiles were edited and need to be checked again.
+		bool stale;
+	} visible;
+	
+	// Cache stats for the last DriftTerrainDrawTiles() call.
+	struct {
+		uint misses, prefetches;
+	} cache_stats;
+	
 	tina_group jobs;
 } DriftTerrain;
 
@@ -90,9 +117,12 @@ DriftTerrain* DriftTerrainNew(tina_job* job, bool force_regen);
 void DriftTerrainFree(DriftTerrain* terra);
 
 void DriftTerrainResetCache(DriftTerrain* terra);
+// Mark every tile as modified after changing the tilemap in bulk.
+void DriftTerrainMarkUnsaved(DriftTerrain* terra);
 void DriftTerrainUpdateVisibility(DriftTerrain* terra, DriftVec2 pos);
 void DriftTerrainDrawTiles(DriftDraw* draw, bool map_mode);
-void DriftTerrainGatherShadows(DriftDraw* draw, DriftTerrain* terra, DriftAABB2 bounds);
+// Gather the shadow mask segments of the terrain tiles within any of the lights' bounds into draw->shadow_masks.
+void DriftTerrainGatherShadows(DriftDraw* draw, DriftTerrain* terra, const DriftAABB2 light_bounds[], uint light_count);
 
 void DriftTerrainDig(DriftTerrain* terra, DriftVec2 pos, float radius);
 
@@ -138,3 +168,7 @@ void DriftBiomeSpaceEdit(DriftTerrain* terra, DriftVec2 pos, float radius, float
 
 void DriftTerrainEditIO(tina_job* job, DriftTerrain* terra, bool save);
 void DriftTerrainEditRectify(DriftTerrain* terra, tina_scheduler* sched, tina_group* group);
+
+#if DRIFT_DEBUG
+void unit_test_terrain_shadows(tina_job* job);
+#endif
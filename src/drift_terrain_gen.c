@@ -31,31 +31,31 @@ static float* VALUES;
 static DriftVec3* CELLS0;
 static DriftVec3* CELLS1;
 
-static void generate_row(tina_job* job){
-	uint y = tina_job_get_description(job)->user_idx;
-	if(y % 256 == 0){printf("\r  map: %d%%", 100*y/MAP_SIZE); fflush(stdout);}
-	
-	for(uint x = 0; x < MAP_SIZE; x++){
-		DriftVec2 pos = {x, y};
-		float value = 0;
-		value += (perlin(pos.x/32, pos.y/32))/1;
-		value += (perlin(pos.x/16, pos.y/16))/2;
-		// value += (perlin(pos.x/8, pos.y/8))/4;
-		float dx = (int)x - (int)MAP_SIZE/2, dy = (int)y - (int)MAP_SIZE/2;
-		float dsq = (dx*dx + dy*dy)*128/MAP_SIZE/MAP_SIZE;
-		VALUES[x + y*MAP_SIZE] = 0.2f + dsq*dsq - fabsf(value);
+#define ROWS_PER_CHUNK 8
+
+static void generate_rows(void* user_data, uint begin, uint end){
+	for(uint y = begin; y < end; y++){
+		if(y % 256 == 0){printf("\r  map: %d%%", 100*y/MAP_SIZE); fflush(stdout);}
+		
+		for(uint x = 0; x < MAP_SIZE; x++){
+			DriftVec2 pos = {x, y};
+			float value = 0;
+			value += (perlin(pos.x/32, pos.y/32))/1;
+			value += (perlin(pos.x/16, pos.y/16))/2;
+			// value += (perlin(pos.x/8, pos.y/8))/4;
+			float dx = (int)x - (int)MAP_SIZE/2, dy = (int)y - (int)MAP_SIZE/2;
+			float dsq = (dx*dx + dy*dy)*128/MAP_SIZE/MAP_SIZE;
+			VALUES[x + y*MAP_SIZE] = 0.2f + dsq*dsq - fabsf(value);
+		}
 	}
 }
 
-#define ROWS_PER_JOB 64
-
 static inline DriftVec3 dist_est(DriftVec3 cmin, float x0, float x1, float dx, float dy){
 	float w = x0*x1 < 0 ? fabsf(x0 - x1)/(fabsf(x0) + FLT_MIN) : 0;
 	return cmin.z > w ? cmin : (DriftVec3){{dx, dy, w}};
 }
 
-static void init_job(tina_job* job){
-	uint j = tina_job_get_description(job)->user_idx;
+static void init_row(uint j){
 	if(j % 256 == 0){printf("\r  init: %d%%", 100*j/MAP_SIZE); fflush(stdout);}
 	
 	float* x = VALUES + j*MAP_SIZE;
@@ -78,18 +78,22 @@ static void init_job(tina_job* job){
 	}
 }
 
+static void init_rows(void* user_data, uint begin, uint end){
+	for(uint j = begin; j < end; j++) init_row(j);
+}
+
 typedef struct {
 	DriftVec3* dst;
 	DriftVec3* src;
 	int r;
 } FloodContext;
 
-static void flood_job(tina_job* job){
-	FloodContext* ctx = tina_job_get_description(job)->user_data;
-	uint i0 = tina_job_get_description(job)->user_idx*ROWS_PER_JOB;
-	if(i0 % 256 == 0){printf("\r  flood(r = %d): %d%%", ctx->r, 100*i0/MAP_SIZE); fflush(stdout);}
-	
-	for(uint i = i0; i < i0 + ROWS_PER_JOB; i += 1) DriftSDFFloodRow(ctx->dst + i, MAP_SIZE, ctx->src + i*MAP_SIZE, MAP_SIZE, ctx->r);
+static void flood_rows(void* user_data, uint begin, uint end){
+	FloodContext* ctx = user_data;
+	for(uint i = begin; i < end; i += 1){
+		if(i % 256 == 0){printf("\r  flood(r = %d): %d%%", ctx->r, 100*i/MAP_SIZE); fflush(stdout);}
+		DriftSDFFloodRow(ctx->dst + i, MAP_SIZE, ctx->src + i*MAP_SIZE, MAP_SIZE, ctx->r);
+	}
 }
 
 static void encode_tile(tina_job* job){
@@ -118,21 +122,21 @@ static void encode_tile(tina_job* job){
 static void DriftTerrainGen(tina_job* job){
 	MAP_SIZE = DRIFT_TERRAIN_TILE_SIZE*DRIFT_TERRAIN_TILEMAP_SIZE;
 	VALUES = DriftAlloc(DriftSystemMem, MAP_SIZE*MAP_SIZE*sizeof(*VALUES));
-	DriftThrottledParallelFor(job, generate_row, NULL, MAP_SIZE);
+	DriftParallelForRange(job, generate_rows, NULL, MAP_SIZE, ROWS_PER_CHUNK);
 	puts("");
 	
 	CELLS0 = DriftAlloc(DriftSystemMem, MAP_SIZE*MAP_SIZE*sizeof(*CELLS0));
 	CELLS1 = DriftAlloc(DriftSystemMem, MAP_SIZE*MAP_SIZE*sizeof(*CELLS1));
-	DriftThrottledParallelFor(job, init_job, NULL, MAP_SIZE);
+	DriftParallelForRange(job, init_rows, NULL, MAP_SIZE, ROWS_PER_CHUNK);
 	
-	DriftThrottledParallelFor(job, flood_job, &(FloodContext){.dst = CELLS1, .src = CELLS0, .r = 1}, MAP_SIZE/ROWS_PER_JOB);
+	DriftParallelForRange(job, flood_rows, &(FloodContext){.dst = CELLS1, .src = CELLS0, .r = 1}, MAP_SIZE, ROWS_PER_CHUNK);
 	puts("");
-	DriftThrottledParallelFor(job, flood_job, &(FloodContext){.dst = CELLS0, .src = CELLS1, .r = 1}, MAP_SIZE/ROWS_PER_JOB);
+	DriftParallelForRange(job, flood_rows, &(FloodContext){.dst = CELLS0, .src = CELLS1, .r = 1}, MAP_SIZE, ROWS_PER_CHUNK);
 	puts("");
 	for(uint r = SDF_MAX_DIST/2; r > 0; r >>= 1){
-		DriftThrottledParallelFor(job, flood_job, &(FloodContext){.dst = CELLS1, .src = CELLS0, .r = r}, MAP_SIZE/ROWS_PER_JOB);
+		DriftParallelForRange(job, flood_rows, &(FloodContext){.dst = CELLS1, .src = CELLS0, .r = r}, MAP_SIZE, ROWS_PER_CHUNK);
 		puts("");
-		DriftThrottledParallelFor(job, flood_job, &(FloodContext){.dst = CELLS0, .src = CELLS1, .r = r}, MAP_SIZE/ROWS_PER_JOB);
+		DriftParallelForRange(job, flood_rows, &(FloodContext){.dst = CELLS0, .src = CELLS1, .r = r}, MAP_SIZE, ROWS_PER_CHUNK);
 		puts("");
 	}
 	
@@ -11,7 +11,7 @@ You should have received a copy of the GNU General Public License along with Ver
 #include "drift_game.h"
 
 // TODO This should get moved to the player struct?
-static DriftVec2 MOUSE_POS = {};
+#define MOUSE_POS (INPUT->mouse_look)
 
 static void draw_mouse(DriftDraw* draw, DriftRGBA8 color){
 	if(INPUT->mouse_captured){
@@ -146,7 +146,7 @@ static void grabber_update(DriftUpdate* update, DriftPlayerData* player, DriftVe
 	}
 	
 	uint transform_idx = DriftComponentFind(&state->transforms.c, e);
-	DRIFT_ASSERT(transform_idx, "Grabbed entity e%d has no transform.", e.id);
+	DRIFT_ASSERT(transform_idx, "Grabbed entity "DRIFT_ENTITY_FORMAT" has no transform.", e.id);
 	float x = state->transforms.matrix[transform_idx].x;
 	state->transforms.matrix[transform_idx].x = position.x;
 	state->transforms.matrix[transform_idx].y = position.y;
@@ -163,7 +163,7 @@ static void grabber_update(DriftUpdate* update, DriftPlayerData* player, DriftVe
 static void grabber_drop(DriftUpdate* update, DriftPlayerData* player){
 	DriftGameState* state = update->state;
 	DriftEntity e = player->grabbed_entity;
-	DRIFT_ASSERT(DriftEntitySetCheck(&state->entities, e), "Grabbed entity e%d does not exist.", e.id);
+	DRIFT_ASSERT(DriftEntitySetCheck(&state->entities, e), "Grabbed entity "DRIFT_ENTITY_FORMAT" does not exist.", e.id);
 	
 	DriftItemDrop(update, e, player->grabbed_type);
 	player->grabbed_type = DRIFT_ITEM_NONE;
@@ -180,7 +180,7 @@ static bool grabber_stash(DriftUpdate* update, DriftPlayerData* player){
 	DriftGameState* state = update->state;
 	DriftItemType type = player->grabbed_type;
 	DriftEntity e = player->grabbed_entity;
-	DRIFT_ASSERT(DriftEntitySetCheck(&state->entities, e), "Grabbed entity e%d does not exist.", e.id);
+	DRIFT_ASSERT(DriftEntitySetCheck(&state->entities, e), "Grabbed entity "DRIFT_ENTITY_FORMAT" does not exist.", e.id);
 	
 	player->grabbed_type = DRIFT_ITEM_NONE;
 	player->grabbed_entity.id = 0;
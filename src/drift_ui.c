@@ -213,28 +213,91 @@ void DriftUIHandleEvent(mu_Context* mu, SDL_Event* event, float scale){
 	}
 }
 
-void DriftUIPresent(mu_Context* mu, DriftDraw* draw){
-	mu_end(mu);
+typedef struct {
+	mu_Rect rect;
+	// Index of the first sprite drawn with this clip rect.
+	uint sprite_idx;
+} UIClip;
+
+struct DriftUIPanelCache {
+	DriftSpriteCache sprites;
+	// Clip rects with sprite indexes relative to the start of the panel.
+	DRIFT_ARRAY(UIClip) clips;
+};
+
+static mu_Command* command_after(mu_Command* cmd){return (mu_Command*)((char*)cmd + cmd->base.size);}
+
+// Iterate a root container's own commands, skipping over any root containers nested inside of it.
+static mu_Command* panel_next_command(mu_Context* mu, mu_Container* cnt, mu_Command* cmd){
+	cmd = command_after(cmd ? cmd : cnt->head);
+	while(cmd != cnt->tail && cmd->type == MU_COMMAND_JUMP){
+		mu_Container* nested = NULL;
+		for(int i = 0; i < mu->root_list.idx; i++){
+			if(mu->root_list.items[i]->head == cmd) nested = mu->root_list.items[i];
+		}
+		DRIFT_ASSERT(nested, "Unexpected jump command in a UI container.");
+		cmd = command_after(nested->tail);
+	}
 	
-	DRIFT_ARRAY(DriftSprite) geo = DRIFT_ARRAY_NEW(draw->mem, 1024, DriftSprite);
-	DRIFT_ARRAY(uint) text_len = DRIFT_ARRAY_NEW(draw->mem, 256, uint);
-	float h = draw->internal_extent.y;
+	return cmd == cnt->tail ? NULL : cmd;
+}
+
+static u64 hash_block(u64 hash, const void* ptr, size_t size){
+	return (hash ^ DriftFNV64(ptr, size))*1099511628211u;
+}
+
+// Hash everything the generated sprites depend on, but not the padding or unused bytes of the commands.
+static u64 panel_hash(mu_Context* mu, mu_Container* cnt, float h){
+	u64 hash = 14695981039346656037u;
+	hash = hash_block(hash, &h, sizeof(h));
+	// Input prompts in the text change with the active device.
+	hash = hash_block(hash, &INPUT->icon_type, sizeof(INPUT->icon_type));
 	
-	for(mu_Command *cmd = NULL; mu_next_command(mu, &cmd);){
+	for(mu_Command* cmd = panel_next_command(mu, cnt, NULL); cmd; cmd = panel_next_command(mu, cnt, cmd)){
+		hash = hash_block(hash, &cmd->type, sizeof(cmd->type));
+		switch(cmd->type){
+			case MU_COMMAND_CLIP:{
+				hash = hash_block(hash, &cmd->clip.rect, sizeof(cmd->clip.rect));
+			} break;
+			case MU_COMMAND_RECT:{
+				hash = hash_block(hash, &cmd->rect.rect, sizeof(cmd->rect.rect));
+				hash = hash_block(hash, &cmd->rect.color, sizeof(cmd->rect.color));
+			} break;
+			case MU_COMMAND_TEXT:{
+				hash = hash_block(hash, &cmd->text.pos, sizeof(cmd->text.pos));
+				hash = hash_block(hash, &cmd->text.color, sizeof(cmd->text.color));
+				hash = hash_block(hash, cmd->text.str, strlen(cmd->text.str));
+			} break;
+			case MU_COMMAND_ICON:
+			case MU_COMMAND_PATCH9:{
+				hash = hash_block(hash, &cmd->icon.rect, sizeof(cmd->icon.rect));
+				hash = hash_block(hash, &cmd->icon.id, sizeof(cmd->icon.id));
+				hash = hash_block(hash, &cmd->icon.color, sizeof(cmd->icon.color));
+			} break;
+		}
+	}
+	
+	return hash;
+}
+
+static void panel_generate(DriftDraw* draw, DRIFT_ARRAY(DriftSprite)* geo, DRIFT_ARRAY(UIClip)* clips, mu_Context* mu, mu_Container* cnt, float h){
+	uint first_sprite = DriftArrayLength(*geo);
+	for(mu_Command* cmd = panel_next_command(mu, cnt, NULL); cmd; cmd = panel_next_command(mu, cnt, cmd)){
 		switch (cmd->type){
+			case MU_COMMAND_CLIP:{
+				DRIFT_ARRAY_PUSH(*clips, ((UIClip){.rect = cmd->clip.rect, .sprite_idx = DriftArrayLength(*geo) - first_sprite}));
+			} break;
 			case MU_COMMAND_TEXT:{
 				mu_Color c = cmd->text.color;
 				float pm = (float)c.a/(float)(255*255);
-				uint len0 = DriftArrayLength(geo);
-				DriftDrawTextFull(draw, &geo, cmd->text.str, (DriftTextOptions){
+				DriftDrawTextFull(draw, geo, cmd->text.str, (DriftTextOptions){
 					.tint = {{c.r*pm, c.g*pm, c.b*pm, 255*pm}},
 					.matrix = {1, 0, 0, 1, cmd->text.pos.x, h - cmd->text.pos.y - 8}, // height - baseline?
 				});
-				DRIFT_ARRAY_PUSH(text_len, DriftArrayLength(geo) - len0);
 			} break;
 			case MU_COMMAND_RECT:{
 				mu_Rect r = cmd->rect.rect;
-				DRIFT_ARRAY_PUSH(geo, ((DriftSprite){.matrix = {r.w, 0, 0, -r.h, r.x, h - r.y}, .color = DriftRGBA8_from_mu(cmd->rect.color)}));
+				DRIFT_ARRAY_PUSH(*geo, ((DriftSprite){.matrix = {r.w, 0, 0, -r.h, r.x, h - r.y}, .color = DriftRGBA8_from_mu(cmd->rect.color)}));
 			} break;
 			case MU_COMMAND_ICON:{
 				static const uint ICON_FRAMES[] = {
@@ -252,7 +315,7 @@ void DriftUIPresent(mu_Context* mu, DriftDraw* draw){
 				frame.anchor.x = frame.anchor.y = 0;
 				
 				mu_Rect r = cmd->icon.rect;
-				DRIFT_ARRAY_PUSH(geo, ((DriftSprite){
+				DRIFT_ARRAY_PUSH(*geo, ((DriftSprite){
 					.frame = frame, .color = DriftRGBA8_from_mu(cmd->icon.color),
 					.matrix = {
 						1, 0, 0, 1,
@@ -263,40 +326,70 @@ void DriftUIPresent(mu_Context* mu, DriftDraw* draw){
 			} break;
 			case MU_COMMAND_PATCH9:{
 				mu_Rect r = cmd->icon.rect;
-				patch9(&geo, (DriftAABB2){r.x, h - r.y - r.h, r.x + r.w, h - r.y}, cmd->icon.id, DriftRGBA8_from_mu(cmd->icon.color));
+				patch9(geo, (DriftAABB2){r.x, h - r.y - r.h, r.x + r.w, h - r.y}, cmd->icon.id, DriftRGBA8_from_mu(cmd->icon.color));
 			} break;
 		}
 	}
+}
+
+void DriftUIPresent(mu_Context* mu, DriftDraw* draw){
+	mu_end(mu);
+	
+	// MicroUI still needs to run its layout every frame to handle input,
+	// but the sprites for each window are only regenerated when its draw commands change.
+	DriftUICache* cache = &draw->ctx->ui_cache;
+	if(cache->panels == NULL){
+		size_t size = MU_CONTAINERPOOL_SIZE*sizeof(*cache->panels);
+		cache->panels = memset(DriftAlloc(DriftSystemMem, size), 0, size);
+	}
+	cache->hits = cache->misses = 0;
+	
+	DRIFT_ARRAY(DriftSprite) geo = DRIFT_ARRAY_NEW(draw->mem, 1024, DriftSprite);
+	DRIFT_ARRAY(UIClip) clips = DRIFT_ARRAY_NEW(draw->mem, 64, UIClip);
+	float h = draw->internal_extent.y;
+	
+	// Root containers were sorted back to front by mu_end().
+	for(int i = 0; i < mu->root_list.idx; i++){
+		mu_Container* cnt = mu->root_list.items[i];
+		DriftUIPanelCache* panel = cache->panels + (cnt - mu->containers);
+		uint first_sprite = DriftArrayLength(geo);
+		
+		if(DriftSpriteCacheBegin(&panel->sprites, panel_hash(mu, cnt, h), &geo)){
+			cache->hits++;
+		} else {
+			if(panel->clips == NULL) panel->clips = DRIFT_ARRAY_NEW(DriftSystemMem, 8, UIClip);
+			DriftArrayHeader(panel->clips)->count = 0;
+			panel_generate(draw, &geo, &panel->clips, mu, cnt, h);
+			DriftSpriteCacheEnd(&panel->sprites, geo);
+			cache->misses++;
+		}
+		
+		DRIFT_ARRAY_FOREACH(panel->clips, clip){
+			DRIFT_ARRAY_PUSH(clips, ((UIClip){.rect = clip->rect, .sprite_idx = first_sprite + clip->sprite_idx}));
+		}
+	}
 	
 	DriftGfxRenderer* renderer = draw->renderer;
 	DriftGfxPipelineBindings ui_bindings = draw->default_bindings;
-	ui_bindings.instance = DriftGfxRendererPushGeometry(renderer, geo, DriftArraySize(geo)).binding;
+	ui_bindings.instance = DriftDrawPushSprites(draw, geo, DriftArrayLength(geo));
 	ui_bindings.uniforms[0] = draw->ui_binding;
 	float hires = draw->shared->hires;
 	
-	uint count = 0;
-	for(mu_Command *cmd = NULL; mu_next_command(mu, &cmd);){
-		switch (cmd->type) {
-			case MU_COMMAND_CLIP:{
-				*DriftGfxRendererPushBindPipelineCommand(renderer, draw->shared->overlay_sprite_pipeline) = ui_bindings;
-				DriftGfxRendererPushDrawIndexedCommand(renderer, draw->quad_index_binding, 6, count);
-				ui_bindings.instance.offset += count*sizeof(DriftSprite);
-				count = 0;
-				
-				mu_Rect r = cmd->clip.rect;
-				r.y = (int)(h - r.y - r.h);
-				DriftGfxRendererPushScissorCommand(renderer, (DriftAABB2){hires*r.x, hires*r.y, hires*(r.x + r.w), hires*(r.y + r.h)});
-			} break;
-			
-			case MU_COMMAND_TEXT: count += *text_len++; break;
-			case MU_COMMAND_RECT:
-			case MU_COMMAND_ICON: count++; break;
-			case MU_COMMAND_PATCH9: count += 9; break;
-		}
+	uint drawn = 0;
+	DRIFT_ARRAY_FOREACH(clips, clip){
+		uint count = clip->sprite_idx - drawn;
+		*DriftGfxRendererPushBindPipelineCommand(renderer, draw->shared->overlay_sprite_pipeline) = ui_bindings;
+		DriftGfxRendererPushDrawIndexedCommand(renderer, draw->quad_index_binding, 6, count);
+		ui_bindings.instance.offset += count*draw->shared->sprite_stride;
+		drawn = clip->sprite_idx;
+		
+		mu_Rect r = clip->rect;
+		r.y = (int)(h - r.y - r.h);
+		DriftGfxRendererPushScissorCommand(renderer, (DriftAABB2){hires*r.x, hires*r.y, hires*(r.x + r.w), hires*(r.y + r.h)});
 	}
 	
 	*DriftGfxRendererPushBindPipelineCommand(renderer, draw->shared->overlay_sprite_pipeline) = ui_bindings;
-	DriftGfxRendererPushDrawIndexedCommand(renderer, draw->quad_index_binding, 6, count);
+	DriftGfxRendererPushDrawIndexedCommand(renderer, draw->quad_index_binding, 6, DriftArrayLength(geo) - drawn);
 	DriftGfxRendererPushScissorCommand(renderer, DRIFT_AABB2_ALL);
 	
 	// TODO static globals
@@ -322,6 +415,17 @@ void DriftUIPresent(mu_Context* mu, DriftDraw* draw){
 	last_focus = mu->focus;
 }
 
+void DriftUICacheFree(DriftUICache* cache){
+	if(cache->panels){
+		for(uint i = 0; i < MU_CONTAINERPOOL_SIZE; i++){
+			DriftSpriteCacheFree(&cache->panels[i].sprites);
+			DriftArrayFree(cache->panels[i].clips);
+		}
+		DriftDealloc(DriftSystemMem, cache->panels, MU_CONTAINERPOOL_SIZE*sizeof(*cache->panels));
+	}
+	*cache = (DriftUICache){};
+}
+
 void DriftUIOpen(DriftGameContext* ctx, const char* ui){
 	mu_Container* win = mu_get_container(ctx->mu, ui);
 	win->open = true;
@@ -539,7 +643,7 @@ static void DriftSettingsPane(mu_Context* mu, DriftVec2 extents, UIStack* stack)
 	}
 }
 
-static void DriftPauseMenu(mu_Context* mu, DriftVec2 extents, DriftGameContext* ctx, bool* exit_to_menu, UIStack* stack){
+static void DriftPauseMenu(mu_Context* mu, DriftVec2 extents, DriftGameContext* ctx, tina_job* job, bool* exit_to_menu, UIStack* stack){
 	static const char* TITLE = "Pause";
 	mu_Container* win = mu_get_container(mu, TITLE);
 	win->open = (stack->arr[stack->top] == DRIFT_UI_STATE_PAUSE);
@@ -563,7 +667,7 @@ static void DriftPauseMenu(mu_Context* mu, DriftVec2 extents, DriftGameContext*
 			if(ctx->state->status.save_lock){
 				mu_open_popup(mu, "NOSAVE");
 			} else {
-				DriftGameStateSave(ctx->state);
+				DriftGameStateSave(ctx->state, job);
 			}
 		}
 		
@@ -632,11 +736,11 @@ static void DriftMainMenu(mu_Context* mu, DriftVec2 extents, DriftGameContext* c
 		if(mu_button(mu, "Load Game") || gfocus){
 			// TODO replace me!
 			ctx->state = DriftGameStateNew(job);
-			if(DriftGameStateLoad(ctx->state)){
+			if(DriftGameStateLoad(ctx->state, job)){
 				APP->no_splash = true;
 				stack->top--;
 			} else {
-				DriftGameStateFree(ctx->state);
+				DriftGameStateFree(ctx->state, job);
 				ctx->state = NULL;
 			}
 		}
@@ -889,7 +993,7 @@ DriftLoopYield DriftMenuLoop(tina_job* job, DriftGameContext* ctx){
 			p = DriftDrawTextF(draw, &draw->hud_sprites, p,"{#80808080}DEV {#40408080}%s\n", DRIFT_GIT_SHORT_SHA);
 			
 			DriftGfxPipelineBindings* sprite_bindings = DriftDrawQuads(draw, draw_shared->overlay_sprite_pipeline, DriftArrayLength(draw->hud_sprites));
-			sprite_bindings->instance = DriftGfxRendererPushGeometry(draw->renderer, draw->hud_sprites, DriftArraySize(draw->hud_sprites)).binding;
+			sprite_bindings->instance = DriftDrawPushSprites(draw, draw->hud_sprites, DriftArrayLength(draw->hud_sprites));
 			sprite_bindings->uniforms[0] = draw->ui_binding;
 			
 			DriftUIBegin(mu, draw);
@@ -970,12 +1074,12 @@ DriftLoopYield DriftPauseLoop(DriftGameContext* ctx, tina_job* job, DriftAffine
 		DriftGfxPipelineBindings* bindings = DriftGfxRendererPushBindPipelineCommand(draw->renderer, draw_shared->overlay_sprite_pipeline);
 		*bindings = draw->default_bindings;
 		bindings->uniforms[0] = draw->ui_binding;
-		bindings->instance = DriftGfxRendererPushGeometry(draw->renderer, draw->hud_sprites, DriftArraySize(draw->hud_sprites)).binding;
+		bindings->instance = DriftDrawPushSprites(draw, draw->hud_sprites, DriftArrayLength(draw->hud_sprites));
 		DriftGfxRendererPushDrawIndexedCommand(draw->renderer, draw->quad_index_binding, 6, DriftArrayLength(draw->hud_sprites));
 		
 		mu_Context* mu = ctx->mu;
 		DriftUIBegin(mu, draw);
-		DriftPauseMenu(mu, draw->internal_extent, ctx, exit_to_menu, &stack);
+		DriftPauseMenu(mu, draw->internal_extent, ctx, job, exit_to_menu, &stack);
 		DriftSettingsPane(mu, draw->internal_extent, &stack);
 		DriftNYIPane(mu, draw->internal_extent, &stack);
 		DriftUIPresent(mu, draw);
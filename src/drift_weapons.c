@@ -356,7 +356,7 @@ static void fire_plasma_gun(DriftUpdate* update, DriftPlayerData* player, DriftA
 
 	DriftGunState* gun = &player->primary;
 	if(fire_repeating(update, player, gun, plasma_gun + level, DRIFT_INPUT_FIRE)){
-		static DriftRandom rand = {};
+		DriftRandom* rand = update->state->rand;
 		PlayerCannonTransforms cannons = CalculatePlayerCannonTransforms(1);
 		
 		for(uint i = 0; i < 4; i++){
@@ -367,8 +367,8 @@ static void fire_plasma_gun(DriftUpdate* update, DriftPlayerData* player, DriftA
 			
 			fire_projectile(update, DRIFT_PROJECTILE_PLAYER_PLASMA, vel, (DriftRay2){
 				.origin = DriftAffineOrigin(cannon),
-				.dir = DriftVec2FMA(dir, DriftRandomInUnitCircle(&rand), 0.3f),
-			}, DriftLerp(0.5f, 1.0f, DriftRandomUNorm(&rand)));
+				.dir = DriftVec2FMA(dir, DriftRandomInUnitCircle(rand), 0.3f),
+			}, DriftLerp(0.5f, 1.0f, DriftRandomUNorm(rand)));
 		}
 		
 		pew_pew(update, DriftAffineOrigin(transform), DRIFT_PROJECTILE_PLAYER_PLASMA);